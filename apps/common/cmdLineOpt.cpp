@@ -30,6 +30,11 @@
    Modified Jul 2024 JHB, add --group_pcap_nocopy and --random_bit_error cmd line options
    Modified Aug 2024 JHB, add --sha1sum and --sha512sum cmd line options
    Modified Mar 2025 JHB, handle ALLOW_XX attributes defined in cmdLineOpt.h for overloaded options, for example -rN can accept N either int or float and fInvalidFormat is not set if the option can't be converted to a valid integer
+   Modified Oct 2026 JHB, add --start_time and --stop_time cmd line options
+   Modified Oct 2026 JHB, add --read_ahead cmd line option
+   Modified Oct 2026 JHB, add --compress_output cmd line option
+   Modified Oct 2026 JHB, add --dup_lookback cmd line option
+   Modified Oct 2026 JHB, add --output_writers cmd line option
 */
 
 #include <stdint.h>
@@ -50,7 +55,7 @@ using namespace std;
 
 /* used when calling getopt_long(), JHB Jul 2023 */
 
-static const struct option long_options[] = { { "version", no_argument, NULL, (char)128 }, { "cut", required_argument, NULL, (char)129 }, { "group_pcap", required_argument, NULL, (char)130 }, { "group_pcap_nocopy", required_argument, NULL, (char)131 }, { "md5sum", no_argument, NULL, (char)132 }, { "sha1sum", no_argument, NULL, (char)133 }, { "sha512sum", no_argument, NULL, (char)134 }, { "show_aud_clas", no_argument, NULL, (char)135 }, { "random_bit_error", required_argument, NULL, (char)136 }, /* insert additional options here */ {NULL, 0, NULL, 0 } };
+static const struct option long_options[] = { { "version", no_argument, NULL, (char)128 }, { "cut", required_argument, NULL, (char)129 }, { "group_pcap", required_argument, NULL, (char)130 }, { "group_pcap_nocopy", required_argument, NULL, (char)131 }, { "md5sum", no_argument, NULL, (char)132 }, { "sha1sum", no_argument, NULL, (char)133 }, { "sha512sum", no_argument, NULL, (char)134 }, { "show_aud_clas", no_argument, NULL, (char)135 }, { "random_bit_error", required_argument, NULL, (char)136 }, { "start_time", required_argument, NULL, (char)137 }, { "stop_time", required_argument, NULL, (char)138 }, { "read_ahead", required_argument, NULL, (char)139 }, { "compress_output", required_argument, NULL, (char)140 }, { "dup_lookback", required_argument, NULL, (char)141 }, { "output_writers", required_argument, NULL, (char)142 }, /* insert additional options here */ {NULL, 0, NULL, 0 } };
 
 //
 // CmdLineOpt - Default constructor.
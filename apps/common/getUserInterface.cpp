@@ -45,6 +45,11 @@
    Modified Jul 2024 JHB, add --group_pcap_nocopy and --random_bit_error cmd line options, integrate userInfo.h CmdLineFlags_t struct with 1-bit flags. Look for CmdLineFlags.xxx
    Modified Aug 2024 JHB, add --sha1sum and --sha512sum cmd line options, used by mediaMin and mediaTest apps
    Modified Mar 2025 JHB, use ALLOW_XX attributes defined in cmdLineOpt.h for overloaded options, for example -rN can accept N either int or float
+   Modified Oct 2026 JHB, add --start_time and --stop_time cmd line options, used by mediaMin to process an arrival time window of pcap inputs
+   Modified Oct 2026 JHB, add --read_ahead cmd line option, used by mediaMin to enable per-input read-ahead threads
+   Modified Oct 2026 JHB, add --compress_output cmd line option, used by mediaMin to write gzip or zstd compressed output pcaps
+   Modified Oct 2026 JHB, add --dup_lookback cmd line option, used by mediaMin to set duplicate packet detection lookback
+   Modified Oct 2026 JHB, add --output_writers cmd line option, used by mediaMin to enable asynchronous output pcap writer threads
 */
 
 #include <stdlib.h>
@@ -193,7 +198,19 @@ static CmdLineOpt::Record options[] = {
    {(char)135, CmdLineOpt::BOOLEAN, NOTMANDATORY,
           (char *)"show per-channel audio classification", {{(void*)0}} },  /* --show_aud_clas, JHB Feb 2024 */
    {(char)136, CmdLineOpt::INTEGER, NOTMANDATORY,
-          (char *)"insert N% random bit errors per frame", {{(void*)0}} }  /* --random_bit_error, JHB Jul 2024 */
+          (char *)"insert N% random bit errors per frame", {{(void*)0}} },  /* --random_bit_error, JHB Jul 2024 */
+   {(char)137, CmdLineOpt::FLOAT, NOTMANDATORY,
+          (char *)"input start time (sec), relative to first packet arrival time", {{(void*)0}} },  /* --start_time <sec>, JHB Oct 2026 */
+   {(char)138, CmdLineOpt::FLOAT, NOTMANDATORY,
+          (char *)"input stop time (sec), relative to first packet arrival time", {{(void*)0}} },  /* --stop_time <sec>, JHB Oct 2026 */
+   {(char)139, CmdLineOpt::INTEGER, NOTMANDATORY,
+          (char *)"input read-ahead ring depth (number of packet batches)", {{(void*)0}} },  /* --read_ahead N, JHB Oct 2026 */
+   {(char)140, CmdLineOpt::STRING, NOTMANDATORY,
+          (char *)"compress output pcaps (gz or zst)", {{(void*)0}} },  /* --compress_output gz|zst, JHB Oct 2026 */
+   {(char)141, CmdLineOpt::INTEGER, NOTMANDATORY,
+          (char *)"duplicate packet detection lookback (number of packets)", {{(void*)0}} },  /* --dup_lookback N, JHB Oct 2026 */
+   {(char)142, CmdLineOpt::INTEGER, NOTMANDATORY,
+          (char *)"number of output pcap writer threads", {{(void*)0}} }  /* --output_writers N, JHB Oct 2026 */
 };
 
 /* global storage of cmd line options */
@@ -426,6 +443,25 @@ char clkstr[100];
 
          if (cmdOpts.nInstances((char)136) != 0 && ((uFlags & CLI_MEDIA_APPS_MEDIAMIN) || (uFlags & CLI_MEDIA_APPS_MEDIATEST))) userIfs->nRandomBitErrorPercentage = cmdOpts.getInt((char)134, 0, 0);  /* look for --random_bit_error cmd line option. Added for mediaTest payload/packet impairment operations, JHB Jul 2024 */
 
+         if (uFlags & CLI_MEDIA_APPS) {  /* look for --start_time and --stop_time cmd line options, convert to msec. -1 indicates no entry. Added for mediaMin arrival time window processing (mediaMin may also run as mediaTest app threads), JHB Oct 2026 */
+
+            userIfs->nInputStartTime = cmdOpts.nInstances((char)137) != 0 ? (int)(cmdOpts.getFloat((char)137, 0, 0)*1000 + 0.5) : -1;
+            userIfs->nInputStopTime = cmdOpts.nInstances((char)138) != 0 ? (int)(cmdOpts.getFloat((char)138, 0, 0)*1000 + 0.5) : -1;
+            userIfs->nInputReadAheadDepth = cmdOpts.nInstances((char)139) != 0 ? cmdOpts.getInt((char)139, 0, 0) : 0;  /* look for --read_ahead cmd line option, zero indicates no read-ahead */
+
+            userIfs->nPcapOutputCompression = 0;  /* look for --compress_output cmd line option: 0 = none, 1 = gzip, 2 = zstd */
+
+            if (cmdOpts.getStr((char)140, 0) != NULL) {
+
+               if (!strcasecmp(cmdOpts.getStr((char)140, 0), "gz") || !strcasecmp(cmdOpts.getStr((char)140, 0), "gzip")) userIfs->nPcapOutputCompression = 1;
+               else if (!strcasecmp(cmdOpts.getStr((char)140, 0), "zst") || !strcasecmp(cmdOpts.getStr((char)140, 0), "zstd")) userIfs->nPcapOutputCompression = 2;
+               else cout << "--compress_output value " << cmdOpts.getStr((char)140, 0) << " not recognized, should be gz or zst" << endl;
+            }
+
+            userIfs->nDuplicateLookback = cmdOpts.nInstances((char)141) != 0 ? cmdOpts.getInt((char)141, 0, 0) : -1;  /* look for --dup_lookback cmd line option, -1 indicates no entry */
+            userIfs->nOutputWriterThreads = cmdOpts.nInstances((char)142) != 0 ? cmdOpts.getInt((char)142, 0, 0) : 0;  /* look for --output_writers cmd line option, zero indicates output pcaps are written by app threads */
+         }
+
          if (userIfs->programMode >= 0) {
 
             userIfs->programSubMode = userIfs->programMode >> 24;
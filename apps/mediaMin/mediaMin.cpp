@@ -217,6 +217,29 @@
    Modified Apr 2025 JHB, in isPortAllowed() improvements to console formatting of port-found messages
    Modified Apr 2025 JHB, simplify stream stats implementation
    Modified Apr 2025 JHB, fix bug preventing display of final mediaMin stats for static sessions
+   Modified Oct 2026 JHB, add ENABLE_MMAP_INPUT cmd line flag. If set, InputSetup() opens pcap, pcapng, and .rtp inputs with DS_OPEN_PCAP_MMAP and GetInputData() reads with DSReadPcapPtr()
+   Modified Oct 2026 JHB, in AFAP mode (-r0 cmd line entry) GetInputData() reads pcap inputs in batches using DSReadPcapBatch(). Batch packet arena also serves as input cache packet data, avoiding a per-packet cache copy. See comments in GetInputData() and InputSetup()
+   Modified Oct 2026 JHB, support --start_time and --stop_time cmd line options. InputTimeWindowSetup() uses DSSeekPcap() to position inputs at the start time, GetInputData() returns end of input after the stop time. Both are in sec relative to the first packet in each input
+   Modified Oct 2026 JHB, support --read_ahead N cmd line option. InputReadAheadStart() starts a producer thread per input that reads batches into an N slot ring; GetInputData() pops slots instead of reading inline. Ring occupancy and stall stats are shown in mediaMin summary stats
+   Modified Oct 2026 JHB, attach pktlib buffered writers (DSCreatePcapWriter()) to output, stream group, and jitter buffer output pcaps, and write with DSWritePcapBuffered() in PullPackets()
+   Modified Oct 2026 JHB, add ENABLE_FLOW_PARTITION cmd line flag. With -tN (N > 1) app threads, PushPackets() uses FlowPartition() to hand each media flow in an input to one app thread, instead of every thread processing every flow. Load/capacity test mode is not set in this case, as app threads are doing functional processing on partitioned inputs
+   Modified Oct 2026 JHB, add ENABLE_INPUT_MERGE cmd line flag. PushPackets() takes inputs from a min-heap keyed on arrival timestamp of each input's next packet (see InputMergeFirst() and InputMergeNext()), so packets from multiple inputs are pushed in global arrival order
+   Modified Oct 2026 JHB, support --compress_output gz|zst cmd line option to write gzip or zstd compressed jitter buffer and stream group output pcaps. Compressed inputs (e.g. -i xxx.pcap.gz) and compressed transcode outputs (e.g. -o xxx.pcap.zst) are handled by DSOpenPcap()
+   Modified Oct 2026 JHB, in PushPackets() detect duplicate packets with DSIsPacketDuplicateRing(), which looks back over a per stream ring of packet fingerprints instead of comparing with the previous packet only. Lookback defaults to DS_PKT_DUPLICATE_DEFAULT_LOOKBACK and can be set with --dup_lookback N cmd line option; N = 0 reverts to previous packet comparison
+   Modified Oct 2026 JHB, DS_PKT_DUPLICATE_DEFAULT_LOOKBACK is now zero, so fingerprint ring duplicate detection is used only if --dup_lookback N (N > 0) is entered
+   Modified Oct 2026 JHB, show pktlib fragment reassembly eviction and pool exhaustion stats in mediaMin summary stats, if non-zero
+   Modified Oct 2026 JHB, FindSession() looks up stream keys in a per thread open addressing hash table with precomputed 64-bit hashes, instead of comparing with every key found so far. Keys can be removed with RemoveSessionKey(), used when dynamic session creation fails and by DeleteSession() if MANAGE_HSESSIONS_DELETIONS is defined
+   Modified Oct 2026 JHB, add ENABLE_PUSH_BATCHING cmd line flag. PushPackets() accumulates packets across inputs and sessions in a per thread push batch and pushes them with one DSPushPackets() call per batch, with partial accept handling. See PushBatchAdd() and PushBatchFlush()
+   Modified Oct 2026 JHB, support --output_writers N cmd line option. PullPackets() enqueues output pcap records into per output rings and N writer threads drain them with DSWritePcapBuffered(), instead of app threads writing inline. See OutputWriterEnqueue() and OutputWriterThread()
+   Modified Oct 2026 JHB, replace usleep() polling with pktlib packet notify waits (DSWaitPacketNotify() in pktlib.h) in push queue full retries, stream group pull retries, AppThreadSync(), and ThreadWait(). Wait timeouts are the previous sleep times, so a missed signal behaves the same as polling
+   Modified Oct 2026 JHB, start p/m threads with DS_MEDIASERVICE_SPIN_THEN_BLOCK flag, so idle p/m threads block until packets are pushed instead of polling with uThreadEnergySaverSleepTime sleeps
+   Modified Oct 2026 JHB, with ROUND_ROBIN_SESSION_ALLOCATION flag in -dN cmd line entry, start p/m threads with DS_MEDIASERVICE_REBALANCE_THREADS flag to move sessions between p/m threads when their loads become uneven
+   Modified Oct 2026 JHB, with -nN cmd line entry (reuse inputs), start p/m threads with DS_MEDIASERVICE_BATCH_DECODE flag
+   Modified Oct 2026 JHB, output writer threads, OutputWriterEnqueue() ring full waits, and OutputWriterDetach() block on futexes instead of polling with usleep(). Output writer ring stats for attached rings are shown in 'd' key run-time debug output. See OutputWriterWait(), OutputWriterSignal(), and OutputWriterStats()
+   Modified Oct 2026 JHB, DS_MEDIASERVICE_SPIN_THEN_BLOCK is now opt-in, p/m threads are started with it only if ENABLE_SPIN_THEN_BLOCK flag is given in -dN cmd line entry
+   Modified Oct 2026 JHB, DS_MEDIASERVICE_REBALANCE_THREADS is no longer tied to ROUND_ROBIN_SESSION_ALLOCATION, p/m threads are started with it only if ENABLE_THREAD_REBALANCE flag is given in -dN cmd line entry
+   Modified Oct 2026 JHB, DS_MEDIASERVICE_BATCH_DECODE is no longer tied to -nN cmd line entry (reuse inputs), p/m threads are started with it only if ENABLE_BATCH_DECODE flag is given in -dN cmd line entry
+   Modified Oct 2026 JHB, p/m threads are started with DS_MEDIASERVICE_PIPELINE_DECODE if ENABLE_PIPELINE_DECODE flag is given in -dN cmd line entry
 */
 
 /* Linux header files */
@@ -226,6 +249,10 @@
 
 #include <signal.h>
 #include <assert.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>  /* output writer waits, JHB Oct 2026 */
 
 #include <algorithm>  /* bring in std::min and std::max */
 #include <fstream>
@@ -350,6 +377,23 @@ void DebugSetup(DEBUG_CONFIG* dbg_cfg);            /* lib debug config */
 /* I/O setup */
 
 void InputSetup(uint64_t cur_time, int thread_index);
+int InputTimeWindowSetup(int thread_index, int nStream);
+int InputReadAheadStart(int thread_index, int nStream);
+int InputReadAheadPop(INPUT_DATA_CACHE* pCache, int tId, int nStream);
+void InputReadAheadStop(int thread_index, int nStream);
+void InputReadAheadFree(int thread_index, int nStream);
+int OutputWritersStart();
+void OutputWritersStop();
+OUTPUT_WRITER_RING* OutputWriterFind(FILE* fp, int thread_index);
+OUTPUT_WRITER_RING* OutputWriterAttach(FILE* fp, int thread_index);
+void OutputWriterDetach(FILE* fp, int thread_index);
+void OutputWriterStats(int thread_index, char* szStats);
+int OutputWriterEnqueue(OUTPUT_WRITER_RING* ring, unsigned int uFlags, uint8_t* pkt_buf, int pkt_len, pcaprec_hdr_t* pcap_pkt_hdr);
+int InputMergeFirst(uint8_t* pkt_buf, int tId);
+void InputMergePeek(uint8_t* pkt_buf, int tId, int nStream);
+void InputMergeSift(int tId, int nPos);
+bool isInputMergeEarlier(int tId, int nStream1, int nStream2);
+int InputMergeNext(uint8_t* pkt_buf, int tId, int nStream, int push_cnt, int nPops);
 void JitterBufferOutputSetup(HSESSION hSessions[], HSESSION hSession, int thread_index);
 int OutputSetup(HSESSION hSessions[], HSESSION hSession, int thread_index);
 void StreamGroupOutputSetup(HSESSION hSession, int nStream, int thread_index);
@@ -364,6 +408,13 @@ void PmThreadSync(int thread_index);
 /* wrapper functions for pktlib DSPushPackets() and DSPullPackets(), including pcap read/write, session create, etc */
   
 int PushPackets(uint8_t* pkt_in_buf, HSESSION hSessions[], SESSION_DATA session_data[], int nSessions, uint64_t cur_time, int thread_index);
+
+/* push batch helper functions, used if ENABLE_PUSH_BATCHING flag is set in -dN cmd line entry */
+
+void PushPacketAccepted(HSESSION hSessions[], PUSH_BATCH_PKT* pPkt, uint64_t cur_time, int thread_index);
+bool PushBatchAdd(uint8_t* pkt_buf, int pkt_len, HSESSION hSessions[], PUSH_BATCH_PKT* pPkt, int thread_index);
+int PushBatchFlush(unsigned int uFlags_push, HSESSION hSessions[], uint64_t cur_time, int thread_index);
+bool isPushBatchPending(HSESSION hSession, int thread_index);
 int PullPackets(uint8_t* pkt_out_buf, HSESSION hSessions[], SESSION_DATA session_data[], unsigned int uFlags, unsigned int pkt_buf_len, uint64_t cur_time, int thread_index);
 
 /* I/O functions */
@@ -374,6 +425,7 @@ bool isNonIPPacket(uint16_t eth_protocol);
 /* packet helper functions */
 
 int isPortAllowed(uint16_t port, uint8_t port_type, uint8_t* pkt_buf, int pkt_len, uint8_t uProtocol, int nStream, uint64_t cur_time, int thread_index);
+int FlowPartition(uint8_t* pkt_buf, PKTINFO* PktInfo, int num_partitions);
 int PacketActions(uint8_t* pyld_data, uint8_t* pkt_buf, uint8_t protocol, int* p_pkt_len, unsigned int uFlags);
 
 /* create and manage packet/media threads */
@@ -522,6 +574,16 @@ char tmpstr[MAX_APP_STR_LEN];  /* large temporary string used for various purpos
       if (Mode & DISABLE_JITTER_BUFFER_OUTPUT_PCAPS) printf("  jitter buffer output pcaps disabled\n");
       if (Mode & ENABLE_STREAM_SDP_INFO) printf("  SDP in-stream info enabled\n");
       if (Mode & DISABLE_TERMINATE_STREAM_ON_BYE) printf("  SIP BYE message stream termination disabled\n");
+      if (Mode & ENABLE_FLOW_PARTITION) printf("  media flow partitioning across app threads enabled\n");
+      if (Mode & ENABLE_INPUT_MERGE) printf("  input merge in arrival timestamp order enabled\n");
+      if (Mode & ENABLE_PUSH_BATCHING) printf("  push batching enabled\n");
+      if (Mode & ENABLE_SPIN_THEN_BLOCK) printf("  p/m thread spin-then-block idle wait enabled\n");
+      if (Mode & ENABLE_THREAD_REBALANCE) printf("  p/m thread session rebalancing enabled\n");
+      if (Mode & ENABLE_BATCH_DECODE) printf("  p/m thread batched decoding enabled\n");
+      if (Mode & ENABLE_PIPELINE_DECODE) printf("  p/m thread pipelined decoding enabled\n");
+      if (nOutputCompression) printf("  %s compressed jitter buffer and stream group output pcaps enabled\n", nOutputCompression == 1 ? "gzip" : "zstd");
+      if (nDupLookback >= 0) printf("  duplicate packet detection lookback = %d\n", nDupLookback);
+      if (nOutputWriters > 0) printf("  %d output pcap writer thread%s enabled\n", min(nOutputWriters, OUTPUT_WRITER_MAX_THREADS), nOutputWriters > 1 ? "s" : "");
 
       if (Mode & ENABLE_DEBUG_STATS) printf("  debug info and stats enabled\n");
       if (Mode & ENABLE_DER_DECODING_STATS) printf("  DER decoding stats enabled\n");
@@ -558,7 +620,7 @@ char tmpstr[MAX_APP_STR_LEN];  /* large temporary string used for various purpos
    if (isMasterThread(thread_index)) {
 
       fStressTest = (Mode & CREATE_DELETE_TEST) || (Mode & CREATE_DELETE_TEST_PCAP);  /* set fStressTest if stress test options have been given */
-      fCapacityTest = num_app_threads > 1 || nReuseInputs;  /* set fCapacityTest if load/capacity options have been given */
+      fCapacityTest = (num_app_threads > 1 && !(Mode & ENABLE_FLOW_PARTITION)) || nReuseInputs;  /* set fCapacityTest if load/capacity options have been given. Multiple app threads with flow partitioning are not a capacity test, each thread processes its own share of input flows, JHB Oct 2026 */
 
       fAutoQuit = !(Mode & DISABLE_AUTOQUIT) && !fStressTest && !fRepeatIndefinitely && fInputsAllFinite;
 
@@ -629,7 +691,12 @@ char tmpstr[MAX_APP_STR_LEN];  /* large temporary string used for various purpos
 
       if (Mode & START_THREADS_FIRST) if (StartPacketMediaThreads(num_app_threads > 1 ? NUM_PKTMEDIA_THREADS : 1, cur_time, thread_index) < 0) goto cleanup;
 
+   /* start output writer threads if --output_writers entered. Must be done before app threads open outputs, JHB Oct 2026 */
+
+      OutputWritersStart();
+
       fThreadSync1 = true;  /* release any app threads waiting in AppThreadSync() */
+      DSSignalPacketNotify(DS_PKT_NOTIFY_APP);
 
    }  /* end of master thread section */
 
@@ -700,6 +767,7 @@ session_create:  /* note - label used only if test mode repeats are enabled */
       if (!(Mode & START_THREADS_FIRST)) if (StartPacketMediaThreads(num_app_threads > 1 ? NUM_PKTMEDIA_THREADS : 1, cur_time, thread_index) < 0) goto cleanup;
 
       fThreadSync2 = true;  /* release any app threads still waiting in AppThreadSync() */
+      DSSignalPacketNotify(DS_PKT_NOTIFY_APP);
    }
 
    if ((num_app_threads > 1 && (Mode & ENABLE_RANDOM_WAIT)) || (Mode & ENERGY_SAVER_TEST)) ThreadWait(0, cur_time, thread_index);  /* staggered start for threads */
@@ -888,6 +956,8 @@ cleanup:
 
    for (j=0; j<thread_info[thread_index].nInPcapFiles; j++) {
    
+      InputReadAheadFree(thread_index, j);  /* stop read-ahead thread and free ring mem, if any. Must be done before closing the input, JHB Oct 2026 */
+
       if (thread_info[thread_index].pcap_in[j]) {
 
          if (thread_info[thread_index].pcap_file_hdr[j]) {
@@ -905,6 +975,13 @@ cleanup:
          thread_info[thread_index].pcap_in[j] = NULL;
       }
 
+   /* free batch read mem. Done regardless of pcap_in[] status as inputs may have been closed on stream termination in PushPackets(), JHB Oct 2026 */
+
+      if (thread_info[thread_index].input_data_cache[j].batch_arena) free(thread_info[thread_index].input_data_cache[j].batch_arena);
+      if (thread_info[thread_index].input_data_cache[j].batch_recs) free(thread_info[thread_index].input_data_cache[j].batch_recs);
+      thread_info[thread_index].input_data_cache[j].batch_arena = NULL;
+      thread_info[thread_index].input_data_cache[j].batch_recs = NULL;
+
       #if 0
       if ((Mode & ENABLE_DER_STREAM_DECODE) && thread_info[thread_index].hDerStreams[j]) DSDeleteDerStream(thread_info[thread_index].hDerStreams[j]);
       #else
@@ -913,11 +990,16 @@ cleanup:
       if (thread_info[thread_index].hFile_ASN_XML[j]) fclose(thread_info[thread_index].hFile_ASN_XML[j]);
    }
 
+/* free push batch mem. Any packets remaining in the batch are discarded, as their sessions have been deleted, JHB Oct 2026 */
+
+   if (thread_info[thread_index].push_batch) free(thread_info[thread_index].push_batch);
+   thread_info[thread_index].push_batch = NULL;
+
 /* close jitter buffer output file descriptors (there may not be any if DISABLE_JITTER_BUFFER_OUTPUT_PCAPS is set on cmd line) */
 
    for (i=0; i<thread_info[thread_index].nSessionsCreated; i++) {
 
-      if (thread_info[thread_index].fp_pcap_jb[i]) { DSClosePcap(thread_info[thread_index].fp_pcap_jb[i], DS_CLOSE_PCAP_QUIET); thread_info[thread_index].fp_pcap_jb[i] = NULL; }
+      if (thread_info[thread_index].fp_pcap_jb[i]) { OutputWriterDetach(thread_info[thread_index].fp_pcap_jb[i], thread_index); DSClosePcap(thread_info[thread_index].fp_pcap_jb[i], DS_CLOSE_PCAP_QUIET); thread_info[thread_index].fp_pcap_jb[i] = NULL; }
 
    /* reset arrival timing stats */
 
@@ -964,7 +1046,10 @@ cleanup:
 
    /* close output file */
 
-      if (thread_info[thread_index].uOutputType[thread_info[thread_index].nOutFiles] == PCAP) DSClosePcap(thread_info[thread_index].out_file[i], DS_CLOSE_PCAP_QUIET);
+      if (thread_info[thread_index].uOutputType[thread_info[thread_index].nOutFiles] == PCAP) {
+         OutputWriterDetach(thread_info[thread_index].out_file[i], thread_index);  /* drain output writer ring, if any, JHB Oct 2026 */
+         DSClosePcap(thread_info[thread_index].out_file[i], DS_CLOSE_PCAP_QUIET);
+      }
       else DSSaveDataFile(DS_GM_HOST_MEM, &thread_info[thread_index].out_file[i], NULL, (uintptr_t)NULL, 0, DS_CLOSE | DS_DATAFILE_USE_SEMAPHORE, NULL);
 
       thread_info[thread_index].out_file[i] = NULL;
@@ -979,6 +1064,7 @@ cleanup:
 
       if (thread_info[thread_index].fp_pcap_group[i]) {
 
+         OutputWriterDetach(thread_info[thread_index].fp_pcap_group[i], thread_index);  /* drain output writer ring, if any, JHB Oct 2026 */
          DSClosePcap(thread_info[thread_index].fp_pcap_group[i], DS_CLOSE_PCAP_QUIET);
 
          if (!fGroupOutputNoCopy) {  /* copy pcap from group output path to local subfolder. This is for documentation compatibility and convenience, can be overridden by using --group_pcap_nocopy instead of --group_pcap on command line */
@@ -1067,7 +1153,9 @@ cleanup:
    }
 
    unsigned int nOrphansRemoved, nMaxListFragments;
+   PKT_FRAGMENT_STATS FragmentStats = { 0 };
 
+   DSPktGetFragmentStats(0, &FragmentStats);  /* get fragment eviction and pool exhaustion stats before removing orphans, JHB Oct 2026 */
    nOrphansRemoved = DSPktRemoveFragment(NULL, 0, &nMaxListFragments);
 
 /* print final mediaMin stats - session summary, stream group output timing */
@@ -1096,6 +1184,8 @@ cleanup:
       sprintf(&tmpstr[strlen(tmpstr)], ", max on list = ");
       sprintf(&tmpstr[strlen(tmpstr)], "%u", nMaxListFragments);
 
+      if (FragmentStats.timeout_evictions || FragmentStats.pool_evictions || FragmentStats.pool_exhausted) sprintf(&tmpstr[strlen(tmpstr)], ", evicted timeout/pool = %u/%u, pool exhausted = %u", FragmentStats.timeout_evictions, FragmentStats.pool_evictions, FragmentStats.pool_exhausted);  /* show only if non-zero, JHB Oct 2026 */
+
       sprintf(&tmpstr[strlen(tmpstr)], "\n%s%sOversize non-fragmented =", tabstr, tabstr);
       for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].num_oversize_nonfragmented_packets[i]);
 
@@ -1123,6 +1213,12 @@ cleanup:
       sprintf(&tmpstr[strlen(tmpstr)], ", Unhandled =");
       for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].num_unhandled_rtp_packets[i]);
 
+      if ((Mode & ENABLE_FLOW_PARTITION) && num_app_threads > 1) {  /* media packets in flows handled by other app threads, JHB Oct 2026 */
+
+         sprintf(&tmpstr[strlen(tmpstr)], "\n%s%sFlow partition %d of %d, other partition media =", tabstr, tabstr, thread_index, num_app_threads);
+         for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].num_flow_partition_skipped[i]);
+      }
+
       sprintf(&tmpstr[strlen(tmpstr)], "\n%s%sRedundant discards TCP =", tabstr, tabstr);
       for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].tcp_redundant_discards[i]);  /* display/log number of redundant TCP retransmissions discarded, if any */
 
@@ -1137,6 +1233,32 @@ cleanup:
       if (fShow_sha1sum) MediaOutputFileOps("sha1sum", tmpstr, STR_APPEND, thread_index);
       if (fShow_sha512sum) MediaOutputFileOps("sha512sum", tmpstr, STR_APPEND, thread_index);
 
+   /* if --read_ahead entered, display read-ahead ring stats, JHB Oct 2026 */
+
+      if (nReadAheadDepth > 0) {
+
+         sprintf(&tmpstr[strlen(tmpstr)], "%sinput read-ahead [input]", tabstr);
+
+         sprintf(&tmpstr[strlen(tmpstr)], "\n%s%sring occupancy avg/max (depth %d) =", tabstr, tabstr, min(nReadAheadDepth, INPUT_READ_AHEAD_MAX_DEPTH));
+         for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%4.2f/%u", i, thread_info[thread_index].read_ahead_slots[i] ? 1.0*thread_info[thread_index].read_ahead_occupancy[i]/thread_info[thread_index].read_ahead_slots[i] : 0.0, thread_info[thread_index].read_ahead_max_occupancy[i]);
+
+         sprintf(&tmpstr[strlen(tmpstr)], ", stalls =");
+         for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].read_ahead_stalls[i]);
+
+         sprintf(&tmpstr[strlen(tmpstr)], ", full waits =");
+         for (i=0; i<thread_info[thread_index].nInPcapFiles; i++) sprintf(&tmpstr[strlen(tmpstr)], " [%d]%u", i, thread_info[thread_index].read_ahead_full_waits[i]);
+
+         strcat(tmpstr, "\n");
+      }
+
+   /* if --output_writers entered, display output writer ring stats, JHB Oct 2026 */
+
+      if (nOutputWriters > 0) { strcat(tmpstr, tabstr); OutputWriterStats(thread_index, tmpstr); }
+
+   /* if ENABLE_PUSH_BATCHING flag is set, display push batch stats, JHB Oct 2026 */
+
+      if (Mode & ENABLE_PUSH_BATCHING) sprintf(&tmpstr[strlen(tmpstr)], "%spush batches = %u, avg packets per batch = %4.2f, partial accepts = %u\n", tabstr, thread_info[thread_index].push_batch_pushes, thread_info[thread_index].push_batch_pushes ? 1.0*thread_info[thread_index].push_batch_pkts/thread_info[thread_index].push_batch_pushes : 0.0, thread_info[thread_index].push_batch_partial_accepts);
+
    /* if specified, display packet arrival stats, JHB Aug 2023 */
 
       if (Mode & SHOW_PACKET_ARRIVAL_STATS) {
@@ -1224,6 +1346,8 @@ cleanup:
 
       DSConfigMediaService(NULL, DS_MEDIASERVICE_EXIT | DS_MEDIASERVICE_THREAD, 0, NULL, NULL);  /* close packet/media thread(s), JHB Dec 2022 */
 
+      OutputWritersStop();  /* stop output writer threads, if any, JHB Oct 2026 */
+
       if (hPlatform != -1) DSFreePlatform((intptr_t)hPlatform);  /* free DirectCore platform handle. See DSAssignPlatform() comments above */
 
       DSCloseLogging(0);  /* close event logging. See diaglib.h */
@@ -1260,28 +1384,48 @@ unsigned int i, count = 0;
 void AppThreadSync(unsigned int mode, bool* fThreadSync, int thread_index) {
 
 static unsigned int uThreadList = 0;  /* bitwise "arrival list" of threads used in WAIT_FOR_ALL_THREADS mode */
+uint32_t notify_seq;
 
    #define  WAIT_1MSEC 1000  /* 1000 usec */
 
+/* waits are DSWaitPacketNotify() with DS_PKT_NOTIFY_APP event, which is signaled when sync flags or the arrival list change. Timeout is the previous polling interval, JHB Oct 2026 */
+
    if (mode & WAIT_FOR_MASTER_THREAD) {  /* non-master threads wait for master thread (i.e. wait for master thread to perform initialization, housekeeping, one-time only task, etc) */
 
-      while (!isMasterThread(thread_index) && fThreadSync && !*fThreadSync) usleep(WAIT_1MSEC);  /* master thread sets global flag pointed to by *fThreadSync after finishing it's task */
+      while (!isMasterThread(thread_index) && fThreadSync) {  /* master thread sets global flag pointed to by *fThreadSync after finishing it's task */
+
+         notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_APP);
+         if (*fThreadSync) break;
+         DSWaitPacketNotify(DS_PKT_NOTIFY_APP, notify_seq, WAIT_1MSEC);
+      }
    }
 
    if (mode & WAIT_FOR_ALL_THREADS) {  /* wait until all threads have arrived */
 
       __sync_or_and_fetch(&uThreadList, 1 << thread_index);  /* set bit in list indicating thread has arrived */
+      DSSignalPacketNotify(DS_PKT_NOTIFY_APP);
 
       if (isMasterThread(thread_index)) {
 
-         while (count_threads(&uThreadList) < num_app_threads) usleep(WAIT_1MSEC);  /* wait until everyone is here */
+         while (true) {  /* wait until everyone is here */
+
+            notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_APP);
+            if (count_threads(&uThreadList) >= num_app_threads) break;
+            DSWaitPacketNotify(DS_PKT_NOTIFY_APP, notify_seq, WAIT_1MSEC);
+         }
 
          __sync_lock_test_and_set(&uThreadList, 0);  /* master thread clears the arrival list, leaving it ready for reuse */
          #if 1  /* added release, was not an issue as last AppThreadSync() call was only one with WAIT_FOR_ALL_THREADS, JHB Jan 2023 */
          __sync_lock_release(&uThreadList);
          #endif
+         DSSignalPacketNotify(DS_PKT_NOTIFY_APP);
+      }
+      else while (true) {  /* non-master app threads wait for the list to be reset */
+
+         notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_APP);
+         if (!__sync_fetch_and_add(&uThreadList, 0)) break;
+         DSWaitPacketNotify(DS_PKT_NOTIFY_APP, notify_seq, WAIT_1MSEC);
       }
-      else while (__sync_fetch_and_add(&uThreadList, 0)) usleep(WAIT_1MSEC);  /* non-master app threads wait for the list to be reset */
    }
 }
 
@@ -1306,7 +1450,7 @@ uint8_t before_sync, after_sync;
 
 #define MAX_KEYS 512  /* increased from 128, JHB Jun 2024 */
 
-/* keys are unique per session; not hashes. No run-time locks are needed */ 
+/* keys are unique per session. Each app thread has its own key table, so no run-time locks are needed */ 
 
 #define INCLUDE_PYLDTYPE_IN_KEY
 #ifdef INCLUDE_PYLDTYPE_IN_KEY
@@ -1315,9 +1459,74 @@ uint8_t before_sync, after_sync;
 #define KEY_LENGTH 36   /* each key is up to 36 bytes (ipv6 address size (2*16) + udp port size (2*2)) */
 #endif
 
-uint8_t keys[MAX_APP_THREADS][MAX_KEYS][KEY_LENGTH] = {{{ 0 }}};
+#define KEY_TABLE_SIZE 1024  /* open addressing hash table size, must be a power of 2 and larger than MAX_KEYS to keep probe sequences short, JHB Oct 2026 */
+
+typedef struct {
+
+  uint64_t hash;              /* precomputed 64-bit hash of IP addresses and ports, zero indicates an empty slot */
+  uint8_t  len;
+  uint8_t  key[KEY_LENGTH];   /* zero padded */
+
+} SESSION_KEY;
+
+SESSION_KEY keys[MAX_APP_THREADS][KEY_TABLE_SIZE] = {{{ 0 }}};
 uint32_t nKeys[MAX_APP_THREADS] = { 0 };
 
+SESSION_KEY new_key[MAX_APP_THREADS] = {{ 0 }};  /* most recent new key found by FindSession() */
+SESSION_KEY session_keys[MAX_APP_THREADS][MAX_SESSIONS_THREAD] = {{{ 0 }}};  /* key for each dynamic session index, used to remove keys when sessions are deleted */
+
+/* key hash table helper functions. Notes, JHB Oct 2026:
+
+  -linear probing. Only IP addresses and ports are hashed, so all keys for a stream (e.g. with different RTP payload types) are in the same probe sequence. This allows DTMF packets, whose keys exclude payload type, to match an existing session
+  -the stored 64-bit hash is compared before key bytes; memcmp() is only needed for hash matches
+  -keys are removed with backward shift deletion (no tombstones), so lookup cost does not grow after many session creates and deletes
+*/
+
+static inline uint64_t KeyHash(uint8_t* key, int len) {
+
+uint64_t h = 0xcbf29ce484222325ULL;  /* FNV-1a */
+
+   for (int i=0; i<len; i++) h = (h ^ key[i]) * 0x100000001b3ULL;
+
+   return h ? h : 1;
+}
+
+static int FindKey(SESSION_KEY* table, uint64_t hash, uint8_t* key, int len) {  /* return slot of matching key, or -(empty slot + 1) if not found */
+
+unsigned int i = hash & (KEY_TABLE_SIZE-1);
+
+   while (table[i].hash) {
+
+      if (table[i].hash == hash && !memcmp(table[i].key, key, len)) return i;
+      i = (i + 1) & (KEY_TABLE_SIZE-1);
+   }
+
+   return -(int)i - 1;
+}
+
+int RemoveSessionKey(SESSION_KEY* pKey, int thread_index) {  /* remove a key, returns 1 if removed, 0 if not found */
+
+SESSION_KEY* table = keys[thread_index];
+unsigned int i, j, home;
+int slot;
+
+   if (!pKey->hash || (slot = FindKey(table, pKey->hash, pKey->key, pKey->len)) < 0) return 0;
+
+   i = slot;
+
+   for (j = (i + 1) & (KEY_TABLE_SIZE-1); table[j].hash; j = (j + 1) & (KEY_TABLE_SIZE-1)) {  /* backward shift: move following entries in the probe sequence into the hole if their home slot allows it */
+
+      home = table[j].hash & (KEY_TABLE_SIZE-1);
+
+      if (((j - home) & (KEY_TABLE_SIZE-1)) >= ((j - i) & (KEY_TABLE_SIZE-1))) { table[i] = table[j]; i = j; }
+   }
+
+   memset(&table[i], 0, sizeof(SESSION_KEY));
+   nKeys[thread_index]--;
+
+   return 1;
+}
+
 /* FindSession() looks for new streams in the specified packet and returns 1 if found. Notes:
 
   -finding a new stream means a new session should be created "on the fly" (i.e. dynamic session creation). A new stream is determined by (i) new IP addr:port header and/or (ii) new RTP payload type
@@ -1330,9 +1539,9 @@ uint32_t nKeys[MAX_APP_THREADS] = { 0 };
 
 int FindSession(uint8_t* pkt, int ip_hdr_len, uint8_t rtp_pyld_type, int pyld_size, int thread_index) {
 
-int len, version = pkt[0] >> 4;
+int len, slot, version = pkt[0] >> 4;
 uint8_t key[KEY_LENGTH] = { 0 };
-bool fFoundMatch = false;
+uint64_t hash;
 
 /* form key from IP addresses and ports */
 
@@ -1340,6 +1549,8 @@ bool fFoundMatch = false;
    memcpy(&key[len], &pkt[ip_hdr_len], 2*sizeof(unsigned short int));  /* copy both UDP ports to key */
    len += 2*sizeof(unsigned short int);
 
+   hash = KeyHash(key, len);  /* hash addresses and ports only, see key hash table notes above */
+
    #ifdef INCLUDE_PYLDTYPE_IN_KEY
 
 /* copy RTP payload type to key (but not DTMF packets, which must match an existing session, JHB May 2019) */
@@ -1348,32 +1559,37 @@ bool fFoundMatch = false;
    #endif
 
 /* see if we already know about this stream */
-   
-   for (unsigned int i=0; i<nKeys[thread_index]; i++) if (!memcmp(keys[thread_index][i], key, len)) { fFoundMatch = true; break; }
 
-   if (!fFoundMatch) {  /* new stream */
+   if ((slot = FindKey(keys[thread_index], hash, key, len)) >= 0) return 0;  /* existing session: return 0 */
 
-      memcpy(keys[thread_index][nKeys[thread_index]], key, len);
-      if (nKeys[thread_index] >= MAX_KEYS) return -1;  /* error condition */
-      else nKeys[thread_index]++;
-   }
+   if (nKeys[thread_index] >= MAX_KEYS) return -1;  /* error condition */
+
+/* new stream, add key to table */
+
+   slot = -slot - 1;
+
+   keys[thread_index][slot].hash = hash;
+   keys[thread_index][slot].len = len;
+   memcpy(keys[thread_index][slot].key, key, KEY_LENGTH);
+
+   new_key[thread_index] = keys[thread_index][slot];  /* save in case session creation fails and the key needs to be removed, or to associate with a created session */
 
    #if 0
    static int cnt = 0;
-   printf("check_for_new_sesion: cnt = %d, found_match = %d, nKeys = %d, fInitKeys = %d, len = %d\n", cnt++, found_match, nKeys[thread_index], fInitKeys, len);
+   printf("check_for_new_sesion: cnt = %d, slot = %d, nKeys = %d, len = %d\n", cnt++, slot, nKeys[thread_index], len);
    printf("key value: ");
-   for (i = 0; i < KEY_LENGTH; i++) printf("%02x ", key[thread_index][i]);
+   for (int i = 0; i < KEY_LENGTH; i++) printf("%02x ", key[i]);
    printf("\n");
    #endif
 
-   if (!fFoundMatch) return nKeys[thread_index];  /* new session: return number of sessions found so far */
-   else return 0;  /* existing session: return 0 */
+   return ++nKeys[thread_index];  /* new session: return number of sessions found so far */
 }
 
 void ResetDynamicSession_info(int thread_index) {
 
    nKeys[thread_index] = 0;
-   memset(keys[thread_index], 0, MAX_KEYS*KEY_LENGTH);
+   memset(keys[thread_index], 0, sizeof(keys[0]));
+   memset(session_keys[thread_index], 0, sizeof(session_keys[0]));
 }
 
 /* codec types currently supported in codec estimation algorithm (used by dynamic session creation). We use shorthand enums equivalent to SigSRF enum definitions in shared_include/codec.h. When modifying mediaMin source, add codec types as needed but always maintain consistency with codec.h */
@@ -2493,6 +2709,8 @@ err_msg:
       if (!fStressTest && !fCapacityTest) {
 
          sprintf(session->szSessionName, "%s%s", szStreamGroupWavOutputPath, thread_info[thread_index].szGroupName[nStream]);  /* set session->szSessionName for wav outputs. Note we currently don't allow wav outputs during capacity test */
+
+         if (num_app_threads > 1) sprintf(&session->szSessionName[strlen(session->szSessionName)], "_t%d", thread_index);  /* multiple app threads without capacity test means ENABLE_FLOW_PARTITION is set; each thread has its own wav outputs for the same input, so add the same thread suffix as group names, JHB Oct 2026 */
       }
 
       if (nReuse) sprintf(&group_id[strlen(group_id)], "_n%d", nReuse);  /* add the re-use count, if applicable. nReuse is typically non-zero only for capacity or stress tests */
@@ -2696,7 +2914,7 @@ err_msg:
 
          if (!fStressTest && !fCapacityTest && nRepeatsRemaining[thread_index] == -1) {  /* specify N-channel wav output. Disable if load/capacity or stress test options are active. Don't enable if repeat is active, otherwise thread preemption warnings will show up in the event log (because N-channel processing takes a while). nRepeatsRemaining is -1 if there is no -RN cmd line entry (because cmd_line_interface.c sets default value of nRepeats to -1), JHB Jun 2019 */
 
-            session->group_term.group_mode |= STREAM_GROUP_WAV_OUT_STREAM_MULTICHANNEL;
+            session->group_term.group_mode |= STREAM_GROUP_WAV_OUT_STREAM_MULTICHANNEL;  /* N-channel wav file is named from session->szSessionName, which includes a "_tN" suffix with ENABLE_FLOW_PARTITION and multiple app threads, JHB Oct 2026 */
             fNChannelWavOutput = true;
          }
 
@@ -2866,6 +3084,8 @@ int nStream;
       thread_info[thread_index].map_stream_to_session_indexes[nStream][nSessionIndex] = -1;
       thread_info[thread_index].nSessions[nStream]--;
    }
+
+   if (nSessionIndex < MAX_SESSIONS_THREAD && RemoveSessionKey(&session_keys[thread_index][nSessionIndex], thread_index)) memset(&session_keys[thread_index][nSessionIndex], 0, sizeof(SESSION_KEY));  /* remove session's stream key so a restarted stream is detected as a new session, JHB Oct 2026 */
    #endif
 
    hSessions[nSessionIndex] |= SESSION_MARKED_AS_DELETED;  /* mark the session as deleted in our session handles array -- we keep its stats available, but no longer call pktlib APIs using its session handle. Note this disables hSessions[] usage in many places, JHB Jan 2020 */
@@ -2889,6 +3109,8 @@ int nStream;
      -packet/media worker threads handle duplicated RTP packets
 */
 
+static uint8_t queue_full_warning[MAX_SESSIONS_THREAD] = { 0 };  /* push queue full warning counters, indexed by session handle. Shared by PushPackets() and PushBatchFlush(), JHB Oct 2026 */
+
 int PushPackets(uint8_t* pkt_buf, HSESSION hSessions[], SESSION_DATA session_data[], int nSessions, uint64_t cur_time, int thread_index) {
 
 int i, j, n, pkt_info_ret_val = 0;
@@ -2899,7 +3121,6 @@ unsigned int uFlags_push = DS_PUSHPACKETS_IP_PACKET
                            ;
 int chnum, push_cnt = 0;
 int session_push_cnt[128] = { 0 };
-static uint8_t queue_full_warning[MAX_SESSIONS_THREAD] = { 0 };
 
 uint64_t wait_time;
 int auto_adj_push_count = 0;
@@ -2914,6 +3135,8 @@ int pkt_len;
 uint16_t eth_protocol, block_type;
 PKTINFO PktInfo;  /* struct in pktlib.h */
 pcaprec_hdr_t pcap_rec_hdr;
+bool fInputRead;
+int nMergePops = 0;
 
 #define tId thread_index  /* short hand */
 
@@ -2924,10 +3147,12 @@ pcaprec_hdr_t pcap_rec_hdr;
 static int num_pcap_packets = 0;
 #endif
 
-   for (j=0; j<thread_info[thread_index].nInPcapFiles; j++) {
+   for (j=(Mode & ENABLE_INPUT_MERGE) ? InputMergeFirst(pkt_buf, tId) : 0; j >= 0 && j<thread_info[thread_index].nInPcapFiles; j = thread_info[tId].fInputMerge ? InputMergeNext(pkt_buf, tId, j, push_cnt, ++nMergePops) : j+1) {  /* if input merge is active, inputs are taken in order of next packet arrival timestamp, otherwise round-robin order, JHB Oct 2026 */
 
       if (thread_info[thread_index].pcap_in[j] != NULL) {
 
+         fInputRead = false;
+
          if (Mode & AUTO_ADJUST_PUSH_TIMING) {
             auto_adj_push_count = 0;
             if (!average_push_rate[thread_index]) goto push_ctrl;  /* dynamically adjust average push rate (APR) if auto-adjust push rate is enabled */
@@ -2935,6 +3160,8 @@ static int num_pcap_packets = 0;
 
 next_packet:  /* next packet input */
 
+         if (fInputRead && thread_info[tId].fInputMerge) continue;  /* input merge active: after each input packet is consumed, go back to the merge heap for the input with the earliest next packet, JHB Oct 2026 */
+
          //#define STRESS_DEBUG
          #ifdef STRESS_DEBUG
          if (nRepeatsRemaining[tId] >= 0 && thread_info[tId].num_rtp_packets[j] > 1000) pkt_len = 0;
@@ -2948,6 +3175,7 @@ next_packet:  /* next packet input */
          /* get next input */
 
             pkt_len = GetInputData(pkt_buf, tId, j, &pcap_rec_hdr, &eth_protocol, &block_type);
+            fInputRead = true;
 
          /* process non-zero length packets */
   
@@ -3024,7 +3252,7 @@ next_packet:  /* next packet input */
 
             /* check for duplicated packets */
 
-               if (DSIsPacketDuplicate((unsigned int)0, &PktInfo, &thread_info[tId].PktInfo[j], &thread_info[tId].packet_number[j])) {
+               if (thread_info[tId].dup_ring[j].lookback > 0 ? DSIsPacketDuplicateRing(&thread_info[tId].dup_ring[j], (unsigned int)0, pkt_buf, &PktInfo) : DSIsPacketDuplicate((unsigned int)0, &PktInfo, &thread_info[tId].PktInfo[j], &thread_info[tId].packet_number[j])) {  /* look back over stream's fingerprint ring, or if --dup_lookback 0 entered compare with previous packet, JHB Oct 2026 */
 
                   if (PktInfo.protocol == TCP) thread_info[tId].tcp_redundant_discards[j]++;  /* increment number of redundant TCP transmissions discarded for input stream */
                   else thread_info[tId].udp_redundant_discards[j]++;  /* increment number of redundant UDP packets discarded for input stream */
@@ -3156,6 +3384,7 @@ next_packet:  /* next packet input */
 
             /* no input repeats - close the input and set stream handle to NULL so it's no longer operated on */
   
+               InputReadAheadFree(tId, j);  /* stop read-ahead thread before closing the input, JHB Oct 2026 */
                if (thread_info[tId].pcap_in[j]) DSClosePcap(thread_info[tId].pcap_in[j], DS_CLOSE_PCAP_QUIET);
                thread_info[tId].pcap_in[j] = NULL;
 
@@ -3183,7 +3412,11 @@ next_packet:  /* next packet input */
 
             /* note that wrapping a pcap will typically cause warning messages about "large negative" timestamp and sequence number jumps, JHB Mar 2020 */
 
+               InputReadAheadStop(tId, j);  /* stop read-ahead thread (if any) before rewinding, JHB Oct 2026 */
                DSOpenPcap(NULL, DS_READ | DS_OPEN_PCAP_RESET, &thread_info[tId].pcap_in[j], NULL, "");  /* seek to start of first pcap record */
+               thread_info[tId].input_data_cache[j].batch_count = thread_info[tId].input_data_cache[j].batch_index = 0;  /* discard any remaining batch read records, JHB Oct 2026 */
+               InputTimeWindowSetup(tId, j);  /* re-apply --start_time and --stop_time, if any, JHB Oct 2026 */
+               if (thread_info[tId].input_data_cache[j].read_ahead) InputReadAheadStart(tId, j);  /* restart read-ahead */
 
                app_printf(APP_PRINTF_NEW_LINE | APP_PRINTF_PRINT_ONLY, cur_time, thread_index, "mediaMin INFO: pcap %s wraps", MediaParams[thread_info[tId].cmd_line_input_index[j]].Media.inputFilename);
 
@@ -3629,6 +3862,12 @@ rtp_packet_processing:
 
          pkt_ignore_count = 0;
          last_ignore_str_len = 0;
+
+         if ((Mode & ENABLE_FLOW_PARTITION) && FlowPartition(pkt_buf, &PktInfo, num_app_threads) != thread_index) {  /* media flow is handled by another app thread. SIP, SDP, and other non-media packets have already been processed above, so all app threads have the same SDP info, JHB Oct 2026 */
+
+            thread_info[tId].num_flow_partition_skipped[j]++;
+            goto next_packet;
+         }
          bool fPacketHandled = false;
 
          bool fShowWarnings = (Mode & ENABLE_DEBUG_STATS) != 0;
@@ -3745,11 +3984,12 @@ check_for_duplicated_headers:
                      nSessions++;
                      fNewSession = true;
                      if (!fFirstConsoleMediaOutput) fFirstConsoleMediaOutput = true;
+
+                     if (thread_info[tId].nSessionsCreated > 0 && thread_info[tId].nSessionsCreated <= MAX_SESSIONS_THREAD) session_keys[tId][thread_info[tId].nSessionsCreated-1] = new_key[tId];  /* associate key with session index, JHB Oct 2026 */
                   }
                   else {  /* if CreateDynamicSession() returns no session created (no errors, information only, return value 0), or error or problem of some type (return value -1), remove the key created by FindSession() */
 
-                     nKeys[tId]--;
-                     memset(keys[tId][nKeys[tId]], 0, KEY_LENGTH);
+                     RemoveSessionKey(&new_key[tId], tId);
 
                      if (ret_val == -2) { thread_info[tId].init_err = true; return -1; }
                   }
@@ -3835,12 +4075,36 @@ check_for_duplicated_headers:
 
                   fPacketHandled = true;
 
+                  PUSH_BATCH_PKT PushPkt = { i, j, chnum, PktInfo.rtp_ssrc, PktInfo.rtp_timestamp, PktInfo.rtp_pyld_len, msec_timestamp_fp };  /* info needed after the packet is accepted, JHB Oct 2026 */
+
+                  if (thread_info[tId].push_batch && !(uFlags_push & DS_PUSHPACKETS_ENABLE_RFC7198_DEDUP)) {  /* push batching enabled: add packet to app thread push batch, see push batch notes near PushBatchFlush(), JHB Oct 2026 */
+
+                     if (!PushBatchAdd(pkt_buf, pkt_len, hSessions, &PushPkt, thread_index)) {  /* batch is full, push it */
+
+                        if (PushBatchFlush(uFlags_push, hSessions, cur_time, thread_index) < 0) return -1;
+
+                        if (!PushBatchAdd(pkt_buf, pkt_len, hSessions, &PushPkt, thread_index)) {  /* packet/media thread queues are full and batch still holds packets not accepted */
+
+                           thread_info[tId].input_data_cache[j].uFlags = CACHE_READ;  /* unable to push this packet, try again later. Keep the packet in cache */
+
+                           continue;  /* move to next session */
+                        }
+                     }
+
+                     session_push_cnt[i]++;  /* packets in the batch are counted as pushed for push rate purposes; push counter and stats are updated when they're accepted */
+                     push_cnt++;
+
+                     break;  /* break out of nSessions loop, the packet should match no other sessions */
+                  }
+
 push:
         #ifdef VLC_CAPTURE_DEBUG
         int rtp_seqnum = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_SEQNUM, pkt_buf, -1, NULL, NULL);
         if (rtp_seqnum > 37810 && rtp_seqnum < 37825) printf("\n *** pushing rtp seqnum %d \n", rtp_seqnum);
         #endif
 
+                  uint32_t notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_INPUT_SPACE);  /* get notify sequence number before pushing, in case we have to wait for queue space, JHB Oct 2026 */
+
                   int ret_val = DSPushPackets(uFlags_push, pkt_buf, &pkt_len, &hSessions[i], 1);  /* push packet to packet/media thread queue */
 
                   if ((uFlags_push & DS_PUSHPACKETS_ENABLE_RFC7198_DEDUP) && (ret_val & DS_PUSHPACKETS_ENABLE_RFC7198_DEDUP)) goto next_packet;  /* if we ask DSPushPackets() to look for duplicate packets and it finds one, move on to next packet. Normally packet/media worker threads handle this using the -lN cmd line input (no entry is a lookback of 1 packet, otherwise N specifies the lookback) */
@@ -3848,7 +4112,7 @@ push:
                   if (!ret_val) {  /* push queue is full, try waiting and pushing the packet again */
 
                      uint32_t uSleepTime = max(1000, (int)(RealTimeInterval[0]*1000));
-                     usleep(uSleepTime);
+                     DSWaitPacketNotify(DS_PKT_NOTIFY_INPUT_SPACE, notify_seq, uSleepTime);  /* wait for a packet/media thread to dequeue packets, up to the previous sleep time, JHB Oct 2026 */
 
                      if (retry_count++ < 3) goto push;  /* max retries */
                      else {
@@ -3871,78 +4135,9 @@ push:
                   else {  /* packet was successfully pushed */
 
                      session_push_cnt[i]++;
-                     thread_info[tId].pkt_push_ctr++;
                      push_cnt++;
 
-                  /* update stream stats with first packet info */
-
-                     for (int k=0; k<thread_info[tId].num_stream_stats; k++) if (chnum == thread_info[tId].StreamStats[k].chnum) {  /* find channel in StreamStats[] */
-
-                        if (!(thread_info[tId].StreamStats[k].uFlags & STREAM_STAT_FIRST_PKT)) {
-
-                           thread_info[tId].StreamStats[k].first_pkt_ssrc = PktInfo.rtp_ssrc;  /* get first packet RTP SSRC */
-                           thread_info[tId].StreamStats[k].first_pkt_usec = DSGetLogTimestamp(NULL, DS_EVENT_LOG_UPTIME_TIMESTAMPS, 0, 0);  /* get usec since app thread start */
-
-                           #if 0  /* debug */
-                           printf("\n *** stream stat %d, updating ch %d, hSessions[%d] = %d, term = %d, ssrc = 0x%x, usec = %llu \n", k, chnum, i, hSessions[i], thread_info[tId].StreamStats[k].term, thread_info[tId].StreamStats[k].first_pkt_ssrc, (long long unsigned int)thread_info[tId].StreamStats[k].first_pkt_usec);
-                           #endif
-
-                           thread_info[tId].StreamStats[k].uFlags |= STREAM_STAT_FIRST_PKT;  /* set first packet flag */
-                        }
-
-                        break;  /* stop searching after channel found */
-                     }
-
-                     if (queue_full_warning[hSessions[i]]) queue_full_warning[hSessions[i]] = 0;  /* reset queue full warning if needed */
-
-                  /* if specified, calculate packet arrival timing stats, JHB Aug 2023:
-                   
-                     -objective is to measure delta and jitter with respect to ptime, and get a handle on whether packet rate is consistently fast or slow. Wireshark averages include SID packets which obscures accurate reading on things like media playout servers
-                     -only calculate for successive media packets and SID packets that immediately follow a media packet, and omit consecutive SID, DTMF packets
-                     -currently we have a 1/2 sec limit on gaps due to packet loss or input pauses, anything larger than that is not counted
-                     -currently these stats are not reset in repeat mode
-                     -to-do: capacity tests
-                  */
-
-                     if (Mode & SHOW_PACKET_ARRIVAL_STATS) {
-
-                        float delta_timestamp,
-                              #ifdef RTP_TIMESTAMP_STATS
-                              Fs = DSGetSessionInfo(hSessions[i], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_SAMPLE_RATE, 1, NULL),  /* get session codec sampling rate in Hz */
-                              #endif
-                              ptime = DSGetSessionInfo(hSessions[i], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_PTIME, 1, NULL);  /* get session ptime in msec */
-
-                        #define MAX_STATS_GAP 25*ptime
-
-                        if (thread_info[tId].last_rtp_pyld_len[i] > 8 && (delta_timestamp = msec_timestamp_fp - thread_info[tId].last_msec_timestamp[i]) < MAX_STATS_GAP) {  /* omit DTMFs and SIDs, gaps larger than 500 msec (for 20 sec nominal ptime). Note the payload len check also ensures the first delta values will not be something - zero */
-
-                           thread_info[tId].arrival_avg_delta[i] += delta_timestamp;
-
-                           thread_info[tId].arrival_avg_jitter[i] += fabsf(delta_timestamp - ptime);
-
-                           thread_info[tId].arrival_avg_delta_clock[i] += (cur_time - thread_info[tId].first_pkt_time[j])/(thread_info[tId].num_arrival_stats_pkts[i]+1)/1000.0;  /* in msec */
-
-                           #ifdef RTP_TIMESTAMP_STATS  /* can be enabled in mediaMin.h for RTP timestamp stats and debug. Not normally used as timestamps are unlikely to be in correct order until processing by pktlib jitter buffer, JHB Mar 2025 */
-                           thread_info[tId].rtp_timestamp_avg_delta[i] += 1000*(PktInfo.rtp_timestamp - thread_info[tId].last_rtp_timestamp[i])/Fs;  /* in msec */
-                           #endif
-
-                           thread_info[tId].num_arrival_stats_pkts[i]++;
-
-                           #if 0
-                           static int count[10] = { 0 };
-                           if (count[i]++ < 50) printf("\n[%d]%d msec_timestamp_fp = %4.2f, delta_timestamp = %4.2f, jitter = %4.2f\n", i, thread_info[tId].num_arrival_stats_pkts[i], msec_timestamp_fp, delta_timestamp, fabsf(delta_timestamp - thread_info[tId].arrival_avg_delta[i]));
-                           #endif
-
-                           thread_info[tId].arrival_max_delta[i] = max(thread_info[tId].arrival_max_delta[i], delta_timestamp);
-                           thread_info[tId].arrival_max_jitter[i] = max(thread_info[tId].arrival_max_jitter[i], fabsf(delta_timestamp - ptime));
-                        }
-                     }
-
-                     thread_info[tId].last_rtp_pyld_len[i] = PktInfo.rtp_pyld_len;
-                     thread_info[tId].last_msec_timestamp[i] = msec_timestamp_fp;
-                     #ifdef RTP_TIMESTAMP_STATS
-                     thread_info[tId].last_rtp_timestamp[i] = PktInfo.rtp_timestamp;
-                     #endif
+                     PushPacketAccepted(hSessions, &PushPkt, cur_time, thread_index);  /* update push counter, stream stats, and arrival stats */
 
                      break;  /* break out of nSessions loop, the packet should match no other sessions */
                   }
@@ -4025,10 +4220,194 @@ push_ctrl:  /* upon entry PushPackets() jumps here if current average push rate
 
    }  /* end of input stream loop */
 
+   if (thread_info[tId].push_batch && PushBatchFlush(uFlags_push, hSessions, cur_time, thread_index) < 0) return -1;  /* push packets accumulated in push batch, JHB Oct 2026 */
+
    return push_cnt;
 
 }  /* end of PushPackets() */
 
+/* push batch functions, used if the ENABLE_PUSH_BATCHING flag is set in the -dN cmd line entry. Notes, JHB Oct 2026:
+
+   -PushPackets() adds packets to the app thread's push batch with PushBatchAdd() instead of calling DSPushPackets() for each packet. Packets are copied consecutively into the batch arena, as DSPushPackets() expects, with per packet lengths and session handles
+   -PushBatchFlush() pushes the batch with one DSPushPackets() call. This is done when the batch is full and at the end of each PushPackets() call, so batching adds no delay beyond the current push interval
+   -DSPushPackets() pushes packets in order and returns the number pushed. If a packet/media thread queue is full the return value is less than the number of packets in the batch (partial accept); accepted packets are removed from the front of the batch and the remainder are kept and pushed first next time, preserving per session packet order
+   -packets for sessions deleted while in the batch are discarded. FlushCheck() treats a session with packets in the batch as having a non-empty input queue
+   -per packet push counter, stream stats, and arrival stats are updated by PushPacketAccepted() when packets are accepted, same as non-batched pushes
+   -batching is not used if the DS_PUSHPACKETS_ENABLE_RFC7198_DEDUP flag is given to DSPushPackets(), as its return value indicates duplicates per packet
+*/
+
+void PushPacketAccepted(HSESSION hSessions[], PUSH_BATCH_PKT* pPkt, uint64_t cur_time, int thread_index) {  /* update push counter, stream stats, and arrival stats for a packet accepted by DSPushPackets() */
+
+int nSessionIndex = pPkt->nSessionIndex;
+
+   thread_info[tId].pkt_push_ctr++;
+
+/* update stream stats with first packet info */
+
+   for (int k=0; k<thread_info[tId].num_stream_stats; k++) if (pPkt->chnum == thread_info[tId].StreamStats[k].chnum) {  /* find channel in StreamStats[] */
+
+      if (!(thread_info[tId].StreamStats[k].uFlags & STREAM_STAT_FIRST_PKT)) {
+
+         thread_info[tId].StreamStats[k].first_pkt_ssrc = pPkt->rtp_ssrc;  /* get first packet RTP SSRC */
+         thread_info[tId].StreamStats[k].first_pkt_usec = DSGetLogTimestamp(NULL, DS_EVENT_LOG_UPTIME_TIMESTAMPS, 0, 0);  /* get usec since app thread start */
+
+         #if 0  /* debug */
+         printf("\n *** stream stat %d, updating ch %d, hSessions[%d] = %d, term = %d, ssrc = 0x%x, usec = %llu \n", k, pPkt->chnum, nSessionIndex, hSessions[nSessionIndex], thread_info[tId].StreamStats[k].term, thread_info[tId].StreamStats[k].first_pkt_ssrc, (long long unsigned int)thread_info[tId].StreamStats[k].first_pkt_usec);
+         #endif
+
+         thread_info[tId].StreamStats[k].uFlags |= STREAM_STAT_FIRST_PKT;  /* set first packet flag */
+      }
+
+      break;  /* stop searching after channel found */
+   }
+
+   if (queue_full_warning[hSessions[nSessionIndex]]) queue_full_warning[hSessions[nSessionIndex]] = 0;  /* reset queue full warning if needed */
+
+/* if specified, calculate packet arrival timing stats, JHB Aug 2023:
+ 
+   -objective is to measure delta and jitter with respect to ptime, and get a handle on whether packet rate is consistently fast or slow. Wireshark averages include SID packets which obscures accurate reading on things like media playout servers
+   -only calculate for successive media packets and SID packets that immediately follow a media packet, and omit consecutive SID, DTMF packets
+   -currently we have a 1/2 sec limit on gaps due to packet loss or input pauses, anything larger than that is not counted
+   -currently these stats are not reset in repeat mode
+   -to-do: capacity tests
+*/
+
+   if (Mode & SHOW_PACKET_ARRIVAL_STATS) {
+
+      float delta_timestamp,
+            #ifdef RTP_TIMESTAMP_STATS
+            Fs = DSGetSessionInfo(hSessions[nSessionIndex], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_SAMPLE_RATE, 1, NULL),  /* get session codec sampling rate in Hz */
+            #endif
+            ptime = DSGetSessionInfo(hSessions[nSessionIndex], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_PTIME, 1, NULL);  /* get session ptime in msec */
+
+      #define MAX_STATS_GAP 25*ptime
+
+      if (thread_info[tId].last_rtp_pyld_len[nSessionIndex] > 8 && (delta_timestamp = pPkt->msec_timestamp_fp - thread_info[tId].last_msec_timestamp[nSessionIndex]) < MAX_STATS_GAP) {  /* omit DTMFs and SIDs, gaps larger than 500 msec (for 20 sec nominal ptime). Note the payload len check also ensures the first delta values will not be something - zero */
+
+         thread_info[tId].arrival_avg_delta[nSessionIndex] += delta_timestamp;
+
+         thread_info[tId].arrival_avg_jitter[nSessionIndex] += fabsf(delta_timestamp - ptime);
+
+         thread_info[tId].arrival_avg_delta_clock[nSessionIndex] += (cur_time - thread_info[tId].first_pkt_time[pPkt->nStream])/(thread_info[tId].num_arrival_stats_pkts[nSessionIndex]+1)/1000.0;  /* in msec */
+
+         #ifdef RTP_TIMESTAMP_STATS  /* can be enabled in mediaMin.h for RTP timestamp stats and debug. Not normally used as timestamps are unlikely to be in correct order until processing by pktlib jitter buffer, JHB Mar 2025 */
+         thread_info[tId].rtp_timestamp_avg_delta[nSessionIndex] += 1000*(pPkt->rtp_timestamp - thread_info[tId].last_rtp_timestamp[nSessionIndex])/Fs;  /* in msec */
+         #endif
+
+         thread_info[tId].num_arrival_stats_pkts[nSessionIndex]++;
+
+         #if 0
+         static int count[10] = { 0 };
+         if (count[nSessionIndex]++ < 50) printf("\n[%d]%d msec_timestamp_fp = %4.2f, delta_timestamp = %4.2f, jitter = %4.2f\n", nSessionIndex, thread_info[tId].num_arrival_stats_pkts[nSessionIndex], pPkt->msec_timestamp_fp, delta_timestamp, fabsf(delta_timestamp - thread_info[tId].arrival_avg_delta[nSessionIndex]));
+         #endif
+
+         thread_info[tId].arrival_max_delta[nSessionIndex] = max(thread_info[tId].arrival_max_delta[nSessionIndex], delta_timestamp);
+         thread_info[tId].arrival_max_jitter[nSessionIndex] = max(thread_info[tId].arrival_max_jitter[nSessionIndex], fabsf(delta_timestamp - ptime));
+      }
+   }
+
+   thread_info[tId].last_rtp_pyld_len[nSessionIndex] = pPkt->rtp_pyld_len;
+   thread_info[tId].last_msec_timestamp[nSessionIndex] = pPkt->msec_timestamp_fp;
+   #ifdef RTP_TIMESTAMP_STATS
+   thread_info[tId].last_rtp_timestamp[nSessionIndex] = pPkt->rtp_timestamp;
+   #endif
+}
+
+bool PushBatchAdd(uint8_t* pkt_buf, int pkt_len, HSESSION hSessions[], PUSH_BATCH_PKT* pPkt, int thread_index) {  /* add packet to push batch, returns false if the batch is full */
+
+PUSH_BATCH* pBatch = thread_info[tId].push_batch;
+
+   if (pBatch->num_pkts >= PUSH_BATCH_MAX_PKTS || pBatch->arena_len + pkt_len > PUSH_BATCH_ARENA_SIZE) return false;
+
+   memcpy(&pBatch->arena[pBatch->arena_len], pkt_buf, pkt_len);
+   pBatch->arena_len += pkt_len;
+
+   pBatch->pkt_len[pBatch->num_pkts] = pkt_len;
+   pBatch->hSession[pBatch->num_pkts] = hSessions[pPkt->nSessionIndex];
+   pBatch->pkt[pBatch->num_pkts] = *pPkt;
+   pBatch->num_pkts++;
+
+   return true;
+}
+
+static void PushBatchRemove(PUSH_BATCH* pBatch, int nStart, int nPkts) {  /* remove nPkts packets from the batch starting at nStart */
+
+int k, ofs = 0, len = 0;
+
+   if (nPkts <= 0) return;
+
+   for (k=0; k<nStart; k++) ofs += pBatch->pkt_len[k];
+   for (k=nStart; k<nStart+nPkts; k++) len += pBatch->pkt_len[k];
+
+   memmove(&pBatch->arena[ofs], &pBatch->arena[ofs+len], pBatch->arena_len - ofs - len);
+   pBatch->arena_len -= len;
+
+   memmove(&pBatch->pkt_len[nStart], &pBatch->pkt_len[nStart+nPkts], (pBatch->num_pkts - nStart - nPkts)*sizeof(pBatch->pkt_len[0]));
+   memmove(&pBatch->hSession[nStart], &pBatch->hSession[nStart+nPkts], (pBatch->num_pkts - nStart - nPkts)*sizeof(pBatch->hSession[0]));
+   memmove(&pBatch->pkt[nStart], &pBatch->pkt[nStart+nPkts], (pBatch->num_pkts - nStart - nPkts)*sizeof(pBatch->pkt[0]));
+   pBatch->num_pkts -= nPkts;
+}
+
+int PushBatchFlush(unsigned int uFlags_push, HSESSION hSessions[], uint64_t cur_time, int thread_index) {  /* push batch with one DSPushPackets() call. Returns number of packets accepted, or -1 for an error condition */
+
+PUSH_BATCH* pBatch = thread_info[tId].push_batch;
+int k, ret_val, num_accepted = 0, retry_count = 0;
+uint32_t uSleepTime = max(1000, (int)(RealTimeInterval[0]*1000));
+uint32_t notify_seq;
+
+   if (!pBatch) return 0;
+
+   for (k=pBatch->num_pkts-1; k>=0; k--) if (hSessions[pBatch->pkt[k].nSessionIndex] & SESSION_MARKED_AS_DELETED) PushBatchRemove(pBatch, k, 1);  /* discard packets for sessions deleted since they were added */
+
+   while (pBatch->num_pkts) {
+
+      notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_INPUT_SPACE);
+
+      ret_val = DSPushPackets(uFlags_push, pBatch->arena, pBatch->pkt_len, pBatch->hSession, pBatch->num_pkts);
+
+      if (ret_val < 0) {  /* error condition */
+
+         fprintf(stderr, "Error condition returned by DSPushPackets, batch of %d packets, first hSession = %d\n", pBatch->num_pkts, pBatch->hSession[0]);
+         return -1;
+      }
+
+      thread_info[tId].push_batch_pushes++;
+      thread_info[tId].push_batch_pkts += ret_val;
+
+      for (k=0; k<ret_val; k++) PushPacketAccepted(hSessions, &pBatch->pkt[k], cur_time, thread_index);
+
+      PushBatchRemove(pBatch, 0, ret_val);  /* remove accepted packets from front of batch */
+      num_accepted += ret_val;
+
+      if (!pBatch->num_pkts) break;
+
+   /* partial accept, a packet/media thread queue is full. Wait and push remaining packets again, same retries as non-batched pushes */
+
+      thread_info[tId].push_batch_partial_accepts++;
+
+      if (retry_count++ >= 3) {
+
+         if (!queue_full_warning[pBatch->hSession[0]]) Log_RT(3, "mediaMin WARNING: says DSPushPackets() timeout, unable to push batch of %d packets for %d msec \n", pBatch->num_pkts, (retry_count-1)*uSleepTime/1000);
+         queue_full_warning[pBatch->hSession[0]]++;  /* will wrap after 255 */
+
+         break;  /* keep remaining packets in the batch, push again next time */
+      }
+
+      DSWaitPacketNotify(DS_PKT_NOTIFY_INPUT_SPACE, notify_seq, uSleepTime);  /* wait for a packet/media thread to dequeue packets */
+   }
+
+   return num_accepted;
+}
+
+bool isPushBatchPending(HSESSION hSession, int thread_index) {  /* returns true if the push batch holds packets for hSession */
+
+PUSH_BATCH* pBatch = thread_info[tId].push_batch;
+
+   if (pBatch) for (int k=0; k<pBatch->num_pkts; k++) if (pBatch->hSession[k] == hSession) return true;
+
+   return false;
+}
+
 /* pull packets from packet / media session-organized queue. Packets are pulled by category:  jitter buffer output, transcoded, and stream group */
 
 int PullPackets(uint8_t* pkt_out_buf, HSESSION hSessions[], SESSION_DATA session_data[], unsigned int uFlags, unsigned int pkt_buf_len, uint64_t cur_time, int thread_index) {
@@ -4042,12 +4421,16 @@ char errstr[20] = "";
 int nRetry[MAX_SESSIONS_THREAD] = { 0 };
 int group_idx = -1;
 bool fRetry = false;
+uint32_t notify_seq;
+OUTPUT_WRITER_RING* pRing;
 uint8_t uOutputType = PCAP;  /* default output type. See io_data_type enums (mediaTest.h), JHB Sep 2024 */
 
    if (!thread_info[thread_index].nSessionsCreated) return 0;  /* nothing to do if no sessions created yet */
 
 pull_setup:
 
+   notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_OUTPUT);  /* get notify sequence number before pulling, used if stream group retries are needed, JHB Oct 2026 */
+
    do {  /* session loop */
 
       fp = NULL;  /* fp controls file output; reset each time through loop */
@@ -4201,6 +4584,8 @@ pull_setup:
 
    /* output processing: transcoded audio, video bitstream, etc. if fp not set then packets are pulled but not written to file or sent to UDP */
 
+      pRing = (fp && uOutputType == PCAP) ? OutputWriterFind(fp, thread_index) : NULL;  /* if --output_writers entered, output pcap records are enqueued for writer threads, JHB Oct 2026 */
+
       if (fp) for (j=0, pkt_out_ptr=pkt_out_buf; j<nPulledPackets; j++) {
 
          if (uOutputType == PCAP) {
@@ -4246,7 +4631,8 @@ pull_setup:
                }
             }
 
-            if (DSWritePcap(fp, uFlags_write, pkt_out_ptr, packet_out_len[j], &pcap_pkt_hdr, NULL, NULL) < 0) { fprintf(stderr, "DSWritePcap() failed for %s output \n", errstr); return -1; }
+            if (pRing) OutputWriterEnqueue(pRing, uFlags_write, pkt_out_ptr, packet_out_len[j], &pcap_pkt_hdr);  /* drops, if any, are counted in ring stats */
+            else if (DSWritePcapBuffered(fp, uFlags_write, pkt_out_ptr, packet_out_len[j], &pcap_pkt_hdr, NULL, NULL) < 0) { fprintf(stderr, "DSWritePcapBuffered() failed for %s output \n", errstr); return -1; }  /* output pcaps have buffered writers attached in OutputSetup(), StreamGroupOutputSetup(), and JitterBufferOutputSetup(). Records are written with writev() when the buffer fills and when DSClosePcap() is called, JHB Oct 2026 */
          }
          else if (uOutputType == ENCODED) {  /* handle encoded outputs, JHB Sep 2024 */
 
@@ -4316,7 +4702,7 @@ pull_setup:
 
    /* check for stream groups that may need a retry. Notes JHB Mar 2020:
 
-      -for a retry we sleep 1 msec, then call DSPullPackets() again. This includes all stream group owner sessions that didn't yet produce a packet (if any)
+      -for a retry we wait up to 1 msec for packet/media thread output (DS_PKT_NOTIFY_OUTPUT), then call DSPullPackets() again. This includes all stream group owner sessions that didn't yet produce a packet (if any)
       -max number of retries is 8
       -currently retries apply only to stream group output when packet arrival times (packet timestamps) and ptime output timing are enabled. In this case regular output timing is required and we want to avoid any variation
    */
@@ -4329,7 +4715,7 @@ pull_setup:
       #endif
 
       if (!isAFAPMode && !isFTRTMode && fRetry) {
-         usleep(1000);  /* sleep 1 msec */
+         DSWaitPacketNotify(DS_PKT_NOTIFY_OUTPUT, notify_seq, 1000);  /* wait for output, up to 1 msec */
          nSessionIndex = 0;  /* reset session index */
 
          goto pull_setup;  /* retry one or more sessions */
@@ -4409,7 +4795,45 @@ int pkt_len;  /* return value */
       printf("\n *** before read, last read pos = %llu, cache mode = %d, read count = %d, cache count = %d \n", (long long unsigned int)thread_info[tId].last_read_pos[nStream], thread_info[tId].input_data_cache[j].uFlags, read_count, cache_count);
       #endif
 
-      pkt_len = DSReadPcap(thread_info[tId].pcap_in[nStream], 0, pkt_buf, (Mode & USE_PACKET_ARRIVAL_TIMES) ? p_pcap_rec_hdr : NULL, thread_info[tId].link_layer_info[nStream], p_eth_protocol, p_block_type, thread_info[tId].pcap_file_hdr[nStream]);  /* DSReadPcap() handles pcap, pcapng, and .rtpdump format, source is in pktlib_pcap.cpp. Return value is packet length (or block data length in case of some none-packet blocks in pcapng format); a return value of zero indicates end of file, -1 indicates an error condition (in which case an error message has been displayed/logged) */
+      if (thread_info[tId].input_data_cache[nStream].fStopped) pkt_len = 0;  /* --stop_time has been reached, indicate end of input, JHB Oct 2026 */
+      else if (thread_info[tId].input_data_cache[nStream].batch_recs) {  /* batch reads, currently enabled in AFAP mode. DSReadPcapBatch() fills a packet arena with up to INPUT_BATCH_MAX_RECS records per call, amortizing per-packet read overhead. Batch items are in INPUT_DATA_CACHE struct, see mediaMin.h, JHB Oct 2026 */
+
+         INPUT_DATA_CACHE* pCache = &thread_info[tId].input_data_cache[nStream];
+
+         pkt_len = 0;
+
+         if (pCache->batch_index >= pCache->batch_count) {  /* current batch consumed, read next batch */
+
+            pCache->batch_index = pCache->batch_count = 0;
+
+            int num_recs;
+
+            if (pCache->read_ahead) num_recs = InputReadAheadPop(pCache, tId, nStream);  /* read-ahead active, take next ring slot filled by producer thread. On return batch_arena and batch_recs point to the slot, JHB Oct 2026 */
+            else num_recs = DSReadPcapBatch(thread_info[tId].pcap_in[nStream], 0, pCache->batch_arena, INPUT_BATCH_ARENA_SIZE, pCache->batch_recs, INPUT_BATCH_MAX_RECS, thread_info[tId].link_layer_info[nStream], thread_info[tId].pcap_file_hdr[nStream]);
+
+            if (num_recs < 0) pkt_len = num_recs;  /* error condition, message has already been displayed/logged */
+            else pCache->batch_count = num_recs;  /* zero indicates end of input */
+         }
+
+         if (pCache->batch_index < pCache->batch_count) {
+
+            pcap_batch_rec_t* pRec = &pCache->batch_recs[pCache->batch_index++];
+
+            pkt_len = pRec->pkt_len;
+            *p_eth_protocol = pRec->eth_protocol;
+            *p_block_type = pRec->block_type;
+            *p_pcap_rec_hdr = pRec->pcap_rec_hdr;
+
+            memcpy(pkt_buf, &pCache->batch_arena[pRec->offset], pkt_len);  /* PushPackets() may modify pkt_buf in-place; the arena copy stays intact and is used as cached packet data */
+         }
+      }
+      else if (Mode & ENABLE_MMAP_INPUT) {  /* memory-mapped input: DSReadPcapPtr() walks records in place and returns a pointer into the mapping, avoiding several fread() and fseek() calls per record. We still copy to pkt_buf as PushPackets() may modify packet data in-place, JHB Oct 2026 */
+
+         uint8_t* pkt_ptr = NULL;
+
+         if ((pkt_len = DSReadPcapPtr(thread_info[tId].pcap_in[nStream], 0, &pkt_ptr, p_pcap_rec_hdr, thread_info[tId].link_layer_info[nStream], p_eth_protocol, p_block_type, thread_info[tId].pcap_file_hdr[nStream])) > 0 && pkt_ptr) memcpy(pkt_buf, pkt_ptr, pkt_len);  /* pkt_ptr is NULL for unused pcapng block types */
+      }
+      else pkt_len = DSReadPcap(thread_info[tId].pcap_in[nStream], 0, pkt_buf, ((Mode & (USE_PACKET_ARRIVAL_TIMES | ENABLE_INPUT_MERGE)) || thread_info[tId].input_data_cache[nStream].stop_time != UINT64_MAX) ? p_pcap_rec_hdr : NULL, thread_info[tId].link_layer_info[nStream], p_eth_protocol, p_block_type, thread_info[tId].pcap_file_hdr[nStream]);  /* DSReadPcap() handles pcap, pcapng, and .rtpdump format, source is in pktlib_pcap.cpp. Return value is packet length (or block data length in case of some none-packet blocks in pcapng format); a return value of zero indicates end of file, -1 indicates an error condition (in which case an error message has been displayed/logged) */
 
       //#define NON_IP_FRAMES_DEBUG  /* enable to see frames that don't contain actual transmitted packet data but still have an IP header type and IP version header */
       #ifdef NON_IP_FRAMES_DEBUG
@@ -4434,6 +4858,12 @@ int pkt_len;  /* return value */
       }
       #endif
 
+      if (pkt_len > 0 && thread_info[tId].input_data_cache[nStream].stop_time != UINT64_MAX && *p_block_type != PCAPNG_SPB_TYPE && (uint64_t)p_pcap_rec_hdr->ts_sec*1000000L + p_pcap_rec_hdr->ts_usec > thread_info[tId].input_data_cache[nStream].stop_time) {  /* check for --stop_time. SPB blocks have no timestamp and are not checked, JHB Oct 2026 */
+
+         thread_info[tId].input_data_cache[nStream].fStopped = true;
+         pkt_len = 0;
+      }
+
       if (pkt_len < 0) return pkt_len;
 
    /* return new input data, write to cache */
@@ -4454,9 +4884,12 @@ int pkt_len;  /* return value */
 
       if (pkt_len - NOMINAL_MTU > 0) {  /* check for packet size larger than input cache data buffer nominal MTU size, for infrequent reasons as noted above. NOMINAL_MTU is defined in pktlib.h */
 
-         thread_info[tId].input_data_cache[nStream].uFlags |= CACHE_MTU_EXPANDED;
+         if (!thread_info[tId].input_data_cache[nStream].batch_arena) {  /* not needed for batch reads, arena holds cached packet data */
+
+            thread_info[tId].input_data_cache[nStream].uFlags |= CACHE_MTU_EXPANDED;
 
-         thread_info[tId].input_data_cache[nStream].pkt_buf = (uint8_t*)realloc(thread_info[tId].input_data_cache[nStream].pkt_buf, pkt_len);  /* realloc cache packet data buffer size as needed */
+            thread_info[tId].input_data_cache[nStream].pkt_buf = (uint8_t*)realloc(thread_info[tId].input_data_cache[nStream].pkt_buf, pkt_len);  /* realloc cache packet data buffer size as needed */
+         }
 
          char szIPver[100] = "n/a", szFragmentFlags[100] = "n/a", szProtocol[100] = "";
          uint16_t pInfoBuffer[100] = { 0 };
@@ -4501,7 +4934,7 @@ int pkt_len;  /* return value */
       }
 
       thread_info[tId].input_data_cache[nStream].pkt_len = pkt_len;
-      memcpy(thread_info[tId].input_data_cache[nStream].pkt_buf, pkt_buf, pkt_len);  /* copy packet data to cache buffer */
+      if (!thread_info[tId].input_data_cache[nStream].batch_arena) memcpy(thread_info[tId].input_data_cache[nStream].pkt_buf, pkt_buf, pkt_len);  /* copy packet data to cache buffer */
       last_input[tId] = nStream;
 
       thread_info[tId].input_data_cache[nStream].uFlags |= CACHE_NEW_DATA;  /* mark input cache as updated with new data */
@@ -4517,17 +4950,23 @@ int pkt_len;  /* return value */
    }
    else {  /* return cached data */
 
-      thread_info[tId].input_data_cache[nStream].uFlags &= ~CACHE_NEW_DATA;  /* remove new data flag */
+      bool fPeek = (thread_info[tId].input_data_cache[nStream].uFlags & CACHE_ITEM_MASK) == CACHE_PEEK;
+
+      if (fPeek) thread_info[tId].input_data_cache[nStream].uFlags = (thread_info[tId].input_data_cache[nStream].uFlags & ~CACHE_ITEM_MASK) | CACHE_NEW_DATA;  /* packet was read ahead by InputMergePeek() and not yet processed, return it as new data, JHB Oct 2026 */
+      else thread_info[tId].input_data_cache[nStream].uFlags &= ~CACHE_NEW_DATA;  /* remove new data flag */
 
       pkt_len = thread_info[tId].input_data_cache[nStream].pkt_len;
       *p_eth_protocol = thread_info[tId].input_data_cache[nStream].eth_protocol;
       *p_pcap_rec_hdr = thread_info[tId].input_data_cache[nStream].pcap_rec_hdr;
 
-      if (nStream != last_input[tId] || thread_info[tId].input_data_cache[nStream].uFlags == CACHE_READ_PKTBUF) {  /* copy pktbuf from cache if either (i) input has changed or (ii) pktbuf has been modified due to in-place processing */
+      if (nStream != last_input[tId] || thread_info[tId].input_data_cache[nStream].uFlags == CACHE_READ_PKTBUF || fPeek) {  /* copy pktbuf from cache if either (i) input has changed, (ii) pktbuf has been modified due to in-place processing, or (iii) packet was read ahead, in which case pktbuf may have been used since */
 
-      /* copy cache buffer to packet data */
+      /* copy cache buffer to packet data. For batch reads cached packet data is the most recently returned arena record */
 
-         memcpy(pkt_buf, thread_info[tId].input_data_cache[nStream].pkt_buf, pkt_len);
+         INPUT_DATA_CACHE* pCache = &thread_info[tId].input_data_cache[nStream];
+
+         if (pCache->batch_arena && pCache->batch_index > 0) memcpy(pkt_buf, &pCache->batch_arena[pCache->batch_recs[pCache->batch_index-1].offset], pkt_len);
+         else memcpy(pkt_buf, pCache->pkt_buf, pkt_len);
 
          last_input[tId] = nStream;
          #ifdef INPUT_CACHE_DEBUG
@@ -4543,27 +4982,613 @@ int pkt_len;  /* return value */
    return pkt_len;
 }
 
-void InputSetup(uint64_t cur_time, int thread_index) {
+/* apply --start_time and --stop_time cmd line entries (if any) to an input stream. Called by InputSetup() after input is opened and when the input wraps. Notes, JHB Oct 2026:
 
-int cmd_line_input = 0;  /* command line input index (i.e. -i xxx specs on command line) */
-int nStream = 0;  /* stream index */
-char tmpstr[1024];
-unsigned int uFlags;
+   -start and stop times are in msec relative to arrival time of the first packet in the input (cmd line entries are in sec)
+   -DSSeekPcap() positions the input at the first record at or after the start time. libpcap inputs are bisected by file offset; for pcapng and .rtp inputs the first call builds a time index, see DSSeekPcap() comments in pktlib.h
+   -the stop time is converted to an absolute arrival timestamp and saved in the input cache; GetInputData() returns end of input after it's reached
+   -return value is 1 if input was positioned, 0 if no time window was entered or no records are at or after the start time, and < 0 for an error condition
+*/
 
-   if (thread_info[thread_index].init_err) return;
+int InputTimeWindowSetup(int thread_index, int nStream) {
 
-   if (Mode & AUTO_ADJUST_PUSH_TIMING) average_push_rate[thread_index] = 2;  /* initialize auto-adjust push rate algorithm state */
+INPUT_DATA_CACHE* pCache = &thread_info[thread_index].input_data_cache[nStream];
+uint64_t first_time = 0, rec_time = 0;
+int ret_val;
 
-   thread_info[thread_index].nInPcapFiles = 0;
+   pCache->stop_time = UINT64_MAX;
+   pCache->fStopped = false;
 
-   uFlags = DS_READ;
-   if (fCapacityTest) uFlags |= DS_OPEN_PCAP_QUIET;
+   if (nStartTime <= 0 && nStopTime < 0) return 0;  /* no time window entered on cmd line */
 
-/* open input pcap files, advance file pointer to first packet. Abort program on any input file failure */
+   if (((thread_info[thread_index].link_layer_info[nStream] & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) == PCAP_TYPE_BER) return 0;  /* not applicable to BER inputs */
 
-   #pragma GCC diagnostic push  /* suppress "address of var will never be NULL" warnings in gcc 12.2; safe-coding rules prevail, JHB May 2023 */
-   #pragma GCC diagnostic ignored "-Waddress"
-   while (MediaParams[cmd_line_input].Media.inputFilename != NULL && strlen(MediaParams[cmd_line_input].Media.inputFilename)) {
+   if ((ret_val = DSSeekPcap(thread_info[thread_index].pcap_in[nStream], DS_SEEK_PCAP_RELATIVE_TIME, 0, thread_info[thread_index].link_layer_info[nStream], thread_info[thread_index].pcap_file_hdr[nStream], &first_time)) <= 0) {  /* get arrival time of first packet */
+
+      if (ret_val < 0) Log_RT(3, "mediaMin WARNING: InputTimeWindowSetup() says DSSeekPcap() failed for input %s, --start_time and --stop_time entries ignored \n", MediaParams[thread_info[thread_index].cmd_line_input_index[nStream]].Media.inputFilename);
+      return ret_val;
+   }
+
+   if (nStopTime >= 0) pCache->stop_time = first_time + (uint64_t)nStopTime*1000;
+
+   if (nStartTime > 0) {
+
+      if ((ret_val = DSSeekPcap(thread_info[thread_index].pcap_in[nStream], DS_SEEK_PCAP_RELATIVE_TIME, (uint64_t)nStartTime*1000, thread_info[thread_index].link_layer_info[nStream], thread_info[thread_index].pcap_file_hdr[nStream], &rec_time)) < 0) return ret_val;
+
+      if (ret_val == 0) Log_RT(3, "mediaMin WARNING: InputTimeWindowSetup() says --start_time %d.%03d sec is past end of input %s \n", nStartTime/1000, nStartTime % 1000, MediaParams[thread_info[thread_index].cmd_line_input_index[nStream]].Media.inputFilename);
+      else Log_RT(4, "mediaMin INFO: input %s positioned at --start_time %d.%03d sec, first record is at %llu.%06llu sec \n", MediaParams[thread_info[thread_index].cmd_line_input_index[nStream]].Media.inputFilename, nStartTime/1000, nStartTime % 1000, (unsigned long long)(rec_time - first_time)/1000000L, (unsigned long long)(rec_time - first_time) % 1000000L);
+   }
+
+   return ret_val;
+}
+
+/* input read-ahead functions, used if --read_ahead N is entered on the cmd line. Notes, JHB Oct 2026:
+
+   -InputReadAheadThread() is a producer thread that fills an N slot ring with DSReadPcapBatch(), one batch per slot. GetInputData() calls InputReadAheadPop() to take filled slots and then returns records one at a time, the same as batch reads without read-ahead
+   -the ring is single producer / single consumer; head is written only by the producer and tail only by the consumer, so no locks are needed
+   -the consumer holds its current slot until taking the next one, as the slot also serves as input cache packet data (see CACHE_READ comments in GetInputData())
+   -the input handle is accessed only by the producer while it's running. InputReadAheadStop() must be called before rewinding, seeking, or closing the input
+*/
+
+void* InputReadAheadThread(void* arg) {
+
+INPUT_READ_AHEAD* ra = (INPUT_READ_AHEAD*)arg;
+int tId = ra->thread_index, nStream = ra->nStream, slot, num_recs;
+bool fFull = false;
+
+   while (!__sync_fetch_and_add(&ra->fExit, 0)) {
+
+      if (ra->head - __sync_fetch_and_add(&ra->tail, 0) >= (uint32_t)ra->depth) {  /* ring full, wait for consumer */
+
+         if (!fFull) { thread_info[tId].read_ahead_full_waits[nStream]++; fFull = true; }
+         usleep(INPUT_READ_AHEAD_WAIT_USEC);
+         continue;
+      }
+
+      fFull = false;
+      slot = ra->head % ra->depth;
+
+      num_recs = DSReadPcapBatch(thread_info[tId].pcap_in[nStream], 0, &ra->slot_arena[slot*INPUT_BATCH_ARENA_SIZE], INPUT_BATCH_ARENA_SIZE, &ra->slot_recs[slot*INPUT_BATCH_MAX_RECS], INPUT_BATCH_MAX_RECS, thread_info[tId].link_layer_info[nStream], thread_info[tId].pcap_file_hdr[nStream]);
+
+      if (num_recs != 0) {  /* publish filled slot, including error conditions so the consumer sees them in order */
+
+         ra->slot_count[slot] = num_recs;
+         __sync_synchronize();  /* slot contents must be visible before head is advanced */
+         __sync_fetch_and_add(&ra->head, 1);
+      }
+
+      if (num_recs <= 0) { __sync_lock_test_and_set(&ra->fEnd, 1); break; }  /* end of input or error */
+   }
+
+   return NULL;
+}
+
+int InputReadAheadPop(INPUT_DATA_CACHE* pCache, int tId, int nStream) {  /* called by GetInputData(). Returns number of records in next slot, 0 for end of input, or < 0 for an error condition */
+
+INPUT_READ_AHEAD* ra = pCache->read_ahead;
+uint32_t head, occupancy;
+bool fStall = false;
+int slot;
+
+   if (ra->fSlotHeld) {  /* release previous slot to producer */
+      __sync_fetch_and_add(&ra->tail, 1);
+      ra->fSlotHeld = false;
+   }
+
+   while ((head = __sync_fetch_and_add(&ra->head, 0)) == ra->tail) {  /* ring empty */
+
+      if (__sync_fetch_and_add(&ra->fEnd, 0) && __sync_fetch_and_add(&ra->head, 0) == ra->tail) return 0;  /* producer is done and all slots consumed. Note producer advances head before setting fEnd, so head is re-checked */
+
+      if (!fStall) { thread_info[tId].read_ahead_stalls[nStream]++; fStall = true; }
+      usleep(INPUT_READ_AHEAD_WAIT_USEC);
+   }
+
+   occupancy = head - ra->tail;  /* update occupancy stats */
+   thread_info[tId].read_ahead_slots[nStream]++;
+   thread_info[tId].read_ahead_occupancy[nStream] += occupancy;
+   thread_info[tId].read_ahead_max_occupancy[nStream] = max(thread_info[tId].read_ahead_max_occupancy[nStream], occupancy);
+
+   slot = ra->tail % ra->depth;
+   pCache->batch_arena = &ra->slot_arena[slot*INPUT_BATCH_ARENA_SIZE];
+   pCache->batch_recs = &ra->slot_recs[slot*INPUT_BATCH_MAX_RECS];
+   ra->fSlotHeld = true;
+
+   return ra->slot_count[slot];
+}
+
+int InputReadAheadStart(int thread_index, int nStream) {  /* allocate ring on first call and start producer thread. Returns 1 on success, -1 on error, in which case GetInputData() falls back to reading inline */
+
+INPUT_DATA_CACHE* pCache = &thread_info[thread_index].input_data_cache[nStream];
+INPUT_READ_AHEAD* ra = pCache->read_ahead;
+int depth = min(nReadAheadDepth, INPUT_READ_AHEAD_MAX_DEPTH);
+
+   if (!ra) {
+
+      if (!(ra = (INPUT_READ_AHEAD*)calloc(1, sizeof(INPUT_READ_AHEAD)))) goto alloc_err;
+
+      ra->thread_index = thread_index;
+      ra->nStream = nStream;
+      ra->depth = depth;
+      ra->slot_arena = (uint8_t*)malloc((size_t)depth*INPUT_BATCH_ARENA_SIZE);
+      ra->slot_recs = (pcap_batch_rec_t*)malloc(depth*INPUT_BATCH_MAX_RECS*sizeof(pcap_batch_rec_t));
+      ra->slot_count = (int*)calloc(depth, sizeof(int));
+
+      if (!ra->slot_arena || !ra->slot_recs || !ra->slot_count) {
+
+         if (ra->slot_arena) free(ra->slot_arena);
+         if (ra->slot_recs) free(ra->slot_recs);
+         if (ra->slot_count) free(ra->slot_count);
+         free(ra);
+         goto alloc_err;
+      }
+
+      pCache->read_ahead = ra;
+   }
+
+   ra->head = ra->tail = 0;
+   ra->fEnd = ra->fExit = 0;
+   ra->fSlotHeld = false;
+
+   pCache->batch_arena = ra->slot_arena;  /* batch_recs must be non-NULL for GetInputData() to take the batch read path */
+   pCache->batch_recs = ra->slot_recs;
+   pCache->batch_count = pCache->batch_index = 0;
+
+   if (pthread_create(&ra->thread, NULL, InputReadAheadThread, ra)) {
+
+      Log_RT(2, "mediaMin ERROR: InputReadAheadStart() says pthread_create() failed for input %s, reading inline \n", MediaParams[thread_info[thread_index].cmd_line_input_index[nStream]].Media.inputFilename);
+      InputReadAheadFree(thread_index, nStream);
+      return -1;
+   }
+
+   ra->fRunning = true;
+
+   return 1;
+
+alloc_err:
+   fprintf(stderr, "Failed to allocate memory (%d x %d bytes) for input read-ahead ring, thread_index = %d, reading inline \n", depth, INPUT_BATCH_ARENA_SIZE, thread_index);
+   return -1;
+}
+
+void InputReadAheadStop(int thread_index, int nStream) {  /* stop producer thread, ring mem is kept for restart */
+
+INPUT_READ_AHEAD* ra = thread_info[thread_index].input_data_cache[nStream].read_ahead;
+
+   if (!ra || !ra->fRunning) return;
+
+   __sync_lock_test_and_set(&ra->fExit, 1);
+   pthread_join(ra->thread, NULL);
+   ra->fRunning = false;
+}
+
+void InputReadAheadFree(int thread_index, int nStream) {  /* stop producer thread and free ring mem */
+
+INPUT_DATA_CACHE* pCache = &thread_info[thread_index].input_data_cache[nStream];
+
+   if (!pCache->read_ahead) return;
+
+   InputReadAheadStop(thread_index, nStream);
+
+   free(pCache->read_ahead->slot_arena);
+   free(pCache->read_ahead->slot_recs);
+   free(pCache->read_ahead->slot_count);
+   free(pCache->read_ahead);
+   pCache->read_ahead = NULL;
+
+   pCache->batch_arena = NULL;  /* batch items pointed to ring slots */
+   pCache->batch_recs = NULL;
+   pCache->batch_count = pCache->batch_index = 0;
+}
+
+/* output writer functions, used if --output_writers N is entered on the cmd line. Notes, JHB Oct 2026:
+
+   -OutputWriterAttach() attaches a ring to an output pcap after it's opened (see OutputSetup(), StreamGroupOutputSetup(), and JitterBufferOutputSetup()) and OutputWriterDetach() drains and detaches the ring before the pcap is closed
+   -each ring is single producer / single consumer. The producer is the app thread that owns the output pcap and the consumer is writer thread (ring index % number of writer threads). head is written only by the producer and tail only by the writer thread, so no locks are needed
+   -writer threads drain rings with DSWritePcapBuffered(), which coalesces records into large writev() writes (see DSCreatePcapWriter() in pktlib.h)
+   -wall clock packet timestamps are taken by OutputWriterEnqueue(), so output timestamps are the same as when written by app threads
+   -if a ring stays full for OUTPUT_WRITER_FULL_TIMEOUT_USEC the record is dropped. Ring high-water, full waits, and drops are shown in mediaMin summary stats, and for attached rings in 'd' key run-time debug output
+   -waits are futex based. A writer thread with all its rings empty waits on its data notify, which OutputWriterEnqueue() signals after advancing head. A producer with a full ring, and OutputWriterDetach(), wait on the ring's space notify, which the writer thread signals after advancing tail. Signaling with no waiters is one atomic increment and one atomic load, no system call
+*/
+
+static OUTPUT_WRITER_RING output_writer_rings[OUTPUT_WRITER_MAX_RINGS] = {{ 0 }};
+static int num_output_writer_rings = 0;  /* highest ring index attached + 1 */
+static pthread_t output_writer_threads[OUTPUT_WRITER_MAX_THREADS];
+static OUTPUT_WRITER_NOTIFY output_writer_data_notify[OUTPUT_WRITER_MAX_THREADS];  /* per writer thread, signaled when records are enqueued to any of its rings */
+static int num_output_writer_threads = 0;
+static int fOutputWritersExit = 0;
+
+static void OutputWriterWait(OUTPUT_WRITER_NOTIFY* notify, uint32_t seq, unsigned int uTimeout_usec) {  /* wait for notify to be signaled after seq was read. Returns on signal, timeout, or spuriously; callers re-check their condition. Same method as DSWaitPacketNotify() in pktlib_notify.cpp */
+
+struct timespec ts = { (time_t)(uTimeout_usec / 1000000L), (long)(uTimeout_usec % 1000000L)*1000 };
+
+   __atomic_add_fetch(&notify->waiters, 1, __ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&notify->seq, __ATOMIC_SEQ_CST) == seq) syscall(SYS_futex, &notify->seq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0);  /* EAGAIN if seq changed before the kernel compare */
+
+   __atomic_sub_fetch(&notify->waiters, 1, __ATOMIC_SEQ_CST);
+}
+
+static void OutputWriterSignal(OUTPUT_WRITER_NOTIFY* notify) {
+
+   __atomic_add_fetch(&notify->seq, 1, __ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&notify->waiters, __ATOMIC_SEQ_CST)) syscall(SYS_futex, &notify->seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+void* OutputWriterThread(void* arg) {
+
+int w = (int)(intptr_t)arg, i, num_rings;
+OUTPUT_WRITER_RING* ring;
+OUTPUT_WRITER_REC* rec;
+uint64_t head, tail;
+uint32_t pos, notify_seq;
+bool fDrained, fExit;
+
+   do {
+
+      notify_seq = __atomic_load_n(&output_writer_data_notify[w].seq, __ATOMIC_SEQ_CST);  /* get notify sequence number before checking rings, so an enqueue after the check is not missed */
+
+      fExit = __sync_fetch_and_add(&fOutputWritersExit, 0) != 0;  /* read exit flag before draining, so one more pass is made after exit is requested */
+      fDrained = false;
+      num_rings = __sync_fetch_and_add(&num_output_writer_rings, 0);
+
+      for (i=w; i<num_rings; i+=num_output_writer_threads) {
+
+         ring = &output_writer_rings[i];
+
+         if ((head = __sync_fetch_and_add(&ring->head, 0)) == (tail = ring->tail)) continue;  /* ring empty. Note fp is valid only when head != tail */
+
+         while (tail != head) {
+
+            pos = tail & (OUTPUT_WRITER_RING_SIZE-1);
+
+            if (OUTPUT_WRITER_RING_SIZE - pos < sizeof(OUTPUT_WRITER_REC) || !((OUTPUT_WRITER_REC*)&ring->buf[pos])->len) {  /* padding to end of ring */
+               tail += OUTPUT_WRITER_RING_SIZE - pos;
+               continue;
+            }
+
+            rec = (OUTPUT_WRITER_REC*)&ring->buf[pos];
+
+            if (DSWritePcapBuffered(ring->fp, rec->uFlags, (uint8_t*)rec + sizeof(OUTPUT_WRITER_REC), rec->len, &rec->pcap_pkt_hdr, NULL, NULL) < 0) Log_RT(2, "mediaMin ERROR: OutputWriterThread() says DSWritePcapBuffered() failed, writer thread %d, app thread %d \n", w, ring->thread_index);
+
+            tail += OUTPUT_WRITER_REC_SIZE(rec->len);
+         }
+
+         __sync_synchronize();  /* records must be written before tail is advanced, as the producer reuses the space */
+         ring->tail = tail;
+         fDrained = true;
+
+         OutputWriterSignal(&ring->space);  /* wake producer waiting for space or OutputWriterDetach(), if any */
+      }
+
+      if (!fDrained && !fExit) OutputWriterWait(&output_writer_data_notify[w], notify_seq, OUTPUT_WRITER_WAIT_TIMEOUT_USEC);
+
+   } while (!fExit || fDrained);  /* after exit is requested, continue until a pass finds all rings empty */
+
+   return NULL;
+}
+
+int OutputWritersStart() {  /* called by master app thread before app threads open outputs. Returns number of writer threads started; if zero, output pcaps are written by app threads */
+
+int i;
+
+   if (nOutputWriters <= 0) return 0;
+
+   fOutputWritersExit = 0;
+   num_output_writer_threads = min(nOutputWriters, OUTPUT_WRITER_MAX_THREADS);
+
+   for (i=0; i<num_output_writer_threads; i++) if (pthread_create(&output_writer_threads[i], NULL, OutputWriterThread, (void*)(intptr_t)i)) {
+
+      Log_RT(2, "mediaMin ERROR: OutputWritersStart() says pthread_create() failed for output writer thread %d, %d writer threads started \n", i, i);
+      num_output_writer_threads = i;  /* no rings are attached yet, so reducing the number of writers doesn't change ring ownership */
+      break;
+   }
+
+   return num_output_writer_threads;
+}
+
+void OutputWritersStop() {  /* called by master app thread at exit. Writer threads drain remaining records before exiting */
+
+int i;
+
+   if (!num_output_writer_threads) return;
+
+   __sync_lock_test_and_set(&fOutputWritersExit, 1);
+   for (i=0; i<num_output_writer_threads; i++) OutputWriterSignal(&output_writer_data_notify[i]);  /* wake writer threads waiting with all rings empty */
+   for (i=0; i<num_output_writer_threads; i++) pthread_join(output_writer_threads[i], NULL);
+   num_output_writer_threads = 0;
+
+   for (i=0; i<OUTPUT_WRITER_MAX_RINGS; i++) if (output_writer_rings[i].buf) {
+      free(output_writer_rings[i].buf);
+      output_writer_rings[i].buf = NULL;
+   }
+}
+
+OUTPUT_WRITER_RING* OutputWriterFind(FILE* fp, int thread_index) {  /* returns ring attached to fp, NULL if none */
+
+int i, num_rings = __sync_fetch_and_add(&num_output_writer_rings, 0);
+
+   if (!num_output_writer_threads || !fp) return NULL;
+
+   for (i=0; i<num_rings; i++) if (output_writer_rings[i].fp == fp && output_writer_rings[i].thread_index == thread_index) return &output_writer_rings[i];
+
+   return NULL;
+}
+
+OUTPUT_WRITER_RING* OutputWriterAttach(FILE* fp, int thread_index) {  /* attach ring to an output pcap opened with DSOpenPcap(). Returns ring, or NULL if output writers are not active or no ring is available, in which case PullPackets() writes the pcap */
+
+OUTPUT_WRITER_RING* ring;
+int i, n;
+
+   if (!num_output_writer_threads || !fp) return NULL;
+
+   if ((ring = OutputWriterFind(fp, thread_index))) return ring;  /* already attached */
+
+   for (i=0; i<OUTPUT_WRITER_MAX_RINGS; i++) if (__sync_bool_compare_and_swap(&output_writer_rings[i].fInUse, 0, 1)) break;
+
+   if (i == OUTPUT_WRITER_MAX_RINGS) {
+
+      Log_RT(3, "mediaMin WARNING: OutputWriterAttach() says all %d output writer rings in use, output pcap will be written by app thread %d \n", OUTPUT_WRITER_MAX_RINGS, thread_index);
+      return NULL;
+   }
+
+   ring = &output_writer_rings[i];
+
+   if (!ring->buf && !(ring->buf = (uint8_t*)malloc(OUTPUT_WRITER_RING_SIZE))) {
+
+      fprintf(stderr, "Failed to allocate memory (%d bytes) for output writer ring, thread_index = %d, writing inline \n", OUTPUT_WRITER_RING_SIZE, thread_index);
+      __sync_lock_release(&ring->fInUse);
+      return NULL;
+   }
+
+   ring->thread_index = thread_index;
+   ring->writer_index = i % num_output_writer_threads;
+   ring->high_water = ring->full_waits = ring->drops = 0;
+   ring->fp = fp;  /* ring is empty (head == tail), writer thread doesn't read fp until head advances */
+
+   while ((n = __sync_fetch_and_add(&num_output_writer_rings, 0)) <= i && !__sync_bool_compare_and_swap(&num_output_writer_rings, n, i+1));
+
+   thread_info[thread_index].output_writer_rings++;
+
+   return ring;
+}
+
+void OutputWriterDetach(FILE* fp, int thread_index) {  /* wait for ring attached to fp (if any) to drain, then detach. Must be called before closing an output pcap */
+
+OUTPUT_WRITER_RING* ring;
+uint32_t notify_seq;
+
+   if (!(ring = OutputWriterFind(fp, thread_index))) return;
+
+   while (notify_seq = __atomic_load_n(&ring->space.seq, __ATOMIC_SEQ_CST), __sync_fetch_and_add(&ring->tail, 0) != ring->head) OutputWriterWait(&ring->space, notify_seq, OUTPUT_WRITER_WAIT_TIMEOUT_USEC);
+
+   thread_info[thread_index].output_writer_high_water = max(thread_info[thread_index].output_writer_high_water, ring->high_water);
+   thread_info[thread_index].output_writer_full_waits += ring->full_waits;
+   thread_info[thread_index].output_writer_drops += ring->drops;
+
+   ring->fp = NULL;
+   __sync_lock_release(&ring->fInUse);
+}
+
+void OutputWriterStats(int thread_index, char* szStats) {  /* append output writer ring stats for an app thread to szStats. Includes rings currently attached, so can be called while running. Attached ring stats are read without sync, which is ok for display */
+
+uint32_t num_attached = 0, occupancy = 0, high_water = thread_info[thread_index].output_writer_high_water, full_waits = thread_info[thread_index].output_writer_full_waits, drops = thread_info[thread_index].output_writer_drops;
+int i, num_rings = __sync_fetch_and_add(&num_output_writer_rings, 0);
+
+   for (i=0; i<num_rings; i++) if (output_writer_rings[i].fp && output_writer_rings[i].thread_index == thread_index) {
+
+      num_attached++;
+      occupancy += (uint32_t)(output_writer_rings[i].head - __sync_fetch_and_add(&output_writer_rings[i].tail, 0));
+      high_water = max(high_water, output_writer_rings[i].high_water);
+      full_waits += output_writer_rings[i].full_waits;
+      drops += output_writer_rings[i].drops;
+   }
+
+   sprintf(&szStats[strlen(szStats)], "output writer rings = %u (%u attached, %u bytes queued), max ring high-water = %u bytes (%4.2f%%), full waits = %u, drops = %u\n", thread_info[thread_index].output_writer_rings, num_attached, occupancy, high_water, 100.0*high_water/OUTPUT_WRITER_RING_SIZE, full_waits, drops);
+}
+
+int OutputWriterEnqueue(OUTPUT_WRITER_RING* ring, unsigned int uFlags, uint8_t* pkt_buf, int pkt_len, pcaprec_hdr_t* pcap_pkt_hdr) {  /* called by PullPackets() instead of DSWritePcapBuffered(). Returns 1 if the record is enqueued, 0 if dropped */
+
+uint32_t rec_size = OUTPUT_WRITER_REC_SIZE(pkt_len), pos = ring->head & (OUTPUT_WRITER_RING_SIZE-1), pad;
+uint64_t wait_start = 0;
+uint32_t notify_seq;
+OUTPUT_WRITER_REC* rec;
+struct timespec ts;
+
+   if (pkt_len <= 0 || rec_size > OUTPUT_WRITER_RING_SIZE/2) { ring->drops++; return 0; }  /* sanity check, not expected for any packet size */
+
+   pad = OUTPUT_WRITER_RING_SIZE - pos < rec_size ? OUTPUT_WRITER_RING_SIZE - pos : 0;  /* records are contiguous; if there is not enough space before end of ring, pad and wrap */
+
+   while (notify_seq = __atomic_load_n(&ring->space.seq, __ATOMIC_SEQ_CST), ring->head + pad + rec_size - __sync_fetch_and_add(&ring->tail, 0) > OUTPUT_WRITER_RING_SIZE) {  /* ring full, wait for writer thread to signal space. Notify sequence number is read before the check so a tail advance after the check is not missed */
+
+      if (!wait_start) { ring->full_waits++; wait_start = get_time(USE_CLOCK_GETTIME); }
+      else if (get_time(USE_CLOCK_GETTIME) - wait_start > OUTPUT_WRITER_FULL_TIMEOUT_USEC) { ring->drops++; return 0; }
+
+      OutputWriterWait(&ring->space, notify_seq, OUTPUT_WRITER_WAIT_TIMEOUT_USEC);
+   }
+
+   if (pad >= sizeof(OUTPUT_WRITER_REC)) ((OUTPUT_WRITER_REC*)&ring->buf[pos])->len = 0;  /* mark padding. Padding smaller than a record header is implied, see OutputWriterThread() */
+
+   rec = (OUTPUT_WRITER_REC*)&ring->buf[pad ? 0 : pos];
+   rec->len = pkt_len;
+   rec->uFlags = uFlags;
+   rec->pcap_pkt_hdr = *pcap_pkt_hdr;
+
+   if (uFlags & DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK) {  /* take wall clock timestamp now, not when the writer thread writes the record */
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      rec->pcap_pkt_hdr.ts_sec = ts.tv_sec;
+      rec->pcap_pkt_hdr.ts_usec = ts.tv_nsec/1000;
+      rec->uFlags &= ~DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK;
+   }
+
+   memcpy((uint8_t*)rec + sizeof(OUTPUT_WRITER_REC), pkt_buf, pkt_len);
+
+   __sync_synchronize();  /* record must be visible before head is advanced */
+   ring->head += pad + rec_size;
+
+   OutputWriterSignal(&output_writer_data_notify[ring->writer_index]);  /* wake writer thread if it's waiting */
+
+   ring->high_water = max(ring->high_water, (uint32_t)(ring->head - __sync_fetch_and_add(&ring->tail, 0)));
+
+   return 1;
+}
+
+/* input merge functions, used if the ENABLE_INPUT_MERGE flag is set in the -dN cmd line entry. Notes, JHB Oct 2026:
+
+   -inputs of an app thread are merged through a min-heap keyed on arrival timestamp of each input's next packet. PushPackets() takes the input at the top of the heap, consumes one packet, and goes back to the heap, so packets are pushed in global arrival order instead of one packet per input in round-robin order
+   -to get its arrival timestamp, each input's next packet is read ahead by InputMergePeek() and held in the input data cache with CACHE_PEEK state. The next GetInputData() call for that input returns it as new data. Heap key and position are in the INPUT_DATA_CACHE struct, the heap itself is in APP_THREAD_INFO (see mediaMin.h)
+   -keys are absolute arrival timestamps, so inputs should be from the same capture session, for example captures from multiple interfaces or taps. Inputs with unrelated capture times are effectively processed one after another
+   -end of input has key zero, so stream termination (close or wrap) is handled without delay. A wrapped input re-enters the heap at its rewound arrival timestamps
+   -InputMergeNext() ends the PushPackets() input loop if (i) the packet at top of the heap is still pending (arrival timestamp not yet elapsed, push queue full, etc), (ii) the same number of packets have been pushed as in round-robin order, or (iii) INPUT_MERGE_MAX_POPS heap pops have been done. The heap persists across PushPackets() calls
+   -.ber inputs have no arrival timestamps; if any are present, input merge is not activated and inputs are taken in round-robin order
+*/
+
+bool isInputMergeEarlier(int tId, int nStream1, int nStream2) {  /* heap ordering, ties are broken by stream index so results are repeatable */
+
+uint64_t key1 = thread_info[tId].input_data_cache[nStream1].merge_key, key2 = thread_info[tId].input_data_cache[nStream2].merge_key;
+
+   return key1 < key2 || (key1 == key2 && nStream1 < nStream2);
+}
+
+void InputMergeSift(int tId, int nPos) {  /* restore heap order for the input at heap position nPos, whose key may have increased or decreased */
+
+int16_t* heap = thread_info[tId].input_merge_heap;
+int heap_size = thread_info[tId].input_merge_heap_size;
+int16_t nStream = heap[nPos];
+int parent, child;
+
+   while (nPos > 0 && isInputMergeEarlier(tId, nStream, heap[parent = (nPos-1)/2])) {  /* sift up */
+
+      heap[nPos] = heap[parent];
+      thread_info[tId].input_data_cache[heap[nPos]].merge_heap_pos = nPos;
+      nPos = parent;
+   }
+
+   while ((child = 2*nPos+1) < heap_size) {  /* sift down */
+
+      if (child+1 < heap_size && isInputMergeEarlier(tId, heap[child+1], heap[child])) child++;
+      if (!isInputMergeEarlier(tId, heap[child], nStream)) break;
+
+      heap[nPos] = heap[child];
+      thread_info[tId].input_data_cache[heap[nPos]].merge_heap_pos = nPos;
+      nPos = child;
+   }
+
+   heap[nPos] = nStream;
+   thread_info[tId].input_data_cache[nStream].merge_heap_pos = nPos;
+}
+
+void InputMergePeek(uint8_t* pkt_buf, int tId, int nStream) {  /* read ahead input's next packet, if not already in cache, and update its heap key. pkt_buf is used as scratch mem */
+
+INPUT_DATA_CACHE* pCache = &thread_info[tId].input_data_cache[nStream];
+pcaprec_hdr_t pcap_rec_hdr;
+uint16_t eth_protocol, block_type;
+
+   if ((pCache->uFlags & CACHE_ITEM_MASK) == CACHE_INVALID) {
+
+      if (GetInputData(pkt_buf, tId, nStream, &pcap_rec_hdr, &eth_protocol, &block_type) < 0) {  /* read error, cache is not updated. Give the input key zero so PushPackets() handles the error without delay */
+
+         pCache->merge_key = 0;
+         pCache->fMergeEOF = true;
+         return;
+      }
+
+      pCache->uFlags = (pCache->uFlags & ~(CACHE_ITEM_MASK | CACHE_NEW_DATA)) | CACHE_PEEK;  /* hold packet in cache until PushPackets() reads it */
+   }
+
+   pCache->fMergeEOF = pCache->pkt_len <= 0;
+   pCache->merge_key = pCache->fMergeEOF ? 0 : (uint64_t)pCache->pcap_rec_hdr.ts_sec*1000000L + pCache->pcap_rec_hdr.ts_usec;
+}
+
+int InputMergeFirst(uint8_t* pkt_buf, int tId) {  /* called by PushPackets() at start of its input loop. Returns stream index of the first input to process, or -1 if no inputs are open */
+
+int j;
+
+   if (thread_info[tId].input_merge_heap_size < 0) {  /* build heap on first call after InputSetup() */
+
+      thread_info[tId].input_merge_heap_size = 0;
+
+      for (j=0; j<thread_info[tId].nInPcapFiles; j++) if (thread_info[tId].pcap_in[j] && ((thread_info[tId].link_layer_info[j] & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) == PCAP_TYPE_BER) {
+
+         Log_RT(3, "mediaMin WARNING: InputMergeFirst() says input %s has no packet arrival timestamps, input merge not enabled for app thread %d \n", MediaParams[thread_info[tId].cmd_line_input_index[j]].Media.inputFilename, tId);
+         return 0;  /* fInputMerge stays false, PushPackets() uses round-robin order */
+      }
+
+      for (j=0; j<thread_info[tId].nInPcapFiles; j++) if (thread_info[tId].pcap_in[j]) {
+
+         InputMergePeek(pkt_buf, tId, j);
+
+         thread_info[tId].input_merge_heap[thread_info[tId].input_merge_heap_size++] = j;
+         InputMergeSift(tId, thread_info[tId].input_merge_heap_size-1);
+      }
+
+      thread_info[tId].fInputMerge = true;
+   }
+
+   if (!thread_info[tId].fInputMerge) return 0;
+
+   return thread_info[tId].input_merge_heap_size > 0 ? thread_info[tId].input_merge_heap[0] : -1;
+}
+
+int InputMergeNext(uint8_t* pkt_buf, int tId, int nStream, int push_cnt, int nPops) {  /* called by PushPackets() after processing input nStream, which is at top of the heap. Returns stream index of the next input to process, or -1 to end the input loop */
+
+INPUT_DATA_CACHE* pCache = &thread_info[tId].input_data_cache[nStream];
+int16_t* heap = thread_info[tId].input_merge_heap;
+int nPos = pCache->merge_heap_pos;
+bool fStop = false;
+
+   if (!thread_info[tId].pcap_in[nStream]) {  /* input has been closed, remove from heap */
+
+      int16_t nLast = heap[--thread_info[tId].input_merge_heap_size];
+
+      if (nPos < thread_info[tId].input_merge_heap_size) {
+
+         heap[nPos] = nLast;
+         InputMergeSift(tId, nPos);
+      }
+   }
+   else if ((pCache->uFlags & CACHE_ITEM_MASK) != CACHE_INVALID) fStop = true;  /* packet still pending; e.g. arrival timestamp not yet elapsed or push queue full. Its key is unchanged and no other input can go ahead of it */
+   else {
+
+      bool fPrevEOF = pCache->fMergeEOF;
+
+      InputMergePeek(pkt_buf, tId, nStream);
+      InputMergeSift(tId, nPos);
+
+      if (fPrevEOF && pCache->fMergeEOF) fStop = true;  /* end of input still pending, e.g. waiting for queues to empty before wrapping */
+   }
+
+   if (fStop || thread_info[tId].input_merge_heap_size <= 0 || push_cnt >= thread_info[tId].nInPcapFiles*(1 + nReuseInputs) || nPops >= INPUT_MERGE_MAX_POPS) return -1;
+
+   return heap[0];
+}
+
+void InputSetup(uint64_t cur_time, int thread_index) {
+
+int cmd_line_input = 0;  /* command line input index (i.e. -i xxx specs on command line) */
+int nStream = 0;  /* stream index */
+char tmpstr[1024];
+unsigned int uFlags;
+
+   if (thread_info[thread_index].init_err) return;
+
+   if (Mode & AUTO_ADJUST_PUSH_TIMING) average_push_rate[thread_index] = 2;  /* initialize auto-adjust push rate algorithm state */
+
+   thread_info[thread_index].nInPcapFiles = 0;
+   thread_info[thread_index].input_merge_heap_size = -1;  /* input merge heap is built on first PushPackets() call, JHB Oct 2026 */
+   thread_info[thread_index].fInputMerge = false;
+
+   if ((Mode & ENABLE_PUSH_BATCHING) && !thread_info[thread_index].push_batch) thread_info[thread_index].push_batch = (PUSH_BATCH*)calloc(1, sizeof(PUSH_BATCH));  /* allocate push batch, JHB Oct 2026 */
+
+   uFlags = DS_READ;
+   if (fCapacityTest) uFlags |= DS_OPEN_PCAP_QUIET;
+   if (Mode & ENABLE_MMAP_INPUT) uFlags |= DS_OPEN_PCAP_MMAP;  /* memory-map inputs, GetInputData() uses DSReadPcapPtr(), JHB Oct 2026 */
+
+/* open input pcap files, advance file pointer to first packet. Abort program on any input file failure */
+
+   #pragma GCC diagnostic push  /* suppress "address of var will never be NULL" warnings in gcc 12.2; safe-coding rules prevail, JHB May 2023 */
+   #pragma GCC diagnostic ignored "-Waddress"
+   while (MediaParams[cmd_line_input].Media.inputFilename != NULL && strlen(MediaParams[cmd_line_input].Media.inputFilename)) {
    #pragma GCC diagnostic pop
 
       if (strcasestr(MediaParams[cmd_line_input].Media.inputFilename, ".pcap") || strcasestr(MediaParams[cmd_line_input].Media.inputFilename, ".rtp")) {  /* look for .pcap and .pcapng, JHB Oct 2020. Look for .rtp and .rtpdump, JHB Nov 2023 */
@@ -4615,6 +5640,7 @@ valid_input_spec:
          thread_info[thread_index].num_unhandled_rtp_packets[nStream] = 0;
          thread_info[thread_index].num_oversize_nonfragmented_packets[nStream] = 0;
          thread_info[thread_index].num_packets_encapsulated[nStream] = 0;
+         thread_info[thread_index].num_flow_partition_skipped[nStream] = 0;
          thread_info[thread_index].num_packets_fragmented[nStream] = 0;
          thread_info[thread_index].num_packets_reassembled[nStream] = 0;
          thread_info[thread_index].cmd_line_input_index[nStream] = cmd_line_input;  /* save to allow mapping from command line input to stream index. See "stream and session notes" in mediaMin.h */
@@ -4627,7 +5653,7 @@ valid_input_spec:
             fprintf(stderr, "Failed to allocate memory (%d bytes) for input cache packet data, thread_index = %d \n", NOMINAL_MTU, thread_index);
 
             if (thread_info[thread_index].pcap_in[nStream]) {
-               fclose(thread_info[thread_index].pcap_in[nStream]);
+               DSClosePcap(thread_info[thread_index].pcap_in[nStream], DS_CLOSE_PCAP_QUIET);  /* DSClosePcap() instead of fclose(), inputs opened with DS_OPEN_PCAP_MMAP have a mapping to release */
                thread_info[thread_index].pcap_in[nStream] = NULL;
             }
 
@@ -4635,6 +5661,32 @@ valid_input_spec:
             break;
          }
 
+      /* in AFAP mode allocate batch read mem for pcap inputs. GetInputData() uses DSReadPcapBatch() if batch_recs is non-NULL. Not needed if --read_ahead is entered, in which case ring slots are used as batch mem, JHB Oct 2026 */
+
+         thread_info[thread_index].input_data_cache[nStream].batch_count = thread_info[thread_index].input_data_cache[nStream].batch_index = 0;
+
+         if (isAFAPMode && nReadAheadDepth <= 0 && ((thread_info[thread_index].link_layer_info[nStream] & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) != PCAP_TYPE_BER) {
+
+            thread_info[thread_index].input_data_cache[nStream].batch_arena = (uint8_t*)malloc(INPUT_BATCH_ARENA_SIZE);
+            thread_info[thread_index].input_data_cache[nStream].batch_recs = (pcap_batch_rec_t*)malloc(INPUT_BATCH_MAX_RECS*sizeof(pcap_batch_rec_t));
+
+            if (!thread_info[thread_index].input_data_cache[nStream].batch_arena || !thread_info[thread_index].input_data_cache[nStream].batch_recs) {  /* not fatal, fall back to per-packet reads */
+
+               fprintf(stderr, "Failed to allocate memory (%d bytes) for input batch reads, thread_index = %d, using per-packet reads \n", INPUT_BATCH_ARENA_SIZE, thread_index);
+
+               if (thread_info[thread_index].input_data_cache[nStream].batch_arena) free(thread_info[thread_index].input_data_cache[nStream].batch_arena);
+               if (thread_info[thread_index].input_data_cache[nStream].batch_recs) free(thread_info[thread_index].input_data_cache[nStream].batch_recs);
+               thread_info[thread_index].input_data_cache[nStream].batch_arena = NULL;
+               thread_info[thread_index].input_data_cache[nStream].batch_recs = NULL;
+            }
+         }
+
+         InputTimeWindowSetup(thread_index, nStream);  /* apply --start_time and --stop_time cmd line entries, if any, JHB Oct 2026 */
+
+         DSInitPacketDuplicateRing(&thread_info[thread_index].dup_ring[nStream], nDupLookback >= 0 ? nDupLookback : DS_PKT_DUPLICATE_DEFAULT_LOOKBACK);  /* duplicate packet detection lookback, JHB Oct 2026. Default is zero (previous packet comparison), the ring is opt-in with --dup_lookback */
+
+         if (nReadAheadDepth > 0 && ((thread_info[thread_index].link_layer_info[nStream] & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) != PCAP_TYPE_BER) InputReadAheadStart(thread_index, nStream);  /* start read-ahead thread if --read_ahead entered. Done after InputTimeWindowSetup() as the producer reads from the current input position, JHB Oct 2026 */
+
          thread_info[thread_index].nInPcapFiles = ++nStream;
       }
       else { fprintf(stderr, "Input file %s does not have .pcap, .pcapng, .rtp, .rtpdump, or .ber file extension \n", MediaParams[cmd_line_input].Media.inputFilename); break; }
@@ -4698,6 +5750,9 @@ int nOutputIndex = thread_info[thread_index].nOutFiles;  /* start with first cmd
             nOutputIndex++; continue;  /* look for next output spec on cmd line; we don't know in what order sessions will be created vs order user has entered on cmd line */
          }
 
+         DSCreatePcapWriter(thread_info[thread_index].out_file[thread_info[thread_index].nOutFiles], 0, 0);  /* attach buffered writer, returns 0 if already attached, JHB Oct 2026 */
+         OutputWriterAttach(thread_info[thread_index].out_file[thread_info[thread_index].nOutFiles], thread_index);  /* attach output writer ring if --output_writers entered, returns existing ring if already attached */
+
          thread_info[thread_index].uOutputType[thread_info[thread_index].nOutFiles] = PCAP;  /* set data type for use in PullPackets(). See io_data_type enums (mediaTest.h), JHB Sep 2024 */
       }
       else if (isVideoCodec(codec_type) &&  /* to-do: needs to be reverse strcasestr() */
@@ -4834,6 +5889,7 @@ unsigned int uFlags;
       if (Mode & ANALYTICS_MODE) strcat(filestr, "_am");
       else if (fUntimedMode) strcat(filestr, "_um");
       strcat(filestr, ".pcap"); 
+      if (nOutputCompression) strcat(filestr, nOutputCompression == 1 ? ".gz" : ".zst");  /* --compress_output entered, DSOpenPcap() compresses outputs based on file extension, JHB Oct 2026 */
 
       strcpy(thread_info[thread_index].szGroupPcap[group_idx], filestr);  /* save copy of group output pcap path, JHB Dec 2023 */
 
@@ -4845,6 +5901,10 @@ unsigned int uFlags;
          thread_info[thread_index].fp_pcap_group[group_idx] = NULL;
          thread_info[thread_index].init_err = true;
       }
+      else {
+         DSCreatePcapWriter(thread_info[thread_index].fp_pcap_group[group_idx], 0, 0);  /* attach buffered writer, JHB Oct 2026 */
+         OutputWriterAttach(thread_info[thread_index].fp_pcap_group[group_idx], thread_index);  /* attach output writer ring if --output_writers entered */
+      }
    }
 
    #if 0  /* not used, ASR output text is handled in pktlib and streamlib, JHB Jan 2021 */
@@ -4902,10 +5962,15 @@ unsigned int uFlags;
       sprintf(filestr, "%s%d", jb_output_pcap_filename, hSession);
       if (num_app_threads > 1) sprintf(&filestr[strlen(filestr)], "_%d", thread_index);
       sprintf(&filestr[strlen(filestr)], ".pcap"); 
+      if (nOutputCompression) strcat(filestr, nOutputCompression == 1 ? ".gz" : ".zst");  /* --compress_output entered, JHB Oct 2026 */
 
       ret_val = DSOpenPcap(filestr, uFlags, &thread_info[thread_index].fp_pcap_jb[nSessionIndex], NULL, "");
 
       if (ret_val < 0 || thread_info[thread_index].fp_pcap_jb[nSessionIndex] == NULL) { fprintf(stderr, "Failed to open jitter buffer output pcap file: %s for session %d, ret_val = %d \n", filestr, hSession, ret_val); }
+      else {
+         DSCreatePcapWriter(thread_info[thread_index].fp_pcap_jb[nSessionIndex], 0, 0);  /* attach buffered writer, JHB Oct 2026 */
+         OutputWriterAttach(thread_info[thread_index].fp_pcap_jb[nSessionIndex], thread_index);  /* attach output writer ring if --output_writers entered */
+      }
    }
 }
 
@@ -4930,8 +5995,12 @@ unsigned int uFlags;
 
    uFlags = DS_MEDIASERVICE_START | DS_MEDIASERVICE_THREAD | DS_MEDIASERVICE_PIN_THREADS | DS_MEDIASERVICE_SET_NICENESS;
    if (Mode & ROUND_ROBIN_SESSION_ALLOCATION) uFlags |= DS_MEDIASERVICE_ROUND_ROBIN;
+   if (Mode & ENABLE_THREAD_REBALANCE) uFlags |= DS_MEDIASERVICE_REBALANCE_THREADS;  /* move sessions or stream groups between p/m threads if their loads become uneven, JHB Oct 2026 */
 
    uFlags |= DS_MEDIASERVICE_ENABLE_THREAD_PROFILING;  /* slight impact on performance, but useful. Turn off for highest possible performance */
+   if (Mode & ENABLE_SPIN_THEN_BLOCK) uFlags |= DS_MEDIASERVICE_SPIN_THEN_BLOCK;  /* in energy saver state p/m threads block until packets are pushed instead of sleeping and polling. Default is uThreadEnergySaverSleepTime sleeps, JHB Oct 2026 */
+   if (Mode & ENABLE_BATCH_DECODE) uFlags |= DS_MEDIASERVICE_BATCH_DECODE;  /* p/m threads decode frames in multichannel batches. Adds one p/m thread loop iteration of output latency, so it's opt-in, JHB Oct 2026 */
+   if (Mode & ENABLE_PIPELINE_DECODE) uFlags |= DS_MEDIASERVICE_PIPELINE_DECODE;  /* p/m threads hand off queued frames to codec stage threads, JHB Oct 2026 */
 
    if (DSConfigMediaService(NULL, uFlags, num_pktmed_threads, packet_flow_media_proc, NULL) < 0) {  /* start packet/media thread(s) */
 
@@ -4979,7 +6048,7 @@ uint64_t* queue_check_time = (uint64_t*)pQueueCheckTime;
 
          if (queue_empty) {  /* continue with queue status check */
 
-            if (DSPushPackets(DS_PUSHPACKETS_GET_QUEUE_STATUS, NULL, NULL, &hSessions[i], 1) == 0) queue_empty = false;  /* input queue not empty yet */
+            if (DSPushPackets(DS_PUSHPACKETS_GET_QUEUE_STATUS, NULL, NULL, &hSessions[i], 1) == 0 || isPushBatchPending(hSessions[i], thread_index)) queue_empty = false;  /* input queue not empty yet. Packets in the push batch, if any, are included, JHB Oct 2026 */
             else {
 
                if ((Mode & (USE_PACKET_ARRIVAL_TIMES | ANALYTICS_MODE)) && !thread_info[thread_index].flush_state[i]) {  /* for real-time packet flow when input has ended (e.g. pcap input with packet arrival times), flush on end of input and push queue empty, JHB Mar 2020 */
@@ -5323,7 +6392,9 @@ struct itimerval tval;
 
 void ThreadWait(int when, uint64_t cur_time, int thread_index) {
 
-int i, j, wait_msec, wait_time;
+int i, wait_msec, wait_time;
+uint64_t t, wait_end;
+uint32_t notify_seq;
 static bool fFirstWait = false;
 
    if (isMasterThread(thread_index)) {
@@ -5353,12 +6424,15 @@ static bool fFirstWait = false;
          if (when == 0) app_printf(APP_PRINTF_NEW_LINE | APP_PRINTF_THREAD_INDEX_SUFFIX | APP_PRINTF_PRINT_ONLY, cur_time, thread_index, "! mediaMin app thread %d staggered start waiting %d msec", thread_index, wait_msec);
          else app_printf(APP_PRINTF_NEW_LINE | APP_PRINTF_THREAD_INDEX_SUFFIX | APP_PRINTF_PRINT_ONLY, cur_time, thread_index, "! mediaMin app thread %d waiting %d msec before repeat", thread_index, wait_msec);
 
-         for (j=0; j<wait_msec*1000; j+=500) {
+         for (t = get_time(USE_CLOCK_GETTIME), wait_end = t + wait_msec*1000; t < wait_end; t = get_time(USE_CLOCK_GETTIME)) {  /* wait in intervals of up to 100 msec and check for fQuit. DS_PKT_NOTIFY_APP is signaled when 'q' key is pressed, JHB Oct 2026 */
 
-            usleep(500);  /* sleep in 500 usec intervals and check for fQuit */
+            notify_seq = DSGetPacketNotifySeq(DS_PKT_NOTIFY_APP);
             if (fQuit) return;
+            DSWaitPacketNotify(DS_PKT_NOTIFY_APP, notify_seq, (unsigned int)min(wait_end - t, (uint64_t)100000));
          }
 
+         if (fQuit) return;
+
          app_printf(APP_PRINTF_NEW_LINE | APP_PRINTF_THREAD_INDEX_SUFFIX | APP_PRINTF_PRINT_ONLY, cur_time, thread_index, "! mediaMin app thread %d waited %d msec", thread_index, wait_msec);
       }
    }
@@ -5505,6 +6579,46 @@ bool SDPInfoCheck(uint8_t* pkt_buf, int pkt_len) {
    return (p != NULL);
 }
 
+/* FlowPartition() returns the app thread that handles a media packet's flow if the ENABLE_FLOW_PARTITION flag is set and the -tN cmd line entry is more than one thread. Notes, JHB Oct 2026:
+
+   -every app thread reads all inputs and sees all packets, including SIP, SAP/SDP, TCP, and fragments, so SDP info databases and fragment reassembly are the same in each thread. Only media packets are partitioned, just before RTP processing, so session lookup and dynamic session creation for a flow happen in one thread and no session is duplicated across threads
+   -the flow key is IP addr and UDP port of both endpoints. Endpoints are put in sorted order so both directions of a call go to the same thread (required for stream groups), and the port low bit is cleared so RTCP (RTP port + 1) stays with its RTP
+   -the key is hashed with FNV-1a, all threads compute the same partition for a given packet
+   -partitioning is by flow, so thread load depends on the mix of flows in the input. An input with one or two flows will still be handled by one thread
+*/
+
+int FlowPartition(uint8_t* pkt_buf, PKTINFO* PktInfo, int num_partitions) {
+
+uint8_t ep[2][IPV6_ADDR_LEN + sizeof(uint16_t)];  /* endpoints, addr followed by port */
+int i, addr_len, addr_ofs, ep_len, lo;
+uint16_t port;
+uint32_t hash = 2166136261U;  /* FNV-1a offset basis */
+
+   if (num_partitions <= 1) return 0;
+
+   if (PktInfo->version == 6) { addr_len = IPV6_ADDR_LEN; addr_ofs = IPV6_ADDR_OFS; }
+   else { addr_len = IPV4_ADDR_LEN; addr_ofs = IPV4_ADDR_OFS; }
+
+   ep_len = addr_len + sizeof(uint16_t);
+
+   for (i=0; i<2; i++) {
+
+      memcpy(ep[i], &pkt_buf[addr_ofs + i*addr_len], addr_len);  /* src addr, then dst addr */
+      port = (i == 0 ? PktInfo->src_port : PktInfo->dst_port) & ~1;
+      memcpy(&ep[i][addr_len], &port, sizeof(uint16_t));
+   }
+
+   lo = memcmp(ep[0], ep[1], ep_len) <= 0 ? 0 : 1;
+
+   for (i=0; i<2*ep_len; i++) {
+
+      hash ^= ep[i < ep_len ? lo : 1-lo][i % ep_len];
+      hash *= 16777619U;  /* FNV prime */
+   }
+
+   return hash % num_partitions;
+}
+
 /* isPortAllowed() handles non-RTP UDP and TCP ports, notes JHB Jan 2023:
 
    -looks through list of allowed ports given on cmd line
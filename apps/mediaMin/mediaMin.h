@@ -59,11 +59,22 @@
    Modified Apr 2025 JHB, rename hdr_type field to eth_protocol in INPUT_DATA_CACHE struct, to align with updates in pktlib.h
    Modified Apr 2025 JHB, add num_rtcp_custom_packets[] stat
    Modified Apr 2025 JHB, simplify stream stats implementation, remove uStreamStatsState[]
+   Modified Oct 2026 JHB, add batch read items to INPUT_DATA_CACHE struct, define INPUT_BATCH_MAX_RECS and INPUT_BATCH_ARENA_SIZE
+   Modified Oct 2026 JHB, add stop_time and fStopped to INPUT_DATA_CACHE struct to support --start_time and --stop_time cmd line options
+   Modified Oct 2026 JHB, define INPUT_READ_AHEAD struct, add read_ahead to INPUT_DATA_CACHE struct and read-ahead stats to APP_THREAD_INFO struct to support --read_ahead cmd line option
+   Modified Oct 2026 JHB, add num_flow_partition_skipped[] stat to support ENABLE_FLOW_PARTITION cmd line flag
+   Modified Oct 2026 JHB, add input merge heap items to INPUT_DATA_CACHE and APP_THREAD_INFO structs, define CACHE_PEEK flag and INPUT_MERGE_MAX_POPS, to support ENABLE_INPUT_MERGE cmd line flag
+   Modified Oct 2026 JHB, add dup_ring[] to APP_THREAD_INFO struct for per stream duplicate packet detection
+   Modified Oct 2026 JHB, define PUSH_BATCH and PUSH_BATCH_PKT structs, add push_batch and push batch stats to APP_THREAD_INFO struct, to support ENABLE_PUSH_BATCHING cmd line flag
+   Modified Oct 2026 JHB, define OUTPUT_WRITER_RING and OUTPUT_WRITER_REC structs, add output writer stats to APP_THREAD_INFO struct, to support --output_writers cmd line option
+   Modified Oct 2026 JHB, define OUTPUT_WRITER_NOTIFY struct, add space notify and writer index to OUTPUT_WRITER_RING struct. Output writer threads and producers block on futexes instead of polling; OUTPUT_WRITER_WAIT_USEC replaced by OUTPUT_WRITER_WAIT_TIMEOUT_USEC
 */
 
 #ifndef _MEDIAMIN_H_
 #define _MEDIAMIN_H_
 
+#include <pthread.h>
+
 #include "cmd_line_options_flags.h"  /* cmd line options and flags definitions. cmd_line_options_flags.h is on mediaTest subfolder, JHB Jan 2022 */
 
 /* SigSRF includes */
@@ -169,6 +180,28 @@ typedef struct {
 
 #define MAX_DYN_PYLD_TYPES  32  /* max number of disallowed payload type messsages (fDisallowedPyldTypeMsg) */
 
+/* input read-ahead ring, enabled by --read_ahead N cmd line entry. A producer thread per input fills ring slots with DSReadPcapBatch() and GetInputData() consumes them, so file read latency doesn't stall the app thread. Each slot holds one batch; N is the number of slots, JHB Oct 2026 */
+
+typedef struct {
+
+  int                thread_index;  /* app thread index and stream of the input */
+  int                nStream;
+  pthread_t          thread;        /* producer thread, valid if fRunning is set */
+  bool               fRunning;
+  int                depth;         /* number of ring slots */
+
+  uint8_t*           slot_arena;    /* packet data for all slots, slot n data starts at slot_arena[n*INPUT_BATCH_ARENA_SIZE] */
+  pcap_batch_rec_t*  slot_recs;     /* record info for all slots, slot n records start at slot_recs[n*INPUT_BATCH_MAX_RECS] */
+  int*               slot_count;    /* number of records in each slot, < 0 indicates a read error */
+
+  volatile uint32_t  head;          /* number of slots filled, written only by producer */
+  volatile uint32_t  tail;          /* number of slots released, written only by consumer */
+  volatile int       fEnd;          /* set by producer at end of input or read error, after the last slot is filled */
+  volatile int       fExit;         /* set by InputReadAheadStop() to stop the producer */
+  bool               fSlotHeld;     /* consumer is holding slot tail % depth. The held slot also serves as input cache packet data, so it's not released until the next slot is taken */
+
+} INPUT_READ_AHEAD;
+
 typedef struct {  /* input data cache items, JHB Oct 2024 */
 
   uint16_t       eth_protocol;
@@ -177,13 +210,108 @@ typedef struct {  /* input data cache items, JHB Oct 2024 */
   uint8_t*       pkt_buf;        /* pointer to allocated packet data buffer */
   uint8_t        uFlags;
 
+  uint8_t*           batch_arena;  /* batch read packet arena filled by DSReadPcapBatch(), NULL if batch reads are not active. When active, cached packet data is read from the arena instead of pkt_buf, JHB Oct 2026 */
+  pcap_batch_rec_t*  batch_recs;   /* per-record info for current batch (see pcap_batch_rec_t in pktlib.h) */
+  int                batch_count;  /* number of records in current batch */
+  int                batch_index;  /* index of next record to be returned by GetInputData() */
+
+  uint64_t           stop_time;    /* --stop_time cmd line entry converted to absolute arrival timestamp (usec), UINT64_MAX if no stop time. Set by InputTimeWindowSetup(), JHB Oct 2026 */
+  bool               fStopped;     /* set by GetInputData() after first record with arrival timestamp past stop_time. Subsequent calls return end of input until the input wraps */
+
+  INPUT_READ_AHEAD*  read_ahead;   /* read-ahead ring, NULL if not active. When active batch_arena and batch_recs point to the consumer's current ring slot, JHB Oct 2026 */
+
+  uint64_t           merge_key;       /* input merge heap key, arrival timestamp (usec) of the input's next packet, zero for end of input. Used if ENABLE_INPUT_MERGE flag is set in -dN cmd line entry, JHB Oct 2026 */
+  int16_t            merge_heap_pos;  /* position of the input in APP_THREAD_INFO input_merge_heap[] */
+  bool               fMergeEOF;       /* next packet is end of input (or a read error) */
+
 } INPUT_DATA_CACHE;
 
+#define INPUT_BATCH_MAX_RECS    64  /* max records per DSReadPcapBatch() call */
+#define INPUT_BATCH_ARENA_SIZE  (INPUT_BATCH_MAX_RECS*NOMINAL_MTU + MAX_TCP_PACKET_LEN)  /* room for a batch of nominal size packets, plus the min arena size required by DSReadPcapBatch() for non memory-mapped inputs */
+
+#define INPUT_READ_AHEAD_MAX_DEPTH   256  /* max --read_ahead entry. Each slot is INPUT_BATCH_ARENA_SIZE bytes */
+#define INPUT_READ_AHEAD_WAIT_USEC    50  /* producer wait when ring is full, consumer wait when ring is empty */
+
+#define INPUT_MERGE_MAX_POPS         256  /* max input merge heap pops per PushPackets() call */
+
+/* push batch, used if ENABLE_PUSH_BATCHING flag is set in -dN cmd line entry. PushPackets() accumulates packets across inputs and sessions and pushes them with one DSPushPackets() call, JHB Oct 2026 */
+
+#define PUSH_BATCH_MAX_PKTS     64
+#define PUSH_BATCH_ARENA_SIZE   (PUSH_BATCH_MAX_PKTS*NOMINAL_MTU + MAX_TCP_PACKET_LEN)  /* room for a batch of nominal size packets; an empty batch always has room for one max size packet */
+
+typedef struct {  /* per packet info needed after a packet is accepted by DSPushPackets() */
+
+  int       nSessionIndex;  /* index into hSessions[] */
+  int       nStream;
+  int       chnum;
+  uint32_t  rtp_ssrc;
+  uint32_t  rtp_timestamp;
+  int       rtp_pyld_len;
+  float     msec_timestamp_fp;  /* packet arrival timestamp, in msec */
+
+} PUSH_BATCH_PKT;
+
+typedef struct {
+
+  int             num_pkts;
+  int             arena_len;                        /* bytes used in arena */
+  int             pkt_len[PUSH_BATCH_MAX_PKTS];
+  HSESSION        hSession[PUSH_BATCH_MAX_PKTS];
+  PUSH_BATCH_PKT  pkt[PUSH_BATCH_MAX_PKTS];
+  uint8_t         arena[PUSH_BATCH_ARENA_SIZE];     /* packets stored consecutively, as expected by DSPushPackets() */
+
+} PUSH_BATCH;
+
+/* output writer ring, used if --output_writers N is entered on the cmd line. PullPackets() enqueues output packets and their pcap record headers into a ring per output pcap, and N writer threads drain the rings with DSWritePcapBuffered(), so slow output storage doesn't stall pulling, JHB Oct 2026 */
+
+typedef struct {  /* output writer futex wait/wake, see OutputWriterWait() and OutputWriterSignal() in mediaMin.cpp */
+
+  volatile uint32_t  seq;           /* futex word, incremented on each signal */
+  volatile uint32_t  waiters;       /* number of threads waiting */
+
+} __attribute__((aligned(64))) OUTPUT_WRITER_NOTIFY;
+
+typedef struct {
+
+  FILE*              fp;            /* output pcap, NULL if the ring is not attached. Set before any records are enqueued and cleared only after the ring is drained */
+  int                thread_index;  /* app thread that enqueues to the ring (single producer) */
+  int                writer_index;  /* writer thread that drains the ring (single consumer) */
+  volatile int       fInUse;
+
+  uint8_t*           buf;           /* OUTPUT_WRITER_RING_SIZE bytes of records, allocated on first attach and kept for reuse */
+  volatile uint64_t  head;          /* bytes enqueued, written only by the producer */
+  volatile uint64_t  tail;          /* bytes drained, written only by the writer thread that owns the ring (single consumer) */
+
+  uint32_t           high_water;    /* max ring occupancy, in bytes */
+  uint32_t           full_waits;    /* number of times the producer found the ring full */
+  uint32_t           drops;         /* number of records dropped after waiting OUTPUT_WRITER_FULL_TIMEOUT_USEC for ring space */
+
+  OUTPUT_WRITER_NOTIFY  space;      /* signaled by the writer thread when tail advances. Producer waits on this when the ring is full, OutputWriterDetach() waits on it for the ring to drain */
+
+} OUTPUT_WRITER_RING;
+
+typedef struct {  /* ring record header, followed by packet data. Records are padded to 8 byte multiples, zero len indicates padding to end of ring */
+
+  uint32_t       len;
+  uint32_t       uFlags;        /* DSWritePcapBuffered() uFlags */
+  pcaprec_hdr_t  pcap_pkt_hdr;
+
+} OUTPUT_WRITER_REC;
+
+#define OUTPUT_WRITER_MAX_THREADS                 8  /* max --output_writers entry */
+#define OUTPUT_WRITER_MAX_RINGS                 512  /* max output pcaps with rings attached, across all app threads */
+#define OUTPUT_WRITER_RING_SIZE         (1024*1024)  /* ring size in bytes, must be a power of 2 */
+#define OUTPUT_WRITER_WAIT_TIMEOUT_USEC        10000  /* max futex wait for writer threads with all rings empty, and producers with a full ring. Waits normally end when signaled; the timeout limits the effect of an unexpected missed signal */
+#define OUTPUT_WRITER_FULL_TIMEOUT_USEC      100000  /* max producer wait for ring space before dropping a record */
+
+#define OUTPUT_WRITER_REC_SIZE(len)  ((sizeof(OUTPUT_WRITER_REC) + (len) + 7) & ~7)  /* ring record size, including header and padding */
+
 /* definitions for uFlags field in INPUT_DATA_CACHE struct */
 
 #define CACHE_INVALID          0  /* indicate to GetInputData() that input cache contains stale or outdated data */
 #define CACHE_READ             1  /* indicate to GetInputData() that current packet data is still being processed and should be read from input cache, examples include (i) packet arrival timestamp not yet elapsed and (ii) a TCP packet being consumed in segments */
 #define CACHE_READ_PKTBUF      2  /* same as CACHE_READ but indicates pktbuf is no longer valid due to in-place processing and should also be read from cache */
+#define CACHE_PEEK             3  /* indicate to GetInputData() that cache holds the input's next packet, read ahead of time to get its arrival timestamp. It should be returned from cache as new data (see InputMergePeek() in mediaMin.cpp), JHB Oct 2026 */
 
 #define CACHE_NEW_DATA      0x10  /* set by GetInputData(), indicates input cache has been updated with new data */
 #define CACHE_MTU_EXPANDED  0x20  /* set by GetInputData(), indicates input cache packet data buffer size is currently expanded for an oversize packet */
@@ -211,6 +339,15 @@ typedef struct {
 
   INPUT_DATA_CACHE      input_data_cache[MAX_STREAMS_THREAD];  /* per-stream input data read cache, JHB Oct 2024 */
 
+  int16_t               input_merge_heap[MAX_STREAMS_THREAD];  /* min-heap of input stream indexes keyed on input_data_cache[].merge_key, used if ENABLE_INPUT_MERGE flag is set in -dN cmd line entry, JHB Oct 2026 */
+  int16_t               input_merge_heap_size;  /* number of inputs in heap, -1 if heap not yet built */
+  bool                  fInputMerge;  /* input merge is active */
+
+  PUSH_BATCH*           push_batch;  /* push batch, NULL if ENABLE_PUSH_BATCHING flag is not set in -dN cmd line entry. Packets in the batch have been taken from input but not yet accepted by DSPushPackets(), JHB Oct 2026 */
+  uint32_t              push_batch_pushes;           /* number of DSPushPackets() calls for batches */
+  uint64_t              push_batch_pkts;             /* number of packets accepted in batches */
+  uint32_t              push_batch_partial_accepts;  /* number of batch pushes with some packets not accepted due to full queues */
+
   FILE*                 out_file[MAX_STREAMS_THREAD];
   uint8_t               uOutputType[MAX_STREAMS_THREAD];
 
@@ -239,6 +376,23 @@ typedef struct {
   uint32_t              num_packets_fragmented[MAX_STREAMS_THREAD];
   uint32_t              num_packets_reassembled[MAX_STREAMS_THREAD];
 
+  uint32_t              num_flow_partition_skipped[MAX_STREAMS_THREAD];  /* media packets in flows handled by other app threads, see FlowPartition() in mediaMin.cpp, JHB Oct 2026 */
+
+/* input read-ahead stats, see INPUT_READ_AHEAD struct above, JHB Oct 2026 */
+
+  uint32_t              read_ahead_slots[MAX_STREAMS_THREAD];          /* number of ring slots consumed */
+  uint64_t              read_ahead_occupancy[MAX_STREAMS_THREAD];      /* sum of ring occupancy (filled slots) at each slot consumed, divided by read_ahead_slots for average occupancy */
+  uint32_t              read_ahead_max_occupancy[MAX_STREAMS_THREAD];
+  uint32_t              read_ahead_stalls[MAX_STREAMS_THREAD];         /* number of times GetInputData() found the ring empty and had to wait */
+  uint32_t              read_ahead_full_waits[MAX_STREAMS_THREAD];     /* number of times the producer found the ring full */
+
+/* output writer stats, accumulated from OUTPUT_WRITER_RING structs when rings are detached, JHB Oct 2026 */
+
+  uint32_t              output_writer_rings;       /* number of output pcaps that had rings attached */
+  uint32_t              output_writer_high_water;  /* max occupancy of any ring, in bytes */
+  uint32_t              output_writer_full_waits;
+  uint32_t              output_writer_drops;
+
 /* stream group items */
 
   FILE*                 fp_pcap_group[MAX_STREAM_GROUPS];  /* note - this array is accessed by a session counter, and each app thread might handle up to 50 sessions, so this size (172, defined in shared_include/streamlib.h) is overkill.  But leave it for now */
@@ -306,6 +460,7 @@ typedef struct {
   PKTINFO               PktInfo[MAX_STREAMS_THREAD];                 /* saved copy of PktInfo, can be used to compare current and previous packets */ 
   unsigned int          tcp_redundant_discards[MAX_STREAMS_THREAD];  /* count of discarded TCP redundant retransmissions */
   unsigned int          udp_redundant_discards[MAX_STREAMS_THREAD];  /* count of discarded UDP redundant retransmissions, JHB Jun 2024 */
+  PKT_DUPLICATE_RING    dup_ring[MAX_STREAMS_THREAD];                /* per stream duplicate packet fingerprint ring, used by DSIsPacketDuplicateRing(). Lookback is set by --dup_lookback cmd line option, JHB Oct 2026 */
 
 /* packet fragmentation items, JHB Jun 2024 */
 
@@ -59,6 +59,8 @@
    Modified Mar 2025 JHB, improve display of SDP info originating from .sdp files (i) implement SDP_PARSE_ALLOW_ZERO_ORIGIN flag, (i) leave comments occurring later on the same line as SDP info text, (iii) remove whitespace lines (e.g. all spaces then a CRLF)
    Modified Apr 2025 JHB, improve SIP message detection and display, add SESSION_CONTROL_FOUND_SIP_TCP_OTHER and SESSION_CONTROL_FOUND_SIP_UDP_OTHER flags, add port exclude and text exclude to avoid MySQL messages with similar keywords as SIP or messages with conflicting keywords
    Modified Apr 2025 JHB, fix bug in find_keyword() case-insensitive search, return value is offset relative to buffer input param, not tmpstr
+   Modified Oct 2026 JHB, add find_keyword_iov() to search payload data split across buffers. In ProcessSessionControl() describe saved partial SDP info and current payload with an iovec list and screen for SDP info / SIP messages without copying; saved data is inserted into pkt_buf only if SDP info parsing is needed
+   Modified Oct 2026 JHB, ProcessSessionControl() searches and extracts SDP info directly from the saved data / payload iovec list using offsets; saved data is no longer inserted into pkt_buf
 */
 
 #include <algorithm>  /* bring in std::min and std::max */
@@ -588,10 +590,125 @@ uint8_t* find_keyword(uint8_t* buffer, uint16_t buflen, const char* szKeyword, b
    return (uint8_t*)memmem(buffer, buflen, (const void*)szKeyword, strlen(szKeyword));  /* case-exact search, ignoring any NULL chars */
 }
 
+/* search data described by an iovec list, e.g. saved SIP data and a packet payload, or a DSPktReassembleIov() reassembled datagram. Return value is offset of szKeyword relative to start of the data, or -1 if not found. Notes, JHB Oct 2026:
+
+   -case-exact search looks in each buffer, then in a small window across each buffer boundary to find keywords split between buffers
+   -case-insensitive search is the same as find_keyword(), limited to the first 4000 bytes of data
+*/
+
+#define MAX_KEYWORD_LEN  64
+
+int find_keyword_iov(const struct iovec* iov, int iovcnt, const char* szKeyword, bool fCaseInsensitive) {
+
+int i, j, k, ofs = 0;
+int keylen = strlen(szKeyword);
+uint8_t* p;
+
+   if (!keylen || iovcnt <= 0) return -1;
+
+   if (iovcnt == 1) return (p = find_keyword((uint8_t*)iov[0].iov_base, iov[0].iov_len, szKeyword, fCaseInsensitive)) ? (int)(p - (uint8_t*)iov[0].iov_base) : -1;
+
+   if (fCaseInsensitive) {
+
+      char tmpstr[4000]; int len = 0;
+
+      for (i=0; i<iovcnt && len < (int)sizeof(tmpstr)-1; i++) for (j=0; j<(int)iov[i].iov_len && len < (int)sizeof(tmpstr)-1; j++) tmpstr[len++] = ((uint8_t*)iov[i].iov_base)[j] != 0 ? ((uint8_t*)iov[i].iov_base)[j] : 127;  /* copy buffers to temporary string, replace zeros with something temporary */
+      tmpstr[len] = 0;
+
+      char* p_ret = strcasestr(tmpstr, szKeyword);
+
+      return p_ret ? (int)(p_ret - tmpstr) : -1;
+   }
+
+   if (keylen > MAX_KEYWORD_LEN) return -1;  /* boundary window size limit. SIP message and SDP info keywords are much shorter */
+
+   for (i=0; i<iovcnt; i++) {
+
+      uint8_t* buffer = (uint8_t*)iov[i].iov_base;
+      int buflen = iov[i].iov_len;
+
+      if ((p = (uint8_t*)memmem(buffer, buflen, szKeyword, keylen))) return ofs + (int)(p - buffer);
+
+      if (i < iovcnt-1 && keylen > 1) {  /* check boundary window: up to keylen-1 bytes before the boundary and keylen-1 bytes after */
+
+         uint8_t window[2*MAX_KEYWORD_LEN];
+         int tail = min(buflen, keylen-1), wlen = 0;
+
+         memcpy(window, &buffer[buflen - tail], tail);
+         wlen = tail;
+
+         for (k=i+1; k<iovcnt && wlen < tail + keylen-1; k++) {
+
+            int n = min((int)iov[k].iov_len, tail + keylen-1 - wlen);
+            memcpy(&window[wlen], iov[k].iov_base, n);
+            wlen += n;
+         }
+
+         if ((p = (uint8_t*)memmem(window, wlen, szKeyword, keylen))) return ofs + buflen - tail + (int)(p - window);
+      }
+
+      ofs += buflen;
+   }
+
+   return -1;
+}
+
+/* iovec list helpers used by ProcessSessionControl(). Offsets are relative to start of the data described by the list, JHB Oct 2026 */
+
+#define MAX_PYLD_IOV  2  /* saved partial SDP info (if any) and current packet payload */
+
+static int iov_slice(const struct iovec* iov, int iovcnt, int ofs, int len, struct iovec* slice) {  /* describe len bytes starting at ofs in slice[], which must have room for iovcnt entries. Return value is number of slice entries */
+
+int i, n = 0;
+
+   for (i=0; i<iovcnt && len > 0; i++) {
+
+      if (ofs >= (int)iov[i].iov_len) { ofs -= iov[i].iov_len; continue; }
+
+      slice[n].iov_base = (uint8_t*)iov[i].iov_base + ofs;
+      slice[n].iov_len = min(len, (int)iov[i].iov_len - ofs);
+      len -= slice[n++].iov_len;
+      ofs = 0;
+   }
+
+   return n;
+}
+
+static int iov_copy(const struct iovec* iov, int iovcnt, int ofs, int len, uint8_t* dst) {  /* copy len bytes starting at ofs to dst, return number of bytes copied */
+
+struct iovec slice[MAX_PYLD_IOV];
+int i, n, num_copied = 0;
+
+   if (len <= 0) return 0;
+
+   n = iov_slice(iov, min(iovcnt, MAX_PYLD_IOV), ofs, len, slice);
+
+   for (i=0; i<n; i++) {
+
+      memcpy(&dst[num_copied], slice[i].iov_base, slice[i].iov_len);
+      num_copied += slice[i].iov_len;
+   }
+
+   return num_copied;
+}
+
+static int find_keyword_iov_range(const struct iovec* iov, int iovcnt, int ofs, int len, const char* szKeyword, bool fCaseInsensitive) {  /* search len bytes starting at ofs. Return value is offset of szKeyword relative to start of the data, or -1 if not found */
+
+struct iovec slice[MAX_PYLD_IOV];
+int n, ret_val;
+
+   if (len <= 0 || (n = iov_slice(iov, min(iovcnt, MAX_PYLD_IOV), ofs, len, slice)) <= 0) return -1;
+
+   return (ret_val = find_keyword_iov(slice, n, szKeyword, fCaseInsensitive)) >= 0 ? ofs + ret_val : -1;
+}
+
 int ProcessSessionControl(uint8_t* pkt_buf, unsigned int uFlags, int nStream, int thread_index, char* szKeyword) {
 
 PKTINFO PktInfo;
 bool fFragmentData = false;
+struct iovec pyld_iov[MAX_PYLD_IOV];  /* payload data, preceded by previous fragment data if any, JHB Oct 2026 */
+int nPyldIov = 0;
+uint8_t* sip_info_save = NULL;
 
    DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTINFO | DS_PKT_INFO_PKTINFO_EXCLUDE_RTP, pkt_buf, -1, &PktInfo, NULL);  /* get packet info excluding RTP items, JHB Jun 2024 */
 
@@ -605,7 +722,11 @@ bool fFragmentData = false;
    int state = 0, save_amount = 0;
    #endif
 
-/* insert previous fragment data (if any) at start of payload */
+/* previous fragment data (if any) goes at start of payload. Notes, JHB Oct 2026:
+
+   -saved data and payload are described with an iovec list. Keyword searches, Content-Length: value, and SDP info extraction use offsets into the list, so saved data is not inserted into pkt_buf
+   -offsets (index, etc) below are relative to start of saved data if any, otherwise start of payload
+*/
 
    if (thread_info[thread_index].sip_info_save_len[nStream]) {
 
@@ -613,8 +734,11 @@ bool fFragmentData = false;
       PrintPacketBuffer(thread_info[thread_index].sip_info_save[nStream], thread_info[thread_index].sip_info_save_len[nStream], " *** inside fragment restore, start of saved data \n", " *** end of saved data \n");
       #endif
 
-      memmove(&pkt_buf[pyld_ofs + thread_info[thread_index].sip_info_save_len[nStream]], &pkt_buf[pyld_ofs], pyld_len);
-      memcpy(&pkt_buf[pyld_ofs], thread_info[thread_index].sip_info_save[nStream], thread_info[thread_index].sip_info_save_len[nStream]);
+      sip_info_save = thread_info[thread_index].sip_info_save[nStream];
+
+      pyld_iov[nPyldIov].iov_base = sip_info_save;
+      pyld_iov[nPyldIov++].iov_len = thread_info[thread_index].sip_info_save_len[nStream];
+
       pyld_len += thread_info[thread_index].sip_info_save_len[nStream];
 
       #ifdef FIND_INVITE_DEBUG
@@ -623,16 +747,18 @@ bool fFragmentData = false;
 
       #ifdef FRAGMENT_DEBUG
       char tmpstr[400];
-      sprintf(tmpstr, " *** inside fragment restore, start of aggregated data, saved amount = %d, pyld_ofs = %d, pyld_len = %d, flags = 0x%x \n", thread_info[thread_index].sip_info_save_len[nStream], pyld_ofs, pyld_len, PktInfo.flags);
-      PrintPacketBuffer(&pkt_buf[pyld_ofs], pyld_len, tmpstr, " *** end of aggregated data \n");
+      sprintf(tmpstr, " *** inside fragment restore, start of current payload, saved amount = %d, pyld_ofs = %d, pyld_len = %d, flags = 0x%x \n", thread_info[thread_index].sip_info_save_len[nStream], pyld_ofs, pyld_len, PktInfo.flags);
+      PrintPacketBuffer(&pkt_buf[pyld_ofs], PktInfo.pyld_len, tmpstr, " *** end of current payload \n");
       #endif
 
-      thread_info[thread_index].sip_info_save_len[nStream] = 0;
-      free(thread_info[thread_index].sip_info_save[nStream]);
+      thread_info[thread_index].sip_info_save_len[nStream] = 0;  /* saved data is freed on return */
 
       fFragmentData = true;
    }
 
+   pyld_iov[nPyldIov].iov_base = &pkt_buf[pyld_ofs];
+   pyld_iov[nPyldIov++].iov_len = PktInfo.pyld_len;
+
    int session_pkt_type_found = 0, candidate_session_pkt_type_found = SESSION_CONTROL_FOUND_SIP_INVITE;
    int index = 0;
    bool fSIPInviteFoundMessageDisplayed = false;
@@ -643,61 +769,55 @@ type_check:
 
    char search_str[50] = "a=rtpmap";
    char search_str2[50] = "m=audio";
-   uint8_t* p, *p_rtpmap;
-   uint8_t* p_start;
+   int ofs, rtpmap_ofs, start_ofs;  /* offsets into pyld_iov[] data */
    int len;
 
 // if (index > pyld_len) fprintf(stderr, " ==== index %d > pyld_len %d \n", index, pyld_len);
 
-   if (!(uFlags & SESSION_CONTROL_NO_PARSE) && pyld_len > index && ((p_rtpmap = find_keyword(&pkt_buf[pyld_ofs+index], pyld_len-index, search_str, false)) || (p_rtpmap = find_keyword(&pkt_buf[pyld_ofs+index], pyld_len-index, search_str2, false)))) {  /* first find rtpmap, then back up and look for length field or application keyword. Check for SESSION_CONTROL_NO_PARSE uFlag first, JHB Mar 2023 */
+   if (!(uFlags & SESSION_CONTROL_NO_PARSE) && pyld_len > index && ((rtpmap_ofs = find_keyword_iov_range(pyld_iov, nPyldIov, index, pyld_len-index, search_str, false)) >= 0 || (rtpmap_ofs = find_keyword_iov_range(pyld_iov, nPyldIov, index, pyld_len-index, search_str2, false)) >= 0)) {  /* first find rtpmap, then back up and look for length field or application keyword. Check for SESSION_CONTROL_NO_PARSE uFlag first, JHB Mar 2023 */
 
       strcpy(search_str, "Length:");
-      p = find_keyword(&pkt_buf[pyld_ofs+index], (uint16_t)(p_rtpmap - &pkt_buf[index]), search_str, false);  /* fix bug: use saved location of "a=rtpmap" as upper limit for subsequent searches, JHB Jun 2024 */
+      ofs = find_keyword_iov_range(pyld_iov, nPyldIov, index, rtpmap_ofs - index, search_str, false);  /* fix bug: use saved location of "a=rtpmap" as upper limit for subsequent searches, JHB Jun 2024 */
 
       #ifdef FRAGMENT_DEBUG
-      if (p) printf("\n *** inside ProcessSessionControl found Length, pyld_ofs = %d, pyld_len = %d \n", pyld_ofs, pyld_len);
+      if (ofs >= 0) printf("\n *** inside ProcessSessionControl found Length, pyld_ofs = %d, pyld_len = %d \n", pyld_ofs, pyld_len);
       #endif
 
-      if (!p) {
+      if (ofs < 0) {
          strcpy(search_str, "l: ");
-         p = find_keyword(&pkt_buf[pyld_ofs+index], (uint16_t)(p_rtpmap - &pkt_buf[index]), search_str, false);
+         ofs = find_keyword_iov_range(pyld_iov, nPyldIov, index, rtpmap_ofs - index, search_str, false);
       }
 
-      if (!p) {  /* SAP/SDP protocol packets do not include a length field */
+      if (ofs < 0) {  /* SAP/SDP protocol packets do not include a length field */
 
          strcpy(search_str, "application");
-         p = find_keyword(&pkt_buf[pyld_ofs+index], (uint16_t)(p_rtpmap - &pkt_buf[index]), search_str, false);
+         ofs = find_keyword_iov_range(pyld_iov, nPyldIov, index, rtpmap_ofs - index, search_str, false);
 
          candidate_session_pkt_type_found = SESSION_CONTROL_FOUND_SAP_SDP;
       }
 
-      if (p) {
-
-         #if 0  /* debug - print out packet search area */
-         PrintPacketBuffer(&pkt_buf[pyld_ofs+index], (int)(p - &pkt_buf[index]), " *** start of pkt \n" " *** end of pkt \n");  /* user_io.h */
-         #endif
+      if (ofs >= 0) {
 
          #ifdef FIND_INVITE_DEBUG
          char tmpstr[4096];
-         int j;
-         memcpy(tmpstr, &pkt_buf[pyld_ofs+index], pyld_len-index);
-         for (j=0; j<pyld_len-index; j++) if (tmpstr[j] < 32 && tmpstr[j] != 10 && tmpstr[j] != 13) tmpstr[j] = 176;  /* fill with printable char */
-         tmpstr[pyld_len-index] = 0;
+         int j, n = iov_copy(pyld_iov, nPyldIov, index, min(pyld_len-index, (int)sizeof(tmpstr)-1), (uint8_t*)tmpstr);
+         for (j=0; j<n; j++) if (tmpstr[j] < 32 && tmpstr[j] != 10 && tmpstr[j] != 13) tmpstr[j] = 176;  /* fill with printable char */
+         tmpstr[n] = 0;
          state = 1;
          #endif
 
-         uint8_t* p_ofs = p;
-         uint8_t* p_siprec = NULL;
+         int keyword_ofs = ofs;  /* start of data to save if SDP info is incomplete */
 
          if (candidate_session_pkt_type_found == SESSION_CONTROL_FOUND_SIP_INVITE) {
 
-            p += strlen(search_str);
-            int i = 0;
-            while (p[i] >= 0x20) i++;
-            uint8_t save = p[i];
-            p[i] = 0;
-            len = atoi((const char*)p);
-            p[i] = save;
+            char lenstr[32];
+            int i = 0, n;
+
+            ofs += strlen(search_str);
+            n = iov_copy(pyld_iov, nPyldIov, ofs, min(pyld_len - ofs, (int)sizeof(lenstr)-1), (uint8_t*)lenstr);
+            while (i < n && (uint8_t)lenstr[i] >= 0x20) i++;
+            lenstr[i] = 0;
+            len = atoi(lenstr);
 
             if (len <= 1 || len > (int)MAX_TCP_PACKET_LEN) { session_pkt_type_found = -1; goto ret; };  /* invalid Length: value */
 
@@ -711,12 +831,13 @@ type_check:
             state = 2;
             #endif
 
-            uint8_t* p2;
+            ofs += i;  /* search after Length: value */
+
             strcpy(search_str, "v=0");
-            p2 = find_keyword(p, pyld_len - index - (int)(&p[i] - &pkt_buf[pyld_ofs+index]), search_str, false);
-            if (!p2) { p2 = find_keyword(p, pyld_len - index - (int)(&p[i] - &pkt_buf[pyld_ofs+index]), "v=1", false); if (p2) strcpy(search_str, "v=1"); }  /* also try v=1 in case SIP guys ever bump version from 0.x to 1.x (unlikely but not impossible) */
+            start_ofs = find_keyword_iov_range(pyld_iov, nPyldIov, ofs, pyld_len - ofs, search_str, false);
+            if (start_ofs < 0) { start_ofs = find_keyword_iov_range(pyld_iov, nPyldIov, ofs, pyld_len - ofs, "v=1", false); if (start_ofs >= 0) strcpy(search_str, "v=1"); }  /* also try v=1 in case SIP guys ever bump version from 0.x to 1.x (unlikely but not impossible) */
 
-            if (!p2) goto ret;  /* v=0 not found */
+            if (start_ofs < 0) goto ret;  /* v=0 not found */
 
             #ifdef FIND_INVITE_DEBUG
             state = 3;
@@ -724,18 +845,18 @@ type_check:
 
          /* Session Recording Protocol (SIPREC, RFC 7866) is an open SIP based protocol for call recording, partly based on RFC 7245 (https://datatracker.ietf.org/doc/id/draft-portman-siprec-protocol-01.html) */
 
-            p_siprec = find_keyword(p2, pyld_len - index - (int)(p2 - &pkt_buf[pyld_ofs+index]), "--OSS-unique-boundary-42", true);  /* look for siprec header, JHB Apr 2023 */
+            int siprec_ofs = find_keyword_iov_range(pyld_iov, nPyldIov, start_ofs, pyld_len - start_ofs, "--OSS-unique-boundary-42", true);  /* look for siprec header, JHB Apr 2023 */
 
-            if (p_siprec) {  /* siprec Invite has a different format, with "unique-boundary" marked header and footer, and XML section */
+            if (siprec_ofs >= 0) {  /* siprec Invite has a different format, with "unique-boundary" marked header and footer, and XML section */
 
                #ifdef FIND_INVITE_DEBUG
                state = 4;
                #endif
 
-               len = (int)(p_siprec - p2);  /* for siprec, use alternative len calculation -- avoid (i) siprec header intro and padding before v=0 (ii) XML section after end of sdp info (separated by another siprec header, if found), JHB Apr 2023 */
+               len = siprec_ofs - start_ofs;  /* for siprec, use alternative len calculation -- avoid (i) siprec header intro and padding before v=0 (ii) XML section after end of sdp info (separated by another siprec header, if found), JHB Apr 2023 */
             }
 
-            p_start = p2;  /* start of contents ("v=0") */
+            /* start_ofs is start of contents ("v=0") */
          }
          else {  /* SAP/SDP protocol packets are lightweight with no header info (e.g. length:, v=, etc) */
 
@@ -743,26 +864,26 @@ type_check:
             state = 5;
             #endif
 
-            len = pyld_len - (int)(p - &pkt_buf[pyld_ofs+index]);
-            p_start = p;  /* start of contents ("application" keyword) */
+            len = pyld_len - ofs;
+            start_ofs = ofs;  /* start of contents ("application" keyword) */
          }
 
-         int rem = pyld_len - index - (int)(p_start - &pkt_buf[pyld_ofs+index]);
+         int rem = pyld_len - start_ofs;
 
          #ifdef FIND_INVITE_DEBUG
-         printf("\nSIP invite state = %d, len>rem %s, count = %d \n pyld_ofs = %d, pyld_len = %d, index = %d \n len = %d, rem = %d, p_start-&pktbuf[ofs] = %d, save_amount = %d \n", state, len > rem ? "yes, saving partial" : "no, goto more search", count++, pyld_ofs, pyld_len, index, len, rem, (int)(p_start - &pkt_buf[pyld_ofs+index]), save_amount);
+         printf("\nSIP invite state = %d, len>rem %s, count = %d \n pyld_ofs = %d, pyld_len = %d, index = %d \n len = %d, rem = %d, start_ofs - index = %d, save_amount = %d \n", state, len > rem ? "yes, saving partial" : "no, goto more search", count++, pyld_ofs, pyld_len, index, len, rem, start_ofs - index, save_amount);
          if (count == 3) printf(tmpstr);
          #endif
 
          if (len > rem) {  /* save partial SIP invite, starting with "Length:" */
 
-            thread_info[thread_index].sip_info_save_len[nStream] = pyld_len - (p_ofs - &pkt_buf[pyld_ofs]);
+            thread_info[thread_index].sip_info_save_len[nStream] = pyld_len - keyword_ofs;
             thread_info[thread_index].sip_info_save[nStream] = (uint8_t*)malloc(thread_info[thread_index].sip_info_save_len[nStream]);
-            memcpy(thread_info[thread_index].sip_info_save[nStream], p_ofs, thread_info[thread_index].sip_info_save_len[nStream]);
+            iov_copy(pyld_iov, nPyldIov, keyword_ofs, thread_info[thread_index].sip_info_save_len[nStream], thread_info[thread_index].sip_info_save[nStream]);  /* may include previous saved data, which is freed on return */
 
             #ifdef FRAGMENT_DEBUG
             char tmpstr[400];
-            sprintf(tmpstr, " *** inside fragment save, start of saved data, amount = %d, len = %d, rem = %d, pyld_len = %d, flags = 0x%x, start to \"v0\" = %d, ret val = %d \n", thread_info[thread_index].sip_info_save_len[nStream], len, rem, pyld_len, PktInfo.flags, (int)(p_ofs - &pkt_buf[pyld_ofs]), candidate_session_pkt_type_found);
+            sprintf(tmpstr, " *** inside fragment save, start of saved data, amount = %d, len = %d, rem = %d, pyld_len = %d, flags = 0x%x, start to \"v0\" = %d, ret val = %d \n", thread_info[thread_index].sip_info_save_len[nStream], len, rem, pyld_len, PktInfo.flags, keyword_ofs, candidate_session_pkt_type_found);
 
             PrintPacketBuffer(thread_info[thread_index].sip_info_save[nStream], thread_info[thread_index].sip_info_save_len[nStream], tmpstr, " *** end of saved data \n");
             #endif
@@ -774,7 +895,7 @@ type_check:
          else {  /* SIP invite or SAP/SDP protocol found, display and/or extract Origin and Media objects from SDP info, add to thread_info[].origins[stream] */
 
             char szSDP[MAX_TCP_PACKET_LEN];
-            memcpy(szSDP, p_start, len);
+            iov_copy(pyld_iov, nPyldIov, start_ofs, len, (uint8_t*)szSDP);  /* SDP info may start in saved data and continue in the payload, JHB Oct 2026 */
 
             uint8_t* p2 = (uint8_t*)memmem(szSDP, len, "sdp", 3);
             if (p2 && *(p2+3) == 0) *(p2+3) = '\n';  /* some SAP packet generators seem to stick a zero after "application/sdp" and before "m=", which I don't see in any spec, but whatever. If so we replace with a new line, JHB Jan 2023 */
@@ -817,7 +938,7 @@ type_check:
 
 update_index:
 
-            index = (int)(p_start - &pkt_buf[pyld_ofs+index]) + len;
+            index = start_ofs + len;
 
             goto type_check;  /* look for more SDP info contents in this packet */
          }
@@ -828,7 +949,7 @@ update_index:
       strcpy(search_str, "");
       int i, num_session_types = sizeof(SIP_Messages)/sizeof(SIP_MESSAGES);
 
-      for (i=0; i<num_session_types; i++) if (find_keyword(&pkt_buf[pyld_ofs], pyld_len, SIP_Messages[i].szTextStr, true) && !find_keyword(&pkt_buf[pyld_ofs], pyld_len, SIP_Messages[i].szTextExclude, true) && SIP_Messages[i].uPortExclude != thread_info[thread_index].dst_port[nStream] && SIP_Messages[i].uPortExclude != thread_info[thread_index].src_port[nStream]) {
+      for (i=0; i<num_session_types; i++) if (find_keyword_iov(pyld_iov, nPyldIov, SIP_Messages[i].szTextStr, true) >= 0 && find_keyword_iov(pyld_iov, nPyldIov, SIP_Messages[i].szTextExclude, true) < 0 && SIP_Messages[i].uPortExclude != thread_info[thread_index].dst_port[nStream] && SIP_Messages[i].uPortExclude != thread_info[thread_index].src_port[nStream]) {
 
       /* implement updated flags to control message parse and display logic with more precision, JHB Jun 2024 */
 
@@ -854,6 +975,8 @@ update_index:
    }
 
 ret:
+   if (sip_info_save) free(sip_info_save);  /* free previous fragment data, JHB Oct 2026 */
+
    if (szKeyword && strlen(search_str)) strcpy(szKeyword, search_str);
 
    return session_pkt_type_found;
@@ -41,6 +41,8 @@
    Modified Mar 2025 JHB, in app_printf() update thread_info[].most_recent_console_output, add cur_time param in app_printf() and UpdateCounters()
    Modified Apr 2025 JHB, in app_printf() implement APP_PRINTF_SAME_LINE_PRESERVE, fix bug with slen not being incremented when \n or \r inserted at output string reserved zeroth location
    Modified Apr 2025 JHB, in app_printf() fixes and simplification to updating line cursor position, mid-line check, and isLinePreserve
+   Modified Oct 2026 JHB, in ProcessKeys() signal DS_PKT_NOTIFY_APP after setting fQuit, to wake app threads waiting in ThreadWait()
+   Modified Oct 2026 JHB, in ProcessKeys() 'd' key output include output writer ring stats if --output_writers was entered
 */
 
 #include <algorithm>
@@ -74,6 +76,8 @@ extern bool fRepeatIndefinitely;  /* true if -R0 is given on the cmd line */
 extern int nRepeatsRemaining[];
 
 extern uint8_t uApp_progress_line_cursor_pos;
+
+extern void OutputWriterStats(int thread_index, char* szStats);  /* in mediaMin.cpp, JHB Oct 2026 */
 static uint8_t uLine_cursor_pos[MAX_APP_THREADS] = { 0 };
  
 /* update screen counters */
@@ -169,6 +173,7 @@ static bool fSetStdoutNonBuffered = false;
          app_printf(APP_PRINTF_NEW_LINE, cur_time, thread_index, tmpstr);
 
          fQuit = true;
+         DSSignalPacketNotify(DS_PKT_NOTIFY_APP);  /* wake app threads waiting in ThreadWait() or AppThreadSync(), JHB Oct 2026 */
          return true;
       }
 
@@ -242,6 +247,8 @@ static bool fSetStdoutNonBuffered = false;
  
             printf("%s \n", tmpstr);
 
+            if (nOutputWriters > 0) { strcpy(tmpstr, ""); OutputWriterStats(app_thread_index_debug, tmpstr); printf("%s", tmpstr); }  /* output writer ring stats while running, JHB Oct 2026 */
+
 #if 0  /* deprecated, don't use this method */
             pm_run = 2;
 #else  /* ask for run-time debug output from one or more packet / media threads */
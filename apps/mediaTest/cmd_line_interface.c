@@ -67,6 +67,11 @@
    Modified Feb 2025 JHB, change references to MAX_INPUT_STREAMS and MAX_CONCURRENT_STREAMS to MAX_STREAMS, defined in shared_include/streamlib.h. All libs and reference apps are now using the same definition
    Modified Mar 2025 JHB, remove debug print flag from cimGetCmdLine() uFlags for mediaMin and mediaTest apps
    Modified Apr 2025 JHB, comments only
+   Modified Oct 2026 JHB, add nStartTime and nStopTime to support --start_time and --stop_time cmd line options
+   Modified Oct 2026 JHB, add nReadAheadDepth to support --read_ahead cmd line option
+   Modified Oct 2026 JHB, add nOutputCompression to support --compress_output cmd line option
+   Modified Oct 2026 JHB, add nDupLookback to support --dup_lookback cmd line option
+   Modified Oct 2026 JHB, add nOutputWriters to support --output_writers cmd line option
 */
 
 #ifdef __cplusplus
@@ -141,6 +146,12 @@ bool             fGroupOutputNoCopy = false;
 int              nRandomBitErrorPercentage = 0;
 bool             fShow_sha1sum = false;
 bool             fShow_sha512sum = false;
+int              nStartTime = -1;  /* command line --start_time and --stop_time inputs, in msec. -1 indicates no entry, JHB Oct 2026 */
+int              nStopTime = -1;
+int              nReadAheadDepth = 0;  /* command line --read_ahead input, zero indicates no read-ahead, JHB Oct 2026 */
+int              nOutputCompression = 0;  /* command line --compress_output input: 0 = none, 1 = gzip, 2 = zstd, JHB Oct 2026 */
+int              nDupLookback = -1;  /* command line --dup_lookback input, -1 indicates no entry, JHB Oct 2026 */
+int              nOutputWriters = 0;  /* command line --output_writers input, zero indicates no output writer threads, JHB Oct 2026 */
 
 /* global vars set in packet_flow_media_proc, but only visible within an app build (not exported from a lib build) */
 
@@ -367,6 +378,15 @@ int i;
 
    nCut = userIfs.nCut;
 
+   if (uFlags & CLI_MEDIA_APPS) {  /* mediaMin input arrival time window, JHB Oct 2026 */
+      nStartTime = userIfs.nInputStartTime;
+      nStopTime = userIfs.nInputStopTime;
+      nReadAheadDepth = userIfs.nInputReadAheadDepth;
+      nOutputCompression = userIfs.nPcapOutputCompression;
+      nDupLookback = userIfs.nDuplicateLookback;
+      nOutputWriters = userIfs.nOutputWriterThreads;
+   }
+
 /* register signal handler to catch Ctrl-C signal and cleanly exit mediaTest, mediaMin, and other test programs */
 
 #if 1  /* disable this if needed for use with gdb (to prevent mediaTest or mediaMin from handling ctrl-c), JHB Jan 2019 */
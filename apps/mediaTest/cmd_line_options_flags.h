@@ -36,6 +36,14 @@
    Modified Jul 2024 JHB, clarification of ENABLE_TIMESTAMP_MATCH_MODE and ENABLE_WAV_OUTPUT flags
    Modified Nov 2024 JHB, update comments
    Modified Mar 2025 JHB, update comments
+   Modified Oct 2026 JHB, add ENABLE_MMAP_INPUT flag
+   Modified Oct 2026 JHB, add ENABLE_FLOW_PARTITION flag
+   Modified Oct 2026 JHB, add ENABLE_INPUT_MERGE flag
+   Modified Oct 2026 JHB, add ENABLE_PUSH_BATCHING flag
+   Modified Oct 2026 JHB, add ENABLE_SPIN_THEN_BLOCK flag
+   Modified Oct 2026 JHB, add ENABLE_THREAD_REBALANCE flag
+   Modified Oct 2026 JHB, add ENABLE_BATCH_DECODE flag
+   Modified Oct 2026 JHB, add ENABLE_PIPELINE_DECODE flag
 */
 
 #ifndef _CMDLINEOPTIONSFLAGS_H_
@@ -127,4 +135,17 @@
 
 #define SHOW_PACKET_ARRIVAL_STATS            0x400000000000000LL  /* m| show packet arrival stats in mediaMin summary stats display, including average interval between packets and average packet jitter vs stream ptime. These stats differ somewhat from Wireshark, as they apply only to media packets and exclude SID and DTMF packets */ 
 
+#define ENABLE_MMAP_INPUT                    0x800000000000000LL  /* m| open pcap, pcapng, and .rtp inputs in memory-mapped mode (DS_OPEN_PCAP_MMAP flag in pktlib.h) and read records in place with DSReadPcapPtr(). Reduces per-packet file read overhead for large inputs, for example multi-GB captures in analytics or -r0 (AFAP) modes */
+
+#define ENABLE_FLOW_PARTITION               0x1000000000000000LL  /* m| with -tN cmd line entry (N > 1 mediaMin app threads), partition media flows in each input across app threads instead of each thread processing all of every input. All threads see SIP, SAP/SDP, and other control traffic; each media flow (both directions and RTCP) is handled by one thread, determined by a hash of its IP addrs and UDP ports. This allows one large multi-stream capture to use multiple app threads. See FlowPartition() in mediaMin.cpp */
+
+#define ENABLE_INPUT_MERGE                  0x2000000000000000LL  /* m| merge multiple inputs of each app thread in packet arrival timestamp order. Instead of taking one packet from each input in turn, PushPackets() takes the next packet from whichever input has the earliest arrival timestamp, so packets are pushed in global arrival order. Intended for inputs from the same capture session, for example captures from multiple interfaces or taps. See InputMergeFirst() and InputMergeNext() in mediaMin.cpp */
+
+#define ENABLE_PUSH_BATCHING                0x4000000000000000LL  /* m| accumulate packets across inputs and sessions in each app thread and push them in batches, with one DSPushPackets() call per batch instead of one per packet. Packets not accepted due to full packet/media thread queues are kept in the batch and pushed first next time. Reduces push queue lock acquisitions and p/m thread wakeups at high session counts. See PushBatchAdd() and PushBatchFlush() in mediaMin.cpp */
+
+#define ENABLE_SPIN_THEN_BLOCK                   0x40000000000LL  /* m| start packet/media threads with the DS_MEDIASERVICE_SPIN_THEN_BLOCK flag (see pktlib.h). In energy saver state p/m threads spin briefly then block until packets are pushed to one of their sessions, instead of sleeping and polling. Lowers idle CPU usage and wakeup latency, but adds a futex wake to DSPushPackets() when a p/m thread is blocked */
+#define ENABLE_THREAD_REBALANCE                  0x80000000000LL  /* m| start packet/media threads with the DS_MEDIASERVICE_REBALANCE_THREADS flag (see pktlib.h). Overloaded p/m threads move a session or whole stream group to the least loaded p/m thread when loads become uneven. Can be combined with ROUND_ROBIN_SESSION_ALLOCATION, which balances session counts only at session creation */
+#define ENABLE_BATCH_DECODE                    0x4000000000000LL  /* m| start packet/media threads with the DS_MEDIASERVICE_BATCH_DECODE flag (see pktlib.h). p/m threads decode single frame payloads with matching codec type and frame size across sessions in multichannel DSCodecDecode() calls. Adds one p/m thread loop iteration of output latency. Most effective with many sessions using the same codec and ptime, for example -nN cmd line entry (reuse inputs). Encoding is not batched */
+#define ENABLE_PIPELINE_DECODE                 0x8000000000000LL  /* m| start packet/media threads with the DS_MEDIASERVICE_PIPELINE_DECODE flag (see pktlib.h). Each p/m thread starts a codec stage thread and hands off queued frames to it, so decoding overlaps with jitter buffer processing of remaining sessions. Includes batched decoding (ENABLE_BATCH_DECODE) and also hands off single frame EVS and AMR payloads */
+
 #endif  /* _CMDLINEOPTIONSFLAGS_H_ */
@@ -60,6 +60,11 @@
    Modified Dec 2024 JHB, rename "header_format" to "payload_format" in codec_test_params_t struct
    Modified Feb 2025 JHB, change references to MAX_INPUT_STREAMS to MAX_STREAMS, which is defined in shared_include/streamlib.h. MAX_STREAMS specifies maximum streams available for reference applications and multithread / high capacity testing
    Modified Apr 2025 JHB, add isLinePreserve extern, change uLineCursorPos from uint8_t to unsigned int (to handle long console output lines)
+   Modified Oct 2026 JHB, add nStartTime and nStopTime to support --start_time and --stop_time command line options
+   Modified Oct 2026 JHB, add nReadAheadDepth to support --read_ahead command line option
+   Modified Oct 2026 JHB, add nOutputCompression to support --compress_output command line option
+   Modified Oct 2026 JHB, add nDupLookback to support --dup_lookback command line option
+   Modified Oct 2026 JHB, add nOutputWriters to support --output_writers command line option
 */
 
 #ifndef _MEDIA_TEST_H_
@@ -264,6 +269,12 @@ extern bool              fGroupOutputNoCopy;  /* command line --group_pcap_nocop
 extern int               nRandomBitErrorPercentage;  /* command line --random_bit_error */
 extern bool              fShow_sha1sum;  /* command line --sha1sum */
 extern bool              fShow_sha512sum;  /* command line --sha512sum */
+extern int               nStartTime;  /* command line --start_time, in msec */
+extern int               nStopTime;  /* command line --stop_time, in msec */
+extern int               nReadAheadDepth;  /* command line --read_ahead */
+extern int               nOutputCompression;  /* command line --compress_output */
+extern int               nDupLookback;  /* command line --dup_lookback */
+extern int               nOutputWriters;  /* command line --output_writers */
 
 #define szAppFullCmdLine (((const char*)full_cmd_line))  /* szAppFullCmdLine is what apps should use. full_cmd_line should not be modified so this is a half-attempt to remind user apps that it should be treated as const char* */
 
@@ -209,6 +209,16 @@
                          -in pktlib.h DS_PKT_INFO_RTP_PYLD_CONTENT was changed to DS_PKT_INFO_PYLD_CONTENT to support this
                          -in pktlib DS_PKT_INFO_PYLD_CONTENT is now a session item inside DSGetPacketInfo() and calls DSGetPayloadInfo()
   Modified May 2025 JHB, call DSStoreStreamData() with uFlags either DS_PKT_PYLD_CONTENT_MEDIA or DS_PKT_PYLD_CONTENT_DTMF
+  Modified Oct 2026 JHB, create pktlib buffered writers for output pcaps (DSCreatePcapWriter()) and write with DSWritePcapBuffered() instead of DSWritePcap() serialized by pcap_write_sem. Close output pcaps with DSClosePcap() so buffered records are written
+  Modified Oct 2026 JHB, at end of each p/m thread loop iteration call DSSignalPacketNotify() with DS_PKT_NOTIFY_INPUT_SPACE if packets were dequeued from push queues and DS_PKT_NOTIFY_OUTPUT if output packets were queued, waking app threads waiting to push or pull (see uNotifyEvents)
+  Modified Oct 2026 JHB, consolidate per session [MAX_SESSIONS] state arrays into cache line aligned SESSION_STATE_HOT and SESSION_STATE_COLD structs, and per channel packet time stats arrays into CHAN_STATE, so p/m threads touch one cache line per session instead of one per array and sessions owned by different p/m threads no longer share lines. See per session and per channel state notes
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_SPIN_THEN_BLOCK wait mode for energy saver state. Instead of usleep() p/m threads spin briefly then block on a per thread futex, woken by set_session_last_push_time() when DSPushPackets() pushes to one of their sessions. See ThreadIdleWait(), ThreadIdleWakeup(), and notes near PM_THREAD_WAKEUP
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_REBALANCE_THREADS session rebalancing. At the start of ManageSessions() overloaded p/m threads move a session or whole stream group to the least loaded thread, with load ratio and minimum difference thresholds, per thread cooldown, and per session hold time to avoid thrashing. p/m threads share a base time when rebalancing is enabled. See RebalanceThreads()
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_BATCH_DECODE batched decoding. p/m threads queue single frame payloads and stream data during each loop iteration, then at the end of the iteration decode frames with matching codec type and frame size across sessions with one multichannel DSCodecDecode() call. See DecodeCodecBatch() and notes near CODEC_BATCH
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_PIPELINE_DECODE. Each p/m thread starts a codec stage thread and hands off batched frames as they are queued, so decoding overlaps with jitter buffer processing of remaining sessions. See HandOffCodecBatch(), CodecStageThread(), and notes near CODEC_STAGE
+  Modified Oct 2026 JHB, with DS_MEDIASERVICE_BATCH_DECODE, payloads decoded immediately (SID, multiframe, size mismatch) ran before the same decoder's queued frames and corrupted codec state. SyncCodecBatchDecoder() now decodes a decoder's queued frames first
+  Modified Oct 2026 JHB, with DS_MEDIASERVICE_PIPELINE_DECODE, single frame EVS and AMR payloads are handed off to codec stage threads and decoded single channel, OutArgs bitrate and frame type are saved per frame and applied to jitter buffer info when stored. SyncCodecBatchDecoder() waits for the codec stage thread only if pending hand-offs include the decoder. Codec stage thread affinity is taken from sched_getaffinity() instead of assuming cores 0..N-1
+  Modified Oct 2026 JHB, codec_batch_rtp_info[] is a ring that never overwrites unconsumed entries. If a channel's ring is full the frame isn't stored, so RTP info returned by GetCodecBatchRTPInfo() always matches stream data from DSGetStreamData(). GetCodecBatchRTPInfo() consumes only as many entries as DSGetStreamData() items
 */
 
 /* Linux header files */
@@ -232,7 +242,9 @@
 #include <semaphore.h>
 #include <limits.h>
 #include <sched.h>
+#include <pthread.h>
 #include <sys/syscall.h>  /* SYS_gettid() */
+#include <linux/futex.h>  /* FUTEX_WAIT_PRIVATE and FUTEX_WAKE_PRIVATE, used by ThreadIdleWait(), ThreadIdleWakeup(), and codec stage threads */
 #include <errno.h>  /* errno and strerror */
 
 /* SigSRF lib header files */
@@ -466,9 +478,127 @@ static uint32_t       nSessions_gbl = 0, nThreads_gbl = 0, num_pktmedia_threads
 
 /* support for DS_ENABLE_PUSHPACKETS_ELAPSED_TIME_ALARM flag. See set_session_last_push_time() which is called from DSPushPackets() in pktlib.c, JHB Jun 2023 */
   
-static uint64_t last_cur_time[MAX_PKTMEDIA_THREADS] = { 0 };
-static uint64_t last_push_time[MAX_SESSIONS] = { 0 };
-static uint8_t session_alarm_flags[MAX_SESSIONS] = { 0 };
+static uint64_t last_cur_time[MAX_PKTMEDIA_THREADS] = { 0 };  /* per session last_push_time and session_alarm_flags are in SESSION_STATE_COLD, see below, JHB Oct 2026 */
+
+/* support for DS_MEDIASERVICE_SPIN_THEN_BLOCK flag. Notes, JHB Oct 2026:
+
+   -in energy saver state, instead of usleep() p/m threads spin briefly then block on a per thread futex. set_session_last_push_time(), called by DSPushPackets() in pktlib.c, wakes the thread to which the pushed session is assigned (see ThreadIdleWait() and ThreadIdleWakeup())
+   -spin length adapts: if input arrives during a spin the limit is doubled, otherwise it's halved, between PM_THREAD_SPIN_MIN and PM_THREAD_SPIN_MAX iterations
+   -blocking waits time out after PM_THREAD_BLOCK_TIMEOUT usec, so session create/delete, UDP input, and app queue checks are still handled if no push occurs. The master thread with UDP input enabled uses uThreadEnergySaverSleepTime as the timeout
+   -wakeup counts and latency (time from wake signal to thread running) are recorded in PACKETMEDIATHREADINFO idle_xxx items
+*/
+
+#define PM_THREAD_SPIN_MIN          64
+#define PM_THREAD_SPIN_MAX          8192
+#define PM_THREAD_BLOCK_TIMEOUT     10000  /* in usec */
+
+typedef struct {
+
+   volatile uint32_t  seq;          /* futex word, incremented by ThreadIdleWakeup() */
+   volatile uint32_t  fBlocked;     /* set while thread is blocked in ThreadIdleWait(), cleared by first waker */
+   volatile uint64_t  signal_time;  /* time of futex wake, used for wakeup latency stats */
+   int                spin_limit;   /* current adaptive spin limit, accessed only by owner thread */
+
+} __attribute__((aligned(64))) PM_THREAD_WAKEUP;
+
+static PM_THREAD_WAKEUP pm_thread_wakeup[MAX_PKTMEDIA_THREADS] = {{ 0 }};
+
+static uint64_t pm_shared_base_time = 0;  /* base time shared by p/m threads if DS_MEDIASERVICE_REBALANCE_THREADS flag is given, see time_init, JHB Oct 2026 */
+
+/* support for DS_MEDIASERVICE_BATCH_DECODE flag. Notes, JHB Oct 2026:
+
+   -in the packet + payload processing loop, p/m threads queue frames for decoding instead of calling DSCodecDecode() for each pulled packet. At the end of each loop iteration, after all sessions are processed, DecodeCodecBatch() decodes queued frames with matching codec type, payload size, and media frame size using one multichannel DSCodecDecode() call, then stores decoded data with DSStoreStreamData()
+   -to keep decoded data in order, all stream data (media, DTMF events, probation zeros) is queued, not only frames to be decoded. Each codec handle appears at most once per DSCodecDecode() call, and a handle skipped while grouping is not used again in that pass, so each codec instance decodes its frames in order
+   -only payloads that contain exactly one coded frame are batched (payload size equals codec's coded frame size), so multichannel input is simply concatenated. pass-thru, SID, and multiframe payloads are decoded immediately, as before, and their output queued. EVS and AMR payloads are also decoded immediately, unless DS_MEDIASERVICE_PIPELINE_DECODE is given (see notes near CODEC_STAGE)
+   -a payload decoded immediately may use a decoder that still has frames queued. SyncCodecBatchDecoder() decodes queued frames before the immediate decode, otherwise the decoder would see frames out of order
+   -stream data is available to DSGetStreamData() on the next loop iteration, which adds one iteration of latency. Sessions being flushed are not delayed; the queue is decoded before their stream processing
+   -RTP timestamp, SSRC, and payload type of stored frames are saved per channel in codec_batch_rtp_info[] and used by stream processing for output packet formatting, instead of rtp_xxx[] values from the current pull. Entries are consumed one per DSGetStreamData() item and never overwritten; if a channel's stream data isn't being consumed and its ring is full, frames are not stored (counted in batch_decode_drops), so RTP info and stream data stay matched
+   -encoding is not batched. Encoder output is formatted and sent per stream data item, in the same loop, and is also used for stream group and timestamp match mode output
+*/
+
+#define CODEC_BATCH_MAX_FRAMES      256
+#define CODEC_BATCH_MAX_CHAN        16          /* max codec handles per DSCodecDecode() call */
+#define CODEC_BATCH_DATA_SIZE       (64*1024)  /* per thread queued payload and media data, in bytes */
+#define CODEC_BATCH_RTP_INFO_DEPTH  32          /* must be a power of 2 */
+
+typedef struct {
+
+   HCODEC        hCodec;      /* decoder handle if frame is pending decode, otherwise zero */
+   HCODEC        hDecoder;    /* decoder handle, not cleared after decode. Used by SyncCodecBatchDecoder() */
+   int           codec_type;
+   int           chnum;       /* chnum used for DSStoreStreamData() */
+   int           chnum_jb;    /* chnum of jitter buffer the payload was pulled from, used for EVS and AMR decoder info */
+   int           bitRate;     /* EVS and AMR decoder OutArgs, saved by DecodeCodecBatchFrames() */
+   int           frameType;
+   unsigned int  uContent;    /* DS_PKT_PYLD_CONTENT_MEDIA or DS_PKT_PYLD_CONTENT_DTMF */
+   uint32_t      in_ofs;      /* coded payload offset in data[] */
+   int           in_len;
+   uint32_t      out_ofs;     /* media or DTMF data offset in data[] */
+   int           out_len;     /* -1 if decode failed */
+   uint32_t      rtp_timestamp;
+   uint32_t      rtp_ssrc;
+   uint8_t       rtp_pyld_type;
+
+} CODEC_BATCH_FRAME;
+
+typedef struct {
+
+   int                num_frames;
+   uint32_t           data_len;
+   CODEC_BATCH_FRAME  frames[CODEC_BATCH_MAX_FRAMES];
+   uint8_t            data[CODEC_BATCH_DATA_SIZE] __attribute__((aligned(64)));
+
+} __attribute__((aligned(64))) CODEC_BATCH;
+
+typedef struct {
+
+   uint32_t      rtp_timestamp[CODEC_BATCH_RTP_INFO_DEPTH];
+   uint32_t      rtp_ssrc[CODEC_BATCH_RTP_INFO_DEPTH];
+   uint8_t       rtp_pyld_type[CODEC_BATCH_RTP_INFO_DEPTH];
+   uint8_t       rd;   /* index of oldest entry */
+   uint8_t       num;  /* number of entries not yet consumed by GetCodecBatchRTPInfo() */
+
+} CODEC_BATCH_RTP_INFO;
+
+static CODEC_BATCH codec_batch[MAX_PKTMEDIA_THREADS];  /* per thread, accessed only by owner thread */
+static CODEC_BATCH_RTP_INFO codec_batch_rtp_info[NCORECHAN] = {{{ 0 }}};  /* per channel, indexed by parent chnum */
+
+/* support for DS_MEDIASERVICE_PIPELINE_DECODE flag. Notes, JHB Oct 2026:
+
+   -p/m thread processing is split into two stages: (i) jitter buffer stage -- packet input, DSGetOrderedPackets(), and queueing frames for decoding, and (ii) codec stage -- decoding queued frames. Each p/m thread starts one codec stage thread the first time it has frames to hand off. The two are connected by a single producer / single consumer ring of frame ranges in the p/m thread's CODEC_BATCH queue
+   -after each channel's pulled packets are queued, HandOffCodecBatch() passes frames queued since the last hand-off to the codec stage thread, if there are at least CODEC_STAGE_CHUNK_FRAMES. Hand-offs are on channel boundaries so a frame range doesn't split one channel's pull. The codec stage thread decodes ranges in order, grouping frames within each range (see DecodeCodecBatchFrames())
+   -the p/m thread owns the queue and is the only thread that calls DSStoreStreamData(). At the end of each loop iteration DecodeCodecBatch() waits for the codec stage thread, decodes remaining frames, and stores all queued stream data in order. Nothing is in flight when ManageSessions() runs or sessions are deleted or migrated
+   -a decoder is never used by both threads at the same time: DecodeCodecBatch() waits before decoding remaining frames, and SyncCodecBatchDecoder() waits before a payload is decoded immediately if hand-offs not yet decoded include the payload's decoder. SyncCodecBatchDecoder() then decodes only that decoder's queued frames, not other decoders' frames, which may have earlier frames in pending hand-offs
+   -single frame EVS and AMR payloads are also queued and handed off, and decoded single channel (never grouped) so OutArgs bitrate and frame type can be saved per frame. DecodeCodecBatch() applies them to jitter buffer info when the frame is stored, same as the immediate decode path. SID and multiframe payloads are decoded immediately
+   -the codec stage thread spins briefly on the ring head, then blocks on it as a futex (same method as ThreadIdleWait()). It's not pinned; its affinity is the process CPU set from sched_getaffinity(), so if the p/m thread is pinned the codec stage thread can run on any core allowed to the process
+   -encoding, stream groups, and output remain on the p/m thread, as they depend on per session state and output queues owned by the p/m thread. If the codec stage thread can't be started, the p/m thread decodes all frames, same as DS_MEDIASERVICE_BATCH_DECODE
+*/
+
+#define CODEC_STAGE_RING_SIZE          32      /* must be a power of 2 */
+#define CODEC_STAGE_CHUNK_FRAMES       16      /* min frames per hand-off */
+#define CODEC_STAGE_SPIN               2048    /* spin iterations before blocking or yielding */
+#define CODEC_STAGE_BLOCK_TIMEOUT      10000   /* codec stage thread block timeout, in usec */
+
+typedef struct {
+
+   volatile uint32_t  head __attribute__((aligned(64)));  /* written by p/m thread, also futex word */
+   volatile uint32_t  fBlocked;                            /* set by codec stage thread while blocked */
+
+   volatile uint32_t  tail __attribute__((aligned(64)));  /* written by codec stage thread */
+   volatile bool      fExit;
+
+   struct {
+      uint16_t  first;
+      uint16_t  last;
+   } ring[CODEC_STAGE_RING_SIZE] __attribute__((aligned(64)));
+
+   int                num_handed_off;  /* frames in CODEC_BATCH queue handed off since last DecodeCodecBatch() */
+   int                state;           /* 0 = not started, 1 = running, -1 = start failed */
+   pthread_t          thread;
+
+} __attribute__((aligned(64))) CODEC_STAGE;
+
+static CODEC_STAGE codec_stage[MAX_PKTMEDIA_THREADS];  /* per thread, shared only between a p/m thread and its codec stage thread */
 
 #ifdef OVERWRITE_INPUT_DATA
 static bool fReuseInputs = false;
@@ -579,7 +709,17 @@ int InitStream(HSESSION[], int, int, bool*);
 int InitSession(HSESSION, int, uint64_t);
 #ifdef __LIBRARYMODE__
 int CleanSession(HSESSION, int);
+int RebalanceThreads(HSESSION[], int, uint64_t);
 #endif
+int isCodecBatchFrame(HCODEC, int, uint8_t*, int, unsigned int);
+int QueueCodecBatchFrame(int, int, int, unsigned int, HCODEC, int, uint8_t*, int, int, uint32_t, uint32_t, uint8_t);
+void SaveDecoderOutArgs(int, int, int, int);
+int DecodeCodecBatch(int);
+int GetCodecBatchRTPInfo(int, int, uint32_t[], uint32_t[], uint8_t[]);
+void SyncCodecBatchDecoder(int, HCODEC, int);
+static bool WaitCodecStage(int);
+int HandOffCodecBatch(int);
+void StopCodecStage(int);
 
 #ifdef USE_CHANNEL_PKT_STATS
 int ManageSessions(HSESSION[], PKT_COUNTERS[], PKT_STATS_HISTORY[], PKT_STATS_HISTORY[], bool*, int, uint64_t);
@@ -631,6 +771,8 @@ void set_session_last_push_time(HSESSION);  /* called by DSPushPackets() in pktl
 void set_session_alarm_flags(HSESSION hSession, uint8_t uFlags);
 
 void ThreadAbort(int, char*);
+void ThreadIdleWait(int, bool);
+void ThreadIdleWakeup(int);
 
 
 #define SECONDARY_THREADS_DEPRECATED  /* mediaTest no longer supports "secondary threads". Since early 2018, packet_flow_media_proc() supports multiple packet/media threads, and multiple app threads are implemented using mediaTest -Et ant -tN cmd line options, which invoke one or more mediaMin application threads, JHB Jan 2020 */
@@ -682,40 +824,75 @@ void DisableStreamMerging(int chnum_parent);
 static int progress_var[MAX_SESSIONS] = { 0 };
 #endif
 
-static uint8_t nDormantChanFlush[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-static uint8_t nOnHoldChanFlush[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
 extern short int nOnHoldChan[MAX_SESSIONS][MAX_TERMS];  /* declared in streamlib.so, referenced by DSProcesstreamGroupContributors() */
 
 #if 0
 static float input_buffer_interval[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-#else
-static unsigned int term_uFlags[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-static unsigned int session_uFlags[MAX_SESSIONS] = { 0 };
 #endif
-static int8_t output_buffer_interval[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-static int8_t ptime[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
 
-static uint8_t uDisplayDTMFEventMsg[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-static uint8_t uDTMFState[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
+/* per session and per channel state notes, JHB Oct 2026:
 
-static int8_t nMaxLossPtimes[MAX_SESSIONS][MAX_TERMS] = {{ 0 }};
-
-static uint64_t last_packet_time[MAX_SESSIONS] = { 0 };
-static uint64_t no_pkt_elapsed_time[MAX_SESSIONS] = { 0 };
+   -state accessed by p/m threads on every loop iteration for each session they own is grouped into SESSION_STATE_HOT, one cache line per session. Previously these were separate [MAX_SESSIONS] arrays, so handling one session touched a dozen or more cache lines, each shared with 7 or more neighboring sessions that might be owned by other p/m threads
+   -state accessed less often (DTMF event handling, packet delta running sum, DSPushPackets() elapsed time alarm) is in SESSION_STATE_COLD. last_push_time and session_alarm_flags are written asynchronously by application threads (see set_session_last_push_time() and set_session_alarm_flags() below), so keeping them out of SESSION_STATE_HOT avoids app threads invalidating p/m thread hot lines on every DSPushPackets() call
+   -per channel packet time stats and last pull time are grouped into CHAN_STATE, one cache line per channel
+   -arrays are indexed by session handle and channel number, which are global across p/m threads (as assigned by pktlib), so there is no per thread allocation. Alignment ensures no two sessions or channels share a cache line
+*/
 
 #define DELTA_SUM_LENGTH 32
-static int64_t pkt_delta_runsum[MAX_SESSIONS][DELTA_SUM_LENGTH] = {{ 0 }};
-static int64_t pkt_delta_sum[MAX_SESSIONS] = { 0 };
-static int pkt_sum_index[MAX_SESSIONS] = { 0 };
-static uint32_t pkt_count[MAX_SESSIONS] = { 0 };
+
+typedef struct {
+
+   uint64_t      last_packet_time;
+   uint64_t      no_pkt_elapsed_time;
+   int64_t       pkt_delta_sum;
+   unsigned int  session_uFlags;
+   unsigned int  term_uFlags[MAX_TERMS];
+   uint32_t      pkt_count;
+   int           pkt_sum_index;
+   int8_t        ptime[MAX_TERMS];
+   int8_t        output_buffer_interval[MAX_TERMS];
+   int8_t        nMaxLossPtimes[MAX_TERMS];
+   uint8_t       nDormantChanFlush[MAX_TERMS];
+   uint8_t       nOnHoldChanFlush[MAX_TERMS];
+   bool          fFirstGroupContribution;
+
+} __attribute__((aligned(64))) SESSION_STATE_HOT;
+
+typedef struct {
+
+   uint64_t      last_push_time;  /* written by app threads, see set_session_last_push_time() */
+   uint64_t      last_migrate_time;  /* time session was last moved to another p/m thread, see RebalanceThreads() */
+   uint8_t       session_alarm_flags;
+   uint8_t       uDisplayDTMFEventMsg[MAX_TERMS];
+   uint8_t       uDTMFState[MAX_TERMS];
+
+   int64_t       pkt_delta_runsum[DELTA_SUM_LENGTH] __attribute__((aligned(64)));
+
+} __attribute__((aligned(64))) SESSION_STATE_COLD;
+
+static SESSION_STATE_HOT session_state_hot[MAX_SESSIONS] = {{ 0 }};
+static SESSION_STATE_COLD session_state_cold[MAX_SESSIONS] = {{ 0 }};
 static HSESSION hSession0 = -1, hSession1 = -1, hSession2 = -1;
 
 #ifdef PACKET_TIME_STATS
 
-static uint64_t packet_in_time[NCORECHAN] = { 0 };
-static uint64_t last_packet_in_time[NCORECHAN] = { 0 };
-static uint32_t packet_rtp_time[NCORECHAN] = { 0 };
-static uint32_t last_rtp_timestamp[NCORECHAN] = { 0 };
+typedef struct {
+
+   uint64_t      last_pull_time;  /* per stream last jitter buffer pull time (in msec), updated after calls to DSGetOrderedPackets(). Referenced in get_chan_packets() in pktlib.c */
+   uint64_t      packet_in_time;
+   uint64_t      last_packet_in_time;
+   uint64_t      packet_in_time_pull;
+   uint64_t      last_packet_in_time_pull;
+   uint32_t      packet_rtp_time;
+   uint32_t      last_rtp_timestamp;
+   uint32_t      packet_rtp_time_pull;
+   uint32_t      last_rtp_timestamp_pull;
+   uint16_t      prev_pyld_content;
+
+} __attribute__((aligned(64))) CHAN_STATE;
+
+static CHAN_STATE chan_state[NCORECHAN] = {{ 0 }};
+
 static uint64_t packet_max_delta[NCORECHAN] = { 0 };
 static uint32_t max_delta_packet[NCORECHAN] = { 0 };
 
@@ -727,17 +904,10 @@ static uint64_t packet_max_sid_delta[NCORECHAN] = { 0 };
 static uint32_t max_sid_delta_packet[NCORECHAN] = { 0 };
 static uint32_t media_stats_pkt_count[NCORECHAN] = { 0 };
 static uint32_t sid_stats_pkt_count[NCORECHAN] = { 0 };
-static uint16_t prev_pyld_content[NCORECHAN] = { 0 };
-
-static uint64_t packet_in_time_pull[NCORECHAN] = { 0 };
-static uint64_t last_packet_in_time_pull[NCORECHAN] = { 0 };
-static uint32_t packet_rtp_time_pull[NCORECHAN] = { 0 };
-static uint32_t last_rtp_timestamp_pull[NCORECHAN] = { 0 };
 
 #ifdef __LIBRARYMODE__
 uint64_t last_buffer_time[NCORECHAN] = { 0 };  /* per stream last jitter buffer add time (in msec) */
 #endif
-static uint64_t last_pull_time[NCORECHAN] = { 0 };  /* per stream last jitter buffer pull time (in msec), updated after calls to DSGetOrderedPackets(). Referenced in get_chan_packets() in pktlib.c */
 
 static uint32_t packet_in_bursts[NCORECHAN] = { 0 };
 extern uint32_t packet_out_bursts[];  /* stat maintained in pktlib (pktlib.c) */
@@ -754,7 +924,6 @@ static uint32_t pkt_pastdue_flush[NCORECHAN] = { 0 };
 static uint32_t pkt_level_flush[NCORECHAN] = { 0 };
 
 static bool fFirstXcodeOutputPkt[NCORECHAN] = { false };
-static bool fFirstGroupContribution[MAX_SESSIONS] = { false };
 
 #ifndef __LIBRARYMODE__
   #ifndef BASE_FS_KHZ  /* define if pktlib source not available, JHB Apr 2024 */
@@ -788,6 +957,7 @@ void* packet_flow_media_proc(void* pExecuteMode) {
    int thread_index = 0;  /* note for mediaTest or other non packet/media thread use, thread_index = 0 assumed */
    bool fThreadInputActive = false;
    bool fThreadOutputActive = false;
+   unsigned int uNotifyEvents = 0;  /* packet notify events to signal at end of loop iteration, JHB Oct 2026 */
 
    int32_t i, j, ret_val, num_chan, n, session_status, num_pkts;
    int32_t nSessionsCreated = 0, nSessionsInit = 0, nStreamsInit = 0, numStreams, numSessions;
@@ -1250,6 +1420,7 @@ too_many_threads:
       if (strstr(strupr(strcpy(tmpstr, MediaParams[nOutFiles].Media.outputFilename)), ".PCAP") && packet_media_thread_info[thread_index].packet_mode) {
 
          if (DSOpenPcap(MediaParams[nOutFiles].Media.outputFilename, DS_WRITE, &fp_out[nOutFiles], NULL, "") < 0) break;
+         DSCreatePcapWriter(fp_out[nOutFiles], 0, 0);  /* attach buffered writer. Output pcaps may be written by multiple threads; DSWritePcapBuffered() handles this without a semaphore. If DSCreatePcapWriter() fails DSWritePcapBuffered() uses DSWritePcap(), JHB Oct 2026 */
          out_type[nOutFiles] = PCAP;
          num_pcap_outputs++;
       }
@@ -1528,7 +1699,7 @@ set_session_flags:
          unsigned int uFlags = DSGetSessionInfo(hSessions_t[i], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, j+1, NULL);
          if (!(uFlags & TERM_DYNAMIC_SESSION)) num_static_streams++;
          #else
-         if (!(term_uFlags[hSessions_t[i]][j] & TERM_DYNAMIC_SESSION)) num_static_streams++;
+         if (!(session_state_hot[hSessions_t[i]].term_uFlags[j] & TERM_DYNAMIC_SESSION)) num_static_streams++;
          #endif
          #endif
       }
@@ -1554,7 +1725,15 @@ time_init:
       else timeScale = 1;
    }
 
-   if (!base_time) base_time = get_time(USE_CLOCK_GETTIME);  /* for each thread, one-time initialization of initial wall clock time, JHB May 2023 */
+   if (!base_time) {
+
+      if (fMediaThread && (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_REBALANCE_THREADS)) {  /* p/m threads share a base time if sessions can move between them, so session and jitter buffer times stay valid after migration. See RebalanceThreads(), JHB Oct 2026 */
+
+         __sync_bool_compare_and_swap(&pm_shared_base_time, 0, get_time(USE_CLOCK_GETTIME));
+         base_time = pm_shared_base_time;
+      }
+      else base_time = get_time(USE_CLOCK_GETTIME);  /* for each thread, one-time initialization of initial wall clock time, JHB May 2023 */
+   }
 
 run_loop:
 
@@ -1690,7 +1869,7 @@ run_loop:
             }
             #endif
 
-            sprintf(&tmpstr[strlen(tmpstr)], " mnp %d %d %d", hSession0 >= 0 ? (int)(no_pkt_elapsed_time[hSession0]/1000) : -1, hSession1 >= 0 ? (int)(no_pkt_elapsed_time[hSession1]/1000) : -1, hSession2 >= 0 ? (int)(no_pkt_elapsed_time[hSession2]/1000) : -1);
+            sprintf(&tmpstr[strlen(tmpstr)], " mnp %d %d %d", hSession0 >= 0 ? (int)(session_state_hot[hSession0].no_pkt_elapsed_time/1000) : -1, hSession1 >= 0 ? (int)(session_state_hot[hSession1].no_pkt_elapsed_time/1000) : -1, hSession2 >= 0 ? (int)(session_state_hot[hSession2].no_pkt_elapsed_time/1000) : -1);
 
 #if 0
             int sum0 = 0, sum1 = 0, sum2 = 0;
@@ -1704,8 +1883,8 @@ run_loop:
             sprintf(&tmpstr[strlen(tmpstr)], " ap %d %d %d", (int)(1.0*sum0/NUM_PKT_STATS/1000), (int)(1.0*sum1/NUM_PKT_STATS/1000), (int)(1.0*sum2/NUM_PKT_STATS/1000));
 #endif
 
-            uint32_t pkt_cnt0 = min(pkt_count[hSession0], (uint32_t)DELTA_SUM_LENGTH), pkt_cnt1 = min(pkt_count[hSession1], (uint32_t)DELTA_SUM_LENGTH), pkt_cnt2 = min(pkt_count[hSession2], (uint32_t)DELTA_SUM_LENGTH);
-            sprintf(&tmpstr[strlen(tmpstr)], " pd %1.2f %1.2f %1.2f", hSession0 >= 0 && pkt_cnt0 ? 1.0*pkt_delta_sum[hSession0]/pkt_cnt0/1000 : -1, hSession1 >= 0 && pkt_cnt1 ? 1.0*pkt_delta_sum[hSession1]/pkt_cnt1/1000 : -1, hSession2 >= 0 && pkt_cnt2 ? 1.0*pkt_delta_sum[hSession2]/pkt_cnt2/1000 : -1);
+            uint32_t pkt_cnt0 = min(session_state_hot[hSession0].pkt_count, (uint32_t)DELTA_SUM_LENGTH), pkt_cnt1 = min(session_state_hot[hSession1].pkt_count, (uint32_t)DELTA_SUM_LENGTH), pkt_cnt2 = min(session_state_hot[hSession2].pkt_count, (uint32_t)DELTA_SUM_LENGTH);
+            sprintf(&tmpstr[strlen(tmpstr)], " pd %1.2f %1.2f %1.2f", hSession0 >= 0 && pkt_cnt0 ? 1.0*session_state_hot[hSession0].pkt_delta_sum/pkt_cnt0/1000 : -1, hSession1 >= 0 && pkt_cnt1 ? 1.0*session_state_hot[hSession1].pkt_delta_sum/pkt_cnt1/1000 : -1, hSession2 >= 0 && pkt_cnt2 ? 1.0*session_state_hot[hSession2].pkt_delta_sum/pkt_cnt2/1000 : -1);
 
             sig_printf(tmpstr, PRN_LEVEL_STATS | PRN_SAME_LINE, thread_index);  /* console print */
 
@@ -1872,6 +2051,7 @@ run_loop:
       num_thread_group_contributions = 0;
 
       fThreadInputActive = false;
+      uNotifyEvents = 0;
 
    /* Interval timing notes:
 
@@ -2030,9 +2210,9 @@ get_pkt_info:
 
          if (lib_dbg_cfg.uDebugMode & DS_ENABLE_PUSHPACKETS_ELAPSED_TIME_ALARM) {
 
-            int64_t session_last_push_time = __sync_fetch_and_add(&last_push_time[hSession], 0);  /* note -- we use an atomic int64_t read as DSPushPackets() is an asynchronous (user) thread and might concurrently write last_push_time[], JHB Jan2020 */
+            int64_t session_last_push_time = __sync_fetch_and_add(&session_state_cold[hSession].last_push_time, 0);  /* note -- we use an atomic int64_t read as DSPushPackets() is an asynchronous (user) thread and might concurrently write last_push_time[], JHB Jan2020 */
 
-            if (!(session_alarm_flags[hSession] & 1) && !(session_alarm_flags[hSession] & 2) && session_last_push_time && ((int64_t)cur_time - session_last_push_time)/1000 >= lib_dbg_cfg.uPushPacketsElapsedTimeAlarm) {  /* note we don't use timeScale here; we assume the app is also pushing packets at accelerated time, JHB Jun 2023 */
+            if (!(session_state_cold[hSession].session_alarm_flags & 1) && !(session_state_cold[hSession].session_alarm_flags & 2) && session_last_push_time && ((int64_t)cur_time - session_last_push_time)/1000 >= lib_dbg_cfg.uPushPacketsElapsedTimeAlarm) {  /* note we don't use timeScale here; we assume the app is also pushing packets at accelerated time, JHB Jun 2023 */
 
                char fstr[50];
                sprintf(fstr, "%4.2f", 1.0*lib_dbg_cfg.uPushPacketsElapsedTimeAlarm/1000);
@@ -2042,7 +2222,7 @@ get_pkt_info:
 
                Log_RT(3, "WARNING: p/m thread %d says DSPushPackets() has pushed no packets for session %d for %s sec. The stream associated with this session may have stopped for a normal reason or there may be a problem \n", thread_index, hSession, fstr);
 
-               __sync_or_and_fetch(&session_alarm_flags[hSession], 2);  /* update the alarm flag so we don't continue to log more messages for this session unless it "returns to life" and has more input packets, JHB Jan 2023 */
+               __sync_or_and_fetch(&session_state_cold[hSession].session_alarm_flags, 2);  /* update the alarm flag so we don't continue to log more messages for this session unless it "returns to life" and has more input packets, JHB Jan 2023 */
             }
          }
 
@@ -2097,30 +2277,31 @@ get_pkt_info:
             }
 
             if (numPkts && !fThreadInputActive) fThreadInputActive = true;  /* any packet for any session sets input active flag */
+            if (numPkts > 0) uNotifyEvents |= DS_PKT_NOTIFY_INPUT_SPACE;  /* push queue space freed */
 
             if (!fPreemptAlarm && session_info_thread[hSession].fDataAvailable) { 
 
-               uint64_t elapsed_time = cur_time - last_packet_time[hSession];
+               uint64_t elapsed_time = cur_time - session_state_hot[hSession].last_packet_time;
 
-               if (numPkts == 0 && last_packet_time[hSession]) {
+               if (numPkts == 0 && session_state_hot[hSession].last_packet_time) {
 
-                  if (elapsed_time > no_pkt_elapsed_time[hSession]) no_pkt_elapsed_time[hSession] = elapsed_time;  /* check for new session mnp */
+                  if (elapsed_time > session_state_hot[hSession].no_pkt_elapsed_time) session_state_hot[hSession].no_pkt_elapsed_time = elapsed_time;  /* check for new session mnp */
                }
                else {
 
-                  if (last_packet_time[hSession]) {  /* numPkts is non-zero */
+                  if (session_state_hot[hSession].last_packet_time) {  /* numPkts is non-zero */
 
-                     int index = pkt_sum_index[hSession];
-                     int oldest_value = pkt_delta_runsum[hSession][index];
-                     pkt_delta_runsum[hSession][index] = elapsed_time;
+                     int index = session_state_hot[hSession].pkt_sum_index;
+                     int oldest_value = session_state_cold[hSession].pkt_delta_runsum[index];
+                     session_state_cold[hSession].pkt_delta_runsum[index] = elapsed_time;
 
-                     pkt_delta_sum[hSession] += elapsed_time - oldest_value;
+                     session_state_hot[hSession].pkt_delta_sum += elapsed_time - oldest_value;
 
-                     pkt_sum_index[hSession] = (index + 1) & (DELTA_SUM_LENGTH-1);
-                     pkt_count[hSession]++;
+                     session_state_hot[hSession].pkt_sum_index = (index + 1) & (DELTA_SUM_LENGTH-1);
+                     session_state_hot[hSession].pkt_count++;
                   }
 
-                  last_packet_time[hSession] = cur_time;
+                  session_state_hot[hSession].last_packet_time = cur_time;
                }
 
                if (i == 0) { hSession0 = hSession; hSession1 = -1; hSession2 = -1; }
@@ -2148,7 +2329,7 @@ get_pkt_info:
             #if 0
             hSession_param = (uFlags_session(hSession) & DS_SESSION_USER_MANAGED) ? hSession : -1;
             #else
-            hSession_param = (session_uFlags[hSession] & DS_SESSION_USER_MANAGED) ? hSession : -1;
+            hSession_param = (session_state_hot[hSession].session_uFlags & DS_SESSION_USER_MANAGED) ? hSession : -1;
             #endif
 
             pkt_ptr = pkt_in_buf;
@@ -2203,7 +2384,7 @@ get_pkt_info:
   #if 0
   static bool fOnce2[MAX_PKTMEDIA_THREADS][8] = {{ false }};
   if (i < 8 && !fOnce2[thread_index][i]) {
-     sprintf(tmpstr, "look ahead pkts = %d, time = %llu, chnums[0] = %d, chnums[1] = %d, hSession = %d, term uFlags = 0x%x\n", numPkts, session_info_thread[hSession].look_ahead_time, chnums_lookahead[0], chnums_lookahead[1], hSession, term_uFlags[hSession][0]);
+     sprintf(tmpstr, "look ahead pkts = %d, time = %llu, chnums[0] = %d, chnums[1] = %d, hSession = %d, term uFlags = 0x%x\n", numPkts, session_info_thread[hSession].look_ahead_time, chnums_lookahead[0], chnums_lookahead[1], hSession, session_state_hot[hSession].term_uFlags[0]);
      sig_printf(tmpstr, PRN_LEVEL_INFO, thread_index);
      fOnce2[thread_index][i] = true;
   }
@@ -2371,7 +2552,7 @@ debug:
                      session_info_thread[hSession].chnum_map[term] = chnum_parent;  /* mark this channel as in use */
 
                      #if 0  /* on-hold flush state machine clears itself. If we clear it here because child stream packets are arriving, we can stop parent stream flush before it's complete, JHB Jan2200 */ 
-                     nOnHoldChanFlush[hSession][term] = 0;  /* reset session's on-hold flush state */
+                     session_state_hot[hSession].nOnHoldChanFlush[term] = 0;  /* reset session's on-hold flush state */
                      nOnHoldChan[hSession][term] = 0;
                      #endif
                   }
@@ -2465,12 +2646,12 @@ static int log_pkt_in_index = 0;
                            pkt_counters[thread_index].pkt_add_to_jb_cnt += ret_val;
 
                            #ifdef PACKET_TIME_STATS  /* we wait until this point to record packet time stats because we need the chnum for either parent or child. For a child we don't know it until created by DSBufferPackets() */
-                           if (lib_dbg_cfg.uPktStatsLogging & DS_ENABLE_PACKET_TIME_STATS && !fPreemptAlarm) RecordPacketTimeStats(chnum, pkt_ptr, packet_len[0], pkt_info[0], pkt_count[hSession], PACKET_TIME_STATS_INPUT);
+                           if (lib_dbg_cfg.uPktStatsLogging & DS_ENABLE_PACKET_TIME_STATS && !fPreemptAlarm) RecordPacketTimeStats(chnum, pkt_ptr, packet_len[0], pkt_info[0], session_state_hot[hSession].pkt_count, PACKET_TIME_STATS_INPUT);
                            #endif
 
                         /* mark session's ssrc state as live upon buffering a packet, record channel's most recent buffer time */
 
-                           if (!nDormantChanFlush[hSession][term]) session_info_thread[hSession].ssrc_state[term] = SSRC_LIVE;
+                           if (!session_state_hot[hSession].nDormantChanFlush[term]) session_info_thread[hSession].ssrc_state[term] = SSRC_LIVE;
 
                            #ifdef __LIBRARYMODE__
                            last_buffer_time[chnum] = cur_time;
@@ -2536,7 +2717,7 @@ static int log_pkt_in_index = 0;
                   #if 0
                   if (ret_val > 0 && (nSSRC_change = CheckForSSRCChange(hSession, &chnum_parent, pkt_ptr, &pkt_len[j], 1, uFlags_info, uFlags_session(hSession), pkt_ctrs, thread_index)) > 0) {  /* look for an SSRC change in the input stream, set fSSRC_Change[] if found */
                   #else
-                  if (ret_val > 0 && (nSSRC_change = CheckForSSRCChange(hSession, &chnum_parent, pkt_ptr, &pkt_len[j], 1, uFlags_info, session_uFlags[hSession], pkt_ctrs, thread_index)) > 0) {  /* look for an SSRC change in the input stream, set fSSRC_Change[] if found */
+                  if (ret_val > 0 && (nSSRC_change = CheckForSSRCChange(hSession, &chnum_parent, pkt_ptr, &pkt_len[j], 1, uFlags_info, session_state_hot[hSession].session_uFlags, pkt_ctrs, thread_index)) > 0) {  /* look for an SSRC change in the input stream, set fSSRC_Change[] if found */
                   #endif
 
                      session_info_thread[hSession].fSSRC_change_active[term] = true;
@@ -2701,7 +2882,8 @@ static int log_pkt_in_index = 0;
                      Log_RT(4, "INFO: Packet/media thread %d entering energy saver state after inactivity time %d sec (has entered %d time%s, max recorded inactivity time = %d sec)\n", thread_index, (int)(no_pkt_elapsed_time_thread/1000000L), count, count > 1 ? "s" : "", (int)( packet_media_thread_info[thread_index].max_inactivity_time/1000000L));
                   }
 
-                  usleep(pktlib_gbl_cfg.uThreadEnergySaverSleepTime);  /* sleep as specified. Note that CPU usage percentage is essentially a ratio of what an inactive p/m thread does to check for input (i.e. "floor" CPU usage) and the sleep time. The floor time measures around 500 usec, so a sleep time of 500 usec (approx 50 sessions active) gives about 50% CPU usage, JHB Jan2019 */
+                  if (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_SPIN_THEN_BLOCK) ThreadIdleWait(thread_index, fNetIOAllowed && isMasterThread(thread_index));  /* spin then block until DSPushPackets() pushes to one of this thread's sessions, JHB Oct 2026 */
+                  else usleep(pktlib_gbl_cfg.uThreadEnergySaverSleepTime);  /* sleep as specified. Note that CPU usage percentage is essentially a ratio of what an inactive p/m thread does to check for input (i.e. "floor" CPU usage) and the sleep time. The floor time measures around 500 usec, so a sleep time of 500 usec (approx 50 sessions active) gives about 50% CPU usage, JHB Jan2019 */
                }
             }
          }
@@ -2860,7 +3042,7 @@ static int log_pkt_in_index = 0;
             #if 0
             hSession_param = (uFlags_session(hSession) & DS_SESSION_USER_MANAGED) ? hSession : -1;
             #else
-            hSession_param = (session_uFlags[hSession] & DS_SESSION_USER_MANAGED) ? hSession : -1;
+            hSession_param = (session_state_hot[hSession].session_uFlags & DS_SESSION_USER_MANAGED) ? hSession : -1;
             #endif
 
             #if 0
@@ -2903,7 +3085,7 @@ static int log_pkt_in_index = 0;
                   else term -= 1;
 
                   #if 0  /* move this to buffer add side so that session's ssrc state is marked as live when a packet is buffered w/o error. This is (i) independent of jitter buffer target delay (for example a short session that never primes, or takes ) and (ii) compatible with both analytics and telecom modes, JHB Apr 2020 */
-                  if (!nDormantChanFlush[hSession][term]) session_info_thread[hSession].ssrc_state[term] = SSRC_LIVE;
+                  if (!session_state_hot[hSession].nDormantChanFlush[term]) session_info_thread[hSession].ssrc_state[term] = SSRC_LIVE;
                   #endif
 
                   #ifdef WAV_OUT_DEBUG_PRINT
@@ -2922,8 +3104,8 @@ static int log_pkt_in_index = 0;
 
                      /* set flags for DSGetOrderedPackets() */
 
-                        bool fFlushChan = !session_info_thread[hSession].fDataAvailable || nDormantChanFlush[hSession][term] || nOnHoldChanFlush[hSession][term];
-                        bool fParentOnly = nDormantChanFlush[hSession][term] || nOnHoldChanFlush[hSession][term];
+                        bool fFlushChan = !session_info_thread[hSession].fDataAvailable || session_state_hot[hSession].nDormantChanFlush[term] || session_state_hot[hSession].nOnHoldChanFlush[term];
+                        bool fParentOnly = session_state_hot[hSession].nDormantChanFlush[term] || session_state_hot[hSession].nOnHoldChanFlush[term];
 
                         #if 0  /* not needed - flushing a parent channel when it still has packets in its jitter buffer after creating a child channel */
                         if (DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_NUM_PKTS) && DSGetSessionInfo(chan_nums[n], DS_SESSION_INFO_CHNUM | DS_SESSION_INFO_DYNAMIC_CHANNELS, 0, NULL)) fFlushChan = true;
@@ -2942,7 +3124,7 @@ static int log_pkt_in_index = 0;
                        2) analytics mode is independent of buffering rate. Packets can be buffered in real-time (either as they arrive over TCP or UDP or per their arrival timestamp), faster-than-real-time mode (FTRT mode), or as-fast-as-possible mode (AFAP mode)
                      */
 
-                        if (term_uFlags[hSession][term] & TERM_ANALYTICS_MODE_PACKET_TIMING) uFlags_get |= DS_GETORD_PKT_ANALYTICS;
+                        if (session_state_hot[hSession].term_uFlags[term] & TERM_ANALYTICS_MODE_PACKET_TIMING) uFlags_get |= DS_GETORD_PKT_ANALYTICS;
 
                         #define ANALYTICSDEBUG
                         #ifdef ANALYTICSDEBUG
@@ -2953,7 +3135,7 @@ static int log_pkt_in_index = 0;
                            unsigned int uTerm_Flags = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_TERM_FLAGS, term+1, NULL);
                            unsigned int lookback = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_RFC7198_LOOKBACK, term+1, NULL);
                            char lookbackstr[10] = ""; if (lookback > 1) sprintf(lookbackstr, "%d,", lookback);
-                           sprintf(tmpstr, "chan_nums[%d] = %d, num_chan = %d, hSession = %d, term = %d, input_buffer_interval = %4.2f, output_buffer_interval = %d, ptime = %d, %s mode,%s%s preemption monitoring %s \n", n, chan_nums[n], num_chan, hSession, term, input_buffer_interval, output_buffer_interval, ptime[hSession][term], uTerm_Flags & TERM_NO_PACKET_ARRIVAL_TIMESTAMPS ? "untimed" : !(uFlags_get & DS_GETORD_PKT_ANALYTICS) ? "telecom" : DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_TARGET_DELAY) <= 7 ? "analytics compatibilty" : "analytics", !lookback ? " RFC7198 lookback disabled," : lookback > 1 ? " RFC7198 lookback " : "", lookbackstr, packet_media_thread_info[thread_index].fPreEmptionMonitorEnabled ? "enabled" : "disabled");
+                           sprintf(tmpstr, "chan_nums[%d] = %d, num_chan = %d, hSession = %d, term = %d, input_buffer_interval = %4.2f, output_buffer_interval = %d, ptime = %d, %s mode,%s%s preemption monitoring %s \n", n, chan_nums[n], num_chan, hSession, term, input_buffer_interval, output_buffer_interval, session_state_hot[hSession].ptime[term], uTerm_Flags & TERM_NO_PACKET_ARRIVAL_TIMESTAMPS ? "untimed" : !(uFlags_get & DS_GETORD_PKT_ANALYTICS) ? "telecom" : DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_TARGET_DELAY) <= 7 ? "analytics compatibilty" : "analytics", !lookback ? " RFC7198 lookback disabled," : lookback > 1 ? " RFC7198 lookback " : "", lookbackstr, packet_media_thread_info[thread_index].fPreEmptionMonitorEnabled ? "enabled" : "disabled");
                            sig_printf(tmpstr, PRN_LEVEL_INFO, thread_index);
                            fOnce[hSession][term] = true;
                         }
@@ -2973,7 +3155,7 @@ static int log_pkt_in_index = 0;
 
                         if (session_info_thread[hSession].fSSRC_change_active[term] && !(uFlags_term & TERM_DTX_ENABLE)) uFlags_get |= DS_GETORD_PKT_RETURN_ALL_DELIVERABLE;
                         #else
-                        if (session_info_thread[hSession].fSSRC_change_active[term] && !(term_uFlags[hSession][term] & TERM_DTX_ENABLE)) uFlags_get |= DS_GETORD_PKT_RETURN_ALL_DELIVERABLE;
+                        if (session_info_thread[hSession].fSSRC_change_active[term] && !(session_state_hot[hSession].term_uFlags[term] & TERM_DTX_ENABLE)) uFlags_get |= DS_GETORD_PKT_RETURN_ALL_DELIVERABLE;
                         #endif
 
                      /* Enable DTMF event handling in DSGetOrderedPackets(). See the check below for pkt_info[] = DS_PKT_PYLD_CONTENT_DTMF */
@@ -2982,7 +3164,7 @@ static int log_pkt_in_index = 0;
 
                      /* enable ooo holdoff, see comments in pktlib.h. The mediaMin application sets the TERM_OOO_HOLDOFF_ENABLE flag by default when creating sessions */
 
-                        if (term_uFlags[hSession][term] & TERM_OOO_HOLDOFF_ENABLE) uFlags_get |= DS_GETORD_PKT_ENABLE_OOO_HOLDOFF;
+                        if (session_state_hot[hSession].term_uFlags[term] & TERM_OOO_HOLDOFF_ENABLE) uFlags_get |= DS_GETORD_PKT_ENABLE_OOO_HOLDOFF;
 
                      /* enable timestamp gap resync in telecom mode for large gaps under specific conditions. Notes JHB Sep 2023:
 
@@ -3005,7 +3187,7 @@ static int log_pkt_in_index = 0;
 
                               #ifdef TELECOM_MODE_TIMESTAMP_GAP_STATS
                               static int nCount[10] = { 0 };
-                              if (nCount[chan_nums[n]] < 500) Log_RT(4, " *** [%d] ch %d telecom mode timestamp gap = %d, num output pkts = %d, num_pkts = %d cum timestamp = %d, cum pulltime = %d, cur_time = %llu, last pull time = %llu \n", nCount[chan_nums[n]]++, chan_nums[n], timestamp_gap, DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_NUM_PKTS), num_output_pkts, DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP), DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME), (long long unsigned)cur_time, (long long unsigned)last_pull_time[chan_nums[n]]);
+                              if (nCount[chan_nums[n]] < 500) Log_RT(4, " *** [%d] ch %d telecom mode timestamp gap = %d, num output pkts = %d, num_pkts = %d cum timestamp = %d, cum pulltime = %d, cur_time = %llu, last pull time = %llu \n", nCount[chan_nums[n]]++, chan_nums[n], timestamp_gap, DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_NUM_PKTS), num_output_pkts, DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP), DSGetJitterBufferInfo(chan_nums[n], DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME), (long long unsigned)cur_time, (long long unsigned)chan_state[chan_nums[n]].last_pull_time);
                               #endif
 
                               uFlags_get |= DS_GETORD_PKT_TIMESTAMP_GAP_RESYNC;
@@ -3134,7 +3316,7 @@ pull:
                               if (
                                   ((uFlags_get & DS_GETORD_PKT_ANALYTICS) && (fLevel = numpkts > nTargetDelay) && nTargetDelay > 7) ||
                                   ((uFlags_get & DS_GETORD_PKT_ANALYTICS) && (fLevel = numpkts > nMaxDelay) && nTargetDelay <= 7) ||  /* level flush added for analytics compatibility mode. Verify with test cases 5280.0.ws, 5281.0.ws, 13041.0, JHB May 2020 */
-                                  (!(uFlags_get & DS_GETORD_PKT_ANALYTICS) && ((fFlush = DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP) < DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME) && (cur_time - last_pull_time[chan_nums[n]] + 500)/1000 > (uint32_t)ptime[hSession][term] && numpkts > nTargetDelay) || (fLevel = (DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_DELAY) > max_depth_ptimes) || numpkts > nTargetDelay)))
+                                  (!(uFlags_get & DS_GETORD_PKT_ANALYTICS) && ((fFlush = DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP) < DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME) && (cur_time - chan_state[chan_nums[n]].last_pull_time + 500)/1000 > (uint32_t)session_state_hot[hSession].ptime[term] && numpkts > nTargetDelay) || (fLevel = (DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_DELAY) > max_depth_ptimes) || numpkts > nTargetDelay)))
                                  ) {
 
                                  if ((nRePull == 0 && fFlush) || (nRePull < 50 && !fFlush)) {  /* impose some limit on number of repulls to avoid excessive increase in subloops (based on num_pkts); after several main loops timestamps will catch up */
@@ -3147,14 +3329,14 @@ pull:
                               #if 0
                               else {
                                  static int count = 0;
-                                 int delta = (cur_time - last_pull_time[chan_nums[n]] + 500)/1000;
+                                 int delta = (cur_time - chan_state[chan_nums[n]].last_pull_time + 500)/1000;
                                  if (cum_timestamp[ch[j]] < cum_timeDelta[ch[j]] && delta >= 20 && count++ < 100) printf("\n === ch %d pull time delta = %d, numpkts = %d \n", chan_nums[n], delta, numpkts);
                               }
                               #endif
                            }
 
    #ifdef SHOW_FLUSH_AND_TIMESTAMP_CONDITIONS
-    if (fRePull && !fFlush && chan == 2) Log_RT(4, " *** ch %d repull to advance timestamp, num_ch = %d, fFlush = %d, fLevel = %d, nRePull = %d, (cum timestamp %d < cum pull time %d && cur_time %d - last pull time %d > 20 && numpkts %d > nTargetDelay %d) || (delay %d > max depth ptimes %d), output pkts = %d, num ooo = %d \n", chan, num_ch, fFlush, fLevel, nRePull, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP), (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME), (int)cur_time/1000, (int)last_pull_time[chan_nums[n]]/1000, numpkts, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_TARGET_DELAY), (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_DELAY), max_depth_ptimes, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_OUTPUT_PKT_COUNT), nNumOoo);
+    if (fRePull && !fFlush && chan == 2) Log_RT(4, " *** ch %d repull to advance timestamp, num_ch = %d, fFlush = %d, fLevel = %d, nRePull = %d, (cum timestamp %d < cum pull time %d && cur_time %d - last pull time %d > 20 && numpkts %d > nTargetDelay %d) || (delay %d > max depth ptimes %d), output pkts = %d, num ooo = %d \n", chan, num_ch, fFlush, fLevel, nRePull, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_CUMULATIVE_TIMESTAMP), (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_CUMULATIVE_PULLTIME), (int)cur_time/1000, (int)chan_state[chan_nums[n]].last_pull_time/1000, numpkts, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_TARGET_DELAY), (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_DELAY), max_depth_ptimes, (int)DSGetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_OUTPUT_PKT_COUNT), nNumOoo);
    #endif
                            if (fRePull) {
 
@@ -3163,7 +3345,7 @@ pull:
                                  #if 0
                                  static uint64_t basetime = 0;
                                  if (!basetime) basetime = cur_time;
-                                 printf("\n === ch %d flush time = %d (usec) %d (msec), cur time - last pull time = %d \n", chan, cur_time - basetime, (cur_time - basetime)/1000, (cur_time - last_pull_time[chan_nums[n]])/1000);
+                                 printf("\n === ch %d flush time = %d (usec) %d (msec), cur time - last pull time = %d \n", chan, cur_time - basetime, (cur_time - basetime)/1000, (cur_time - chan_state[chan_nums[n]].last_pull_time)/1000);
                                  #endif
 
                                  uFlags_get |= DS_GETORD_PKT_FLUSH;
@@ -3204,8 +3386,8 @@ pull:
 
                      /* record last pull time for this channel */
 
-                        if (uFlags_get & DS_GETORD_PKT_ANALYTICS) last_pull_time[chan_nums[n]] = cur_time;
-                        else if (num_pkts) last_pull_time[chan_nums[n]] = cur_time;  /* in telecom mode we go by whether a packet was returned, JHB Apr 2020 */
+                        if (uFlags_get & DS_GETORD_PKT_ANALYTICS) chan_state[chan_nums[n]].last_pull_time = cur_time;
+                        else if (num_pkts) chan_state[chan_nums[n]].last_pull_time = cur_time;  /* in telecom mode we go by whether a packet was returned, JHB Apr 2020 */
 
                         if (session_info_thread[hSession].fDataAvailable && fFlushChan) {
 
@@ -3292,6 +3474,12 @@ pull:
                   HCODEC hCodec = (intptr_t)NULL;
                   int prev_chnum = -1, in_media_sample_rate __attribute__ ((unused)) = 0;
 
+                  #if defined(__LIBRARYMODE__) && defined(DECOUPLE_STREAM_PROCESSING)
+                  bool fBatchDecode = fMediaThread && (packet_media_thread_info[thread_index].uFlags & (DS_MEDIASERVICE_BATCH_DECODE | DS_MEDIASERVICE_PIPELINE_DECODE)) && packet_media_thread_info[thread_index].packet_mode && session_info_thread[hSession].fUseJitterBuffer;  /* queue stream data for DecodeCodecBatch(), see notes near CODEC_BATCH, JHB Oct 2026 */
+                  #else
+                  bool fBatchDecode = false;  /* decoded data is needed in the packet loop for mediaTest wav output */
+                  #endif
+
                /* packet payload processing loop. A jitter buffer may have returned multiple packets representing multiple channels */
 
                   for (j=0; j<num_pkts; j++) {
@@ -3302,6 +3490,7 @@ pull:
                      #endif
 
                      int packet_type = MEDIA_PACKET;  /* default */
+                     int batch_framesize = 0;  /* non-zero if payload is queued for DecodeCodecBatch() */
 
                      #ifndef DONT_USE_PKTINFO
                      PKTINFO PktInfo;  /* fill in PKTINFO struct and avoid any further DSGetPacketInfo() calls except session/stream related (chnum, parent chnum, etc), and for those we can use DS_PKT_INFO_USE_IP_HDR_LEN flag for minimal overhead, JHB Dec 2024 */
@@ -3392,6 +3581,7 @@ pull:
                            if (fMediaThread) {
 
                               DSSendPackets((HSESSION*)&hSession, DS_SEND_PKT_QUEUE | DS_PULLPACKETS_JITTER_BUFFER | DS_SEND_PKT_SUPPRESS_QUEUE_FULL_MSG, pkt_ptr, &packet_len[j], 1);  /* send jitter buffer output packet to application thread (write to outgoing packet queue). While working on video, which can have many large packets for each timestamp, wondering if it's not a good idea to suppress queue full messages, JHB Jul 2024 */
+                              uNotifyEvents |= DS_PKT_NOTIFY_OUTPUT;
 
                               #ifdef DONT_USE_PKTINFO
                               rtp_timestamp[j] = DSGetPacketInfo(-1, uFlags_info | DS_PKT_INFO_RTP_TIMESTAMP, pkt_ptr, packet_len[j], NULL, NULL);  /* save packet timestamp and ssrc */
@@ -3452,22 +3642,22 @@ pull:
 
                         DSGetDTMFInfo(-1, (uintptr_t)NULL, rtp_pyld_ptr, rtp_pyld_len, &dtmf_info);
 
-                        if (uDisplayDTMFEventMsg[hSession][term] < dtmf_display_msg_limit || dtmf_display_msg_limit == 0) {  /* arbitrary limit on how many DTMF events to display during normal operation; to see all events look at the packet stats log generated when the program exits */
+                        if (session_state_cold[hSession].uDisplayDTMFEventMsg[term] < dtmf_display_msg_limit || dtmf_display_msg_limit == 0) {  /* arbitrary limit on how many DTMF events to display during normal operation; to see all events look at the packet stats log generated when the program exits */
 
-                           uDisplayDTMFEventMsg[hSession][term]++;
+                           session_state_cold[hSession].uDisplayDTMFEventMsg[term]++;
 
                            strcpy(tmpstr, "");  /* remove preceding newline handling, let sig_printf() make the decision. This makes DTMF event display format consistent and removes blanks lines, JHB Apr 2023 */
 
-                           if (uDTMFState[hSession][term] == 0) {
+                           if (session_state_cold[hSession].uDTMFState[term] == 0) {
 
-                              uDTMFState[hSession][term] = 1;
+                              session_state_cold[hSession].uDTMFState[term] = 1;
                               nStatsDisplayPause = 50;  /* pause real-time stats display for some arbitrary duration of DTMF event group, JHB May 2023 */
                            }
 
-                           sprintf(&tmpstr[strlen(tmpstr)], "DTMF Event packet %u received @ pkt %d ssrc 0x%x", uDisplayDTMFEventMsg[hSession][term], pkt_pulled_cnt, rtp_ssrc[j]);
+                           sprintf(&tmpstr[strlen(tmpstr)], "DTMF Event packet %u received @ pkt %d ssrc 0x%x", session_state_cold[hSession].uDisplayDTMFEventMsg[term], pkt_pulled_cnt, rtp_ssrc[j]);
 
                            if (packet_type == DTMF_PACKET) strcat(tmpstr, ", will be forwarded to output");
-                           if (uDisplayDTMFEventMsg[hSession][term] == dtmf_display_msg_limit) strcat(tmpstr, " (check packet log for all further events)");
+                           if (session_state_cold[hSession].uDisplayDTMFEventMsg[term] == dtmf_display_msg_limit) strcat(tmpstr, " (check packet log for all further events)");
 
                            sprintf(&tmpstr[strlen(tmpstr)], ", Event = %d, Duration = %d, Volume = %d", dtmf_info.event, dtmf_info.duration, dtmf_info.volume);
 
@@ -3476,7 +3666,7 @@ pull:
                               strcat(tmpstr, ", End of Event");
 
                               DSSetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_UNDERRUN_RESYNC_WARNING, 1);  /* avoid underrun resync warning when media packets resume, JHB Jun2019 */
-                              uDTMFState[hSession][term] = 0;  /* we clear DTMF state on first end-of-event, although there may be several end-of-events, JHB May 2023 */
+                              session_state_cold[hSession].uDTMFState[term] = 0;  /* we clear DTMF state on first end-of-event, although there may be several end-of-events, JHB May 2023 */
                               nStatsDisplayPause = 0;  /* clear stats pause, which could be faster than stats display count down, for example in FTRT and AFAP modes, JHB May 2023 */
                            }
 
@@ -3539,7 +3729,12 @@ pull:
    }
    #endif
 
-                           if (isVoiceCodec(termInfo.codec_type) || isAudioCodec(termInfo.codec_type)) {  /* voice or audio (isXxxCodec() macros are in shared_include/codec.h) */
+                           batch_framesize = fBatchDecode ? isCodecBatchFrame(hCodec, termInfo.codec_type, rtp_pyld_ptr, rtp_pyld_len, packet_media_thread_info[thread_index].uFlags) : 0;
+
+                           if (batch_framesize > 0) media_data_len = 0;  /* payload is decoded by DecodeCodecBatch(), JHB Oct 2026 */
+                           else if (isVoiceCodec(termInfo.codec_type) || isAudioCodec(termInfo.codec_type)) {  /* voice or audio (isXxxCodec() macros are in shared_include/codec.h) */
+
+                              if (fBatchDecode) SyncCodecBatchDecoder(thread_index, hCodec, termInfo.codec_type);  /* decoder may have queued frames, JHB Oct 2026 */
 
                               media_data_len = DSCodecDecode(&hCodec, 0, rtp_pyld_ptr, media_data_buffer, rtp_pyld_len, 1, NULL, &OutArgs);  /* call voplib decoder */
                            }
@@ -3570,19 +3765,7 @@ pull:
                            if (isVideoCodec(termInfo.codec_type) && !fOnce[hSession]) { fOnce[hSession] = true; printf("\n *** video decode pass-thru hSession = %d, rtp_pyld_len = %d, media_data_len = %d \n", hSession, rtp_pyld_len, media_data_len); }
                            #endif
 
-                           if (isEVSCodec(termInfo.codec_type) || isAMRCodec(termInfo.codec_type)) {  /* handle return data, JHB Oct 2022. AMR support added Dec 2024 */
-
-                              int bitrate_index = OutArgs.bitRate > 0 ? DSGetCodecInfo(termInfo.codec_type, DS_CODEC_INFO_BITRATE_TO_INDEX, OutArgs.bitRate, 0, NULL) : -1;  /* convert bitrate to an index used by all codecs. Note that to avoid warning messages bitrate param should be checked for > 0 in case codec doesn't know it, for example input frame is a NO_DATA type, JHB Nov 2024 */
-
-                              if (bitrate_index >= 0) {
-                                 int bitrate_list = DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_BITRATE_LIST);
-                                 if (bitrate_list >= 0) DSSetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_BITRATE_LIST, bitrate_list | (1L << bitrate_index));  /* save bitrate index in list of bitrates */
-                              }
-
-                           /* add audio classification to current list */
-
-                              if (OutArgs.bitRate >= 0) DSSetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_CLASSIFICATION_LIST, OutArgs.frameType | DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_CLASSIFICATION_LIST));
-                           }
+                           if (batch_framesize <= 0 && (isEVSCodec(termInfo.codec_type) || isAMRCodec(termInfo.codec_type))) SaveDecoderOutArgs(chnum, termInfo.codec_type, OutArgs.bitRate, OutArgs.frameType);  /* handle return data, JHB Oct 2022. AMR support added Dec 2024. Queued frames are handled by DecodeCodecBatch(), JHB Oct 2026 */
 
                            if (media_data_len < 0) {
 
@@ -3672,9 +3855,15 @@ pull:
                            if (hSession == 0 && !fOnce[chnum]) { fOnce[chnum] = true; printf("\n *** before DSStoreStream ch = %d, rtp_pyld_len = %d, media_data_len = %d \n", chnum, rtp_pyld_len, media_data_len); }
                         #endif
 
-                        DSStoreStreamData(chnum_parent, DS_PKT_PYLD_CONTENT_MEDIA, media_data_buffer, media_data_len);  /* store decoded media data */
+                        if (batch_framesize > 0) QueueCodecBatchFrame(thread_index, chnum_parent, chnum, DS_PKT_PYLD_CONTENT_MEDIA, hCodec, termInfo.codec_type, rtp_pyld_ptr, rtp_pyld_len, batch_framesize, rtp_timestamp[j], rtp_ssrc[j], rtp_pyld_type[j]);  /* queue payload for batched decoding, JHB Oct 2026 */
+                        else if (fBatchDecode) QueueCodecBatchFrame(thread_index, chnum_parent, chnum, DS_PKT_PYLD_CONTENT_MEDIA, (intptr_t)NULL, 0, media_data_buffer, media_data_len, 0, rtp_timestamp[j], rtp_ssrc[j], rtp_pyld_type[j]);  /* queue decoded media data to keep stream data in order */
+                        else DSStoreStreamData(chnum_parent, DS_PKT_PYLD_CONTENT_MEDIA, media_data_buffer, media_data_len);  /* store decoded media data */
+                     }
+                     else if (packet_type == DTMF_PACKET) {
+
+                        if (fBatchDecode) QueueCodecBatchFrame(thread_index, chnum_parent, chnum, DS_PKT_PYLD_CONTENT_DTMF, (intptr_t)NULL, 0, rtp_pyld_ptr, rtp_pyld_len, 0, rtp_timestamp[j], rtp_ssrc[j], rtp_pyld_type[j]);
+                        else DSStoreStreamData(chnum_parent, DS_PKT_PYLD_CONTENT_DTMF, rtp_pyld_ptr, rtp_pyld_len);  /* store DTMF event */
                      }
-                     else if (packet_type == DTMF_PACKET) DSStoreStreamData(chnum_parent, DS_PKT_PYLD_CONTENT_DTMF, rtp_pyld_ptr, rtp_pyld_len);  /* store DTMF event */
 
                   /* end of loop items */
 
@@ -3694,6 +3883,9 @@ next_packet:
 
                   }  /* end of packet + payload processing loop. Note -- if DECOUPLE_STREAM_PROCESSING is not defined then the loop end is not here */
 
+                  if (fBatchDecode && !session_info_thread[hSession].fDataAvailable) DecodeCodecBatch(thread_index);  /* don't delay stream data for sessions being flushed, JHB Oct 2026 */
+                  else if (fBatchDecode && (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_PIPELINE_DECODE)) HandOffCodecBatch(thread_index);  /* codec stage thread decodes queued frames while we continue with remaining channels and sessions, see notes near CODEC_STAGE, JHB Oct 2026 */
+
                /* decode time profiling, if enabled */
 
                   if (!fPreemptAlarm
@@ -3750,6 +3942,8 @@ next_packet:
                   }
                   #endif
 
+                  if (fBatchDecode) num_pkts = GetCodecBatchRTPInfo(chan_nums[n], max(num_data, 0), rtp_timestamp, rtp_ssrc, rtp_pyld_type);  /* with batched decoding, stream data was stored by DecodeCodecBatch() and may be from a previous pull. Use RTP info saved when it was stored, JHB Oct 2026 */
+
                /* Media stream data processing loop. Notes:
 
                   1) If DECOUPLE_STREAM_PROCESSING is defined (default setting), then stream processing is decoupled from packet + payload processing above (i.e. two separate loops). The define can
@@ -3812,7 +4006,7 @@ next_packet:
                         }
                      }
 
-                     bool fOutputPacketProcessing = !(term_uFlags[hSession][0] & TERM_DISABLE_OUTPUT_QUEUE_PACKETS);  /* see if output packet queueing is disabled by application (isXxxCodec() macros are in shared_include/codec.h), JHB Sep 2024 */
+                     bool fOutputPacketProcessing = !(session_state_hot[hSession].term_uFlags[0] & TERM_DISABLE_OUTPUT_QUEUE_PACKETS);  /* see if output packet queueing is disabled by application (isXxxCodec() macros are in shared_include/codec.h), JHB Sep 2024 */
                      bool fTimestampMatchModeL16Transcode = (uTimestampMatchMode & TIMESTAMP_MATCH_MODE_ENABLE) && packet_type == MEDIA_PACKET;  /* timestamp match mode needs most of output packet processing, but not all, so we use 2 flags */
 
                      if (packet_type == MEDIA_PACKET) {
@@ -3906,7 +4100,7 @@ extern int32_t merge_save_buffer_read[NCORECHAN], merge_save_buffer_write[NCOREC
                               if (fStopContributor) DisableStreamMerging(chnum_parent);  /* turn off stream merging for this contributor */
                            }
 
-                           if (ret_val > 0) fFirstGroupContribution[hSessionOwner] = true;
+                           if (ret_val > 0) session_state_hot[hSessionOwner].fFirstGroupContribution = true;
 
                         }  /* if (fStreamGroupMember) */
 
@@ -4101,7 +4295,10 @@ static int log_pkt_index = 0;
                            if (fDebugTelecomSIDHandling) printf("\n === sending packet TimeStamp = %u \n", (unsigned int)(get_time(USE_CLOCK_GETTIME)/1000));
                            #endif
 
-                           if (fOutputPacketProcessing) DSSendPackets(&hSession, DS_SEND_PKT_QUEUE | DS_PULLPACKETS_OUTPUT | DS_SEND_PKT_SUPPRESS_QUEUE_FULL_MSG, pkt_out_buf, &packet_length, 1);  /* queue output packet to application. Note we are not checking for queue full here; external applications may or may not be de-queuing packets */
+                           if (fOutputPacketProcessing) {
+                              DSSendPackets(&hSession, DS_SEND_PKT_QUEUE | DS_PULLPACKETS_OUTPUT | DS_SEND_PKT_SUPPRESS_QUEUE_FULL_MSG, pkt_out_buf, &packet_length, 1);  /* queue output packet to application. Note we are not checking for queue full here; external applications may or may not be de-queuing packets */
+                              uNotifyEvents |= DS_PKT_NOTIFY_OUTPUT;
+                           }
              
                            if (fTimestampMatchModeL16Transcode) {
 
@@ -4119,21 +4316,16 @@ static int log_pkt_index = 0;
                         #ifndef __LIBRARYMODE__
                         else if (pcap_index >= 0 && fp_out[pcap_index] != NULL) {
 
-                           sem_wait(&pcap_write_sem);
-
-                           if (DSWritePcap(fp_out[pcap_index], DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK, pkt_out_buf, packet_length, NULL, NULL, NULL
+                           if (DSWritePcapBuffered(fp_out[pcap_index], DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK, pkt_out_buf, packet_length, NULL, NULL, NULL  /* buffered writer handles concurrent writes, pcap_write_sem is no longer needed, JHB Oct 2026 */
                                            #if 0  /* remove pTermInfo param - we just called DSFormatPacket() and formatted a packet using termInfo_link, so the IP type in pkt_out_buf should be used. Anything different would be a mismatch and result in a basic / Wireshark error. See DSWritePcap() in pktlib_pcap.cpp for more detail, JHB Jul 2024 */
                                            , &termInfo_link
                                            #endif
                                           ) < 0) {
 
-                              sem_post(&pcap_write_sem);
-                              fprintf(stderr, "Main thread test, problem with DSWritePcap()\n");
+                              fprintf(stderr, "Main thread test, problem with DSWritePcapBuffered()\n");
                               break;
                            }
 
-                           sem_post(&pcap_write_sem);
-
                            pkt_counters[thread_index].pkt_write_cnt++;
                            fThreadOutputActive = true;  /* any output packet for any session sets output active flag */
                         }
@@ -4200,7 +4392,7 @@ static int log_pkt_index = 0;
                   -use test cases 13572.0 and 2922.0, which are extremely sensitive to what happens in the first 1 sec, and verify repeatability in run-time stats, especially PLCs, resynsc, holdoffs, and max packets. Monitor timestamps on "first appears @ pkt N" log messages generated by streamlib
                */      
   
-                  if (!fFirstGroupContribution[hSession]) continue;
+                  if (!session_state_hot[hSession].fFirstGroupContribution) continue;
 
                /* stream group profiling, if enabled */
 
@@ -4247,7 +4439,7 @@ static int log_pkt_index = 0;
                      Log_RT(3, "%s, idx = %d, group_name = %s, thread = %d, ret_val = %d \n", tmpstr, idx, group_name, thread_index, ret_val);
                   }
 
-                  if (ret_val == 2) fThreadOutputActive = true;  /* any output packet for any session sets output active flag */
+                  if (ret_val == 2) { fThreadOutputActive = true; uNotifyEvents |= DS_PKT_NOTIFY_OUTPUT; }  /* any output packet for any session sets output active flag */
 
                   if (!fPreemptAlarm && packet_media_thread_info[thread_index].fProfilingEnabled) {
 
@@ -4262,6 +4454,13 @@ static int log_pkt_index = 0;
             } while (++n < num_chan);  /* channel loop */
 
          }  /* session loop (index i) */
+
+         if (packet_media_thread_info[thread_index].uFlags & (DS_MEDIASERVICE_BATCH_DECODE | DS_MEDIASERVICE_PIPELINE_DECODE)) {  /* decode frames queued by all sessions, see notes near CODEC_BATCH, JHB Oct 2026 */
+
+            start_profile_time = get_time(USE_CLOCK_GETTIME);
+
+            if (DecodeCodecBatch(thread_index) > 0) decode_time += get_time(USE_CLOCK_GETTIME) - start_profile_time;
+         }
       }
 
       #ifdef ALLOW_BACKGROUND_PROCESS
@@ -4322,6 +4521,10 @@ static int log_pkt_index = 0;
          if (fAllSessionsDataAvailable && !fDebugPass) packet_media_thread_info[thread_index].thread_stats_time_moving_avg_index = (stats_index + 1) & (THREAD_STATS_TIME_MOVING_AVG-1);
       }
 
+   /* wake app threads waiting for push queue space or output packets, JHB Oct 2026. Signaling once per loop iteration keeps cost low when nobody is waiting, see DSSignalPacketNotify() notes in pktlib.h */
+
+      if (uNotifyEvents) DSSignalPacketNotify(uNotifyEvents);
+
       if (!pm_run && nNumCleanupLoops < 3) {  /* make sure ManageSessions() deletes any sessions marked pending for deletion, and otherwise cleans up, then allow exit, JHB Dec2019 */
          nNumCleanupLoops++;
          goto run_loop;
@@ -4332,6 +4535,8 @@ static int log_pkt_index = 0;
 
 /* thread exit:  pm_run = 0 */
 
+   if (fMediaThread) StopCodecStage(thread_index);  /* exit codec stage thread, if started, JHB Oct 2026 */
+
    if (!fMediaThread) {
 
    /* Delete Sessions */
@@ -4421,6 +4626,7 @@ cleanup:
 
          ret_val_wav = DSSaveDataFile(DS_GM_HOST_MEM, &fp_out[i], NULL, (uintptr_t)NULL, 0, DS_CLOSE, &MediaInfo[i]);  /* close wav file, update Fs and length in Wav header */
       }
+      else if (out_type[i] == PCAP) DSClosePcap(fp_out[i], DS_CLOSE_PCAP_QUIET);  /* writes any remaining buffered records, JHB Oct 2026 */
       else fclose(fp_out[i]);
    }
    #endif
@@ -4641,7 +4847,7 @@ char errstr[50];
 */
 
    int term1_chnum = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_CHNUM, 1, NULL);  /* get channel number for term1  */
-   unsigned int term1_uFlags = term_uFlags[hSession][0];
+   unsigned int term1_uFlags = session_state_hot[hSession].term_uFlags[0];
 
    if (term1_chnum < 0) {
       sprintf(errstr, "get_channels(), term1_chnum"); 
@@ -4667,7 +4873,7 @@ char errstr[50];
    else chnum0 = term1_chnum;
    
    int term2_chnum = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_CHNUM, 2, NULL);  /* get channel number for term2 */
-   unsigned int term2_uFlags = term_uFlags[hSession][1];
+   unsigned int term2_uFlags = session_state_hot[hSession].term_uFlags[1];
 
    if (term2_chnum < 0) {
       sprintf(errstr, "get_channels(), term2_chnum"); 
@@ -4817,7 +5023,7 @@ bool fChanFound = false;
       #if 0
       if ((unsigned int)DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, i+1, NULL) & TERM_DISABLE_DORMANT_SESSION_DETECTION) continue;  /* go no further, hSession's channel doesn't want to be considered dormant and flushed, JHB Sep 2022 */
       #else
-      if (term_uFlags[hSession][i] & TERM_DISABLE_DORMANT_SESSION_DETECTION) continue;  /* go no further, hSession's channel doesn't want to be considered dormant and flushed, JHB Sep 2022 */
+      if (session_state_hot[hSession].term_uFlags[i] & TERM_DISABLE_DORMANT_SESSION_DETECTION) continue;  /* go no further, hSession's channel doesn't want to be considered dormant and flushed, JHB Sep 2022 */
       #endif
 
       int ssrc_change_index = max(session_info_thread[hSession].num_ssrc_changes[i]-1, 0);
@@ -4873,7 +5079,7 @@ bool fChanFound = false;
                if ((int64_t)((cur_time - last_buffer_time[chnum]) - (cur_time - last_buffer_time[chnum2]))/1000 > term1.dormant_SSRC_wait_time) {  /* note we don't use timeScale here; we assume the app is also operating at accelerated time, JHB Jun 2023 */
                #endif
 
-                  if (!nDormantChanFlush[hSession][i]) {
+                  if (!session_state_hot[hSession].nDormantChanFlush[i]) {
 
                      #if 0  /* debug, JHB Sep 2022 */
                      unsigned int uFlags = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, i+1, NULL);
@@ -4882,13 +5088,13 @@ bool fChanFound = false;
 
                      Log_RT(4, "=== INFO: detected session %d channel %d now using dormant session %d channel %d SSRC value 0x%x, flushing dormant channel %d last active %lld msec\n", hSession2, chnum2, hSession, chnum, stream_ssrc, chnum, (long long int)((cur_time - last_buffer_time[chnum])/1000));
 
-                     nDormantChanFlush[hSession][i] = DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_TARGET_DELAY);  /* if there was a way to force all remaining packets out at once, that would avoid the count-down */
+                     session_state_hot[hSession].nDormantChanFlush[i] = DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_TARGET_DELAY);  /* if there was a way to force all remaining packets out at once, that would avoid the count-down */
                   }
-                  else nDormantChanFlush[hSession][i]--;
+                  else session_state_hot[hSession].nDormantChanFlush[i]--;
 
                /* modify num_chan for hSession and force a call to DSGetOrderedPackets() to retrieve any of the dormant channel's packets still in its jitter buffer and set a state var indicating the channel is now considered dormant (which will be reset if the channel starts receiving again) */
 
-                  if (nDormantChanFlush[hSession][i]) {
+                  if (session_state_hot[hSession].nDormantChanFlush[i]) {
 
                      for (k=0; k<num_chan; k++) if (chan_nums[k] == chnum) { fChanFound = true; break; }
 
@@ -4939,9 +5145,9 @@ int ch[32];
                chan_nums[n] = ch[0];  /* insert parent channel */
                num_chan++;
 
-               if (!nOnHoldChanFlush[hSession][i]) {
+               if (!session_state_hot[hSession].nOnHoldChanFlush[i]) {
 
-                  nOnHoldChanFlush[hSession][i] = numpkts;  /* start the flush countdown */
+                  session_state_hot[hSession].nOnHoldChanFlush[i] = numpkts;  /* start the flush countdown */
 
                /* hSession is a group owner by definition (nOnHoldChan[][] is set in DSProcessStreamGroupContributors() in streamlib), so we can get the group mode and check for flags, JHB Nov2019 */
 
@@ -4955,13 +5161,13 @@ int ch[32];
 
    for (i=0; i<MAX_TERMS; i++) {
 
-      if (nOnHoldChanFlush[hSession][i]) {
+      if (session_state_hot[hSession].nOnHoldChanFlush[i]) {
 
-         nOnHoldChanFlush[hSession][i]--;
-         if (!nOnHoldChanFlush[hSession][i]) nOnHoldChan[hSession][i] = 0;  /* flushing complete */
+         session_state_hot[hSession].nOnHoldChanFlush[i]--;
+         if (!session_state_hot[hSession].nOnHoldChanFlush[i]) nOnHoldChan[hSession][i] = 0;  /* flushing complete */
       }
 #if 0  /* debug */
-      if (nOnHoldChanFlush[hSession][i]) Log_RT(4, "on-hold flushing for hSession %d ch %d = %d, num_chan = %d, chan_nums[0] = %d\n", hSession, i, nOnHoldChanFlush[hSession][i], num_chan, chan_nums[0]);
+      if (session_state_hot[hSession].nOnHoldChanFlush[i]) Log_RT(4, "on-hold flushing for hSession %d ch %d = %d, num_chan = %d, chan_nums[0] = %d\n", hSession, i, session_state_hot[hSession].nOnHoldChanFlush[i], num_chan, chan_nums[0]);
 #endif
    }
 
@@ -4979,7 +5185,7 @@ bool fChanFound, fAnalyticsMode, fAnalyticsCompatibilityMode;
 
    for (i=0; i<MAX_TERMS; i++) {
 
-      if (nMaxLossPtimes[hSession][i] < 0) continue;  /* setting max_loss_ptimes in TERMINATION_INFO struct to -1 disables packet loss mitigation (shared_include/session.h) */
+      if (session_state_hot[hSession].nMaxLossPtimes[i] < 0) continue;  /* setting max_loss_ptimes in TERMINATION_INFO struct to -1 disables packet loss mitigation (shared_include/session.h) */
 
       ch[0] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_CHNUM, i+1, NULL);  num_ch = 1;  /* get parent channel */
 
@@ -4992,14 +5198,14 @@ bool fChanFound, fAnalyticsMode, fAnalyticsCompatibilityMode;
 
       if (!fChanFound) {  /* in telecom mode fChanFound is always true, channels are always on the pull list. In analytics mode we can skip further processing if the parent channel is already on the pull list */
 
-         fAnalyticsMode = (term_uFlags[hSession][i] & TERM_ANALYTICS_MODE_PACKET_TIMING) && output_buffer_interval[hSession][i];  /* determine analytics mode or telecom mode */
+         fAnalyticsMode = (session_state_hot[hSession].term_uFlags[i] & TERM_ANALYTICS_MODE_PACKET_TIMING) && session_state_hot[hSession].output_buffer_interval[i];  /* determine analytics mode or telecom mode */
 
          fAnalyticsCompatibilityMode = fAnalyticsMode && DSGetJitterBufferInfo(ch[0], DS_JITTER_BUFFER_INFO_TARGET_DELAY) <= 7;
 
       /* for last_pull_time[] we need only check the parent channel, as DSGetOrderedPackets() expects parent as input and automatically searches any children */
 
          if (fAnalyticsMode && ((uTimestampMatchMode & (TIMESTAMP_MATCH_MODE_ENABLE) && (uTimestampMatchMode & TIMESTAMP_MATCH_DISABLE_FLUSH)) ||  /* use of cur_time (wall-clock reference) not allowed in timestamp matching mode so -- if we are here in the first place (fFlushDisable not active) - we evalute to true and always check, JHB Feb 2024 */
-                               (last_pull_time[ch[0]] && cur_time - last_pull_time[ch[0]] > (uint64_t)(nMaxLossPtimes[hSession][i]*ptime[hSession][i]*1000)))) {
+                               (chan_state[ch[0]].last_pull_time && cur_time - chan_state[ch[0]].last_pull_time > (uint64_t)(session_state_hot[hSession].nMaxLossPtimes[i]*session_state_hot[hSession].ptime[i]*1000)))) {
 
          /* when looking at jitter buffer levels, we need to check both parent and its child (dynamic) channels, if any */
 
@@ -5031,7 +5237,7 @@ bool fChanFound, fAnalyticsMode, fAnalyticsCompatibilityMode;
                   int ptime_bytes = DSGetCodecInfo(hCodec, DS_CODEC_INFO_HANDLE | DS_CODEC_INFO_RAW_FRAMESIZE, 0, 0, NULL);
                   int timestamp_delta = DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_TIMESTAMP_DELTA);
                   if (num_packets <= target_packets && DSGetStreamGroupContributorPastDue(ch[0]) >= ptime_bytes) {
-                     printf("$$$ pastdue jb flush candidate, j = %d, timestamp delta = %d, num_chan = %d, parent ch = %d, ch = %d, num pkts = %d, pastdue = %d, avail data = %d, sid state = %d, ptime_bytes = %d, ptime = %d, ptime other term = %d, nMaxLossPtimes[hSession][i] = %d \n", j, timestamp_delta, num_chan, ch[0], chan, num_packets, DSGetStreamGroupContributorPastDue(ch[0]), DSGetStreamGroupData(ch[0], NULL, ptime_bytes, DS_GROUPDATA_PEEK), DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_SID_STATE), ptime_bytes, ptime[hSession][i], ptime[hSession][i ^ 1], nMaxLossPtimes[hSession][i]);
+                     printf("$$$ pastdue jb flush candidate, j = %d, timestamp delta = %d, num_chan = %d, parent ch = %d, ch = %d, num pkts = %d, pastdue = %d, avail data = %d, sid state = %d, ptime_bytes = %d, ptime = %d, ptime other term = %d, nMaxLossPtimes[hSession][i] = %d \n", j, timestamp_delta, num_chan, ch[0], chan, num_packets, DSGetStreamGroupContributorPastDue(ch[0]), DSGetStreamGroupData(ch[0], NULL, ptime_bytes, DS_GROUPDATA_PEEK), DSGetJitterBufferInfo(ch[j], DS_JITTER_BUFFER_INFO_SID_STATE), ptime_bytes, session_state_hot[hSession].ptime[i], session_state_hot[hSession].ptime[i ^ 1], session_state_hot[hSession].nMaxLossPtimes[i]);
                   }
                   #endif
 
@@ -5070,14 +5276,14 @@ bool fChanFound, fAnalyticsMode, fAnalyticsCompatibilityMode;
                   chan_nums[n] = ch[0];  /* insert parent channel and increment channel count */
                   num_chan++;
                }
-               else nOnHoldChanFlush[hSession][i] = 1;  /* currently not used */
+               else session_state_hot[hSession].nOnHoldChanFlush[i] = 1;  /* currently not used */
 
                if (target_packets <= min_packets || !fAnalyticsCompatibilityMode) {
 
                   DSSetJitterBufferInfo(chan, DS_JITTER_BUFFER_INFO_UNDERRUN_RESYNC_WARNING, min_packets);
 
                   #if 0  /* use to print out pastdue flush occurrences */
-                  if (session_info_thread[hSession].fDataAvailable) printf("$$$ pastdue jb flush, num_chan = %d, parent ch = %d, ch = %d, num pkts = %d, pastdue = %d, avail data = %d, ptime_bytes = %d, ptime = %d, ptime other term = %d, nMaxLossPtimes[hSession][i] = %d \n", num_chan, ch[0], chan, num_packets, DSGetStreamGroupContributorPastDue(ch[0]), DSGetStreamGroupData(ch[0], NULL, ptime_bytes, DS_GROUPDATA_PEEK), ptime_bytes, ptime[hSession][i], ptime[hSession][i ^ 1], nMaxLossPtimes[hSession][i]);
+                  if (session_info_thread[hSession].fDataAvailable) printf("$$$ pastdue jb flush, num_chan = %d, parent ch = %d, ch = %d, num pkts = %d, pastdue = %d, avail data = %d, ptime_bytes = %d, ptime = %d, ptime other term = %d, nMaxLossPtimes[hSession][i] = %d \n", num_chan, ch[0], chan, num_packets, DSGetStreamGroupContributorPastDue(ch[0]), DSGetStreamGroupData(ch[0], NULL, ptime_bytes, DS_GROUPDATA_PEEK), ptime_bytes, session_state_hot[hSession].ptime[i], session_state_hot[hSession].ptime[i ^ 1], session_state_hot[hSession].nMaxLossPtimes[i]);
                   #endif
                }
 
@@ -5153,10 +5359,10 @@ char tmpstr[1024];
 
 /* termN uFlags might be altered after session creation, for example in non-library mode (mediaTest cmd line), so we keep them updated, JHB May 2019 */
 
-   term_uFlags[hSession][0] = term1.uFlags;
-   term_uFlags[hSession][1] = term2.uFlags;
+   session_state_hot[hSession].term_uFlags[0] = term1.uFlags;
+   session_state_hot[hSession].term_uFlags[1] = term2.uFlags;
 
-   session_uFlags[hSession] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, 0, NULL);  /* session flags are less likely to be altered, but we allow for it anyway. zero pulls session flags, 1 or 2 pulls termination info flags */
+   session_state_hot[hSession].session_uFlags = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, 0, NULL);  /* session flags are less likely to be altered, but we allow for it anyway. zero pulls session flags, 1 or 2 pulls termination info flags */
 
    #ifdef SESSIONINFOMEMCPYDEBUG
    DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_TERM, 2, &term2);
@@ -5175,15 +5381,15 @@ char tmpstr[1024];
 
 void ResetPktStats(HSESSION hSession) {
 
-   no_pkt_elapsed_time[hSession] = 0;
-   memset(&pkt_delta_runsum[hSession], 0, sizeof(pkt_delta_runsum)/MAX_SESSIONS);
-   pkt_delta_sum[hSession] = 0;
-   pkt_sum_index[hSession] = 0;
+   session_state_hot[hSession].no_pkt_elapsed_time = 0;
+   memset(&session_state_cold[hSession].pkt_delta_runsum, 0, sizeof(session_state_cold[0].pkt_delta_runsum));
+   session_state_hot[hSession].pkt_delta_sum = 0;
+   session_state_hot[hSession].pkt_sum_index = 0;
 #if 0
-   pkt_count[hSession] = 0;
+   session_state_hot[hSession].pkt_count = 0;
 #endif
 
-   last_packet_time[hSession] = 0;
+   session_state_hot[hSession].last_packet_time = 0;
 #if 0
    for (int j=0; j<NUM_PKT_STATS; j++) avg_pkt_elapsed_time[hSession][j] = 0;
    pkt_stats_index[hSession] = 0;
@@ -5262,8 +5468,8 @@ int session_state, j;
 
       packet_media_thread_info[thread_index].fPreEmptionMonitorEnabled = true;  /* this is wrong, affecting all sessions assigned to a packet/media thread. Currently it only flips false for AFAP mode and we're not expecting multiple sessions in that mode so we leave it this way for the time being, JHB Jun 2023 */
 
-      last_push_time[hSession] = 0;
-      session_alarm_flags[hSession] = 0;
+      session_state_cold[hSession].last_push_time = 0;
+      session_state_cold[hSession].session_alarm_flags = 0;
 
    /* init stream group items, if this session is a stream group owner */
 
@@ -5275,7 +5481,7 @@ int session_state, j;
 
          pkt_count_group[idx] = 0;
 
-         fFirstGroupContribution[hSession] = false;
+         session_state_hot[hSession].fFirstGroupContribution = false;
       }
 #if 0
       else idx = DSGetStreamGroupInfo(hSession, DS_SESSION_INFO_USE_PKTLIB_SEM | DS_STREAMGROUP_INFO_CHECK_ALLTERMS, NULL, NULL, NULL);
@@ -5298,7 +5504,7 @@ int session_state, j;
          session_info_thread[hSession].nPrevMissingContributor[j] = 0;
       }
 
-      session_uFlags[hSession] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, 0, NULL);  /* zero pulls session flags, 1 or 2 pulls termination info flags */
+      session_state_hot[hSession].session_uFlags = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, 0, NULL);  /* zero pulls session flags, 1 or 2 pulls termination info flags */
 
       for (j=0; j<MAX_TERMS; j++) {
 
@@ -5309,30 +5515,30 @@ int session_state, j;
             if (packet_media_thread_info[thread_index].fMediaThread) Log_RT(4, "WARNING: InitSession() says input_buffer_interval is not initialized for session %d, term %d\n", hSession, j);
          }
 
-         term_uFlags[hSession][j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, j+1, NULL);
+         session_state_hot[hSession].term_uFlags[j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, j+1, NULL);
 
-         ptime[hSession][j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_PTIME, j+1, NULL);
-         if (ptime[hSession][j] < 0) { Log_RT(4, "WARNING: InitSession() says ptime is not initialized for session %d\n", hSession); ptime[hSession][j] = 20; }
+         session_state_hot[hSession].ptime[j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_PTIME, j+1, NULL);
+         if (session_state_hot[hSession].ptime[j] < 0) { Log_RT(4, "WARNING: InitSession() says ptime is not initialized for session %d\n", hSession); session_state_hot[hSession].ptime[j] = 20; }
 
-         output_buffer_interval[hSession][j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_OUTPUT_BUFFER_INTERVAL, j+1, NULL);
+         session_state_hot[hSession].output_buffer_interval[j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_OUTPUT_BUFFER_INTERVAL, j+1, NULL);
 
-         if (output_buffer_interval[hSession][j] < 0) {
+         if (session_state_hot[hSession].output_buffer_interval[j] < 0) {
 
             if (packet_media_thread_info[thread_index].fMediaThread) Log_RT(4, "WARNING: InitSession() says output_buffer_interval is not initialized for session %d\n", hSession);
-            output_buffer_interval[hSession][j] = 0;
+            session_state_hot[hSession].output_buffer_interval[j] = 0;
          }
 
-         if (!output_buffer_interval[hSession][j]) packet_media_thread_info[thread_index].fPreEmptionMonitorEnabled = false;  /* currently only AFAP mode makes this false, idea being to disable pre-emption alarms due to super fast push rates. Modified the logic slightly so result would not depend only on term2, JHB Jan 2023 */ 
+         if (!session_state_hot[hSession].output_buffer_interval[j]) packet_media_thread_info[thread_index].fPreEmptionMonitorEnabled = false;  /* currently only AFAP mode makes this false, idea being to disable pre-emption alarms due to super fast push rates. Modified the logic slightly so result would not depend only on term2, JHB Jan 2023 */ 
 
-         nDormantChanFlush[hSession][j] = 0;
-         nOnHoldChanFlush[hSession][j] = 0;  /* reset session's on-hold flush state */
+         session_state_hot[hSession].nDormantChanFlush[j] = 0;
+         session_state_hot[hSession].nOnHoldChanFlush[j] = 0;  /* reset session's on-hold flush state */
          nOnHoldChan[hSession][j] = 0;
 
-         nMaxLossPtimes[hSession][j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_MAX_LOSS_PTIMES, j+1, NULL);
-         if (nMaxLossPtimes[hSession][j] < -1) { Log_RT(4, "WARNING: InitSession() says max_loss_ptimes is not initialized for session %d\n", hSession); nMaxLossPtimes[hSession][j] = 0; }  /* -1 is allowed, disables maxLossPtimes, JHB Sep 2022 */
+         session_state_hot[hSession].nMaxLossPtimes[j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_MAX_LOSS_PTIMES, j+1, NULL);
+         if (session_state_hot[hSession].nMaxLossPtimes[j] < -1) { Log_RT(4, "WARNING: InitSession() says max_loss_ptimes is not initialized for session %d\n", hSession); session_state_hot[hSession].nMaxLossPtimes[j] = 0; }  /* -1 is allowed, disables maxLossPtimes, JHB Sep 2022 */
 
-         uDisplayDTMFEventMsg[hSession][j] = 0;
-         uDTMFState[hSession][j] = 0;
+         session_state_cold[hSession].uDisplayDTMFEventMsg[j] = 0;
+         session_state_cold[hSession].uDTMFState[j] = 0;
       }
 
    /* session timing stats items */
@@ -5381,7 +5587,7 @@ int ch[64];
 
       int j, num_ch = 2;  /* subsequent indexes start at 2 for child channels, if any */
 
-      pkt_count[hSession] = 0;
+      session_state_hot[hSession].pkt_count = 0;
 
    /* build channel list, including child channels belonging to this termN, if any. JHB Nov2019 */
 
@@ -5392,10 +5598,10 @@ int ch[64];
 
          #ifdef PACKET_TIME_STATS
 
-         packet_in_time[ch[j]] = 0;
-         last_packet_in_time[ch[j]] = 0;
-         packet_in_time_pull[ch[j]] = 0;
-         last_packet_in_time_pull[ch[j]] = 0;
+         chan_state[ch[j]].packet_in_time = 0;
+         chan_state[ch[j]].last_packet_in_time = 0;
+         chan_state[ch[j]].packet_in_time_pull = 0;
+         chan_state[ch[j]].last_packet_in_time_pull = 0;
 
          packet_max_delta[ch[j]] = 0;
          max_delta_packet[ch[j]] = 0;
@@ -5410,12 +5616,12 @@ int ch[64];
          media_stats_pkt_count[ch[j]] = 0;
          sid_stats_pkt_count[ch[j]] = 0;
 
-         prev_pyld_content[ch[j]] = 0;
+         chan_state[ch[j]].prev_pyld_content = 0;
 
-         packet_rtp_time[ch[j]] = 0;
-         last_rtp_timestamp[ch[j]] = 0;
-         packet_rtp_time_pull[ch[j]] = 0;
-         last_rtp_timestamp_pull[ch[j]] = 0;
+         chan_state[ch[j]].packet_rtp_time = 0;
+         chan_state[ch[j]].last_rtp_timestamp = 0;
+         chan_state[ch[j]].packet_rtp_time_pull = 0;
+         chan_state[ch[j]].last_rtp_timestamp_pull = 0;
 
          num_jb_zero_pulls[ch[j]] = 0;
          packet_in_bursts[ch[j]] = 0;
@@ -5428,9 +5634,11 @@ int ch[64];
          pkt_level_flush[ch[j]] = 0;
 
          last_buffer_time[ch[j]] = 0;
-         last_pull_time[ch[j]] = 0;
+         chan_state[ch[j]].last_pull_time = 0;
 
          fFirstXcodeOutputPkt[ch[j]] = false;
+         codec_batch_rtp_info[ch[j]].rd = 0;  /* see GetCodecBatchRTPInfo(), JHB Oct 2026 */
+         codec_batch_rtp_info[ch[j]].num = 0;
 
          session_run_time_stats[ch[j]] = 0;
 
@@ -5455,6 +5663,619 @@ int ch[64];
 
 #endif
 
+#ifdef __LIBRARYMODE__
+
+/* RebalanceThreads() moves sessions between p/m threads, used if DS_MEDIASERVICE_REBALANCE_THREADS flag is given in DSConfigMediaService(). Notes, JHB Oct 2026:
+
+  -called by ManageSessions() at the start of each p/m thread loop iteration, which is a safe point: the calling thread is not processing any sessions, and it migrates only sessions it owns. The target thread picks up migrated sessions in its next ManageSessions() pass
+  -thread load is the average of nonzero CPU_time_avg[] entries (i.e. recent loop time while processing input). Per session cost is estimated as thread load / numSessions
+  -a thread migrates when its load is more than REBALANCE_LOAD_RATIO percent of the least loaded thread's load and the difference is at least REBALANCE_MIN_LOAD_DIFF usec. The unit moved (one session, or all of this thread's sessions in a stream group) must have an estimated cost no more than half the difference, so the source can't end up less loaded than the target
+  -hysteresis: each thread checks no more than once per REBALANCE_INTERVAL, source and target threads are not considered again until REBALANCE_COOLDOWN has elapsed, and migrated sessions are not moved again for REBALANCE_SESSION_HOLD_TIME
+  -stream group sessions on this thread are moved together, which keeps whole groups on one thread if they were allocated that way (see WHOLE_GROUP_THREAD_ALLOCATE in mediaMin). Sessions being initialized, flushed, or deleted are not moved
+  -session state at p/m thread level is indexed by session handle (session_state_hot[], session_info_thread[], etc), so nothing is copied. p/m threads share a base time when rebalancing is enabled (see time_init), so session and jitter buffer times remain valid after migration
+*/
+
+#define REBALANCE_INTERVAL           1000000  /* in usec */
+#define REBALANCE_COOLDOWN           4000000
+#define REBALANCE_SESSION_HOLD_TIME  30000000
+#define REBALANCE_LOAD_RATIO         150      /* percent */
+#define REBALANCE_MIN_LOAD_DIFF      2000     /* in usec */
+
+static uint64_t rebalance_check_time[MAX_PKTMEDIA_THREADS] = { 0 };    /* time of each thread's last rebalance check */
+static uint64_t rebalance_migrate_time[MAX_PKTMEDIA_THREADS] = { 0 };  /* time each thread was last a migration source or target */
+
+static inline bool isRebalanceCooldown(int thread_index, uint64_t cur_time) {  /* note that cur_time is comparable across p/m threads when rebalancing is enabled */
+
+uint64_t t = rebalance_migrate_time[thread_index];
+
+   return t && (t > cur_time || cur_time - t < REBALANCE_COOLDOWN*timeScale);
+}
+
+static inline uint64_t get_thread_load(int thread_index) {
+
+int i, n = 0;
+uint64_t sum = 0;
+
+   if (packet_media_thread_info[thread_index].numSessions <= 0) return 0;  /* CPU_time_avg[] is not updated when a thread has no input, so don't use stale values */
+
+   for (i=0; i<THREAD_STATS_TIME_MOVING_AVG; i++) if (packet_media_thread_info[thread_index].CPU_time_avg[i] > 0) { sum += packet_media_thread_info[thread_index].CPU_time_avg[i]; n++; }
+
+   return n ? sum/n : 0;
+}
+
+static inline bool isSessionMigratable(HSESSION hSession, int thread_index, uint64_t cur_time) {
+
+   if (hSession < 0 || !isSessionAssignedToThread(hSession, thread_index)) return false;
+
+   int state = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_STATE | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, 0, NULL);
+   if (state == DS_SESSION_STATE_NEW || (state & DS_SESSION_STATE_FLUSH_PACKETS)) return false;
+   if (DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_DELETE_STATUS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, 0, NULL) & DS_SESSION_DELETE_PENDING) return false;
+   if (!session_info_thread[hSession].fDataAvailable) return false;
+
+   if (session_state_cold[hSession].last_migrate_time && cur_time - session_state_cold[hSession].last_migrate_time < REBALANCE_SESSION_HOLD_TIME*timeScale) return false;
+
+   return true;
+}
+
+int RebalanceThreads(HSESSION hSessions[], int thread_index, uint64_t cur_time) {
+
+int i, j, target = -1, numSessions, num_unit, num_groups;
+HSESSION hUnit[MAX_SESSIONS];
+uint64_t load, target_load = 0, session_cost;
+int idx;
+
+   if (!pm_run || num_pktmedia_threads <= 1) return 0;
+
+   if (cur_time - rebalance_check_time[thread_index] < REBALANCE_INTERVAL*timeScale || isRebalanceCooldown(thread_index, cur_time)) return 0;
+   rebalance_check_time[thread_index] = cur_time;
+
+   numSessions = packet_media_thread_info[thread_index].numSessions;
+   if (numSessions <= 1) return 0;
+
+   load = get_thread_load(thread_index);
+
+/* find least loaded thread */
+
+   for (i=0; i<MAX_PKTMEDIA_THREADS; i++) {
+
+      if (i == thread_index || !packet_media_thread_info[i].fMediaThread || !packet_media_thread_info[i].threadid) continue;
+      if (!(packet_media_thread_info[i].uFlags & DS_MEDIASERVICE_REBALANCE_THREADS)) continue;
+      if (isRebalanceCooldown(i, cur_time)) continue;  /* thread was recently a migration source or target */
+      if (pktlib_gbl_cfg.uMaxSessionsPerThread && packet_media_thread_info[i].numSessions >= (int)pktlib_gbl_cfg.uMaxSessionsPerThread) continue;
+
+      uint64_t thread_load = get_thread_load(i);
+
+      if (target < 0 || thread_load < target_load) { target = i; target_load = thread_load; }
+   }
+
+   if (target < 0) return 0;
+
+   if (load*100 <= target_load*REBALANCE_LOAD_RATIO || load - target_load < REBALANCE_MIN_LOAD_DIFF) return 0;  /* hysteresis: not enough imbalance */
+
+   session_cost = load/numSessions;
+
+/* find a migration unit: one session, or all of this thread's sessions in the same stream group */
+
+   num_unit = 0;
+   num_groups = 0;
+
+   for (i=0; i<numSessions && hSessions[i] >= 0; i++) {
+
+      if (!isSessionMigratable(hSessions[i], thread_index, cur_time)) continue;
+
+      num_unit = 0;
+      num_groups = 0;
+
+      if ((idx = DSGetStreamGroupInfo(hSessions[i], DS_STREAMGROUP_INFO_CHECK_ALLTERMS, NULL, NULL, NULL)) >= 0) {
+
+         for (j=0; j<numSessions && hSessions[j] >= 0; j++) {
+
+            if (hSessions[j] != hSessions[i] && DSGetStreamGroupInfo(hSessions[j], DS_STREAMGROUP_INFO_CHECK_ALLTERMS, NULL, NULL, NULL) != idx) continue;
+
+            if (!isSessionMigratable(hSessions[j], thread_index, cur_time)) { num_unit = 0; break; }  /* all group sessions on this thread must be movable */
+
+            hUnit[num_unit++] = hSessions[j];
+            if (DSGetSessionInfo(hSessions[j], DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_GROUP_OWNER, 0, NULL) == hSessions[j]) num_groups++;
+         }
+      }
+      else hUnit[num_unit++] = hSessions[i];
+
+      if (num_unit && num_unit < numSessions && num_unit*session_cost*2 <= load - target_load) break;  /* unit found */
+
+      num_unit = 0;
+   }
+
+   if (!num_unit) return 0;
+
+   if (num_groups && pktlib_gbl_cfg.uMaxGroupsPerThread && packet_media_thread_info[target].numGroups + num_groups > (int)pktlib_gbl_cfg.uMaxGroupsPerThread) return 0;
+
+/* migrate. pktlib_sem protects session-to-thread assignment and per thread session counts */
+
+   sem_wait(&pktlib_sem);
+
+   for (i=0; i<num_unit; i++) {
+
+      sessions[hUnit[i]].threadid = packet_media_thread_info[target].threadid;
+      sessions[hUnit[i]].thread_index = target;
+      session_state_cold[hUnit[i]].last_migrate_time = cur_time;
+   }
+
+   packet_media_thread_info[thread_index].numSessions -= num_unit;
+   packet_media_thread_info[target].numSessions += num_unit;
+   packet_media_thread_info[target].numSessionsMax = max(packet_media_thread_info[target].numSessionsMax, packet_media_thread_info[target].numSessions);
+   packet_media_thread_info[thread_index].numGroups -= num_groups;
+   packet_media_thread_info[target].numGroups += num_groups;
+
+   packet_media_thread_info[thread_index].rebalance_migrations_out++;
+   packet_media_thread_info[thread_index].rebalance_sessions_out += num_unit;
+   packet_media_thread_info[target].rebalance_migrations_in++;
+   packet_media_thread_info[target].rebalance_sessions_in += num_unit;
+
+   rebalance_migrate_time[thread_index] = cur_time;
+   rebalance_migrate_time[target] = cur_time;
+
+   sem_post(&pktlib_sem);
+
+   ThreadIdleWakeup(target);  /* in case target is blocked in energy saver state */
+
+   Log_RT(4, "INFO: p/m thread %d moved %d session%s%s (first hSession %d) to p/m thread %d, thread load avg = %4.2f msec, target thread load avg = %4.2f msec \n", thread_index, num_unit, num_unit > 1 ? "s" : "", num_groups ? " in stream group" : "", hUnit[0], target, 1.0*load/1000, 1.0*target_load/1000);
+
+   return num_unit;
+}
+
+#endif
+
+/* batched decode functions, used if DS_MEDIASERVICE_BATCH_DECODE flag is given in DSConfigMediaService(). See notes near CODEC_BATCH, JHB Oct 2026 */
+
+int isCodecBatchFrame(HCODEC hCodec, int codec_type, uint8_t* pyld, int pyld_len, unsigned int uFlags) {  /* returns media frame size if payload can be queued for decoding, zero if not */
+
+int coded_framesize, raw_framesize;
+
+   if (!hCodec || codec_type == DS_CODEC_NONE || (!isVoiceCodec(codec_type) && !isAudioCodec(codec_type))) return 0;
+
+   if (isEVSCodec(codec_type) || isAMRCodec(codec_type)) {  /* variable payload size. Queued only for codec stage threads, which decode them single channel, see notes near CODEC_STAGE */
+
+      PAYLOAD_INFO PayloadInfo = {};  /* use aggregate initialization as PAYLOAD_INFO contains a typdef */
+
+      if (!(uFlags & DS_MEDIASERVICE_PIPELINE_DECODE) || pyld_len > (int)MAX_RAW_FRAME) return 0;
+
+      if (DSGetPayloadInfo(codec_type, DS_CODEC_INFO_TYPE | DS_PAYLOAD_INFO_IGNORE_DTMF | DS_VOPLIB_SUPPRESS_WARNING_ERROR_MSG, pyld, pyld_len, &PayloadInfo, NULL, -1, NULL, NULL) < 0 || PayloadInfo.NumFrames != 1 || PayloadInfo.voice.fSID) return 0;  /* single frame payloads only */
+   }
+   else {
+
+      coded_framesize = DSGetCodecInfo(hCodec, DS_CODEC_INFO_HANDLE | DS_CODEC_INFO_CODED_FRAMESIZE, 0, 0, NULL);
+      if (coded_framesize <= 0 || pyld_len != coded_framesize || pyld_len > (int)MAX_RAW_FRAME) return 0;  /* single frame payloads only */
+   }
+
+   raw_framesize = DSGetCodecInfo(hCodec, DS_CODEC_INFO_HANDLE | DS_CODEC_INFO_RAW_FRAMESIZE, 0, 0, NULL);
+   if (raw_framesize <= 0 || raw_framesize > (int)MAX_RAW_FRAME) return 0;
+
+   return raw_framesize;
+}
+
+void SaveDecoderOutArgs(int chnum, int codec_type, int bitRate, int frameType) {  /* save EVS and AMR decoder bitrate and audio classification in chnum's jitter buffer info */
+
+   int bitrate_index = bitRate > 0 ? DSGetCodecInfo(codec_type, DS_CODEC_INFO_BITRATE_TO_INDEX, bitRate, 0, NULL) : -1;  /* convert bitrate to an index used by all codecs. Note that to avoid warning messages bitrate param should be checked for > 0 in case codec doesn't know it, for example input frame is a NO_DATA type, JHB Nov 2024 */
+
+   if (bitrate_index >= 0) {
+      int bitrate_list = DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_BITRATE_LIST);
+      if (bitrate_list >= 0) DSSetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_BITRATE_LIST, bitrate_list | (1L << bitrate_index));  /* save bitrate index in list of bitrates */
+   }
+
+/* add audio classification to current list */
+
+   if (bitRate >= 0) DSSetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_CLASSIFICATION_LIST, frameType | DSGetJitterBufferInfo(chnum, DS_JITTER_BUFFER_INFO_PKT_CLASSIFICATION_LIST));
+}
+
+static bool SaveCodecBatchRTPInfo(CODEC_BATCH_FRAME* pFrame) {  /* returns false if chnum's ring is full; unconsumed entries are not overwritten, caller should not store the frame */
+
+CODEC_BATCH_RTP_INFO* pInfo = &codec_batch_rtp_info[pFrame->chnum];
+int wr;
+
+   if (pInfo->num >= CODEC_BATCH_RTP_INFO_DEPTH) return false;  /* stream data not being consumed */
+
+   wr = (pInfo->rd + pInfo->num) & (CODEC_BATCH_RTP_INFO_DEPTH-1);
+
+   pInfo->rtp_timestamp[wr] = pFrame->rtp_timestamp;
+   pInfo->rtp_ssrc[wr] = pFrame->rtp_ssrc;
+   pInfo->rtp_pyld_type[wr] = pFrame->rtp_pyld_type;
+   pInfo->num++;
+
+   return true;
+}
+
+int GetCodecBatchRTPInfo(int chnum, int num_data, uint32_t rtp_timestamp[], uint32_t rtp_ssrc[], uint8_t rtp_pyld_type[]) {  /* get RTP info for num_data items of stream data, oldest first, returns number of items */
+
+CODEC_BATCH_RTP_INFO* pInfo = &codec_batch_rtp_info[chnum];
+int i, num = min(num_data, (int)pInfo->num);
+
+   for (i=0; i<num; i++) {
+
+      rtp_timestamp[i] = pInfo->rtp_timestamp[pInfo->rd];
+      rtp_ssrc[i] = pInfo->rtp_ssrc[pInfo->rd];
+      rtp_pyld_type[i] = pInfo->rtp_pyld_type[pInfo->rd];
+      pInfo->rd = (pInfo->rd + 1) & (CODEC_BATCH_RTP_INFO_DEPTH-1);
+   }
+
+   pInfo->num -= num;
+
+   return num;
+}
+
+/* QueueCodecBatchFrame() queues one item of stream data for chnum. chnum_jb is the jitter buffer chnum the payload was pulled from (child channel or parent). If hCodec is non-zero, data is a coded payload to be decoded by DecodeCodecBatch() and out_len is its media frame size (from isCodecBatchFrame()), otherwise data is stored as-is. If the queue is full it's decoded first. Returns 1 if queued, 0 if data was stored immediately, -1 on error */
+
+int QueueCodecBatchFrame(int thread_index, int chnum, int chnum_jb, unsigned int uContent, HCODEC hCodec, int codec_type, uint8_t* data, int len, int out_len, uint32_t rtp_timestamp, uint32_t rtp_ssrc, uint8_t rtp_pyld_type) {
+
+CODEC_BATCH* pBatch = &codec_batch[thread_index];
+CODEC_BATCH_FRAME* pFrame;
+uint32_t size;
+
+   if (len < 0 || chnum < 0 || chnum >= NCORECHAN) return -1;
+
+   if (!hCodec) out_len = len;
+   size = (hCodec ? len : 0) + ((out_len + 7) & ~7);  /* keep media data 8-byte aligned */
+
+   if (pBatch->num_frames >= CODEC_BATCH_MAX_FRAMES || pBatch->data_len + size > CODEC_BATCH_DATA_SIZE) DecodeCodecBatch(thread_index);
+
+   if (size > CODEC_BATCH_DATA_SIZE) {  /* too large to queue, queue is empty so store now */
+
+      CODEC_BATCH_FRAME Frame = { 0 };
+
+      if (hCodec) return -1;  /* isCodecBatchFrame() doesn't allow this */
+
+      Frame.chnum = chnum; Frame.rtp_timestamp = rtp_timestamp; Frame.rtp_ssrc = rtp_ssrc; Frame.rtp_pyld_type = rtp_pyld_type;
+
+      if (!SaveCodecBatchRTPInfo(&Frame)) { packet_media_thread_info[thread_index].batch_decode_drops++; return 0; }
+
+      DSStoreStreamData(chnum, uContent, data, len);
+      return 0;
+   }
+
+   pFrame = &pBatch->frames[pBatch->num_frames];
+
+   pFrame->hCodec = hCodec;
+   pFrame->hDecoder = hCodec;
+   pFrame->codec_type = codec_type;
+   pFrame->chnum = chnum;
+   pFrame->chnum_jb = chnum_jb;
+   pFrame->bitRate = -1;
+   pFrame->frameType = 0;
+   pFrame->uContent = uContent;
+   pFrame->rtp_timestamp = rtp_timestamp;
+   pFrame->rtp_ssrc = rtp_ssrc;
+   pFrame->rtp_pyld_type = rtp_pyld_type;
+   pFrame->out_ofs = pBatch->data_len;
+   pFrame->out_len = out_len;
+
+   if (hCodec) {
+      pFrame->in_ofs = pBatch->data_len + ((out_len + 7) & ~7);
+      pFrame->in_len = len;
+      memcpy(&pBatch->data[pFrame->in_ofs], data, len);
+   }
+   else {
+      pFrame->in_ofs = 0;
+      pFrame->in_len = 0;
+      memcpy(&pBatch->data[pFrame->out_ofs], data, len);
+   }
+
+   pBatch->data_len += size;
+   pBatch->num_frames++;
+
+   return 1;
+}
+
+static inline bool isHandleInList(HCODEC hCodec, HCODEC hList[], int num) {
+
+int i;
+
+   for (i=0; i<num; i++) if (hList[i] == hCodec) return true;
+
+   return false;
+}
+
+/* DecodeCodecBatchFrames() decodes pending frames in queue range [first, last). Called by p/m threads, and by codec stage threads if DS_MEDIASERVICE_PIPELINE_DECODE flag is given */
+
+static void DecodeCodecBatchFrames(int thread_index, int first, int last) {
+
+CODEC_BATCH* pBatch = &codec_batch[thread_index];
+CODEC_BATCH_FRAME* f = pBatch->frames;
+int i, k, c, s, num_chan, max_chan, num_blocked, len;
+int group[CODEC_BATCH_MAX_CHAN];
+HCODEC hCodecs[CODEC_BATCH_MAX_CHAN], hBlocked[CODEC_BATCH_MAX_FRAMES];
+uint8_t in_buf[CODEC_BATCH_MAX_CHAN*MAX_RAW_FRAME];
+int16_t out_buf[CODEC_BATCH_MAX_CHAN*MAX_RAW_FRAME/sizeof(int16_t)];
+
+/* each pass takes the first pending frame and adds subsequent pending frames with the same codec type, payload size, and media frame size, one frame per codec handle. Handles skipped during a pass are blocked for the rest of the pass, so each codec instance decodes its frames in queue order */
+
+   for (i=first; i<last; i++) {
+
+      if (!f[i].hCodec) continue;
+
+      group[0] = i;
+      hCodecs[0] = f[i].hCodec;
+      num_chan = 1;
+      num_blocked = 0;
+      max_chan = (isEVSCodec(f[i].codec_type) || isAMRCodec(f[i].codec_type)) ? 1 : CODEC_BATCH_MAX_CHAN;  /* EVS and AMR are decoded single channel, OutArgs are needed per frame */
+
+      for (k=i+1; k<last && num_chan < max_chan; k++) {
+
+         if (!f[k].hCodec || isHandleInList(f[k].hCodec, hBlocked, num_blocked)) continue;
+
+         if (f[k].codec_type == f[i].codec_type && f[k].in_len == f[i].in_len && f[k].out_len == f[i].out_len && !isHandleInList(f[k].hCodec, hCodecs, num_chan)) {
+            group[num_chan] = k;
+            hCodecs[num_chan++] = f[k].hCodec;
+         }
+         else hBlocked[num_blocked++] = f[k].hCodec;
+      }
+
+      if (num_chan == 1) {
+
+         CODEC_OUTARGS OutArgs = { 0 };
+
+         len = DSCodecDecode(&hCodecs[0], 0, &pBatch->data[f[i].in_ofs], (uint8_t*)out_buf, f[i].in_len, 1, NULL, max_chan == 1 ? &OutArgs : NULL);
+
+         if (max_chan == 1) {
+            f[i].bitRate = OutArgs.bitRate;
+            f[i].frameType = OutArgs.frameType;
+         }
+
+         if (len > 0) {
+            len = min(len, f[i].out_len);  /* out_len is space reserved in data[] */
+            memcpy(&pBatch->data[f[i].out_ofs], out_buf, len);
+         }
+
+         __sync_add_and_fetch(&packet_media_thread_info[thread_index].batch_decode_single, 1);  /* stats may be updated by p/m thread and its codec stage thread */
+      }
+      else {
+
+      /* multichannel input is one coded frame per channel, output is interleaved */
+
+         for (c=0; c<num_chan; c++) memcpy(&in_buf[c*f[i].in_len], &pBatch->data[f[group[c]].in_ofs], f[i].in_len);
+
+         len = DSCodecDecode(hCodecs, 0, in_buf, (uint8_t*)out_buf, f[i].in_len, num_chan, NULL, NULL);
+
+         if (len > 0) {
+
+            len = min(len, f[i].out_len);  /* return value is per channel length */
+
+            for (c=0; c<num_chan; c++) {
+
+               int16_t* out = (int16_t*)&pBatch->data[f[group[c]].out_ofs];
+               for (s=0; s<len/(int)sizeof(int16_t); s++) out[s] = out_buf[s*num_chan + c];
+            }
+         }
+
+         __sync_add_and_fetch(&packet_media_thread_info[thread_index].batch_decode_calls, 1);
+         __sync_add_and_fetch(&packet_media_thread_info[thread_index].batch_decode_frames, num_chan);
+      }
+
+      if (len < 0) Log_RT(2, "ERROR: DecodeCodecBatchFrames() says DSCodecDecode() returned error condition %d, p/m thread %d, num chan = %d, chnum = %d, codec type = %d, pyld len = %d \n", len, thread_index, num_chan, f[i].chnum, f[i].codec_type, f[i].in_len);
+
+      for (c=0; c<num_chan; c++) {
+         f[group[c]].hCodec = (intptr_t)NULL;
+         f[group[c]].out_len = len;
+      }
+   }
+}
+
+/* SyncCodecBatchDecoder() is called by p/m threads before decoding a payload immediately (not queued), for example SID, multiframe, or payload size not matching coded frame size. If the decoder has queued frames they are decoded first, so each codec instance decodes its frames in order. Decoded data is stored later by DecodeCodecBatch(), in queue order */
+
+void SyncCodecBatchDecoder(int thread_index, HCODEC hCodec, int codec_type) {
+
+CODEC_BATCH* pBatch = &codec_batch[thread_index];
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+uint32_t tail;
+int i;
+
+   (void)codec_type;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+/* with DS_MEDIASERVICE_PIPELINE_DECODE flag, wait for the codec stage thread only if frames handed off and not yet decoded use the same decoder. Ring entries from tail to head are not modified until the codec stage thread moves tail past them, and hDecoder is not written after queueing, so both are safe to read here */
+
+   if (pStage->state == 1 && (tail = __atomic_load_n(&pStage->tail, __ATOMIC_ACQUIRE)) != pStage->head) {
+
+      for (i=pStage->ring[tail & (CODEC_STAGE_RING_SIZE-1)].first; i<pStage->num_handed_off; i++) if (pBatch->frames[i].hDecoder == hCodec) {
+
+         WaitCodecStage(thread_index);
+         break;
+      }
+   }
+
+/* decode only this decoder's frames not yet handed off, in queue order. Other decoders' frames are left queued, as they may have earlier frames still being decoded by the codec stage thread */
+
+   for (i=pStage->num_handed_off; i<pBatch->num_frames; i++) if (pBatch->frames[i].hCodec == hCodec) DecodeCodecBatchFrames(thread_index, i, i+1);
+}
+
+/* codec stage thread functions, used if DS_MEDIASERVICE_PIPELINE_DECODE flag is given in DSConfigMediaService(). See notes near CODEC_STAGE, JHB Oct 2026 */
+
+static void* CodecStageThread(void* arg) {
+
+int thread_index = (int)(intptr_t)arg;
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+uint32_t head = 0, tail;
+struct timespec ts;
+int i;
+
+   ts.tv_sec = CODEC_STAGE_BLOCK_TIMEOUT / 1000000L;
+   ts.tv_nsec = (CODEC_STAGE_BLOCK_TIMEOUT % 1000000L)*1000;
+
+   while (!__atomic_load_n(&pStage->fExit, __ATOMIC_ACQUIRE)) {
+
+      tail = pStage->tail;  /* written only by this thread */
+
+      for (i=0; i<CODEC_STAGE_SPIN && (head = __atomic_load_n(&pStage->head, __ATOMIC_ACQUIRE)) == tail; i++) {
+
+         #if defined(__x86_64__) || defined(__i386__)
+         __builtin_ia32_pause();
+         #endif
+      }
+
+      if (head == tail) {  /* ring empty, block. Either HandOffCodecBatch() sees fBlocked set, or we see head change, so no hand-offs are missed */
+
+         __atomic_store_n(&pStage->fBlocked, 1, __ATOMIC_SEQ_CST);
+
+         if (__atomic_load_n(&pStage->head, __ATOMIC_SEQ_CST) == tail && !__atomic_load_n(&pStage->fExit, __ATOMIC_SEQ_CST)) syscall(SYS_futex, &pStage->head, FUTEX_WAIT_PRIVATE, tail, &ts, NULL, 0);
+
+         __atomic_store_n(&pStage->fBlocked, 0, __ATOMIC_SEQ_CST);
+         continue;
+      }
+
+      while (tail != head) {
+
+         DecodeCodecBatchFrames(thread_index, pStage->ring[tail & (CODEC_STAGE_RING_SIZE-1)].first, pStage->ring[tail & (CODEC_STAGE_RING_SIZE-1)].last);
+
+         __atomic_store_n(&pStage->tail, ++tail, __ATOMIC_RELEASE);  /* decoded data and frame updates are visible to p/m thread before tail */
+      }
+   }
+
+   return NULL;
+}
+
+static int StartCodecStage(int thread_index) {
+
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+pthread_attr_t attr;
+cpu_set_t cpuset;
+int ret_val;
+bool fAffinity;
+
+   pStage->head = 0;
+   pStage->tail = 0;
+   pStage->fBlocked = 0;
+   pStage->fExit = false;
+   pStage->num_handed_off = 0;
+
+/* threads inherit CPU affinity of their creator, so if p/m threads are pinned (DS_MEDIASERVICE_PIN_THREADS flag) the codec stage thread would share its p/m thread's core. Use cores allowed to the process instead (taskset, cgroup cpusets, etc), which may not be 0..N-1. If the calling thread's mask is a single core it's pinned, in which case the process mask is taken from the main thread */
+
+   fAffinity = sched_getaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+   if (fAffinity && CPU_COUNT(&cpuset) == 1) fAffinity = sched_getaffinity(getpid(), sizeof(cpu_set_t), &cpuset) == 0;
+
+   pthread_attr_init(&attr);
+   if (fAffinity) pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);  /* on error codec stage thread inherits p/m thread affinity */
+
+   if ((ret_val = pthread_create(&pStage->thread, &attr, CodecStageThread, (void*)(intptr_t)thread_index))) {
+
+      Log_RT(2, "ERROR: p/m thread %d says pthread_create() failed for codec stage thread, ret_val = %d, frames will be decoded by p/m thread \n", thread_index, ret_val);
+      pStage->state = -1;
+   }
+   else {
+
+      Log_RT(4, "INFO: p/m thread %d started codec stage thread \n", thread_index);
+      pStage->state = 1;
+   }
+
+   pthread_attr_destroy(&attr);
+
+   return pStage->state;
+}
+
+void StopCodecStage(int thread_index) {  /* called by p/m thread on exit. DecodeCodecBatch() has already waited for all hand-offs to be decoded */
+
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+
+   if (pStage->state != 1) { pStage->state = 0; return; }
+
+   __atomic_store_n(&pStage->fExit, true, __ATOMIC_SEQ_CST);
+   syscall(SYS_futex, &pStage->head, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+
+   pthread_join(pStage->thread, NULL);
+
+   pStage->state = 0;
+}
+
+/* HandOffCodecBatch() is called by p/m threads after queueing a channel's pulled packets. If at least CODEC_STAGE_CHUNK_FRAMES frames have been queued since the last hand-off, they are passed to the thread's codec stage thread for decoding. Returns number of frames handed off */
+
+int HandOffCodecBatch(int thread_index) {
+
+CODEC_BATCH* pBatch = &codec_batch[thread_index];
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+uint32_t head;
+int num_frames = pBatch->num_frames - pStage->num_handed_off;
+
+   if (num_frames < CODEC_STAGE_CHUNK_FRAMES) return 0;
+
+   if (pStage->state == 0) StartCodecStage(thread_index);
+   if (pStage->state < 0) return 0;  /* no codec stage thread, DecodeCodecBatch() decodes all frames */
+
+   head = pStage->head;  /* written only by p/m thread */
+
+   if (head - __atomic_load_n(&pStage->tail, __ATOMIC_ACQUIRE) >= CODEC_STAGE_RING_SIZE) return 0;  /* ring full; frames stay queued and are included in the next hand-off or decoded by DecodeCodecBatch() */
+
+   pStage->ring[head & (CODEC_STAGE_RING_SIZE-1)].first = pStage->num_handed_off;
+   pStage->ring[head & (CODEC_STAGE_RING_SIZE-1)].last = pBatch->num_frames;
+
+   __atomic_store_n(&pStage->head, head+1, __ATOMIC_SEQ_CST);  /* queued frames and ring entry are visible to codec stage thread before head */
+
+   if (__atomic_load_n(&pStage->fBlocked, __ATOMIC_SEQ_CST)) syscall(SYS_futex, &pStage->head, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+
+   pStage->num_handed_off = pBatch->num_frames;
+
+   packet_media_thread_info[thread_index].pipeline_handoffs++;
+   packet_media_thread_info[thread_index].pipeline_frames += num_frames;
+
+   return num_frames;
+}
+
+static bool WaitCodecStage(int thread_index) {  /* wait for codec stage thread to decode all frames handed off. Returns true if p/m thread had to wait */
+
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+int i;
+
+   if (pStage->state != 1 || __atomic_load_n(&pStage->tail, __ATOMIC_ACQUIRE) == pStage->head) return false;
+
+   for (i=0; __atomic_load_n(&pStage->tail, __ATOMIC_ACQUIRE) != pStage->head; i++) {
+
+      if (i < CODEC_STAGE_SPIN) {
+         #if defined(__x86_64__) || defined(__i386__)
+         __builtin_ia32_pause();
+         #endif
+      }
+      else sched_yield();
+   }
+
+   packet_media_thread_info[thread_index].pipeline_waits++;
+
+   return true;
+}
+
+/* DecodeCodecBatch() decodes queued frames and stores all queued stream data in queue order. Called by p/m threads at the end of each loop iteration, before stream processing of sessions being flushed, and when the queue is full. Returns number of items stored */
+
+int DecodeCodecBatch(int thread_index) {
+
+CODEC_BATCH* pBatch = &codec_batch[thread_index];
+CODEC_STAGE* pStage = &codec_stage[thread_index];
+CODEC_BATCH_FRAME* f = pBatch->frames;
+int i, num_stored = 0;
+
+   if (!pBatch->num_frames) return 0;
+
+/* wait for codec stage thread before decoding remaining frames, as they may use the same decoders as handed off frames */
+
+   WaitCodecStage(thread_index);
+
+   DecodeCodecBatchFrames(thread_index, pStage->num_handed_off, pBatch->num_frames);
+
+   pStage->num_handed_off = 0;
+
+/* store in queue order */
+
+   for (i=0; i<pBatch->num_frames; i++) {
+
+      if (f[i].hDecoder && (isEVSCodec(f[i].codec_type) || isAMRCodec(f[i].codec_type))) SaveDecoderOutArgs(f[i].chnum_jb, f[i].codec_type, f[i].bitRate, f[i].frameType);  /* same as immediate decode path, done here as jitter buffer info is owned by p/m thread */
+
+      if (f[i].out_len < 0) continue;  /* decode error, same as previous per packet handling */
+
+      if (!SaveCodecBatchRTPInfo(&f[i])) { packet_media_thread_info[thread_index].batch_decode_drops++; continue; }  /* RTP info ring full, don't store so stream data and RTP info stay matched */
+
+      DSStoreStreamData(f[i].chnum, f[i].uContent, &pBatch->data[f[i].out_ofs], f[i].out_len);
+      num_stored++;
+   }
+
+   pBatch->num_frames = 0;
+   pBatch->data_len = 0;
+
+   return num_stored;
+}
+
 /* ManageSessions() enumerates through all session handles and manages sessions assigned to this thread:
 
   -saves an accurate copy of currently active sessions in hSessions[] (hSessions[] is per thread, located on each thread's stack as hSessions_t[])
@@ -5475,6 +6296,10 @@ bool fNoJitterBuffersUsed = true;
 char tmpstr[1024];
 int nRetry = 0, numInit = 0, numDeleted = 0;
 
+   #ifdef __LIBRARYMODE__
+   if (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_REBALANCE_THREADS) RebalanceThreads(hSessions, thread_index, cur_time);  /* move a session or stream group to a less loaded p/m thread if needed. hSessions[] still has the previous pass's sessions, so this must be done before it's rebuilt below, JHB Oct 2026 */
+   #endif
+
 get_num_sessions:
 
    if (num_pktmedia_threads <= 1) numSessions = DSGetSessionInfo(0, DS_SESSION_INFO_NUM_SESSIONS, 0, NULL);  /* note -- DS_SESSION_INFO_NUM_SESSIONS does not take DS_SESSION_INFO_HANDLE or DS_SESSION_INFO_CHNUM */
@@ -5621,8 +6446,8 @@ get_num_sessions:
 
       /* update session flags and termination flags that might change while session is active, JHB Sep 2024 */
   
-         session_uFlags[hSession] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, 0, NULL);  /* zero pulls session flags, 1 or 2 pulls termination flags */
-         for (j=0; j<MAX_TERMS; j++) term_uFlags[hSession][j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, j+1, NULL);
+         session_state_hot[hSession].session_uFlags = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, 0, NULL);  /* zero pulls session flags, 1 or 2 pulls termination flags */
+         for (j=0; j<MAX_TERMS; j++) session_state_hot[hSession].term_uFlags[j] = DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS | DS_SESSION_INFO_SUPPRESS_ERROR_MSG, j+1, NULL);
 
          numSessionsFound++;
 
@@ -5770,7 +6595,7 @@ int i;
       if (hSession >= 0) uFlags_log |= ((unsigned int)DSGetSessionInfo(hSession, DS_SESSION_INFO_HANDLE | DS_SESSION_INFO_UFLAGS, 1, NULL) & TERM_DISABLE_DORMANT_SESSION_DETECTION) ? DS_PKTSTATS_MATCH_CHNUM : 0;  /* Term1 flags for specific hSession */
       else for (i=0; i<packet_media_thread_info[thread_index].numSessionsMax; i++) {  /* term_uFlags[] and packet_media_thread_info[thread_index].numSessionsMax are persistent after thread clean up */
       
-         if ((term_uFlags[i][0] & TERM_DISABLE_DORMANT_SESSION_DETECTION) || (term_uFlags[i][1] & TERM_DISABLE_DORMANT_SESSION_DETECTION)) {  /* any session with dormant session detection disabled will set the combined ssrc + chnum logging flag, JHB Jul 2024 */
+         if ((session_state_hot[i].term_uFlags[0] & TERM_DISABLE_DORMANT_SESSION_DETECTION) || (session_state_hot[i].term_uFlags[1] & TERM_DISABLE_DORMANT_SESSION_DETECTION)) {  /* any session with dormant session detection disabled will set the combined ssrc + chnum logging flag, JHB Jul 2024 */
             uFlags_log |= DS_PKTSTATS_MATCH_CHNUM;
             break;
          }
@@ -6072,19 +6897,15 @@ HSESSION          hSessions_t[MAX_SESSIONS] = { 0 };
             /* write to file if this channel has an associated file handle, otherwise send packet over network */
             if (pcap_index >= 0 && fp_out[pcap_index] != NULL)
             {
-               sem_wait(&pcap_write_sem);
-
-               if (DSWritePcap(fp_out[pcap_index], DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK, pkt_buffer, packet_length, NULL, NULL, NULL
+               if (DSWritePcapBuffered(fp_out[pcap_index], DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK, pkt_buffer, packet_length, NULL, NULL, NULL  /* buffered writer handles concurrent writes, pcap_write_sem is no longer needed, JHB Oct 2026 */
                                #if 0  /* remove pTermInfo param, JHB Jul 2024 */
                                , &termInfo_link
                                #endif
                               ) < 0) {
 
-                  sem_post(&pcap_write_sem);
-                  fprintf(stderr, "Multithread test thread id = %d, problem with DSWritePcap()\n", threadid);
+                  fprintf(stderr, "Multithread test thread id = %d, problem with DSWritePcapBuffered()\n", threadid);
                   continue;
                }
-               sem_post(&pcap_write_sem);
                __sync_add_and_fetch(&pkt_write_cnt_multithread, 1);
             }
             else
@@ -6262,31 +7083,31 @@ int idx;
 
       rtp_timestamp = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_TIMESTAMP, pkt, pkt_len, NULL, NULL);
 
-      if (last_rtp_timestamp[chnum]) {  /* note that input RTP timestamps may be ooo, so we use int calculations here and allow negative values. They will still add up correctly, JHB Jan 2020 */
+      if (chan_state[chnum].last_rtp_timestamp) {  /* note that input RTP timestamps may be ooo, so we use int calculations here and allow negative values. They will still add up correctly, JHB Jan 2020 */
 
          Fs = DSGetSessionInfo(chnum, DS_SESSION_INFO_CHNUM | DS_SESSION_INFO_INPUT_SAMPLE_RATE, 0, NULL);
          if (!Fs) Fs = DSGetSessionInfo(chnum, DS_SESSION_INFO_CHNUM | DS_SESSION_INFO_SAMPLE_RATE, 0, NULL);  /* use decode sample rate if no input sample rate was assigned */
-         if (Fs) packet_rtp_time[chnum] += 1000*((int64_t)rtp_timestamp - (int64_t)last_rtp_timestamp[chnum])/Fs;  /* save in msec (and avoid divide-by-zero, JHB May 2019) */
+         if (Fs) chan_state[chnum].packet_rtp_time += 1000*((int64_t)rtp_timestamp - (int64_t)chan_state[chnum].last_rtp_timestamp)/Fs;  /* save in msec (and avoid divide-by-zero, JHB May 2019) */
       }
  
-      last_rtp_timestamp[chnum] = rtp_timestamp;
+      chan_state[chnum].last_rtp_timestamp = rtp_timestamp;
 
       packet_time = get_time(USE_CLOCK_GETTIME);
 
       if ((idx = DSGetStreamGroupInfo(chnum, DS_STREAMGROUP_INFO_HANDLE_CHNUM, NULL, NULL, NULL)) >= 0) pkt_count = ++pkt_count_group[idx];  /* overwrite input pkt_count */
 
-      if (last_packet_in_time[chnum]) {
+      if (chan_state[chnum].last_packet_in_time) {
 
-         uint64_t elapsed_time = packet_time - last_packet_in_time[chnum];
+         uint64_t elapsed_time = packet_time - chan_state[chnum].last_packet_in_time;
 
-         packet_in_time[chnum] += elapsed_time;  /* save in usec */
+         chan_state[chnum].packet_in_time += elapsed_time;  /* save in usec */
 
          if (elapsed_time > packet_max_delta[chnum]) {
             packet_max_delta[chnum] = elapsed_time;
             max_delta_packet[chnum] = pkt_count;
          }
 
-         if ((pkt_info == DS_PKT_PYLD_CONTENT_MEDIA || pkt_info == DS_PKT_PYLD_CONTENT_MEDIA_REUSE) && (prev_pyld_content[chnum] == DS_PKT_PYLD_CONTENT_MEDIA || prev_pyld_content[chnum] == DS_PKT_PYLD_CONTENT_MEDIA_REUSE)) {  /* bug-fix: also check for DS_PKT_PYLD_CONTENT_MEDIA_REUSE, JHB Nov 2024 */
+         if ((pkt_info == DS_PKT_PYLD_CONTENT_MEDIA || pkt_info == DS_PKT_PYLD_CONTENT_MEDIA_REUSE) && (chan_state[chnum].prev_pyld_content == DS_PKT_PYLD_CONTENT_MEDIA || chan_state[chnum].prev_pyld_content == DS_PKT_PYLD_CONTENT_MEDIA_REUSE)) {  /* bug-fix: also check for DS_PKT_PYLD_CONTENT_MEDIA_REUSE, JHB Nov 2024 */
 
             packet_media_delta[chnum] += elapsed_time;
             media_stats_pkt_count[chnum]++;
@@ -6296,7 +7117,7 @@ int idx;
                max_media_delta_packet[chnum] = pkt_count;
             }
          }
-         else if (pkt_info == DS_PKT_PYLD_CONTENT_SID && prev_pyld_content[chnum] == DS_PKT_PYLD_CONTENT_SID) {
+         else if (pkt_info == DS_PKT_PYLD_CONTENT_SID && chan_state[chnum].prev_pyld_content == DS_PKT_PYLD_CONTENT_SID) {
 
             packet_sid_delta[chnum] += elapsed_time;
             sid_stats_pkt_count[chnum]++;
@@ -6307,29 +7128,29 @@ int idx;
             }
          }
 
-         prev_pyld_content[chnum] = pkt_info;
+         chan_state[chnum].prev_pyld_content = pkt_info;
       }
 
-      last_packet_in_time[chnum] = packet_time;
+      chan_state[chnum].last_packet_in_time = packet_time;
    }
    else if (uFlags == PACKET_TIME_STATS_PULL) {
 
       rtp_timestamp = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_TIMESTAMP, pkt, pkt_len, NULL, NULL);
 
-      if (last_rtp_timestamp_pull[chnum]) {
+      if (chan_state[chnum].last_rtp_timestamp_pull) {
 
          Fs = DSGetSessionInfo(chnum, DS_SESSION_INFO_CHNUM | DS_SESSION_INFO_INPUT_SAMPLE_RATE, 0, NULL);
          if (!Fs) Fs = DSGetSessionInfo(chnum, DS_SESSION_INFO_CHNUM | DS_SESSION_INFO_SAMPLE_RATE, 0, NULL);  /* use decode sample rate if no input sample rate was assigned */
-         if (Fs) packet_rtp_time_pull[chnum] += 1000*((int64_t)rtp_timestamp - (int64_t)last_rtp_timestamp_pull[chnum])/Fs;  /* save in msec (and avoid divide-by-zero, JHB May 2019) */
+         if (Fs) chan_state[chnum].packet_rtp_time_pull += 1000*((int64_t)rtp_timestamp - (int64_t)chan_state[chnum].last_rtp_timestamp_pull)/Fs;  /* save in msec (and avoid divide-by-zero, JHB May 2019) */
       }
 
-      last_rtp_timestamp_pull[chnum] = rtp_timestamp;
+      chan_state[chnum].last_rtp_timestamp_pull = rtp_timestamp;
 
       packet_time = get_time(USE_CLOCK_GETTIME);
 
-      if (last_packet_in_time_pull[chnum]) packet_in_time_pull[chnum] += packet_time - last_packet_in_time_pull[chnum];  /* save in usec */
+      if (chan_state[chnum].last_packet_in_time_pull) chan_state[chnum].packet_in_time_pull += packet_time - chan_state[chnum].last_packet_in_time_pull;  /* save in usec */
 
-      last_packet_in_time_pull[chnum] = packet_time;
+      chan_state[chnum].last_packet_in_time_pull = packet_time;
    }
 }
 
@@ -6469,8 +7290,8 @@ organize_by_session:
                add_stats_str(medxstr, MAX_STATS_STRLEN, " %d%c%2.2f/%d", c, ISL, timeScale*packet_max_media_delta[c]/1000, max_media_delta_packet[c]);
                add_stats_str(sidxstr, MAX_STATS_STRLEN, " %d%c%2.2f/%d", c, ISL, timeScale*packet_max_sid_delta[c]/1000, max_sid_delta_packet[c]);
                add_stats_str(maxdstr, MAX_STATS_STRLEN, " %d%c%2.2f/%d", c, ISL, timeScale*packet_max_delta[c]/1000, max_delta_packet[c]);
-               add_stats_str(iptstr, MAX_STATS_STRLEN, " %d%c%2.2f/%2.2f", c, ISL, timeScale*packet_in_time[c]/1000000L, 1.0*packet_rtp_time[c]/1000);
-               add_stats_str(jbptstr, MAX_STATS_STRLEN, " %d%c%2.2f/%2.2f", c, ISL, timeScale*packet_in_time_pull[c]/1000000L, 1.0*packet_rtp_time_pull[c]/1000);
+               add_stats_str(iptstr, MAX_STATS_STRLEN, " %d%c%2.2f/%2.2f", c, ISL, timeScale*chan_state[c].packet_in_time/1000000L, 1.0*chan_state[c].packet_rtp_time/1000);
+               add_stats_str(jbptstr, MAX_STATS_STRLEN, " %d%c%2.2f/%2.2f", c, ISL, timeScale*chan_state[c].packet_in_time_pull/1000000L, 1.0*chan_state[c].packet_rtp_time_pull/1000);
             }
 
             TERMINATION_INFO termInfo;
@@ -6827,20 +7648,105 @@ void manage_pkt_stats_mem(PKT_STATS_HISTORY pkt_stats[], int chnum, int num_pkts
 }
 #endif
 
+/* p/m thread idle wait and wakeup, used if DS_MEDIASERVICE_SPIN_THEN_BLOCK flag is given in DSConfigMediaService(). See notes near PM_THREAD_WAKEUP above, JHB Oct 2026 */
+
+void ThreadIdleWait(int thread_index, bool fNetIO) {
+
+PM_THREAD_WAKEUP* pWakeup = &pm_thread_wakeup[thread_index];
+uint32_t seq;
+uint64_t signal_time, wakeup_time, latency;
+struct timespec ts;
+unsigned int uTimeout;
+int i, ret_val;
+
+   if (!pWakeup->spin_limit) pWakeup->spin_limit = PM_THREAD_SPIN_MIN;
+
+   seq = __atomic_load_n(&pWakeup->seq, __ATOMIC_SEQ_CST);
+
+/* adaptive spin */
+
+   for (i=0; i<pWakeup->spin_limit; i++) {
+
+      if (__atomic_load_n(&pWakeup->seq, __ATOMIC_ACQUIRE) != seq) {
+
+         pWakeup->spin_limit = min(pWakeup->spin_limit*2, PM_THREAD_SPIN_MAX);
+         packet_media_thread_info[thread_index].idle_spin_wakeups++;
+         return;
+      }
+
+      #if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+      #endif
+   }
+
+   pWakeup->spin_limit = max(pWakeup->spin_limit/2, PM_THREAD_SPIN_MIN);
+
+/* block. Either ThreadIdleWakeup() sees fBlocked set, or we see seq change, so no wakeups are lost */
+
+   uTimeout = fNetIO ? pktlib_gbl_cfg.uThreadEnergySaverSleepTime : max((unsigned int)PM_THREAD_BLOCK_TIMEOUT, pktlib_gbl_cfg.uThreadEnergySaverSleepTime);
+
+   ts.tv_sec = uTimeout / 1000000L;
+   ts.tv_nsec = (uTimeout % 1000000L)*1000;
+
+   __atomic_store_n(&pWakeup->fBlocked, 1, __ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&pWakeup->seq, __ATOMIC_SEQ_CST) != seq) ret_val = -1;
+   else ret_val = syscall(SYS_futex, &pWakeup->seq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0);
+
+   __atomic_store_n(&pWakeup->fBlocked, 0, __ATOMIC_SEQ_CST);
+
+   packet_media_thread_info[thread_index].idle_blocks++;
+
+   if (__atomic_load_n(&pWakeup->seq, __ATOMIC_SEQ_CST) == seq) packet_media_thread_info[thread_index].idle_block_timeouts++;  /* timeout, EINTR, or spurious wakeup */
+   else {
+
+      packet_media_thread_info[thread_index].idle_block_wakeups++;
+
+      if (ret_val == 0 && (signal_time = __atomic_exchange_n(&pWakeup->signal_time, 0, __ATOMIC_SEQ_CST))) {  /* woken by futex wake, record latency */
+
+         wakeup_time = get_time(USE_CLOCK_GETTIME);
+         latency = wakeup_time > signal_time ? wakeup_time - signal_time : 0;
+
+         packet_media_thread_info[thread_index].idle_wakeup_latency_sum += latency;
+         packet_media_thread_info[thread_index].idle_wakeup_latency_max = max(packet_media_thread_info[thread_index].idle_wakeup_latency_max, latency);
+         packet_media_thread_info[thread_index].idle_wakeup_latency_count++;
+      }
+   }
+}
+
+void ThreadIdleWakeup(int thread_index) {  /* called by app threads. Unless the thread is blocked the cost is one atomic increment and one atomic load */
+
+PM_THREAD_WAKEUP* pWakeup;
+
+   if (thread_index < 0 || thread_index >= MAX_PKTMEDIA_THREADS) return;
+
+   pWakeup = &pm_thread_wakeup[thread_index];
+
+   __atomic_add_fetch(&pWakeup->seq, 1, __ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&pWakeup->fBlocked, __ATOMIC_SEQ_CST) && __atomic_exchange_n(&pWakeup->fBlocked, 0, __ATOMIC_SEQ_CST)) {  /* only first waker makes the syscall */
+
+      __atomic_store_n(&pWakeup->signal_time, get_time(USE_CLOCK_GETTIME), __ATOMIC_SEQ_CST);
+      syscall(SYS_futex, &pWakeup->seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+   }
+}
+
 #ifdef __LIBRARYMODE__  /* added to fix mediaTest link fail under gcc 7.2 + ld 2.26. Not sure why this is not showing up on other gcc versions; it does make sense though - for mediaTest, pktlib.c is not in the build, JHB Mar 2024 */
 
 /* called by DSPushPackets() in pktlib.c. Can be called as needed to get index of packet/media thread to which a session is assigned, JHB Jun 2023 */
 
 void set_session_last_push_time(HSESSION hSession) {
 
-   __sync_lock_test_and_set(&last_push_time[hSession], last_cur_time[get_session_thread_index(hSession)]);  /* get_session_thread_index() is inline in pktlib.c, JHB Jun 2023 */
-   __sync_and_and_fetch(&session_alarm_flags[hSession], ~2);  /* clear alarm flag, JHB Jan 2023 */
+   __sync_lock_test_and_set(&session_state_cold[hSession].last_push_time, last_cur_time[get_session_thread_index(hSession)]);  /* get_session_thread_index() is inline in pktlib.c, JHB Jun 2023 */
+   __sync_and_and_fetch(&session_state_cold[hSession].session_alarm_flags, ~2);  /* clear alarm flag, JHB Jan 2023 */
+
+   ThreadIdleWakeup(get_session_thread_index(hSession));  /* wake session's p/m thread if it's blocked in ThreadIdleWait(), JHB Oct 2026 */
 }
 
 void set_session_alarm_flags(HSESSION hSession, uint8_t uFlags) {  /* note we use bit 7 to determine set or clear, so only 7 flags available, JHB Jun 2023 */
   
-   if (!(uFlags & 0x80)) session_alarm_flags[hSession] |= uFlags;
-   else session_alarm_flags[hSession] &= uFlags;
+   if (!(uFlags & 0x80)) session_state_cold[hSession].session_alarm_flags |= uFlags;
+   else session_state_cold[hSession].session_alarm_flags &= uFlags;
 }
 #endif
 
@@ -6909,6 +7815,26 @@ char tmpstr[8000] = "";
 
    sprintf(&tmpstr[strlen(tmpstr)], "buffer pkts = %2.2f, decode pkts = %2.2f, encode pkts = %2.2f, stream group contributions = %2.2f \n", 1.0*buf_pkt_sum/max(num_buf_counted, (uint64_t)1), 1.0*enc_pkt_sum/max(num_enc_counted, (uint64_t)1), 1.0*dec_pkt_sum/max(num_dec_counted, (uint64_t)1), 1.0*group_contrib_sum/max(num_stream_group_counted, (uint64_t)1));
 
+   if (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_REBALANCE_THREADS) {  /* session rebalancing stats, JHB Oct 2026 */
+
+      sprintf(&tmpstr[strlen(tmpstr)], "rebalance migrations out = %u (%u sessions), in = %u (%u sessions) \n", packet_media_thread_info[thread_index].rebalance_migrations_out, packet_media_thread_info[thread_index].rebalance_sessions_out, packet_media_thread_info[thread_index].rebalance_migrations_in, packet_media_thread_info[thread_index].rebalance_sessions_in);
+   }
+
+   if (packet_media_thread_info[thread_index].uFlags & (DS_MEDIASERVICE_BATCH_DECODE | DS_MEDIASERVICE_PIPELINE_DECODE)) {  /* batched decode stats, JHB Oct 2026 */
+
+      sprintf(&tmpstr[strlen(tmpstr)], "batch decode calls = %u, frames = %u (avg %2.2f per call), single frame decodes = %u, drops = %u \n", packet_media_thread_info[thread_index].batch_decode_calls, packet_media_thread_info[thread_index].batch_decode_frames, 1.0*packet_media_thread_info[thread_index].batch_decode_frames/max(packet_media_thread_info[thread_index].batch_decode_calls, (uint32_t)1), packet_media_thread_info[thread_index].batch_decode_single, packet_media_thread_info[thread_index].batch_decode_drops);
+   }
+
+   if (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_PIPELINE_DECODE) {  /* codec stage stats, JHB Oct 2026 */
+
+      sprintf(&tmpstr[strlen(tmpstr)], "codec stage hand-offs = %u, frames = %u (avg %2.2f per hand-off), waits = %u \n", packet_media_thread_info[thread_index].pipeline_handoffs, packet_media_thread_info[thread_index].pipeline_frames, 1.0*packet_media_thread_info[thread_index].pipeline_frames/max(packet_media_thread_info[thread_index].pipeline_handoffs, (uint32_t)1), packet_media_thread_info[thread_index].pipeline_waits);
+   }
+
+   if (packet_media_thread_info[thread_index].uFlags & DS_MEDIASERVICE_SPIN_THEN_BLOCK) {  /* energy saver state spin-then-block wakeup stats, JHB Oct 2026 */
+
+      sprintf(&tmpstr[strlen(tmpstr)], "idle spin wakeups = %u, blocks = %u, block wakeups = %u, block timeouts = %u, wakeup latency avg/max (usec) = %2.2f/%llu \n", packet_media_thread_info[thread_index].idle_spin_wakeups, packet_media_thread_info[thread_index].idle_blocks, packet_media_thread_info[thread_index].idle_block_wakeups, packet_media_thread_info[thread_index].idle_block_timeouts, 1.0*packet_media_thread_info[thread_index].idle_wakeup_latency_sum/max(packet_media_thread_info[thread_index].idle_wakeup_latency_count, (uint32_t)1), (unsigned long long)packet_media_thread_info[thread_index].idle_wakeup_latency_max);
+   }
+
    char sessstr[20];
    if (numSessions >= 0) sprintf(sessstr, "numSessions = %d, ", numSessions);
    else strcpy(sessstr, "");  /* this case if called from ThreadAbort() */
@@ -6957,9 +7883,9 @@ char tmpstr[8000] = "";
 
          for (i=0; i<numSessions; i++) {
 
-            uint32_t pkt_cnt =  min(pkt_count[hSessions_t[i]], (uint32_t)DELTA_SUM_LENGTH);
+            uint32_t pkt_cnt =  min(session_state_hot[hSessions_t[i]].pkt_count, (uint32_t)DELTA_SUM_LENGTH);
 
-            if (hSessions_t[i] >= 0) sprintf(&tmpstr[strlen(tmpstr)], " %1.2f/%d", pkt_cnt ? 1.0*pkt_delta_sum[hSessions_t[i]]/pkt_cnt/1000 : -1, DSPushPackets(DS_PUSHPACKETS_GET_QUEUE_LEVEL, NULL, NULL, &hSessions_t[i], 1));
+            if (hSessions_t[i] >= 0) sprintf(&tmpstr[strlen(tmpstr)], " %1.2f/%d", pkt_cnt ? 1.0*session_state_hot[hSessions_t[i]].pkt_delta_sum/pkt_cnt/1000 : -1, DSPushPackets(DS_PUSHPACKETS_GET_QUEUE_LEVEL, NULL, NULL, &hSessions_t[i], 1));
          }
 
          sprintf(&tmpstr[strlen(tmpstr)], "\n");
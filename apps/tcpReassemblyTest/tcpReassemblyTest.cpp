@@ -0,0 +1,326 @@
+/*
+$Header: /root/Signalogic/apps/tcpReassemblyTest/tcpReassemblyTest.cpp
+
+Description
+
+  Test program for pktlib TCP flow reassembly APIs (DSCreateTcpReassembly(), DSTcpReassemblyAddPacket(), DSDeleteTcpReassembly()). Feeds in-order, out-of-order, overlapping, retransmitted, and lost segments and checks the reassembled byte stream and callback stream flags
+
+Notes
+
+  -each test builds a known byte stream, splits it into IPv4 TCP packets, reorders / overlaps / duplicates / drops them as specified, and compares callback output with the original stream
+  -PKTINFO is filled directly from the packets built here, so the test depends only on the TCP reassembly engine (see Makefile), not on DSGetPacketInfo()
+  -return value is zero if all tests pass, otherwise the number of failed tests
+
+Projects
+
+  SigSRF, DirectCore
+
+Copyright Signalogic Inc. 2026
+
+License
+
+  Github SigSRF License, Version 1.1, https://github.com/signalogic/SigSRF_SDK/blob/master/LICENSE.md
+
+Revision History
+
+  Created Oct 2026 JHB
+*/
+
+/* Linux and/or other OS includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+using namespace std;
+
+/* SigSRF includes */
+
+#include "pktlib.h"  /* TCP reassembly API definitions */
+
+#define STREAM_MAX_LEN      (256*1024)
+#define SEG_MAX_LEN         1460
+#define MAX_TEST_SEGMENTS   4096
+
+#define SEG_FIN             1  /* TEST_SEGMENT flags */
+#define SEG_SYN             2
+#define SEG_RST             4
+
+typedef struct {
+
+   uint32_t      ofs;    /* offset into test stream */
+   int           len;
+   unsigned int  flags;  /* SEG_xxx flags */
+
+} TEST_SEGMENT;
+
+typedef struct {  /* callback results for one flow */
+
+   uint8_t       data[STREAM_MAX_LEN];
+   int           len;
+   int           num_start;
+   int           num_end;
+   int           num_gap;
+   unsigned int  end_flags;
+   bool          fDataAfterEnd;
+
+} STREAM_RESULT;
+
+static uint8_t stream[STREAM_MAX_LEN];
+static STREAM_RESULT result;
+static TEST_SEGMENT segs[MAX_TEST_SEGMENTS];
+static uint32_t rand_state = 1;
+
+static uint32_t test_rand() { rand_state = rand_state*1103515245 + 12345; return rand_state >> 8; }  /* deterministic pseudo-random, results are the same on all systems */
+
+static void shuffle(TEST_SEGMENT* s, int num) {
+
+   for (int i=num-1; i>0; i--) { int j = test_rand() % (i+1); TEST_SEGMENT t = s[i]; s[i] = s[j]; s[j] = t; }
+}
+
+static int StreamCallback(TCP_FLOW_INFO* pFlowInfo, uint8_t* data, int len, unsigned int uStreamFlags, void* pUserData) {
+
+STREAM_RESULT* r = (STREAM_RESULT*)pUserData;
+
+   (void)pFlowInfo;
+
+   if (uStreamFlags & DS_TCP_STREAM_START) r->num_start++;
+   if (uStreamFlags & DS_TCP_STREAM_GAP) r->num_gap++;
+   if (uStreamFlags & DS_TCP_STREAM_END) { r->num_end++; r->end_flags = uStreamFlags; }
+
+   if (len > 0) {
+
+      if (r->num_end) r->fDataAfterEnd = true;
+
+      if (r->len + len <= STREAM_MAX_LEN) memcpy(&r->data[r->len], data, len);
+      r->len += len;
+   }
+
+   return 0;
+}
+
+/* build an IPv4 TCP packet for a test segment and fill PKTINFO the same as DSGetPacketInfo() with DS_PKT_INFO_PKTINFO would */
+
+static int AddSegment(HTCPREASSEMBLY hReasm, uint32_t isn, TEST_SEGMENT* s) {
+
+uint8_t pkt[20+20+SEG_MAX_LEN*2];
+PKTINFO PktInfo;
+uint32_t seq = isn + 1 + s->ofs;  /* SYN consumes one sequence number */
+
+   memset(pkt, 0, 40);
+   memset(&PktInfo, 0, sizeof(PktInfo));
+
+   pkt[0] = 0x45;  /* IPv4, 20 byte header */
+   pkt[9] = TCP;
+   pkt[12] = 10; pkt[13] = 0; pkt[14] = 0; pkt[15] = 1;  /* src 10.0.0.1 */
+   pkt[16] = 10; pkt[17] = 0; pkt[18] = 0; pkt[19] = 2;  /* dst 10.0.0.2 */
+
+   if (s->flags & SEG_SYN) seq = isn;
+
+   pkt[24] = seq >> 24; pkt[25] = seq >> 16; pkt[26] = seq >> 8; pkt[27] = seq;
+   pkt[32] = 0x50;  /* TCP header length 20 */
+   pkt[33] = ((s->flags & SEG_FIN) ? 0x01 : 0) | ((s->flags & SEG_SYN) ? 0x02 : 0) | ((s->flags & SEG_RST) ? 0x04 : 0) | 0x10;
+
+   memcpy(&pkt[40], &stream[s->ofs], s->len);
+
+   PktInfo.version = IPv4;
+   PktInfo.protocol = TCP;
+   PktInfo.ip_hdr_len = 20;
+   PktInfo.pkt_len = 40 + s->len;
+   PktInfo.src_port = 5060;
+   PktInfo.dst_port = 5060;
+   PktInfo.seqnum = seq;
+   PktInfo.pyld_ofs = 40;
+   PktInfo.pyld_len = s->len;
+
+   return DSTcpReassemblyAddPacket(hReasm, pkt, &PktInfo, 0);
+}
+
+/* run one test: SYN, then segs[] in given order. The instance is always deleted before checking results, which closes open flows and delivers any saved data */
+
+static int RunTest(const char* szName, uint32_t isn, int stream_len, int num_segs, int expected_len, int expected_gaps, unsigned int expected_end_flags, TCP_REASSEMBLY_STATS* pStats) {
+
+HTCPREASSEMBLY hReasm;
+TEST_SEGMENT syn = { 0, 0, SEG_SYN };
+int i, ret_val, nErrors = 0;
+
+   memset(&result, 0, sizeof(result));
+
+   if (!(hReasm = DSCreateTcpReassembly(0, 16, 0, StreamCallback, &result))) { printf("  %s: DSCreateTcpReassembly() failed \n", szName); return 1; }
+
+   AddSegment(hReasm, isn, &syn);
+
+   for (i=0; i<num_segs; i++) if ((ret_val = AddSegment(hReasm, isn, &segs[i])) < 0) { printf("  %s: DSTcpReassemblyAddPacket() returned error %d for segment %d \n", szName, ret_val, i); nErrors++; }
+
+   DSGetTcpReassemblyStats(hReasm, 0, pStats);
+   DSDeleteTcpReassembly(hReasm);
+
+/* check reassembled stream. If no data was lost the stream must match exactly, otherwise delivered data must match the stream with lost ranges removed (see TestGapAndFin()) */
+
+   if (result.len != expected_len) { printf("  %s: reassembled length %d, expected %d \n", szName, result.len, expected_len); nErrors++; }
+   else if (expected_len == stream_len && memcmp(result.data, stream, stream_len)) { printf("  %s: reassembled data does not match \n", szName); nErrors++; }
+
+   if (result.num_start != 1) { printf("  %s: DS_TCP_STREAM_START given %d times \n", szName, result.num_start); nErrors++; }
+   if (result.num_end != 1) { printf("  %s: DS_TCP_STREAM_END given %d times \n", szName, result.num_end); nErrors++; }
+   else if ((result.end_flags & ~DS_TCP_STREAM_GAP) != (DS_TCP_STREAM_END | expected_end_flags)) { printf("  %s: end flags 0x%x, expected 0x%x \n", szName, result.end_flags, DS_TCP_STREAM_END | expected_end_flags); nErrors++; }
+   if (result.fDataAfterEnd) { printf("  %s: data delivered after DS_TCP_STREAM_END \n", szName); nErrors++; }
+   if (expected_gaps >= 0 && result.num_gap != expected_gaps) { printf("  %s: DS_TCP_STREAM_GAP given %d times, expected %d \n", szName, result.num_gap, expected_gaps); nErrors++; }
+
+   return nErrors;
+}
+
+static int SplitStream(int stream_len, int seg_len, unsigned int last_flags) {  /* split stream into consecutive segments, returns number of segments */
+
+int num = 0;
+
+   for (int ofs=0; ofs<stream_len; ofs+=seg_len, num++) { segs[num].ofs = ofs; segs[num].len = min(seg_len, stream_len - ofs); segs[num].flags = 0; }
+
+   segs[num-1].flags |= last_flags;
+
+   return num;
+}
+
+static void InitStream(int stream_len) {
+
+   for (int i=0; i<stream_len; i++) stream[i] = (uint8_t)(i*7 + i/251 + 3);  /* not periodic with segment sizes used, so misplaced data is detected */
+}
+
+/* tests */
+
+static int TestInOrder() {
+
+TCP_REASSEMBLY_STATS stats;
+int num = SplitStream(65536, 1000, SEG_FIN);
+int nErrors = RunTest("in order", 1000, 65536, num, 65536, 0, 0, &stats);
+
+   if (stats.out_of_order_segments || stats.duplicate_segments) { printf("  in order: unexpected out-of-order %u or duplicate %u segments \n", stats.out_of_order_segments, stats.duplicate_segments); nErrors++; }
+
+   return nErrors;
+}
+
+static int TestOutOfOrder() {
+
+TCP_REASSEMBLY_STATS stats;
+int i, num, nErrors = 0;
+
+   for (i=0; i<8; i++) {  /* several random orders, FIN included in the shuffle */
+
+      num = SplitStream(65536, 1000, SEG_FIN);
+      shuffle(segs, num);
+
+      nErrors += RunTest("out of order", 0x12345678, 65536, num, 65536, 0, 0, &stats);
+      if (!stats.out_of_order_segments) { printf("  out of order: no segments were saved \n"); nErrors++; }
+   }
+
+   num = SplitStream(65536, 1000, SEG_FIN);  /* fully reversed */
+   for (i=0; i<num/2; i++) { TEST_SEGMENT t = segs[i]; segs[i] = segs[num-1-i]; segs[num-1-i] = t; }
+
+   nErrors += RunTest("reversed", 0x12345678, 65536, num, 65536, 0, 0, &stats);
+
+   return nErrors;
+}
+
+static int TestOverlap() {
+
+TCP_REASSEMBLY_STATS stats;
+int i, num, nErrors = 0;
+uint32_t ofs;
+
+   for (i=0; i<8; i++) {  /* segments of random length, each starting at a random point inside the previous one, in random order */
+
+      for (num=0, ofs=0; ofs < 65536 && num < MAX_TEST_SEGMENTS-1; num++) {
+
+         segs[num].len = min(200 + (int)(test_rand() % 1200), 65536 - (int)ofs);
+         segs[num].ofs = ofs;
+         segs[num].flags = 0;
+
+         if (ofs + segs[num].len >= 65536) { segs[num].flags = SEG_FIN; num++; break; }
+
+         ofs += 1 + test_rand() % segs[num].len;  /* next segment overlaps this one */
+      }
+
+      if (i > 0) shuffle(segs, num);  /* first pass in order, overlaps trimmed from caller's buffer */
+
+      nErrors += RunTest("overlap", 0xfffff000 + i*100, 65536, num, 65536, 0, 0, &stats);  /* sequence numbers wrap partway through */
+      if (!stats.trimmed_bytes && !stats.out_of_order_segments) { printf("  overlap: no overlapping data was trimmed \n"); nErrors++; }
+   }
+
+   return nErrors;
+}
+
+static int TestRetransmit() {
+
+TCP_REASSEMBLY_STATS stats;
+int i, num, num_dup, nErrors = 0;
+
+   for (i=0; i<8; i++) {  /* each segment sent 1 to 3 times, in random order. Duplicates of saved and already delivered segments */
+
+      num = SplitStream(32768, 512, SEG_FIN);
+      num_dup = num;
+
+      for (int j=0; j<num; j++) for (int k=test_rand() % 3; k>0 && num_dup < MAX_TEST_SEGMENTS; k--) { segs[num_dup] = segs[j]; segs[num_dup++].flags &= ~SEG_FIN; }
+
+      shuffle(segs, num_dup);
+
+      nErrors += RunTest("retransmit", 7*i, 32768, num_dup, 32768, 0, 0, &stats);
+      if (num_dup > num && !stats.duplicate_segments) { printf("  retransmit: no duplicate segments detected \n"); nErrors++; }
+   }
+
+   return nErrors;
+}
+
+static int TestGapAndFin() {
+
+TCP_REASSEMBLY_STATS stats;
+int num, lost, nErrors = 0;
+
+/* one segment is never received. The flow is closed when the instance is deleted, saved data after the gap must be delivered with DS_TCP_STREAM_GAP */
+
+   num = SplitStream(20000, 1000, SEG_FIN);
+   lost = 7;
+   segs[lost] = segs[num-1];  /* drop segment 7 */
+   num--;
+   shuffle(segs, num);
+
+   nErrors += RunTest("gap", 99, 20000, num, 19000, 1, 0, &stats);
+
+   if (!nErrors && (memcmp(result.data, stream, lost*1000) || memcmp(&result.data[lost*1000], &stream[(lost+1)*1000], 20000 - (lost+1)*1000))) { printf("  gap: data around gap does not match \n"); nErrors++; }
+
+   return nErrors;
+}
+
+static int TestReset() {
+
+TCP_REASSEMBLY_STATS stats;
+int num = SplitStream(10000, 1000, 0);
+
+   segs[num] = segs[num-1]; segs[num].len = 0; segs[num].ofs = 10000; segs[num].flags = SEG_RST;  /* RST after all data */
+   num++;
+
+   return RunTest("reset", 5, 10000, num, 10000, 0, DS_TCP_STREAM_RESET, &stats);
+}
+
+int main(int argc, char** argv) {
+
+int nFailed = 0, nErrors;
+
+   (void)argc; (void)argv;
+
+   InitStream(STREAM_MAX_LEN);
+
+   printf("TCP reassembly tests \n");
+
+   struct { const char* szName; int (*test)(); } tests[] = { { "in order", TestInOrder }, { "out of order", TestOutOfOrder }, { "overlap", TestOverlap }, { "retransmit", TestRetransmit }, { "gap and FIN", TestGapAndFin }, { "reset", TestReset } };
+
+   for (unsigned int i=0; i<sizeof(tests)/sizeof(tests[0]); i++) {
+
+      nErrors = tests[i].test();
+      printf("  %-14s %s \n", tests[i].szName, nErrors ? "FAIL" : "pass");
+      if (nErrors) nFailed++;
+   }
+
+   printf("%d tests failed \n", nFailed);
+
+   return nFailed;
+}
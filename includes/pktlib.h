@@ -125,6 +125,23 @@
   Modified Apr 2025 JHB, add NOMINAL_MTU definition
   Modified Apr 2025 JHB, add DS_PKT_INFO_PINFO_CONTAINS_ETH_PROTOCOL flag to support rudimentary non-IP packet handling in DSGetPacketInfo(). An ethernet protocol can be given in pInfo and this flag applied. For example usage see GetInputData() in mediaMin.cpp
   Modified Apr 2025 JHB, add rtcp_pyld_type field to PKTINFO struct, add isRTCPCustomPacket() macro. See comments
+  Modified Oct 2026 JHB, add DS_OPEN_PCAP_MMAP flag and DSReadPcapPtr() API for memory-mapped, zero-copy reading of pcap, pcapng, and .rtp files
+  Modified Oct 2026 JHB, add DSReadPcapBatch() API and pcap_batch_rec_t struct to read multiple pcap records per call into a caller supplied packet arena
+  Modified Oct 2026 JHB, add DSCreatePcapIndex() API and DS_FIND_PCAP_PACKET_USE_INDEX flag. DSFindPcapPacket() uses a .sigidx sidecar index file to binary search for matching packets instead of scanning the pcap
+  Modified Oct 2026 JHB, add DSSeekPcap() API and DS_SEEK_PCAP_RELATIVE_TIME flag for arrival time based seek in pcap, pcapng, and .rtp files
+  Modified Oct 2026 JHB, add DSCreatePcapWriter() and DSWritePcapBuffered() APIs and DS_WRITE_PCAP_FLUSH flag for buffered pcap output without semaphore serialization
+  Modified Oct 2026 JHB, add DSScanPcap() API, pcap_scan_rec_t struct, and PCAP_SCAN_CALLBACK typedef for chunk-parallel pcap parsing. Add DSGetPcapStats() API and pcap_stats_t struct
+  Modified Oct 2026 JHB, DSOpenPcap() supports streaming gzip and zstd compressed pcap inputs and outputs, see DSOpenPcap() comments
+  Modified Oct 2026 JHB, add PKT_FRAGMENT_STATS struct and DSPktGetFragmentStats() for fragment reassembly eviction and pool exhaustion stats
+  Modified Oct 2026 JHB, add DSPktReassembleIov() and DSPktReleaseReassembly() for zero-copy scatter-gather reassembly output
+  Modified Oct 2026 JHB, PKT_FRAGMENT identifier is now 32-bit, to support IPv6 Fragment header reassembly
+  Modified Oct 2026 JHB, add PKT_DUPLICATE_RING struct, DSInitPacketDuplicateRing(), and DSIsPacketDuplicateRing() for duplicate detection beyond the previous packet
+  Modified Oct 2026 JHB, add TCP flow reassembly APIs DSCreateTcpReassembly(), DSTcpReassemblyAddPacket(), DSGetTcpReassemblyStats(), and DSDeleteTcpReassembly(), and related structs, callback typedef, and flags. Source is in pktlib_tcp_reassembly.cpp
+  Modified Oct 2026 JHB, add push/pull event notification APIs DSGetPacketNotifySeq(), DSWaitPacketNotify(), and DSSignalPacketNotify(), and DS_PKT_NOTIFY_xxx flags. Source is in pktlib_notify.cpp
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_SPIN_THEN_BLOCK flag for DSConfigMediaService(), add idle_xxx wakeup stats to PACKETMEDIATHREADINFO struct
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_REBALANCE_THREADS flag for DSConfigMediaService(), add rebalance_xxx migration stats to PACKETMEDIATHREADINFO struct
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_BATCH_DECODE flag for DSConfigMediaService(), add batch_decode_xxx stats to PACKETMEDIATHREADINFO struct
+  Modified Oct 2026 JHB, add DS_MEDIASERVICE_PIPELINE_DECODE flag for DSConfigMediaService(), add pipeline_xxx codec stage stats to PACKETMEDIATHREADINFO struct
 */
 
 #ifndef _PKTLIB_H_
@@ -135,6 +152,7 @@
 #include <asm/byteorder.h>
 #include <semaphore.h>
 #include <sys/resource.h>
+#include <sys/uio.h>  /* struct iovec, JHB Oct 2026 */
 
 #include "alias.h"
 #include "filelib.h"
@@ -353,7 +371,7 @@ extern "C" {
 
     uint8_t   flags;            /* fragment flags */
     uint16_t  offset;           /* fragment offset */
-    uint16_t  identifier;       /* identification field */
+    uint32_t  identifier;       /* identification field, 32-bit to hold IPv6 Identification, JHB Oct 2026 */
 
   /* 3-way tuple defines the stream connection */
 
@@ -452,6 +470,28 @@ extern "C" {
     uint8_t    encode_time_index;
     uint8_t    stream_group_time_index;
 
+    uint32_t   idle_spin_wakeups;  /* energy saver state wakeup stats, maintained if DS_MEDIASERVICE_SPIN_THEN_BLOCK flag is given in DSConfigMediaService(), JHB Oct 2026 */
+    uint32_t   idle_blocks;
+    uint32_t   idle_block_wakeups;
+    uint32_t   idle_block_timeouts;
+    uint32_t   idle_wakeup_latency_count;
+    uint64_t   idle_wakeup_latency_sum;  /* in usec */
+    uint64_t   idle_wakeup_latency_max;  /* in usec */
+
+    uint32_t   rebalance_migrations_out;  /* session migration stats, maintained if DS_MEDIASERVICE_REBALANCE_THREADS flag is given in DSConfigMediaService(), JHB Oct 2026 */
+    uint32_t   rebalance_migrations_in;
+    uint32_t   rebalance_sessions_out;
+    uint32_t   rebalance_sessions_in;
+
+    uint32_t   batch_decode_calls;   /* batched decode stats, maintained if DS_MEDIASERVICE_BATCH_DECODE flag is given in DSConfigMediaService(), JHB Oct 2026 */
+    uint32_t   batch_decode_frames;  /* frames decoded by batched calls */
+    uint32_t   batch_decode_single;  /* frames queued but decoded individually (no other frame matched) */
+    uint32_t   batch_decode_drops;   /* frames not stored because channel's RTP info ring was full (stream data not being consumed) */
+
+    uint32_t   pipeline_handoffs;    /* codec stage stats, maintained if DS_MEDIASERVICE_PIPELINE_DECODE flag is given in DSConfigMediaService(), JHB Oct 2026 */
+    uint32_t   pipeline_frames;      /* frames handed off to codec stage thread */
+    uint32_t   pipeline_waits;       /* loop iterations where p/m thread waited for codec stage thread to finish */
+
   } PACKETMEDIATHREADINFO;
 
   #define MAX_PKTMEDIA_THREADS         64
@@ -801,10 +841,120 @@ int DSIsPacketDuplicate(unsigned int uFlags, PKTINFO* PktInfo1, PKTINFO* PktInfo
 #define DS_PKT_DUPLICATE_PRINT_PKTNUMBER                 0x100  /* debug info printed; pInfo is interpreted as a packet number */
 #define DS_PKT_DUPLICATE_INCLUDE_UDP_CHECKSUM            0x200  /* include UDP checksum in duplicate comparison; default is UDP checksum ignored (see comments in pktlib_RFC791_fragmentation.cpp) */
 
+/* per stream duplicate packet detection using a ring of packet fingerprints. Detects duplicates up to lookback packets apart; see notes in pktlib_RFC791_fragmentation.cpp, JHB Oct 2026 */
+
+#define DS_PKT_DUPLICATE_MAX_LOOKBACK                    64   /* max lookback packets */
+#define DS_PKT_DUPLICATE_DEFAULT_LOOKBACK                0    /* ring detection is opt-in. Zero disables, in which case apps should use DSIsPacketDuplicate() previous packet comparison */
+#define DS_PKT_DUPLICATE_HASH_SIZE                       128  /* fingerprint hash table size, must be a power of 2 */
+#define DS_PKT_DUPLICATE_PREFIX_LEN                      64   /* amount of packet data included in a fingerprint */
+
+typedef struct {
+
+  int           lookback;                                      /* lookback window, in candidate packets */
+  int           index;                                         /* next ring position */
+  int           count;                                         /* number of fingerprints in ring */
+  unsigned int  num_duplicates;                                /* number of duplicates found */
+  uint64_t      fingerprint[DS_PKT_DUPLICATE_MAX_LOOKBACK];    /* fingerprint ring */
+  int8_t        hash_next[DS_PKT_DUPLICATE_MAX_LOOKBACK];      /* hash bucket chains, -1 terminates */
+  int8_t        hash_head[DS_PKT_DUPLICATE_HASH_SIZE];
+
+} PKT_DUPLICATE_RING;
+
+int DSInitPacketDuplicateRing(PKT_DUPLICATE_RING* pRing, int lookback);  /* lookback is limited to DS_PKT_DUPLICATE_MAX_LOOKBACK, zero disables. Return value is lookback or -1 for an error condition */
+int DSIsPacketDuplicateRing(PKT_DUPLICATE_RING* pRing, unsigned int uFlags, uint8_t* pkt_buf, PKTINFO* PktInfo);  /* pkt_buf is the current packet and PktInfo its DSGetPacketInfo() PKTINFO. Returns true or false; uFlags may include DS_PKT_DUPLICATE_INCLUDE_UDP_CHECKSUM */
+
 int DSIsReservedUDP(uint16_t port);
 
 int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max_list_fragments);  /* Reserved API: currently undocumented */
 
+/* fragment reassembly stats for the calling thread, returned by DSPktGetFragmentStats(), JHB Oct 2026 */
+
+typedef struct {
+
+  unsigned int total_fragments;     /* fragments saved */
+  unsigned int active_fragments;    /* fragments waiting for reassembly */
+  unsigned int max_fragments;       /* max active fragments */
+  unsigned int timeout_evictions;   /* datagrams evicted after reassembly timeout */
+  unsigned int pool_evictions;      /* datagrams evicted to make room for new fragments */
+  unsigned int pool_exhausted;      /* number of times fragment pool or datagram table was full */
+  unsigned int oversize_fragments;  /* fragments too large for a fragment pool buffer */
+
+} PKT_FRAGMENT_STATS;
+
+int DSPktGetFragmentStats(unsigned int uFlags, PKT_FRAGMENT_STATS* pStats);  /* Reserved API: currently undocumented */
+
+/* DSPktReassembleIov() is a zero-copy alternative to DSGetPacketInfo() with DS_PKT_INFO_REASSEMBLY_GET_PACKET. Notes, JHB Oct 2026:
+
+  -pkt_buf is a fragment of the datagram to reassemble, uFlags should include DS_PKTLIB_HOST_BYTE_ORDER if applicable
+  -on return iov[] describes the reassembled packet: iov[0] is the IP header (total length updated, fragmentation info removed; for IPv6 the Fragment header is removed and Payload Length updated), followed by packet data in offset order. Return value is number of iovecs used, 0 if reassembly is not available, or -1 for an error condition (e.g. more than max_iov - 1 fragments). Reassembled packet length is returned in pkt_len if not NULL
+  -iov[] points into pktlib's fragment buffers for the calling thread. It remains valid until the thread's next DSPktReassembleIov() or DSGetPacketInfo() reassembly call, or DSPktReleaseReassembly()
+*/
+
+int DSPktReassembleIov(uint8_t* pkt_buf, unsigned int uFlags, struct iovec* iov, int max_iov, int* pkt_len);
+int DSPktReleaseReassembly(unsigned int uFlags);  /* return value is number of fragments released */
+
+/* TCP flow reassembly APIs. Notes, JHB Oct 2026:
+
+  -DSCreateTcpReassembly() creates a TCP flow table with max_flows flows and a pool of num_segments out-of-order segment buffers (zero for either uses a default). pCallback is called with in-order byte stream data for each flow, pUserData is passed through to the callback
+  -DSTcpReassemblyAddPacket() adds a TCP packet; pkt_buf should start with an IP header and PktInfo should be filled by DSGetPacketInfo() with DS_PKT_INFO_PKTINFO. Packets that are not TCP are ignored. Return value is one or more DS_TCP_REASSEMBLY_RETURN_xxx flags, or < 0 for an error condition
+  -in-order data is given to the callback directly from pkt_buf when possible (no copy). Retransmitted data is trimmed, out-of-order segments are saved until gaps are filled. The callback's uStreamFlags param includes DS_TCP_STREAM_START when a flow is created, DS_TCP_STREAM_GAP if data is missing (e.g. capture loss) before the current data, and DS_TCP_STREAM_END when a flow is closed (FIN, RST, LRU eviction, or DSDeleteTcpReassembly())
+  -flows are unidirectional. The callback can save per flow context in the TCP_FLOW_INFO pFlowUserData field
+  -a TCP reassembly instance is not thread safe; it should be used by one thread
+*/
+
+typedef void* HTCPREASSEMBLY;
+
+typedef struct {
+
+  uint8_t   ip_version;
+  uint8_t   src_addr[16];        /* IPv4 uses first 4 bytes */
+  uint8_t   dst_addr[16];
+  uint16_t  src_port;
+  uint16_t  dst_port;
+  uint64_t  bytes_delivered;     /* in-order bytes delivered so far */
+  void*     pFlowUserData;       /* available for callback use, NULL when flow is created */
+
+} TCP_FLOW_INFO;
+
+typedef int (*TCP_STREAM_CALLBACK)(TCP_FLOW_INFO* pFlowInfo, uint8_t* data, int len, unsigned int uStreamFlags, void* pUserData);
+
+#define DS_TCP_STREAM_START                              1     /* TCP_STREAM_CALLBACK uStreamFlags. data is NULL and len is zero for DS_TCP_STREAM_START and DS_TCP_STREAM_END */
+#define DS_TCP_STREAM_END                                2
+#define DS_TCP_STREAM_GAP                                4
+#define DS_TCP_STREAM_RESET                              8     /* combined with DS_TCP_STREAM_END */
+#define DS_TCP_STREAM_EVICTED                            0x10  /*  "" */
+
+#define DS_TCP_REASSEMBLY_RETURN_NEW_FLOW                1     /* DSTcpReassemblyAddPacket() return flags */
+#define DS_TCP_REASSEMBLY_RETURN_DELIVERED               2     /* packet data (and possibly saved data) delivered to callback */
+#define DS_TCP_REASSEMBLY_RETURN_SAVED                   4     /* out-of-order packet data saved */
+#define DS_TCP_REASSEMBLY_RETURN_DUPLICATE               8     /* packet data already delivered or saved (retransmission) */
+#define DS_TCP_REASSEMBLY_RETURN_FLOW_END                0x10  /* flow closed after FIN or RST */
+
+#define DS_TCP_REASSEMBLY_ERROR_NO_MEMORY                -2    /* DSTcpReassemblyAddPacket() error return: out-of-order segment too large for a pool buffer and malloc() failed. The segment is dropped and counted in dropped_segments */
+
+typedef struct {
+
+  uint64_t      packets;
+  uint64_t      bytes_delivered;
+  uint64_t      trimmed_bytes;          /* retransmitted bytes trimmed from partially new segments */
+  unsigned int  total_flows;
+  unsigned int  active_flows;
+  unsigned int  max_flows;
+  unsigned int  flow_evictions;         /* flows removed to make room for new flows */
+  unsigned int  duplicate_segments;
+  unsigned int  out_of_order_segments;
+  unsigned int  gaps;                   /* number of times missing data was skipped */
+  unsigned int  pool_exhausted;         /* number of times segment pool was empty */
+  unsigned int  oversize_segments;      /* segments too large for a pool buffer */
+  unsigned int  dropped_segments;       /* segments dropped when no segment memory could be recovered */
+
+} TCP_REASSEMBLY_STATS;
+
+HTCPREASSEMBLY DSCreateTcpReassembly(unsigned int uFlags, int max_flows, int num_segments, TCP_STREAM_CALLBACK pCallback, void* pUserData);
+int DSTcpReassemblyAddPacket(HTCPREASSEMBLY hReasm, uint8_t* pkt_buf, PKTINFO* PktInfo, unsigned int uFlags);
+int DSGetTcpReassemblyStats(HTCPREASSEMBLY hReasm, unsigned int uFlags, TCP_REASSEMBLY_STATS* pStats);
+int DSDeleteTcpReassembly(HTCPREASSEMBLY hReasm);  /* remaining saved data is delivered before flows are removed. Return value is number of flows removed */
+
 /* media processing related APIs:
    
     -DSConvertFsPacket() - converts sampling rate from one codec to another, taking into account RTP packet info. Notes:
@@ -1002,6 +1152,7 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
    -reads the file header(s) and leaves fp_pcap pointing at the first pcap record, and returns a filled pcap_hdr_t struct pointed to by pcap_file_hdr
    -pErrstr is optional; if used it should point to an error information string to be included in warning or error messages. NULL indicates not used
    -uFlags are given in DS_OPEN_PCAP_XXX definitions below
+   -gzip and zstd compressed inputs are detected automatically and decompressed while reading. Outputs are compressed if pcap_file ends in .gz or .zst. In both cases fp_pcap can be used with other pcap APIs as usual. zlib (libz.so) and libzstd (libzstd.so) are loaded at run-time when first needed. Seeking backwards in a compressed input may restart decompression from the start of the file, and compressed inputs can't be memory-mapped (DS_OPEN_PCAP_MMAP falls back to buffered reads), JHB Oct 2026
 
    -return value is a 32-bit int formatted as:
 
@@ -1023,6 +1174,7 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
   #define DS_OPEN_PCAP_QUIET                            0x0400  /* suppress status and progress messages */
   #define DS_OPEN_PCAP_RESET                            0x1000  /* seek to start of pcap; assumes a valid (already open) file handle given to DSOpenPcap(). Must be combined with DS_OPEN_PCAP_READ, JHB Dec 2021 */
   #define DS_OPEN_PCAP_FILE_HDR_PCAP_FORMAT             0x2000  /* info returned in pcap_file_hdr will be in pcap (libpcap) file format, even if the file being opened is in pcapng format */
+  #define DS_OPEN_PCAP_MMAP                             0x4000  /* memory-map the input file for use with DSReadPcapPtr(). Must be combined with DS_OPEN_PCAP_READ. If the file cannot be mapped (e.g. pipe or special file) DSReadPcapPtr() falls back to buffered reads. DSClosePcap() unmaps the file, JHB Oct 2026 */
 
 /* DSReadPcap() reads one or more pcap records at the current file position of fp_pcap into pkt_buf, and fills in one or more pcaprec_hdr_t structs (see above definition). Notes:
 
@@ -1047,9 +1199,71 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
   #define DS_READ_PCAP_SUPPRESS_WARNING_ERROR_MSG       DS_PKTLIB_SUPPRESS_WARNING_ERROR_MSG
   #define DS_READ_PCAP_SUPPRESS_INFO_MSG                DS_PKTLIB_SUPPRESS_INFO_MSG
 
+/* DSReadPcapPtr() reads a pcap record in place from a file opened by DSOpenPcap() with the DS_OPEN_PCAP_MMAP flag. Notes:
+
+   -instead of copying packet data to a caller supplied buffer, *p_pkt is set to point at packet data inside the file mapping. For .rtp files *p_pkt points to a per-handle buffer containing the formatted IPv4/UDP packet. *p_pkt is valid until the next DSReadPcapPtr() or DSClosePcap() call for fp_pcap
+   -packet data pointed to by *p_pkt may be modified by the caller (the mapping is private, the file is not affected)
+   -for unused or unknown pcapng block types *p_pkt is returned as NULL
+   -other params, DS_READ_PCAP_XXX uFlags, and return value are the same as DSReadPcap(). Link layer, VLAN, Null/Loopback, and TSO length fix handling is also the same
+   -DSReadPcapPtr() does not use or advance the fp_pcap file position, so DSReadPcap() and DSReadPcapPtr() should not be mixed on the same handle
+*/
+
+  int DSReadPcapPtr(FILE* fp_pcap, unsigned int uFlags, uint8_t** p_pkt, pcaprec_hdr_t* pcap_pkt_hdr, int link_layer_info, uint16_t* p_eth_protocol, uint16_t* p_block_type, pcap_hdr_t* pcap_file_hdr);
+
+/* DSReadPcapBatch() reads up to max_recs packet records into a caller supplied contiguous packet arena and fills in one pcap_batch_rec_t struct per record. Notes:
+
+   -packet data for record n is at arena[batch_recs[n].offset], with length batch_recs[n].pkt_len. Offsets are 8-byte aligned
+   -only packet blocks are returned (PCAP_PB_TYPE, RTP_PB_TYPE, PCAPNG_EPB_TYPE, PCAPNG_SPB_TYPE). IDB and other non-packet pcapng blocks are read and skipped
+   -if fp_pcap was opened with DS_OPEN_PCAP_MMAP, records are packed into the arena until the next one doesn't fit; that record is left for the next call. Otherwise records are read with DSReadPcap() while at least MAX_TCP_PACKET_LEN bytes of arena remain, so arena_len should be at least MAX_TCP_PACKET_LEN plus expected batch data size
+   -link_layer_info, pcap_file_hdr, and DS_READ_PCAP_XXX uFlags are the same as DSReadPcap(), except DS_READ_PCAP_COPY which is not supported
+   -return value is the number of records read, zero if file end has been reached, or < 0 for an error condition. If an error occurs after one or more records have been read, the number of records already read is returned
+*/
+
+  typedef struct {
+
+    uint32_t       offset;        /* offset of packet data in arena */
+    int            pkt_len;       /* packet length, same as DSReadPcap() return value */
+    uint16_t       eth_protocol;  /* ETH_P_XXX ethernet protocol, same as DSReadPcap() p_eth_protocol */
+    uint16_t       block_type;    /* block type, same as DSReadPcap() p_block_type */
+    pcaprec_hdr_t  pcap_rec_hdr;  /* record header */
+
+  } pcap_batch_rec_t;
+
+  int DSReadPcapBatch(FILE* fp_pcap, unsigned int uFlags, uint8_t* arena, int arena_len, pcap_batch_rec_t batch_recs[], int max_recs, int link_layer_info, pcap_hdr_t* pcap_file_hdr);
+
+/* DSSeekPcap() positions fp_pcap at the first packet record with arrival timestamp at or after seek_time (in usec). Notes, JHB Oct 2026:
+
+   -works for pcap, pcapng (EPB timestamps), and .rtp (.rtpdump) files opened by DSOpenPcap(), including DS_OPEN_PCAP_MMAP handles. Note that pcapng simple packet blocks (SPBs) have no timestamp and are treated as time zero
+   -libpcap files are bisected by file offset, resynchronizing on record headers at each step, so a seek costs a few dozen record header reads regardless of file size
+   -for pcapng, .rtp, and compressed files the first call for a handle builds a coarse time index (one entry per 1024 records) in one pass over the file; subsequent calls binary search the index and read forward at most a few records. The first call should be made before any records are read, for example immediately after DSOpenPcap() or after DSOpenPcap() with DS_OPEN_PCAP_RESET. DSClosePcap() frees the index
+   -if uFlags includes DS_SEEK_PCAP_RELATIVE_TIME seek_time is relative to the first packet record in the file. A relative seek_time of zero positions at the first packet record and can be used to get its arrival time
+   -link_layer_info and pcap_file_hdr are the same as DSReadPcap()
+   -p_rec_time, if not NULL, receives the arrival timestamp (usec) of the record at the new position
+   -return value is 1 on success, 0 if no record is at or after seek_time (fp_pcap is left at end of file), or < 0 for an error condition
+*/
+
+  int DSSeekPcap(FILE* fp_pcap, unsigned int uFlags, uint64_t seek_time, int link_layer_info, pcap_hdr_t* pcap_file_hdr, uint64_t* p_rec_time);
+
+  #define DS_SEEK_PCAP_RELATIVE_TIME                        1
+
   int DSWritePcap(FILE* fp_pcap, unsigned int uFlags, uint8_t* pkt_buf, int pkt_buf_len, pcaprec_hdr_t* pcap_pkt_hdr, struct ethhdr* p_eth_hdr, pcap_hdr_t* pcap_file_hdr);
 
   #define DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK         0x0100  /* use wall clock to set packet record header timestamp (this is the arrival timestamp in Wireshark) */
+  #define DS_WRITE_PCAP_FLUSH                           0x0200  /* DSWritePcapBuffered() only: write buffered records to file. pkt_buf may be NULL to flush without writing a record */
+
+/* DSCreatePcapWriter() attaches a write buffer to fp_pcap, which must be opened by DSOpenPcap() with DS_WRITE. Notes, JHB Oct 2026:
+
+   -DSWritePcapBuffered() params and record formatting are the same as DSWritePcap(). Records are coalesced in the buffer and written with writev() when it fills; DSClosePcap() writes remaining records and frees the writer
+   -multiple threads may call DSWritePcapBuffered() for the same fp_pcap without a semaphore or other lock
+   -after DSCreatePcapWriter() is called, DSWritePcap() and other fwrite() based writes should not be used with fp_pcap, as they are not ordered with buffered records
+   -if no writer exists for fp_pcap, DSWritePcapBuffered() calls DSWritePcap()
+   -buf_size is the buffer size in bytes, zero specifies a default of 256 KB. uFlags is currently unused
+   -return value is 1 on success, 0 if a writer already exists for fp_pcap, or < 0 for an error condition
+*/
+
+  int DSCreatePcapWriter(FILE* fp_pcap, unsigned int uFlags, int buf_size);
+
+  int DSWritePcapBuffered(FILE* fp_pcap, unsigned int uFlags, uint8_t* pkt_buf, int pkt_buf_len, pcaprec_hdr_t* pcap_pkt_hdr, struct ethhdr* p_eth_hdr, pcap_hdr_t* pcap_file_hdr);
 
   int DSClosePcap(FILE* fp_pcap, unsigned uFlags);
 
@@ -1085,6 +1299,69 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
   #define DS_FIND_PCAP_PACKET_FIRST_MATCHING            0x1000
   #define DS_FIND_PCAP_PACKET_LAST_MATCHING             0x2000
   #define DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET           0x4000  /* use byte offset instead of record offset. Seek offset gives faster performance but record offset can be useful when the number of records searched prior to a match is needed. Record offset is the default. This flag may be combined with DS_FILTER_PKT_xxx flags and affects the return value of pNumRead in DSFilterPacket() */
+  #define DS_FIND_PCAP_PACKET_USE_INDEX                 0x8000  /* build a pcap index on first use if no valid .sigidx sidecar file exists. See DSCreatePcapIndex() notes below, JHB Oct 2026 */
+
+/* DSCreatePcapIndex() creates a pcap index sidecar file for DSFindPcapPacket(). Notes, JHB Oct 2026:
+
+   -the index is built in one DSScanPcap() pass over szInputPcap (libpcap files larger than 16 MB are parsed in parallel ranges) and saved with the same name plus ".sigidx" (e.g. input.pcap.sigidx). Each entry holds record file offset and number, arrival time, 5-tuple, RTP SSRC, timestamp, and sequence number
+   -when a valid sidecar exists (pcap file size and modification time match) DSFindPcapPacket() uses it automatically, binary searching for offset_start, offset_end, and SSRC + RTP timestamp matches instead of reading the pcap. Return values and found offsets (record or DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET byte offsets) are the same as without an index
+   -alternatively DS_FIND_PCAP_PACKET_USE_INDEX can be given to DSFindPcapPacket() to build the index on first use
+   -only pcap and pcapng files are indexed. uFlags may include DS_OPEN_PCAP_QUIET
+   -return value is the number of packet records indexed, or < 0 for an error condition
+*/
+
+  int DSCreatePcapIndex(const char* szInputPcap, unsigned int uFlags);
+
+/* DSScanPcap() parses szInputPcap in byte ranges concurrently and calls a user callback for each record. Notes, JHB Oct 2026:
+
+   -libpcap files are split into up to num_threads ranges of at least 16 MB each (num_threads <= 0 specifies the number of online CPU cores, max 64). Each range after the first is resynchronized on a record boundary by checking a chain of record headers for plausible values (captured length <= snaplen and <= original length, valid usec, non-decreasing timestamps). pcapng and .rtp files are parsed as one range
+   -each range is parsed by its own thread and DS_OPEN_PCAP_MMAP handle, and range boundaries are verified after parsing. If a resync was wrong the following range is parsed again from the correct position, so results are always the same as a sequential pass
+   -callback is called for every record, including pcapng non-packet blocks (scan_rec->pkt is NULL for unused block types). Calls for the same range are in file order; calls for different ranges are concurrent, so callback should keep per-range results, for example in arrays indexed by range. Results merged in range order (0, 1, 2 ...) are in file order
+   -a callback with scan_rec NULL means results already given for that range should be discarded, either because the range is about to be parsed again or because of an error in an earlier range. A callback return value < 0 aborts the scan
+   -scan_rec->pkt points into the file mapping and is valid only during the callback
+   -uFlags may include DS_READ_PCAP_XXX flags. DS_READ_PCAP_COPY is ignored, scans always advance
+   -return value is the number of ranges, or < 0 for an error condition. If an error occurs, results for ranges up to and including the range where the error occurred are valid
+*/
+
+  typedef struct {
+
+    uint64_t       offset;        /* file offset of record */
+    uint32_t       length;        /* record length in file */
+    int            pkt_len;       /* packet length, same as DSReadPcapPtr() return value */
+    uint8_t*       pkt;           /* packet data, same as DSReadPcapPtr() *p_pkt */
+    uint16_t       eth_protocol;  /* ETH_P_XXX ethernet protocol, same as DSReadPcap() p_eth_protocol */
+    uint16_t       block_type;    /* block type, same as DSReadPcap() p_block_type */
+    pcaprec_hdr_t  pcap_rec_hdr;  /* record header */
+
+  } pcap_scan_rec_t;
+
+  typedef int (*PCAP_SCAN_CALLBACK)(int range, pcap_scan_rec_t* scan_rec, void* user_data);
+
+  int DSScanPcap(const char* szInputPcap, unsigned int uFlags, int num_threads, PCAP_SCAN_CALLBACK callback, void* user_data);
+
+/* DSGetPcapStats() returns record, packet, byte, time span, and protocol counts for szInputPcap using a DSScanPcap() pass. uFlags and num_threads are the same as DSScanPcap(). Return value is the number of ranges parsed, or < 0 for an error condition. Notes, JHB Oct 2026:
+
+   -IPv6 TCP and UDP counts use the IPv6 header next header field only, extension headers are not followed
+   -timestamps are in usec. pcapng simple packet blocks (SPBs) have no timestamp and are not included
+*/
+
+  typedef struct {
+
+    uint64_t  num_recs;         /* all records, including pcapng non-packet blocks */
+    uint64_t  num_pkts;         /* packet records */
+    uint64_t  num_bytes;        /* sum of packet record captured lengths */
+    uint64_t  first_timestamp;  /* earliest and latest packet arrival timestamps */
+    uint64_t  last_timestamp;
+    uint64_t  num_ipv4;
+    uint64_t  num_ipv6;
+    uint64_t  num_tcp;
+    uint64_t  num_udp;
+    uint64_t  num_other;        /* non-IP packets, e.g. ARP, 802.2, etc */
+    int       num_ranges;       /* number of ranges parsed concurrently */
+
+  } pcap_stats_t;
+
+  int DSGetPcapStats(const char* szInputPcap, unsigned int uFlags, int num_threads, pcap_stats_t* pcap_stats);
 
 /* DSConfigMediaService() -- start the SigSRF media service as a process or some number of packet/media threads. Notes:
 
@@ -1151,6 +1428,25 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
   int DSPushPackets(unsigned int uFlags, uint8_t pkt_buf[], int pkt_buf_len[], HSESSION* hSession, unsigned int numPkts);
   int DSPullPackets(unsigned int uFlags, uint8_t pkt_buf[], int pkt_buf_len[], HSESSION hSession, uint64_t* pktInfo, unsigned int pkt_max_buf_len, int numPkts);
 
+/* push/pull event notification APIs, JHB Oct 2026. Notes:
+
+  -packet/media threads call DSSignalPacketNotify() with DS_PKT_NOTIFY_OUTPUT when output packets are available to pull, and with DS_PKT_NOTIFY_INPUT_SPACE when packets have been dequeued from push queues. DS_PKT_NOTIFY_APP is available for application use, for example app thread sync
+  -to wait for an event, first call DSGetPacketNotifySeq(), then check the condition (e.g. DSPushPackets() returns queue full, or DSPullPackets() returns no packets), then call DSWaitPacketNotify() with the sequence number. A signal between the two calls is not lost; DSWaitPacketNotify() returns immediately
+  -DSWaitPacketNotify() returns 1 if the event was signaled, 0 on timeout, or -1 for an error condition. uEvent must be one DS_PKT_NOTIFY_xxx flag. Spurious returns are possible, callers should re-check their condition
+  -the timeout should be the same as the caller's polling interval without notification, so a missed signal does no worse than polling
+  -DSSignalPacketNotify() accepts one or more flags and returns the number of threads woken. With no waiters it does not make a system call
+  -source is in pktlib_notify.cpp (Linux futex based)
+*/
+
+  #define DS_PKT_NOTIFY_OUTPUT             1
+  #define DS_PKT_NOTIFY_INPUT_SPACE        2
+  #define DS_PKT_NOTIFY_APP                4
+  #define DS_PKT_NOTIFY_MAX_EVENTS         3
+
+  uint32_t DSGetPacketNotifySeq(unsigned int uEvent);
+  int DSWaitPacketNotify(unsigned int uEvent, uint32_t seq, unsigned int uTimeout_usec);
+  int DSSignalPacketNotify(unsigned int uEvents);
+
   int DSGetDebugInfo(unsigned int uFlags, int, int*, int*);  /* for internal use only */
 
   int DSDisplayThreadDebugInfo(uint64_t uThreadList, unsigned int uFlags, const char* userstr);
@@ -1528,6 +1824,10 @@ int DSPktRemoveFragment(uint8_t* pkt_buf, unsigned int uFlags, unsigned int* max
 #define DS_MEDIASERVICE_CMDLINE                        0x40000  /* use the szCmdLine param to specify cmd line arguments to create sessions, read/write pcap files, specify buffer add interval, etc. Can be combined with thread, process, or app flags */
 #define DS_MEDIASERVICE_PIN_THREADS                    0x80000
 #define DS_MEDIASERVICE_SET_NICENESS                  0x100000
+#define DS_MEDIASERVICE_SPIN_THEN_BLOCK               0x200000  /* in energy saver state, p/m threads spin briefly then block until DSPushPackets() pushes packets for one of their sessions, instead of sleeping uThreadEnergySaverSleepTime usec (see GLOBAL_CONFIG struct in config.h). Reduces idle CPU usage and wakeup latency. Wakeup stats are in PACKETMEDIATHREADINFO struct idle_xxx items */
+#define DS_MEDIASERVICE_REBALANCE_THREADS             0x400000  /* move sessions, or whole stream groups, from heavily loaded p/m threads to lightly loaded ones, based on PACKETMEDIATHREADINFO struct CPU_time_avg[] thread load. Migration stats are in PACKETMEDIATHREADINFO struct rebalance_xxx items. See RebalanceThreads() in packet_flow_media_proc.c */
+#define DS_MEDIASERVICE_BATCH_DECODE                  0x800000  /* p/m threads queue single frame RTP payloads during each loop iteration and decode them at the end of the iteration, using one multichannel DSCodecDecode() call for all frames with matching codec type and frame size. Stats are in PACKETMEDIATHREADINFO struct batch_decode_xxx items. See DecodeCodecBatch() in packet_flow_media_proc.c */
+#define DS_MEDIASERVICE_PIPELINE_DECODE              0x2000000  /* same as DS_MEDIASERVICE_BATCH_DECODE, and in addition each p/m thread starts a codec stage thread to decode queued frames while the p/m thread continues jitter buffer processing of remaining sessions. Stats are in PACKETMEDIATHREADINFO struct pipeline_xxx items. See HandOffCodecBatch() in packet_flow_media_proc.c */
 
 #define DS_MEDIASERVICE_ENABLE_THREAD_PROFILING      0x1000000
 #define DS_MEDIASERVICE_DISABLE_THREAD_PROFILING     0x1000001
@@ -38,6 +38,11 @@
    Modified Jul 2024 JHB, add nRandomBitErrorPercentage define to support mediaTest payload / packet impairment operations
    Modified Aug 2024 JHB, add sha1sum and sha512sum flags to CmdLineFlags_t
    Modified Feb 2025 JHB, remove references to MAX_CONCURRENT_STREAMS and MAXSTREAMS; instead all libs and apps are now using a single definition MAX_STREAMS, in shared_include/streamlib.h
+   Modified Oct 2026 JHB, add nInputStartTime and nInputStopTime defines to support --start_time and --stop_time cmd line options for mediaMin app
+   Modified Oct 2026 JHB, add nInputReadAheadDepth define to support --read_ahead cmd line option
+   Modified Oct 2026 JHB, add nPcapOutputCompression define to support --compress_output cmd line option
+   Modified Oct 2026 JHB, add nDuplicateLookback define to support --dup_lookback cmd line option
+   Modified Oct 2026 JHB, add nOutputWriterThreads define to support --output_writers cmd line option
 */
 
 #ifndef _USERINFO_H_
@@ -175,6 +180,12 @@ typedef struct UserInterface_t {
    #define   nLookbackDepth libFlags                  /* mediamin app usage of -l for RFC7198 lookback depth. Note default value of 1 if no entry, handled in getUserInfo() in get_user_interface.cpp, JHB May 2023 */
    #define   nCut detailsLevel
    #define   nRandomBitErrorPercentage algorithmIdNum
+   #define   nInputStartTime qpValues[0]              /* mediaMin app usage of --start_time cmd line entry, in msec. Video qpValues[] are not used by media apps, JHB Oct 2026 */
+   #define   nInputStopTime qpValues[1]               /* mediaMin app usage of --stop_time cmd line entry, in msec */
+   #define   nInputReadAheadDepth qpValues[2]         /* mediaMin app usage of --read_ahead cmd line entry */
+   #define   nPcapOutputCompression qpValues[3]       /* mediaMin app usage of --compress_output cmd line entry: 0 = none, 1 = gzip, 2 = zstd */
+   #define   nDuplicateLookback qpValues[4]           /* mediaMin app usage of --dup_lookback cmd line entry, -1 = no entry */
+   #define   nOutputWriterThreads qpValues[5]         /* mediaMin app usage of --output_writers cmd line entry */
 
 } UserInterface;
 
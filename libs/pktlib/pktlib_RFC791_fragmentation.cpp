@@ -44,12 +44,19 @@ Revision History
   Modified Nov 2024 JHB, update comments
   Modified Dec 2024 JHB, include <algorithm> and use std namespace; minmax.h no longer defines min-max if __cplusplus defined
   Modified Apr 2025 JHB, add check for UDP SIP duplicates in DSIsPacketDuplicate(). See comments about differentiating UDP and RTP payloads
+  Modified Oct 2026 JHB, replace per thread fragment linked list with a datagram hash table keyed on 3-way tuple and identifier, backed by a preallocated pool of fragment entries and buffers. Add datagram reassembly timeout eviction, eviction and pool exhaustion stats, and DSPktGetFragmentStats()
+  Modified Oct 2026 JHB, replace GetThreadIndex() spin-lock and App_Thread_Info[] search with thread-local per thread info, registered on first use and freed at thread exit. Removes the 128 thread limit
+  Modified Oct 2026 JHB, add DSPktReassembleIov() and DSPktReleaseReassembly() for zero-copy scatter-gather reassembly output; PktReassemble() now gathers from the same fragment descriptors
+  Modified Oct 2026 JHB, implement IPv6 fragmentation (Fragment extension header) reassembly, using the same datagram hash table and fragment pool as IPv4. Identifier is now 32-bit to hold IPv6 Identification field
+  Modified Oct 2026 JHB, add DSInitPacketDuplicateRing() and DSIsPacketDuplicateRing(), per stream duplicate detection using a lookback ring of packet fingerprints
 */
 
 /* Linux and/or other OS includes */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <pthread.h>
 
 #include <algorithm>
@@ -64,14 +71,26 @@ using namespace std;
 
 /* internal fragmentation functions and stats. Notes, JHB Jun 2024:
 
-   -fragments are managed as per app thread linked lists; a simple mem barrier lock coordinates critical section thread access and modification of App_Thread_Info[]. This method works as long as the caller has a unique thread Id; for example, p/m threads could also call DSGetPacketInfo() with fragmented packets
-   -each linked list fragment entry includes 3-way tuple info (protocol, IP src addr, IP dst addr), IP header identifier (Identification field), and fragment offset. See PKT_FRAGMENT struct in pktlib.h
-   -each linked list entry also includes packet info: flags, identifier, fragment offset, and saved IP header and packet data
-   -performance wise, the worst case is an app thread with a high number of streams each with large packets of size 4500 to 6000 bytes, in which case the thread's linked list length could grow to around N*3 or N*4, where N is number of streams
-   -theoretically performance could be improved by adding a per stream linked list (as a sub list under the thread list) based on the 3-way tuple, but that involves creating a unique key or hash for each tuple. That step is time-consuming, involving memcmp's of 30+ bytes, so potential performance gain is unclear at the expense of increase in coding complexity and maintenance resources **
-   -we maintain a "highest used location" (max_search_limit) to reduce search time for existing thread Ids. The search loop isn't doing much, just comparing 64-bit thread Id values
-   
-** I actually tried this in pktlib_new_frag_list.c ... I didn't get it completely working, some debug needed. But after seeing the amount of critical section code for the sub linked list, I put the effort on hold
+   -fragments are managed per app thread; any thread can call DSGetPacketInfo() with fragmented packets, for example p/m threads. See "per thread fragment state" notes below
+   -each fragment entry includes 3-way tuple info (protocol, IP src addr, IP dst addr), IP header identifier (Identification field), and fragment offset. See PKT_FRAGMENT struct in pktlib.h
+   -each fragment entry also includes packet info: flags, identifier, fragment offset, and saved IP header and packet data
+
+   Hash table and fragment pool notes, JHB Oct 2026:
+
+   -a per thread fragment list, walked linearly on every add, find, status, and reassembly call, degraded quadratically with SIP/SDP fragment storms and large TSO captures. Fragments are now grouped by datagram; each datagram is uniquely identified by its 3-way tuple and identifier, and datagrams are found with a hash table of PKT_FRAG_HASH_SIZE buckets. Add, find, status, and reassembly calls only walk fragments of one datagram
+   -fragment entries and their buffers come from a per thread pool of PKT_FRAG_POOL_SIZE entries, each with a fixed size PKT_FRAG_BUF_SIZE buffer (enough for standard MTU fragments), allocated on the thread's first fragment. Fragments too large for a pool buffer (e.g. jumbo frames) use malloc() as before
+   -datagrams not fully reassembled within PKT_FRAG_TIMEOUT_USEC (RFC 791 reassembly timer, wall clock time) are evicted along with their fragments. If the fragment pool or datagram table is full, the oldest datagram is evicted to make room. Eviction and pool exhaustion counts are returned by DSPktGetFragmentStats()
+
+   Scatter-gather reassembly notes, JHB Oct 2026:
+
+   -DSPktReassembleIov() returns a reassembled datagram as an iovec list pointing into saved fragment buffers (first fragment IP header, then fragment data in offset order) instead of copying into a contiguous packet buffer. The datagram is removed from the hash table but its fragments are held as the thread's "pending reassembly" until the thread's next reassembly call or DSPktReleaseReassembly(), so the iovec list remains valid while the caller inspects it
+   -PktReassemble() (DSGetPacketInfo() with DS_PKT_INFO_REASSEMBLY_GET_PACKET) gathers the same iovec list into the caller's buffer and releases it immediately
+
+   IPv6 notes, JHB Oct 2026:
+
+   -IPv6 fragments are identified by a Fragment extension header (RFC 8200 section 4.5), found after any Hop-by-Hop, Routing, and Destination Options headers. get_ipv6_frag_hdr() walks the extension header chain
+   -3-way tuple protocol is the Fragment header Next Header (upper layer protocol), identifier is the 32-bit Identification field, and fragment offset and M flag are in the same 8-byte units and meaning as IPv4
+   -the saved "IP header" of an IPv6 fragment is the unfragmentable part (IPv6 header and extension headers before the Fragment header) plus the Fragment header. On reassembly the Fragment header is removed, the preceding Next Header field is set to the Fragment header Next Header, and Payload Length is updated
 */
 
 #ifdef __cplusplus
@@ -89,77 +108,92 @@ int PktReassemble(uint8_t* pkt, unsigned int uFlags);
 
 //#define FRAGMENTATION_DEBUG
 
-#define MAX_APP_THREADS 128
+#define PKT_FRAG_HASH_SIZE      512        /* number of datagram hash buckets per thread, must be a power of 2 */
+#define PKT_FRAG_MAX_DATAGRAMS  256        /* max datagrams being reassembled per thread */
+#define PKT_FRAG_POOL_SIZE      1024       /* number of preallocated fragment entries and buffers per thread */
+#define PKT_FRAG_BUF_SIZE       1536       /* fragment buffer size, holds IP header and fragment data */
+#define PKT_FRAG_TIMEOUT_USEC   30000000   /* datagram reassembly timeout, same as Linux ipfrag_time default */
 
-typedef struct {
+typedef struct PKT_FRAG_DATAGRAM {
 
-   pthread_t      ThreadId;               /* unique thread Id */
-   PKT_FRAGMENT*  pPktFragmentList;       /* per thread packet fragment list */
-   int            total_fragment_count;   /* total fragments handled by the app thread */
-   int            active_fragment_count;  /* fragments currently active at any one time. DSPktRemoveFragment() can be called by an app thread during cleanup to get number of "orphan" fragments remaining on the thread's linked list */
-   int            max_fragment_count;     /* max active fragments on the thread's link list */
+   uint8_t            protocol;         /* 3-way tuple and identifier, used as hash key */
+   unsigned __int128  ip_src_addr;
+   unsigned __int128  ip_dst_addr;
+   uint32_t           identifier;       /* 32-bit to hold IPv6 Identification field, JHB Oct 2026 */
 
-} APP_THREAD_INFO;
+   PKT_FRAGMENT*      pFragmentList;    /* datagram's fragments, in any order */
+   uint64_t           create_time;      /* time of first fragment, in usec */
 
-static APP_THREAD_INFO App_Thread_Info[MAX_APP_THREADS] = {{ 0 }};
-static int max_search_limit = 0;
+   struct PKT_FRAG_DATAGRAM* hash_next;  /* next datagram in hash bucket, or next free datagram */
+   struct PKT_FRAG_DATAGRAM* age_prev;   /* datagram age list, oldest first */
+   struct PKT_FRAG_DATAGRAM* age_next;
 
-static uint8_t app_thread_lock = 0;  /* mem barrier lock used for app thread synchronization */
+} PKT_FRAG_DATAGRAM;
 
-/* local static APIs */
+typedef struct {
 
-static int GetThreadIndex(bool fDelete) {  /* get thread Id index; create if not existing yet */
+   PKT_FRAG_DATAGRAM*  hash[PKT_FRAG_HASH_SIZE];
+   PKT_FRAG_DATAGRAM   datagrams[PKT_FRAG_MAX_DATAGRAMS];
+   PKT_FRAG_DATAGRAM*  pFreeDatagrams;
+   PKT_FRAG_DATAGRAM*  pOldest;           /* age list head and tail */
+   PKT_FRAG_DATAGRAM*  pNewest;
 
-int i;
+   PKT_FRAGMENT        fragments[PKT_FRAG_POOL_SIZE];
+   PKT_FRAGMENT*       pFreeFragments;
+   uint8_t*            bufs;              /* PKT_FRAG_POOL_SIZE buffers of PKT_FRAG_BUF_SIZE bytes; fragments[i] uses buffer i */
 
-/* start critical section. Section is short and conflict with other threads will be rare */
+   PKT_FRAG_DATAGRAM*  pReassembled;      /* datagram returned by DSPktReassembleIov(), removed from hash table and age list; its fragments are held until released, JHB Oct 2026 */
 
-   while (__sync_lock_test_and_set(&app_thread_lock, 1) != 0);  /* set a memory barrier to coordinate concurrent app thread access to App_Thread_Info[]. __sync_lock_test_and_set() does atomic test and write 1. Repeat until lock is zero; i.e. no other thread has the lock (https://gcc.gnu.org/onlinedocs/gcc-4.1.0/gcc/Atomic-Builtins.html) */
+} PKT_FRAG_TABLE;
 
-   for (i=0; i<max_search_limit; i++) if (App_Thread_Info[i].ThreadId == pthread_self()) {  /* look for existing thread id */
+typedef struct {
 
-      if (fDelete) App_Thread_Info[i].ThreadId = 0;  /* delete if requested */
-      goto exit;
-   }
+   pthread_t        ThreadId;               /* unique thread Id */
+   PKT_FRAG_TABLE*  pFragTable;             /* per thread datagram hash table and fragment pool, allocated on first use, JHB Oct 2026 */
+   int              total_fragment_count;   /* total fragments handled by the app thread */
+   int              active_fragment_count;  /* fragments currently active at any one time. DSPktRemoveFragment() can be called by an app thread during cleanup to get number of "orphan" fragments remaining */
+   int              max_fragment_count;     /* max active fragments */
+   unsigned int     timeout_evictions;      /* datagrams evicted after PKT_FRAG_TIMEOUT_USEC, JHB Oct 2026 */
+   unsigned int     pool_evictions;         /* datagrams evicted to make room for new fragments */
+   unsigned int     pool_exhausted;         /* number of times fragment pool or datagram table was full */
+   unsigned int     oversize_fragments;     /* fragments too large for a pool buffer */
 
-   if (i == max_search_limit) {  /* create if not found */
+} APP_THREAD_INFO;
 
-      for (i=0; i<MAX_APP_THREADS; i++) if (App_Thread_Info[i].ThreadId == 0) {  /* find first available index */
+/* inline helper functions for PktXxxFragment() functions */
 
-         App_Thread_Info[i].ThreadId = pthread_self();  /* initialize the new index */
-         max_search_limit = max(max_search_limit, i+1);  /* adjust max search limit */
-         #if 0
-         printf("\n *** creating linked list node, max_search_limit = %d \n", max_search_limit);
-         #endif
-         goto exit;
-      }
-   }
+static inline int get_ipv6_frag_hdr(uint8_t* pkt, int* nh_ofs, unsigned int uFlags) {  /* return offset of IPv6 Fragment header, or 0 if none. If nh_ofs is not NULL, return offset of the Next Header field that points to the Fragment header, JHB Oct 2026 */
 
-   if (i >= MAX_APP_THREADS) i = -1;  /* return error condition - too many app threads */
+int pkt_len = 40 + ((uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (pkt[5] << 8) | pkt[4] : (pkt[4] << 8) | pkt[5]);  /* fixed header plus Payload Length */
+int ofs = 40, prev_ofs = 6;
+uint8_t next_hdr = pkt[6];
 
-exit:
-/* end critical section */
-   __sync_lock_release(&app_thread_lock);  /* clear the mem barrier (write 0 to the lock) */
-   return i;  /* return thread Id index */
-}
+   while (next_hdr == HOPOPT || next_hdr == IPv6_Route || next_hdr == IPv6_Opts) {  /* skip extension headers that can precede a Fragment header */
 
-__attribute__ ((unused)) static int DeleteThreadIndex(void) {  /* delete thread index (currently unused) */
+      if (ofs + 8 > pkt_len) return 0;
 
-   return GetThreadIndex(true);
-}
+      prev_ofs = ofs;
+      next_hdr = pkt[ofs];
+      ofs += (pkt[ofs+1] + 1)*8;  /* Hdr Ext Len is in 8-byte units, not including first 8 bytes */
+   }
 
-/* inline helper functions for PktXxxFragment() functions */
+   if (next_hdr != IPv6_Frag || ofs + 8 > pkt_len) return 0;
+
+   if (nh_ofs) *nh_ofs = prev_ofs;
+
+   return ofs;
+}
 
 static inline void get_3way_tuple(uint8_t* pkt, uint8_t* protocol, unsigned __int128* ip_src_addr, unsigned __int128* ip_dst_addr, unsigned int uFlags) {
 
   if (pkt) {
 
-      if (protocol) *protocol = pkt[9];
-
       uint8_t version = pkt[0] >> 4;
 
       if (version == IPv4) {
 
+         if (protocol) *protocol = pkt[9];
+
          if (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) memcpy(ip_src_addr, &pkt[12], 4);  /* copy src IP addr */
          else { uint32_t* p32 = (uint32_t*)ip_src_addr; *p32 = ((uint32_t)pkt[12] << 24) | ((uint32_t)pkt[13] << 16) | ((uint32_t)pkt[14] << 8) | (uint32_t)pkt[15]; }
 
@@ -168,106 +202,406 @@ static inline void get_3way_tuple(uint8_t* pkt, uint8_t* protocol, unsigned __in
       }
       else if (version == IPv6) {  /* IPv6 addresses are always in host byte order (https://www.gnu.org/software/guile/manual/html_node/Network-Address-Conversion.html) */
  
+         if (protocol) { int frag_ofs = get_ipv6_frag_hdr(pkt, NULL, uFlags); *protocol = frag_ofs ? pkt[frag_ofs] : pkt[6]; }  /* upper layer protocol is Fragment header Next Header, JHB Oct 2026 */
+
          memcpy(ip_src_addr, &pkt[8], 16);  /* copy src IP addr */
          memcpy(ip_dst_addr, &pkt[24], 16);  /* copy dst IP addr */
       }
    }
 }
 
-static inline void get_identifier_and_offset(uint8_t* pkt, uint16_t* identifier, uint16_t* fragment_offset, unsigned int uFlags) {
+static inline void get_identifier_and_offset(uint8_t* pkt, uint32_t* identifier, uint16_t* fragment_offset, unsigned int uFlags) {
+
+   if (!pkt) return;
+
+   if ((pkt[0] >> 4) == IPv6) {  /* IPv6 Identification and Fragment Offset are in the Fragment header, JHB Oct 2026 */
 
-  if (pkt && identifier) *identifier = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (pkt[5] << 8) | pkt[4] : (pkt[4] << 8) | pkt[5];
+      int frag_ofs = get_ipv6_frag_hdr(pkt, NULL, uFlags);
+      uint8_t* p = &pkt[frag_ofs];
 
-  if (pkt && fragment_offset) *fragment_offset = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? ((pkt[7] & 0x1f) << 8) | pkt[6] : ((pkt[6] & 0x1f) << 8) | pkt[7];
+      if (!frag_ofs) { if (identifier) *identifier = 0; if (fragment_offset) *fragment_offset = 0; return; }
+
+      if (identifier) *identifier = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? ((uint32_t)p[7] << 24) | ((uint32_t)p[6] << 16) | ((uint32_t)p[5] << 8) | p[4] : ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | ((uint32_t)p[6] << 8) | p[7];
+
+      if (fragment_offset) *fragment_offset = ((uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (p[3] << 8) | p[2] : (p[2] << 8) | p[3]) >> 3;
+
+      return;
+   }
+
+   if (identifier) *identifier = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (pkt[5] << 8) | pkt[4] : (pkt[4] << 8) | pkt[5];
+
+   if (fragment_offset) *fragment_offset = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? ((pkt[7] & 0x1f) << 8) | pkt[6] : ((pkt[6] & 0x1f) << 8) | pkt[7];
+}
+
+static inline bool get_more_fragments(uint8_t* pkt, unsigned int uFlags) {  /* return MF flag (IPv4) or M flag (IPv6 Fragment header), JHB Oct 2026 */
+
+   if ((pkt[0] >> 4) == IPv6) {
+
+      int frag_ofs = get_ipv6_frag_hdr(pkt, NULL, uFlags);
+
+      return frag_ofs && (pkt[frag_ofs + ((uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 2 : 3)] & 1);
+   }
+
+   return (pkt[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 7 : 6] >> 5) & 1;
+}
+
+/* datagram hash table and fragment pool helpers, JHB Oct 2026 */
+
+static inline uint64_t frag_time_usec(void) {
+
+struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec*1000000 + ts.tv_nsec/1000;
+}
+
+static inline unsigned int frag_hash(uint8_t protocol, unsigned __int128 ip_src_addr, unsigned __int128 ip_dst_addr, uint32_t identifier) {
+
+uint64_t key = (uint64_t)ip_src_addr ^ (uint64_t)(ip_src_addr >> 64) ^ (((uint64_t)ip_dst_addr ^ (uint64_t)(ip_dst_addr >> 64)) * 0x100000001b3ULL) ^ ((uint64_t)identifier << 24) ^ ((uint64_t)protocol << 56);
+
+   return (unsigned int)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (PKT_FRAG_HASH_SIZE-1);  /* multiplicative hash, upper bits are best mixed */
+}
+
+static PKT_FRAG_TABLE* GetFragTable(APP_THREAD_INFO* pThreadInfo) {  /* get thread's hash table and fragment pool, create on first use */
+
+PKT_FRAG_TABLE* pTable;
+int i;
+
+   if (!pThreadInfo) return NULL;
+
+   if ((pTable = pThreadInfo->pFragTable)) return pTable;
+
+   if (!(pTable = (PKT_FRAG_TABLE*)calloc(1, sizeof(PKT_FRAG_TABLE)))) return NULL;
+
+   if (!(pTable->bufs = (uint8_t*)malloc(PKT_FRAG_POOL_SIZE*PKT_FRAG_BUF_SIZE))) { free(pTable); return NULL; }
+
+   for (i=PKT_FRAG_POOL_SIZE-1; i>=0; i--) { pTable->fragments[i].next = pTable->pFreeFragments; pTable->pFreeFragments = &pTable->fragments[i]; }  /* build free lists */
+   for (i=PKT_FRAG_MAX_DATAGRAMS-1; i>=0; i--) { pTable->datagrams[i].hash_next = pTable->pFreeDatagrams; pTable->pFreeDatagrams = &pTable->datagrams[i]; }
+
+   pThreadInfo->pFragTable = pTable;
+
+   return pTable;
+}
+
+static PKT_FRAG_DATAGRAM* FindDatagram(PKT_FRAG_TABLE* pTable, uint8_t protocol, unsigned __int128 ip_src_addr, unsigned __int128 ip_dst_addr, uint32_t identifier) {
+
+PKT_FRAG_DATAGRAM* pDatagram = pTable ? pTable->hash[frag_hash(protocol, ip_src_addr, ip_dst_addr, identifier)] : NULL;
+
+   while (pDatagram) {
+
+      if (identifier == pDatagram->identifier && protocol == pDatagram->protocol && ip_src_addr == pDatagram->ip_src_addr && ip_dst_addr == pDatagram->ip_dst_addr) return pDatagram;  /* 3-way tuple and identifier have to match */
+
+      pDatagram = pDatagram->hash_next;
+   }
+
+   return NULL;
+}
+
+static void FreeFragment(PKT_FRAG_TABLE* pTable, PKT_FRAGMENT* pFrag) {
+
+   if (pFrag->ip_hdr_buf != &pTable->bufs[(pFrag - pTable->fragments)*PKT_FRAG_BUF_SIZE]) free(pFrag->ip_hdr_buf);  /* oversize fragment buffer was malloc'd */
+
+   pFrag->next = pTable->pFreeFragments;
+   pTable->pFreeFragments = pFrag;
+}
+
+static void UnlinkDatagram(PKT_FRAG_TABLE* pTable, PKT_FRAG_DATAGRAM* pDatagram) {  /* remove datagram from hash table and age list */
+
+PKT_FRAG_DATAGRAM** ppDatagram = &pTable->hash[frag_hash(pDatagram->protocol, pDatagram->ip_src_addr, pDatagram->ip_dst_addr, pDatagram->identifier)];
+
+   while (*ppDatagram && *ppDatagram != pDatagram) ppDatagram = &(*ppDatagram)->hash_next;
+   if (*ppDatagram) *ppDatagram = pDatagram->hash_next;
+
+   if (pDatagram->age_prev) pDatagram->age_prev->age_next = pDatagram->age_next;
+   else pTable->pOldest = pDatagram->age_next;
+   if (pDatagram->age_next) pDatagram->age_next->age_prev = pDatagram->age_prev;
+   else pTable->pNewest = pDatagram->age_prev;
+}
+
+static int ReleaseDatagram(PKT_FRAG_TABLE* pTable, PKT_FRAG_DATAGRAM* pDatagram, APP_THREAD_INFO* pThreadInfo) {  /* free an unlinked datagram's fragments and return datagram to the free list, return number of fragments freed */
+
+PKT_FRAGMENT* pFrag;
+int nFreed = 0;
+
+   while ((pFrag = pDatagram->pFragmentList)) {
+
+      pDatagram->pFragmentList = pFrag->next;
+      FreeFragment(pTable, pFrag);
+      nFreed++;
+   }
+
+   pThreadInfo->active_fragment_count -= nFreed;
+
+   pDatagram->hash_next = pTable->pFreeDatagrams;
+   pTable->pFreeDatagrams = pDatagram;
+
+   return nFreed;
+}
+
+static int FreeDatagram(PKT_FRAG_TABLE* pTable, PKT_FRAG_DATAGRAM* pDatagram, APP_THREAD_INFO* pThreadInfo) {  /* remove datagram from hash table and age list, free its fragments, return number of fragments freed */
+
+   UnlinkDatagram(pTable, pDatagram);
+
+   return ReleaseDatagram(pTable, pDatagram, pThreadInfo);
+}
+
+static int ReleaseReassembled(PKT_FRAG_TABLE* pTable, APP_THREAD_INFO* pThreadInfo) {  /* free pending reassembly held for DSPktReassembleIov() caller, if any */
+
+int nFreed = 0;
+
+   if (pTable && pTable->pReassembled) {
+
+      nFreed = ReleaseDatagram(pTable, pTable->pReassembled, pThreadInfo);
+      pTable->pReassembled = NULL;
+   }
+
+   return nFreed;
+}
+
+static void EvictDatagrams(PKT_FRAG_TABLE* pTable, APP_THREAD_INFO* pThreadInfo, uint64_t cur_time) {  /* evict datagrams older than the reassembly timeout. Age list is in creation order, so we stop at the first datagram not timed out */
+
+   while (pTable->pOldest && cur_time - pTable->pOldest->create_time > PKT_FRAG_TIMEOUT_USEC) {
+
+      #ifdef FRAGMENTATION_DEBUG
+      printf("\n *** evicting timed out datagram, identifier = %u \n", pTable->pOldest->identifier);
+      #endif
+
+      FreeDatagram(pTable, pTable->pOldest, pThreadInfo);
+      pThreadInfo->timeout_evictions++;
+   }
+}
+
+static bool EvictOldestDatagram(PKT_FRAG_TABLE* pTable, APP_THREAD_INFO* pThreadInfo, PKT_FRAG_DATAGRAM* pKeep) {  /* make room when fragment pool or datagram table is full. pKeep is the datagram currently being added to, if any */
+
+PKT_FRAG_DATAGRAM* pDatagram = pTable->pOldest;
+
+   pThreadInfo->pool_exhausted++;
+
+   if (pDatagram == pKeep) pDatagram = pDatagram->age_next;
+   if (!pDatagram) return false;  /* nothing to evict, pKeep is using the whole pool */
+
+   FreeDatagram(pTable, pDatagram, pThreadInfo);
+   pThreadInfo->pool_evictions++;
+
+   return true;
+}
+
+/* per thread fragment state. Notes, JHB Oct 2026:
+
+   -each thread's APP_THREAD_INFO is allocated on the thread's first fragmentation API call (RegisterThreadInfo()) and found with a thread-local pointer, so lookup is lock-free and O(1) and there is no limit on number of threads. Previously GetThreadIndex() took a global spin-lock and searched a fixed App_Thread_Info[] array (max 128 threads) by thread Id on every call
+   -registration also constructs a thread_local cleanup object; its destructor runs at thread exit and frees the thread's remaining fragments, fragment pool, and APP_THREAD_INFO (FreeThreadInfo()). pthread_key_create() is not used, see comments in diaglib event_logging.cpp
+*/
+
+static __thread APP_THREAD_INFO* pAppThreadInfo = NULL;
+
+static void FreeThreadInfo(void) {
+
+APP_THREAD_INFO* pThreadInfo = pAppThreadInfo;
+PKT_FRAG_TABLE* pTable;
+
+   if (!pThreadInfo) return;
+
+   if ((pTable = pThreadInfo->pFragTable)) {
+
+      while (pTable->pOldest) FreeDatagram(pTable, pTable->pOldest, pThreadInfo);  /* free orphan fragments, including malloc'd oversize fragment buffers */
+      ReleaseReassembled(pTable, pThreadInfo);
+
+      free(pTable->bufs);
+      free(pTable);
+   }
+
+   free(pThreadInfo);
+   pAppThreadInfo = NULL;
+}
+
+typedef struct FRAG_THREAD_CLEANUP {
+
+   ~FRAG_THREAD_CLEANUP() { FreeThreadInfo(); }  /* thread exit hook */
+
+} FRAG_THREAD_CLEANUP;
+
+static thread_local FRAG_THREAD_CLEANUP Frag_Thread_Cleanup;
+
+static APP_THREAD_INFO* RegisterThreadInfo(void) {  /* create current thread's info and register its cleanup */
+
+   if (!(pAppThreadInfo = (APP_THREAD_INFO*)calloc(1, sizeof(APP_THREAD_INFO)))) return NULL;
+
+   pAppThreadInfo->ThreadId = pthread_self();
+
+   (void)&Frag_Thread_Cleanup;  /* first use in a thread constructs its thread_local cleanup object and registers the destructor to run at thread exit */
+
+   #if 0
+   printf("\n *** registering fragment thread info, thread id = %lu \n", (unsigned long)pAppThreadInfo->ThreadId);
+   #endif
+
+   return pAppThreadInfo;
+}
+
+static inline APP_THREAD_INFO* GetThreadInfo(void) {  /* get current thread's info; create if not existing yet */
+
+   return pAppThreadInfo ? pAppThreadInfo : RegisterThreadInfo();
 }
 
 /* private fragment management APIs */
 
-/* add packet fragment to app thread's fragment list */
+/* add packet fragment to app thread's datagram hash table */
 
 int PktAddFragment(uint8_t* pkt, unsigned int uFlags) {
 
    if (!pkt) return -1;  /* error condition */
 
-/* allocate linked list fragment struct mem */
+/* get current thread's info and hash table. If not existing GetThreadInfo() and GetFragTable() will create new ones */
 
-   PKT_FRAGMENT* pPktFrag = (PKT_FRAGMENT*)calloc(1, sizeof(PKT_FRAGMENT));  /* create new fragment list item, initialize all items to zero (especially fragment list head and IP src/dst addrs) */
+   APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+   PKT_FRAG_TABLE* pTable = GetFragTable(pThreadInfo);
 
-   if (!pPktFrag) return -1;  /* error condition */
-
-/* populate fields of new fragment struct */
+   if (!pTable) return -1;  /* error condition */
 
 /* protocol + IP src addr + IP dst addr form a 3-way tuple used to uniquely identify stream / connection between endpoints. This prevents potential confusion of Identifiers (16-bit Identification field) between streams, especially after long durations where 16-bit Ids may wrap. Mentioned in RFCs 6864 and 6146 */
 
-   get_3way_tuple(pkt, &pPktFrag->protocol, &pPktFrag->ip_src_addr, &pPktFrag->ip_dst_addr, uFlags);
-   get_identifier_and_offset(pkt, &pPktFrag->identifier, &pPktFrag->offset, uFlags);
+   uint8_t protocol = 0;
+   unsigned __int128 ip_src_addr = 0, ip_dst_addr = 0;  /* be sure to init IP addrs to zero as IPv4 uses only 4 out of 16 bytes */
+   uint32_t identifier = 0;
+   uint16_t fragment_offset = 0;
+   int ip_hdr_len, pkt_len;
 
-   pPktFrag->flags = ((pkt[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 7 : 6] >> 5) & 1) ? DS_PKT_FRAGMENT_MF : 0;
-   if (pPktFrag->offset) pPktFrag->flags |= DS_PKT_FRAGMENT_OFS;
+   get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
+   get_identifier_and_offset(pkt, &identifier, &fragment_offset, uFlags);
 
-/* save packet header and payload */
+   if ((pkt[0] >> 4) == IPv6) {  /* for IPv6 the saved header includes extension headers up to and including the Fragment header, JHB Oct 2026 */
 
-   int ip_hdr_len = DSGetPacketInfo(-1, (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) | DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_HDRLEN, pkt, -1, NULL, NULL);  /* may be a recursive call (if caller is DSGetPacketInfo()) but not a problem if uFlags does not include fragment or PKTINFO related flags */
-   int pkt_len = DSGetPacketInfo(-1, (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) | DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt, -1, NULL, NULL);
+      int frag_ofs = get_ipv6_frag_hdr(pkt, NULL, uFlags);
+      if (!frag_ofs) return -1;  /* not an IPv6 fragment */
+
+      ip_hdr_len = frag_ofs + 8;
+      pkt_len = 40 + ((uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (pkt[5] << 8) | pkt[4] : (pkt[4] << 8) | pkt[5]);
+   }
+   else {
+      ip_hdr_len = DSGetPacketInfo(-1, (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) | DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_HDRLEN, pkt, -1, NULL, NULL);  /* may be a recursive call (if caller is DSGetPacketInfo()) but not a problem if uFlags does not include fragment or PKTINFO related flags */
+      pkt_len = DSGetPacketInfo(-1, (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) | DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt, -1, NULL, NULL);
+   }
 
    if (ip_hdr_len <= 0 || pkt_len <= 0) return -1;
 
-   if (!(pPktFrag->pkt_buf = (uint8_t*)malloc(pkt_len))) return -1;
-   if (!(pPktFrag->ip_hdr_buf = (uint8_t*)malloc(ip_hdr_len))) return -1;
+/* evict timed out datagrams, then find or create this fragment's datagram */
 
-/* save IP header info in fragment list entry. Technically only the first fragment (with offset 0) needs to be copied but we can receive fragments out-of-order, so we give PktReassemble() all info it might need at time of reassembly */
+   uint64_t cur_time = frag_time_usec();
 
-   pPktFrag->ip_hdr_len = ip_hdr_len;
-   memcpy(pPktFrag->ip_hdr_buf, pkt, pPktFrag->ip_hdr_len);
+   EvictDatagrams(pTable, pThreadInfo, cur_time);
 
-/* save packet data in fragment list entry */
+   PKT_FRAG_DATAGRAM* pDatagram = FindDatagram(pTable, protocol, ip_src_addr, ip_dst_addr, identifier);
+   bool fNewDatagram = !pDatagram;
 
-   pPktFrag->len = pkt_len - ip_hdr_len;
-   memcpy(pPktFrag->pkt_buf, &pkt[ip_hdr_len], pPktFrag->len);
+   if (fNewDatagram) {
 
-/* get App_Thread_Info[] index for current thread. If not existing GetThreadIndex() will create a new one */
+      if (!pTable->pFreeDatagrams && !EvictOldestDatagram(pTable, pThreadInfo, NULL)) return -1;
 
-   int thread_index = GetThreadIndex(false), list_count = 1;
+      pDatagram = pTable->pFreeDatagrams;
+      pTable->pFreeDatagrams = pDatagram->hash_next;
 
-   #ifdef FRAGMENTATION_DEBUG
-   printf("\n *** inside pkt_frag_add, active fragments = %d, flags = 0x%x, identifier = %d, offset = %d, pkt len = %d \n", App_Thread_Info[thread_index].active_fragment_count, pPktFrag->flags, pPktFrag->identifier, pPktFrag->offset, pPktFrag->len);
-   #endif
+      pDatagram->protocol = protocol;
+      pDatagram->ip_src_addr = ip_src_addr;
+      pDatagram->ip_dst_addr = ip_dst_addr;
+      pDatagram->identifier = identifier;
+      pDatagram->pFragmentList = NULL;
+      pDatagram->create_time = cur_time;
 
-   if (!App_Thread_Info[thread_index].pPktFragmentList) App_Thread_Info[thread_index].pPktFragmentList = pPktFrag;  /* empty list: add as first fragment */
-   else {
+      unsigned int hash_index = frag_hash(protocol, ip_src_addr, ip_dst_addr, identifier);
+      pDatagram->hash_next = pTable->hash[hash_index];  /* add to hash bucket */
+      pTable->hash[hash_index] = pDatagram;
+
+      pDatagram->age_prev = pTable->pNewest;  /* add to end of age list */
+      pDatagram->age_next = NULL;
+      if (pTable->pNewest) pTable->pNewest->age_next = pDatagram;
+      else pTable->pOldest = pDatagram;
+      pTable->pNewest = pDatagram;
+   }
+
+/* get fragment entry from pool */
+
+   if (!pTable->pFreeFragments && !EvictOldestDatagram(pTable, pThreadInfo, pDatagram)) {
+      if (fNewDatagram) FreeDatagram(pTable, pDatagram, pThreadInfo);  /* don't leave an empty datagram in the hash table until timeout */
+      return -1;
+   }
+
+   PKT_FRAGMENT* pPktFrag = pTable->pFreeFragments;
+   pTable->pFreeFragments = pPktFrag->next;
+
+/* populate fields of new fragment struct */
 
-      PKT_FRAGMENT* pList = App_Thread_Info[thread_index].pPktFragmentList;
+   pPktFrag->protocol = protocol;
+   pPktFrag->ip_src_addr = ip_src_addr;
+   pPktFrag->ip_dst_addr = ip_dst_addr;
+   pPktFrag->identifier = identifier;
+   pPktFrag->offset = fragment_offset;
 
-      while (pList->next) { pList = pList->next; list_count++; }  /* find end of list, count number of list nodes */
+   pPktFrag->flags = get_more_fragments(pkt, uFlags) ? DS_PKT_FRAGMENT_MF : 0;
+   if (pPktFrag->offset) pPktFrag->flags |= DS_PKT_FRAGMENT_OFS;
+
+/* save packet header and payload. Pool buffers hold IP header followed by fragment data; fragments too large for a pool buffer are malloc'd */
 
-      pList->next = pPktFrag;  /* add to end of list */
+   if (pkt_len <= PKT_FRAG_BUF_SIZE) pPktFrag->ip_hdr_buf = &pTable->bufs[(pPktFrag - pTable->fragments)*PKT_FRAG_BUF_SIZE];
+   else if ((pPktFrag->ip_hdr_buf = (uint8_t*)malloc(pkt_len))) pThreadInfo->oversize_fragments++;
+   else {
+      pPktFrag->ip_hdr_buf = &pTable->bufs[(pPktFrag - pTable->fragments)*PKT_FRAG_BUF_SIZE];  /* return entry to pool */
+      FreeFragment(pTable, pPktFrag);
+      if (fNewDatagram) FreeDatagram(pTable, pDatagram, pThreadInfo);  /* don't leave an empty datagram in the hash table until timeout */
+      return -1;
    }
 
-   App_Thread_Info[thread_index].active_fragment_count++;  /* increment fragment counts */
-   App_Thread_Info[thread_index].total_fragment_count++;
+   pPktFrag->pkt_buf = &pPktFrag->ip_hdr_buf[ip_hdr_len];
+
+/* save IP header info in fragment entry. Technically only the first fragment (with offset 0) needs to be copied but we can receive fragments out-of-order, so we give PktReassemble() all info it might need at time of reassembly */
+
+   pPktFrag->ip_hdr_len = ip_hdr_len;
+   memcpy(pPktFrag->ip_hdr_buf, pkt, pPktFrag->ip_hdr_len);
+
+/* save packet data in fragment entry */
+
+   pPktFrag->len = pkt_len - ip_hdr_len;
+   memcpy(pPktFrag->pkt_buf, &pkt[ip_hdr_len], pPktFrag->len);
+
+   #ifdef FRAGMENTATION_DEBUG
+   printf("\n *** inside pkt_frag_add, active fragments = %d, flags = 0x%x, identifier = %u, offset = %d, pkt len = %d \n", pThreadInfo->active_fragment_count, pPktFrag->flags, pPktFrag->identifier, pPktFrag->offset, pPktFrag->len);
+   #endif
+
+   pPktFrag->next = pDatagram->pFragmentList;  /* add to datagram's fragment list */
+   pDatagram->pFragmentList = pPktFrag;
 
-   if (list_count > App_Thread_Info[thread_index].max_fragment_count) App_Thread_Info[thread_index].max_fragment_count = list_count;  /* update max_fragment_count */
+   pThreadInfo->active_fragment_count++;  /* increment fragment counts */
+   pThreadInfo->total_fragment_count++;
 
-   return DS_PKT_INFO_RETURN_FRAGMENT | DS_PKT_INFO_RETURN_FRAGMENT_SAVED;  /* return applicable DS_PKT_INFO_RETURN_xxx flags. To-do: add error checking, what can go wrong here */
+   if (pThreadInfo->active_fragment_count > pThreadInfo->max_fragment_count) pThreadInfo->max_fragment_count = pThreadInfo->active_fragment_count;  /* update max_fragment_count */
+
+   return DS_PKT_INFO_RETURN_FRAGMENT | DS_PKT_INFO_RETURN_FRAGMENT_SAVED;  /* return applicable DS_PKT_INFO_RETURN_xxx flags */
 }
 
-/* walk app thread's fragment list and look for existing fragment, uniquely identified by Identification field and fragment offset */
+/* look for existing fragment, uniquely identified by 3-way tuple, Identification field, and fragment offset */
 
 int PktFindFragment(uint8_t* pkt, unsigned int uFlags) {
 
-PKT_FRAGMENT* pList = App_Thread_Info[GetThreadIndex(false)].pPktFragmentList;
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+PKT_FRAG_DATAGRAM* pDatagram;
+PKT_FRAGMENT* pList;
 
 uint8_t protocol = 0;  /* don't need to be initialized, only to avoid compiler warnings */
 unsigned __int128 ip_src_addr = 0, ip_dst_addr = 0;  /* be sure to init IP addrs to zero as IPv4 uses only 4 out of 16 bytes */
-uint16_t identifier = 0, fragment_offset = 0;
+uint32_t identifier = 0;
+uint16_t fragment_offset = 0;
+
+   if (!pThreadInfo) return 0;
 
    get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
 
    get_identifier_and_offset(pkt, &identifier, &fragment_offset, uFlags);
 
+   if (!(pDatagram = FindDatagram(pThreadInfo->pFragTable, protocol, ip_src_addr, ip_dst_addr, identifier))) return 0;  /* not found */
+
+   pList = pDatagram->pFragmentList;
+
    while (pList) {
 
-      if (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier && fragment_offset == pList->offset) return DS_PKT_INFO_RETURN_FRAGMENT;  /* fragment found if 3-way tuple, identifier, and offset all match */
+      if (fragment_offset == pList->offset) return DS_PKT_INFO_RETURN_FRAGMENT;  /* fragment found if 3-way tuple, identifier, and offset all match */
 
       pList = pList->next;
    }
@@ -275,103 +609,139 @@ uint16_t identifier = 0, fragment_offset = 0;
    return 0;  /* not found */
 }
 
-/* remove a fragment from app thread's fragment list. If pkt is NULL, remove all fragments */
+/* remove a fragment from app thread's hash table. If pkt is NULL, remove all fragments */
 
 int DSPktRemoveFragment(uint8_t* pkt, unsigned int uFlags, unsigned int* max_list_fragments) {
 
-int thread_index = GetThreadIndex(false), nRemoved = 0;
-PKT_FRAGMENT *pList = App_Thread_Info[thread_index].pPktFragmentList, *pListPrev = NULL, *pListNext = NULL;
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+int nRemoved = 0;
+PKT_FRAG_TABLE* pTable;
+PKT_FRAG_DATAGRAM* pDatagram;
+PKT_FRAGMENT *pList, *pListPrev = NULL, *pListNext = NULL;
 
 uint8_t protocol = 0;  /* don't need to be initialized, only to avoid compiler warnings */
 unsigned __int128 ip_src_addr = 0, ip_dst_addr = 0;
-uint16_t identifier = 0, fragment_offset = 0;
+uint32_t identifier = 0;
+uint16_t fragment_offset = 0;
 
-   get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
+   if (!pThreadInfo) return pkt ? 0 : nRemoved;
 
-   get_identifier_and_offset(pkt, &identifier, &fragment_offset, uFlags);
+   pTable = pThreadInfo->pFragTable;
 
-/* remove fragment(s) with matching identifier and offset, free allocated mem */
+   if (!pkt) {  /* pkt is NULL, remove all remaining datagrams and fragments (cleanup) */
 
-   while (pList) {
+      while (pTable && pTable->pOldest) nRemoved += FreeDatagram(pTable, pTable->pOldest, pThreadInfo);
+      nRemoved += ReleaseReassembled(pTable, pThreadInfo);
+   }
+   else {
 
-      pListNext = pList->next;  /* save next ptr in case pList is freed */
+      get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
 
-      if (!pkt || (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier && fragment_offset == pList->offset)) {  /* 3-way tuple, identifier, and offset all have to match. Note pkt can be NULL, in which case we remove all remaining nodes (cleanup) */
+      get_identifier_and_offset(pkt, &identifier, &fragment_offset, uFlags);
 
-         if (pListPrev) pListPrev->next = pList->next;  /* remove fragment from the list and update last non-matching fragment to point to next fragment */ 
-         else App_Thread_Info[thread_index].pPktFragmentList = pList->next;  /* if fragment was at start of the list then move the list head */
+   /* remove fragment(s) with matching offset, return entries to the pool */
 
-         free(pList->ip_hdr_buf);  /* free IP header buffer */
-         free(pList->pkt_buf);  /* free packet data buffer */
-         free(pList);  /* free fragment list entry */
+      if ((pDatagram = FindDatagram(pTable, protocol, ip_src_addr, ip_dst_addr, identifier))) {
 
-         nRemoved++;
+         pList = pDatagram->pFragmentList;
 
-         App_Thread_Info[thread_index].active_fragment_count--;  /* decrement fragment count */
-      }
-      else pListPrev = pList;  /* update last non-matching fragment */
+         while (pList) {
+
+            pListNext = pList->next;  /* save next ptr in case pList is freed */
+
+            if (fragment_offset == pList->offset) {  /* 3-way tuple, identifier, and offset all have to match */
+
+               if (pListPrev) pListPrev->next = pList->next;  /* remove fragment from the list and update last non-matching fragment to point to next fragment */ 
+               else pDatagram->pFragmentList = pList->next;  /* if fragment was at start of the list then move the list head */
+
+               FreeFragment(pTable, pList);
+
+               nRemoved++;
 
-      pList = pListNext;
+               pThreadInfo->active_fragment_count--;  /* decrement fragment count */
+            }
+            else pListPrev = pList;  /* update last non-matching fragment */
+
+            pList = pListNext;
+         }
+
+         if (!pDatagram->pFragmentList) FreeDatagram(pTable, pDatagram, pThreadInfo);  /* no fragments left */
+      }
    }
 
    #ifdef FRAGMENTATION_DEBUG
-   printf("\n *** inside pkt removed %d fragments, active fragments = %d, identifier = %d, offset = %d \n", nRemoved, App_Thread_Info[thread_index].active_fragment_count, identifier, fragment_offset);
+   printf("\n *** inside pkt removed %d fragments, active fragments = %d, identifier = %u, offset = %d \n", nRemoved, pThreadInfo->active_fragment_count, identifier, fragment_offset);
    #endif
 
-   if (max_list_fragments) *max_list_fragments = App_Thread_Info[thread_index].max_fragment_count;  /* return max list fragments stat if requested */
+   if (max_list_fragments) *max_list_fragments = pThreadInfo->max_fragment_count;  /* return max list fragments stat if requested */
 
    return pkt ? (nRemoved ? DS_PKT_INFO_RETURN_FRAGMENT_REMOVED : 0) : nRemoved;  /* if pkt NULL return number removed, otherwise return status flag */ 
 }
 
+/* return app thread's fragment stats, JHB Oct 2026 */
+
+int DSPktGetFragmentStats(unsigned int uFlags, PKT_FRAGMENT_STATS* pStats) {
+
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+
+   (void)uFlags;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+   if (!pStats || !pThreadInfo) return -1;
+
+   pStats->total_fragments = pThreadInfo->total_fragment_count;
+   pStats->active_fragments = pThreadInfo->active_fragment_count;
+   pStats->max_fragments = pThreadInfo->max_fragment_count;
+   pStats->timeout_evictions = pThreadInfo->timeout_evictions;
+   pStats->pool_evictions = pThreadInfo->pool_evictions;
+   pStats->pool_exhausted = pThreadInfo->pool_exhausted;
+   pStats->oversize_fragments = pThreadInfo->oversize_fragments;
+
+   return 1;
+}
+
 /* check if all fragments are available for reassembly. Note this is independent of packet receive order */
 
 int PktGetReassemblyStatus(uint8_t* pkt, unsigned int uFlags) {
 
-int thread_index = GetThreadIndex(false), ret_val = 0;
-PKT_FRAGMENT* pList = App_Thread_Info[thread_index].pPktFragmentList;
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+int ret_val = 0;
+PKT_FRAG_DATAGRAM* pDatagram;
+PKT_FRAGMENT* pList;
 uint16_t reassembled_len = 0;
-#if 0
-uint16_t matching_fragments = 0;
-#endif
 
 uint8_t protocol = 0;  /* don't need to be initialized, only to avoid compiler warnings */
 unsigned __int128 ip_src_addr = 0, ip_dst_addr = 0;
-uint16_t identifier = 0;
+uint32_t identifier = 0;
+
+   if (!pThreadInfo) return 0;
 
    get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
 
    get_identifier_and_offset(pkt, &identifier, NULL, uFlags);
 
+   if (!(pDatagram = FindDatagram(pThreadInfo->pFragTable, protocol, ip_src_addr, ip_dst_addr, identifier))) return 0;
+
 /* first sum lengths of currently available fragments */
 
+   pList = pDatagram->pFragmentList;
+
    while (pList) {
 
-      if (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier) {  /* 3-way tuple and identifier have to match, but not offsets, which can be in any order */
-
-         reassembled_len += pList->len;
-         ret_val |= DS_PKT_INFO_RETURN_FRAGMENT;
-         #if 0
-         matching_fragments++;
-         #endif
-      }
+      reassembled_len += pList->len;
+      ret_val |= DS_PKT_INFO_RETURN_FRAGMENT;
 
       pList = pList->next;
    }
 
 /* second check if all fragments have arrived and math of total lengths vs final offset checks out */
 
-   pList = App_Thread_Info[thread_index].pPktFragmentList;
+   pList = pDatagram->pFragmentList;
 
    while (pList) {  /* if last fragment has arrived, and its offset matches sum of lengths received, then we have all fragments */
 
-      if (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier) {  /* 3-way tuple and identifier have to match */
-
-         if (!(pList->flags & DS_PKT_FRAGMENT_MF)) {
+      if (!(pList->flags & DS_PKT_FRAGMENT_MF)) {
 
-//  printf("\n *** last fragment, identifier = %d, 8x offset + len = %d, total len = %d \n", pList->identifier, pList->offset*8 + pList->len, total_length);
-
-            if (pList->offset*8 + pList->len == reassembled_len) { ret_val |= DS_PKT_INFO_RETURN_REASSEMBLED_PACKET_AVAILABLE; break; }  /* all fragments received */
-         }
+         if (pList->offset*8 + pList->len == reassembled_len) { ret_val |= DS_PKT_INFO_RETURN_REASSEMBLED_PACKET_AVAILABLE; break; }  /* all fragments received */
       }
 
       pList = pList->next;
@@ -380,77 +750,148 @@ uint16_t identifier = 0;
    return ret_val;
 }
 
-/* walk app thread's fragment list to find matching identifiers, copy IP header and reassembled packet data, remove fragments from list, return total packet length */
-  
-int PktReassemble(uint8_t* pkt, unsigned int uFlags) {
+/* find datagram with matching 3-way tuple and identifier, return iovec list describing reassembled packet. iov[0] is the first fragment's IP header (adjusted for reassembled length and with fragmentation info removed), followed by fragment data in offset order. Return value is number of iovecs used, 0 if no reassembly available, or -1 for an error condition. Total packet length is returned in pkt_len if not NULL. See "Scatter-gather reassembly notes" above, JHB Oct 2026 */
+
+int DSPktReassembleIov(uint8_t* pkt, unsigned int uFlags, struct iovec* iov, int max_iov, int* pkt_len) {
 
-int thread_index = GetThreadIndex(false), matching_fragments = 0;
-PKT_FRAGMENT *pList = App_Thread_Info[thread_index].pPktFragmentList, *pListPrev = NULL, *pListNext = NULL;
-uint16_t reassembled_len = 0, ip_hdr_len = 0;
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+PKT_FRAG_TABLE* pTable;
+PKT_FRAG_DATAGRAM* pDatagram;
+PKT_FRAGMENT *pList, *pSorted = NULL, **ppInsert;
+uint8_t* ip_hdr;
+int nIov = 0, data_len = 0, matching_fragments = 0, len;
 
 uint8_t protocol = 0;  /* don't need to be initialized, only to avoid compiler warnings */
 unsigned __int128 ip_src_addr = 0, ip_dst_addr = 0;
-uint16_t identifier = 0;
+uint32_t identifier = 0;
+
+   if (!pkt || !iov || max_iov < 2 || !pThreadInfo) return -1;
+
+   if (!(pTable = pThreadInfo->pFragTable)) return 0;
+
+   ReleaseReassembled(pTable, pThreadInfo);  /* previous pending reassembly, if any, is no longer valid */
 
    get_3way_tuple(pkt, &protocol, &ip_src_addr, &ip_dst_addr, uFlags);
 
    get_identifier_and_offset(pkt, &identifier, NULL, uFlags);
 
-/* reassemble full packet from matching fragment saved data, free allocated mem */
+   if (!(pDatagram = FindDatagram(pTable, protocol, ip_src_addr, ip_dst_addr, identifier))) return 0;
 
-   while (pList) {  /* first locate fragment 0 IP header len, in case fragments are received out of order and have different IP header lens */
+/* sort datagram's fragments by offset. Fragments per datagram are few, so an insertion sort is fine */
 
-      if (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier) {  /* 3-way tuple and identifier have to match */
+   while ((pList = pDatagram->pFragmentList)) {
 
-         if (pList->offset == 0) { ip_hdr_len = pList->ip_hdr_len; break; }
-      }
+      pDatagram->pFragmentList = pList->next;
 
-      pList = pList->next;
+      ppInsert = &pSorted;
+      while (*ppInsert && (*ppInsert)->offset <= pList->offset) ppInsert = &(*ppInsert)->next;
+
+      pList->next = *ppInsert;
+      *ppInsert = pList;
+      matching_fragments++;
    }
 
-   pList = App_Thread_Info[thread_index].pPktFragmentList;
+   pDatagram->pFragmentList = pSorted;
 
-   if (ip_hdr_len) while (pList) {  /* then run the loop again and reassemble packet data */
+   if (!pSorted || pSorted->offset != 0) return 0;  /* first fragment not available */
 
-      pListNext = pList->next;  /* save next ptr in case pList is freed */
+   if (matching_fragments + 1 > max_iov) {
+      Log_RT(2, "ERROR: DSPktReassembleIov() says %d fragments exceeds max_iov %d, identifier = %u \n", matching_fragments, max_iov, identifier);
+      return -1;
+   }
 
-      if (protocol == pList->protocol && ip_src_addr == pList->ip_src_addr && ip_dst_addr == pList->ip_dst_addr && identifier == pList->identifier) {  /* 3-way tuple and identifier have to match */
+/* build iovec list: first fragment IP header followed by fragment data. Overlapping data (retransmitted fragments with different boundaries) is trimmed; a gap means reassembly is not available */
 
-         matching_fragments++;
+   iov[nIov].iov_base = pSorted->ip_hdr_buf;
+   iov[nIov++].iov_len = pSorted->ip_hdr_len;
 
-         reassembled_len += pList->len;
+   pList = pSorted;
 
-         if (pList->offset == 0) memcpy(pkt, pList->ip_hdr_buf, ip_hdr_len);  /* copy IP header from first fragment */
+   while (pList) {
 
-         memcpy(&pkt[pList->ip_hdr_len + pList->offset*8], pList->pkt_buf, pList->len);  /* copy packet data into reassembly position given by fragment offset */
+      int start = pList->offset*8;
 
-         if (pListPrev) pListPrev->next = pList->next;  /* remove fragment from the list and update last non-matching fragment to point to next fragment */ 
-         else App_Thread_Info[thread_index].pPktFragmentList = pList->next;  /* if fragment was at start of the list then move the list head */
+      if (start > data_len) return 0;
 
-         free(pList->ip_hdr_buf);  /* free IP header buffer */
-         free(pList->pkt_buf);  /* free packet data buffer */
-         free(pList);  /* free fragment list entry */
+      if ((len = start + pList->len - data_len) > 0) {
+
+         iov[nIov].iov_base = &pList->pkt_buf[data_len - start];
+         iov[nIov++].iov_len = len;
+         data_len += len;
       }
-      else pListPrev = pList;  /* update last non-matching fragment */
 
-      pList = pListNext;
+      pList = pList->next;
    }
 
-   int pkt_len = ip_hdr_len + reassembled_len;
+/* adjust reassembled packet header, in place in the first fragment's saved header */
 
-   if (pkt_len) {  /* adjust reassembled packet header */
+   ip_hdr = pSorted->ip_hdr_buf;
 
-      pkt[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 7 : 6] &= 0xc0;  /* remove original packet fragmentation info */
-      pkt[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 6 : 7] = 0;
-      pkt[2] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? pkt_len & 0xff : pkt_len >> 8;  /* update length */
-      pkt[3] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? pkt_len >> 8 : pkt_len & 0xff;
+   if ((ip_hdr[0] >> 4) == IPv6) {  /* remove Fragment header: header iovec ends at the Fragment header, preceding Next Header takes the Fragment header Next Header, JHB Oct 2026 */
 
-      App_Thread_Info[thread_index].active_fragment_count -= matching_fragments;  /* reduce active count by number of reassembly fragments */
+      int nh_ofs = 6, frag_ofs = get_ipv6_frag_hdr(ip_hdr, &nh_ofs, uFlags);
+      if (!frag_ofs) return 0;
 
-      #ifdef FRAGMENTATION_DEBUG
-      printf("\n *** reassembled packet returned, identifier = %d, total fragments = %d, active fragments = %d, pkt len = %d, pFragmentList = %p \n", identifier, App_Thread_Info[thread_index].total_fragment_count, App_Thread_Info[thread_index].active_fragment_count, pkt_len, App_Thread_Info[thread_index].pPktFragmentList);
-      #endif
+      iov[0].iov_len = frag_ofs;
+      len = frag_ofs + data_len;
+
+      ip_hdr[nh_ofs] = ip_hdr[frag_ofs];
+      ip_hdr[4] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (len - 40) & 0xff : (len - 40) >> 8;  /* update Payload Length */
+      ip_hdr[5] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? (len - 40) >> 8 : (len - 40) & 0xff;
    }
+   else {
+
+      len = pSorted->ip_hdr_len + data_len;
+
+      ip_hdr[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 7 : 6] &= 0xc0;  /* remove original packet fragmentation info */
+      ip_hdr[(uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? 6 : 7] = 0;
+      ip_hdr[2] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? len & 0xff : len >> 8;  /* update length */
+      ip_hdr[3] = (uFlags & DS_PKTLIB_HOST_BYTE_ORDER) ? len >> 8 : len & 0xff;
+   }
+
+/* remove datagram from hash table and hold its fragments until the thread's next reassembly call or DSPktReleaseReassembly() */
+
+   UnlinkDatagram(pTable, pDatagram);
+   pTable->pReassembled = pDatagram;
+
+   #ifdef FRAGMENTATION_DEBUG
+   printf("\n *** reassembled packet iovec returned, identifier = %u, total fragments = %d, matching fragments = %d, iovecs = %d, pkt len = %d \n", identifier, pThreadInfo->total_fragment_count, matching_fragments, nIov, len);
+   #endif
+
+   if (pkt_len) *pkt_len = len;
+
+   return nIov;
+}
+
+/* release pending reassembly returned by DSPktReassembleIov() and return its fragments to the pool. Return value is number of fragments released, JHB Oct 2026 */
+
+int DSPktReleaseReassembly(unsigned int uFlags) {
+
+APP_THREAD_INFO* pThreadInfo = GetThreadInfo();
+
+   (void)uFlags;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+   if (!pThreadInfo) return -1;
+
+   return ReleaseReassembled(pThreadInfo->pFragTable, pThreadInfo);
+}
+
+/* find datagram with matching 3-way tuple and identifier, copy IP header and reassembled packet data, return fragments to the pool, return total packet length */
+  
+int PktReassemble(uint8_t* pkt, unsigned int uFlags) {
+
+struct iovec iov[PKT_FRAG_POOL_SIZE + 1];  /* a datagram can't have more fragments than the pool */
+int i, nIov, pkt_len = 0, ofs = 0;
+
+   if ((nIov = DSPktReassembleIov(pkt, uFlags, iov, sizeof(iov)/sizeof(iov[0]), &pkt_len)) <= 0) return 0;
+
+   for (i=0; i<nIov; i++) {  /* gather IP header and fragment data */
+
+      memcpy(&pkt[ofs], iov[i].iov_base, iov[i].iov_len);
+      ofs += iov[i].iov_len;
+   }
+
+   DSPktReleaseReassembly(uFlags);  /* return fragments to the pool, reduces active count by number of reassembly fragments */
 
    return pkt_len;  /* return reassembled packet length */
 }
@@ -501,6 +942,7 @@ int DSIsPacketDuplicate(unsigned int uFlags, PKTINFO* PktInfo1, PKTINFO* PktInfo
          -we detect and strip these out. Sequence numbers, length, and ports must be an exact copy
          -currently this is a rudimentary implementation, not likely to work with multiple/mixed TCP sessions
          -to-do: implement TCP session management, separate but similar to existing UDP sessions handled by pktlib
+         -per flow TCP retransmission handling with out-of-order reassembly is available in DSTcpReassemblyAddPacket() (pktlib_tcp_reassembly.cpp), JHB Oct 2026
       */
 
       if (PktInfo1->seqnum == PktInfo2->seqnum && PktInfo1->ack_seqnum == PktInfo2->ack_seqnum && PktInfo1->pkt_len == PktInfo2->pkt_len && PktInfo1->dst_port == PktInfo2->dst_port && PktInfo1->src_port == PktInfo2->src_port) {
@@ -573,3 +1015,116 @@ int DSIsPacketDuplicate(unsigned int uFlags, PKTINFO* PktInfo1, PKTINFO* PktInfo
 
    return false;
 }
+
+/* DSIsPacketDuplicateRing() looks for duplicates of the current packet within a lookback window of earlier packets. Notes, JHB Oct 2026:
+
+   -DSIsPacketDuplicate() compares a current and previous packet pair, so duplicates arriving 2 or more packets later (e.g. HI2/HI3 double-sends interleaved with other traffic, out-of-order retransmissions) are missed
+   -each candidate packet is reduced to a 64-bit fingerprint: TCP sequence numbers and ports, or UDP IP header checksum (which includes the IP Identification field), fragment flags and offset, ports, and lengths, plus a hash of up to DS_PKT_DUPLICATE_PREFIX_LEN bytes of TCP payload or UDP data following the IP header
+   -fingerprints of the most recent lookback candidate packets are kept in a ring, indexed by a small hash table, so detection is O(1) per packet with no pairwise comparisons
+   -candidate packets are the same as DSIsPacketDuplicate(): TCP, UDP fragments, UDP reserved ports, and non-RTP UDP SIP ports. As with DSIsPacketDuplicate(), UDP checksums are ignored unless uFlags includes DS_PKT_DUPLICATE_INCLUDE_UDP_CHECKSUM
+   -zero-payload TCP segments (pure ACKs, window updates) are not candidates. Repeated ACKs with identical headers are normal TCP behavior (e.g. duplicate ACKs signaling loss), not capture duplicates
+   -duplicates are not added to the ring
+*/
+
+int DSInitPacketDuplicateRing(PKT_DUPLICATE_RING* pRing, int lookback) {
+
+   if (!pRing || lookback < 0) return -1;
+
+   memset(pRing, 0, sizeof(PKT_DUPLICATE_RING));
+   memset(pRing->hash_head, -1, sizeof(pRing->hash_head));
+
+   pRing->lookback = min(lookback, DS_PKT_DUPLICATE_MAX_LOOKBACK);
+
+   return pRing->lookback;
+}
+
+static inline uint64_t dup_hash(uint64_t h, const uint8_t* p, int len) {  /* FNV-1a */
+
+   for (int i=0; i<len; i++) h = (h ^ p[i]) * 0x100000001b3ULL;
+
+   return h;
+}
+
+static inline unsigned int dup_bucket(uint64_t fingerprint) {
+
+   return (unsigned int)((fingerprint * 0x9e3779b97f4a7c15ULL) >> 56) & (DS_PKT_DUPLICATE_HASH_SIZE-1);
+}
+
+int DSIsPacketDuplicateRing(PKT_DUPLICATE_RING* pRing, unsigned int uFlags, uint8_t* pkt_buf, PKTINFO* PktInfo) {
+
+uint64_t fingerprint = 0xcbf29ce484222325ULL;  /* FNV offset basis */
+uint32_t fields[8];
+uint8_t prefix[DS_PKT_DUPLICATE_PREFIX_LEN];
+int i, len = 0, bucket;
+
+   if (!pRing || !pkt_buf || !PktInfo || pRing->lookback <= 0) return false;
+
+/* check for candidate packets and form fingerprint */
+
+   if (PktInfo->protocol == TCP) {
+
+      if (PktInfo->pyld_len <= 0) return false;  /* zero-payload segment, not a candidate */
+
+      fields[0] = PktInfo->seqnum; fields[1] = PktInfo->ack_seqnum; fields[2] = PktInfo->pkt_len; fields[3] = (PktInfo->src_port << 16) | PktInfo->dst_port;
+      fields[4] = fields[5] = fields[6] = fields[7] = 0;
+
+      if (PktInfo->pyld_ofs > 0) {  /* TCP header is not included, retransmissions may have different options (timestamps) and window size */
+
+         len = min(PktInfo->pyld_len, DS_PKT_DUPLICATE_PREFIX_LEN);
+         memcpy(prefix, &pkt_buf[PktInfo->pyld_ofs], len);
+      }
+   }
+   else if (PktInfo->protocol == UDP) {
+
+      if (!(PktInfo->flags & DS_PKT_FRAGMENT_ITEM_MASK) && !DSIsReservedUDP(PktInfo->dst_port) &&
+          !(PktInfo->dst_port >= SIP_PORT_RANGE_LOWER && PktInfo->dst_port <= SIP_PORT_RANGE_UPPER && (PktInfo->rtp_version != 2 || PktInfo->rtp_pyld_len < 0 || PktInfo->rtp_pyld_len > PktInfo->pkt_len))) return false;  /* not a candidate; RTP duplicates are handled by pktlib RFC 7198 lookback */
+
+      fields[0] = PktInfo->ip_hdr_checksum; fields[1] = PktInfo->pkt_len; fields[2] = PktInfo->fragment_offset; fields[3] = PktInfo->flags & DS_PKT_FRAGMENT_ITEM_MASK;
+      fields[4] = (PktInfo->src_port << 16) | PktInfo->dst_port; fields[5] = (PktInfo->fragment_offset == 0) ? PktInfo->pyld_len : 0;
+      fields[6] = (uFlags & DS_PKT_DUPLICATE_INCLUDE_UDP_CHECKSUM) ? PktInfo->udp_checksum : 0; fields[7] = 0;
+
+      if (PktInfo->ip_hdr_len > 0 && PktInfo->pkt_len > PktInfo->ip_hdr_len) {  /* data following IP header: UDP header and payload, or fragment data */
+
+         len = min(PktInfo->pkt_len - PktInfo->ip_hdr_len, DS_PKT_DUPLICATE_PREFIX_LEN);
+         memcpy(prefix, &pkt_buf[PktInfo->ip_hdr_len], len);
+
+         if (PktInfo->fragment_offset == 0 && len >= UDP_HEADER_LEN && !(uFlags & DS_PKT_DUPLICATE_INCLUDE_UDP_CHECKSUM)) prefix[6] = prefix[7] = 0;  /* ignore UDP checksum */
+      }
+   }
+   else return false;
+
+   fingerprint = dup_hash(fingerprint, (const uint8_t*)&PktInfo->protocol, sizeof(PktInfo->protocol));
+   fingerprint = dup_hash(fingerprint, (const uint8_t*)fields, sizeof(fields));
+   fingerprint = dup_hash(fingerprint, prefix, len);
+
+/* look for fingerprint in the ring */
+
+   bucket = dup_bucket(fingerprint);
+
+   for (i = pRing->hash_head[bucket]; i >= 0; i = pRing->hash_next[i]) if (pRing->fingerprint[i] == fingerprint) {
+
+      pRing->num_duplicates++;
+      return true;  /* duplicate packet */
+   }
+
+/* not found, add to ring. If ring is full remove oldest fingerprint from its hash bucket */
+
+   i = pRing->index;
+
+   if (pRing->count == pRing->lookback) {
+
+      int8_t* pIndex = &pRing->hash_head[dup_bucket(pRing->fingerprint[i])];
+
+      while (*pIndex != i) pIndex = &pRing->hash_next[(int)*pIndex];
+      *pIndex = pRing->hash_next[i];
+   }
+   else pRing->count++;
+
+   pRing->fingerprint[i] = fingerprint;
+   pRing->hash_next[i] = pRing->hash_head[bucket];
+   pRing->hash_head[bucket] = i;
+
+   if (++pRing->index >= pRing->lookback) pRing->index = 0;
+
+   return false;
+}
@@ -0,0 +1,134 @@
+/*
+$Header: /root/Signalogic/DirectCore/lib/pktlib/pktlib_notify.cpp
+
+Description
+
+  APIs for push/pull queue event notification between packet/media threads and application threads: p/m threads signal when output packets are available or push queue space has been freed, application threads block with a timeout instead of polling with fixed sleeps
+
+Notes
+
+  -Linux futex based. No dependencies on other pktlib APIs
+
+Projects
+
+  SigSRF, DirectCore
+
+Copyright Signalogic Inc. 2026
+
+License
+
+  Github SigSRF License, Version 1.1, https://github.com/signalogic/SigSRF_SDK/blob/master/LICENSE.md
+
+Documentation and Usage
+
+  1) All notification related API definitions and flags are documented in pktlib.h
+
+  2) If you modify DSXxx() functions, then place the resulting .o before libpktlib.so in your app link order, then your mods will take precedence over pktlib function names
+
+Revision History
+
+  Created Oct 2026 JHB, DSGetPacketNotifySeq(), DSWaitPacketNotify(), and DSSignalPacketNotify(). Replace usleep() polling in mediaMin push queue full retries, stream group pull retries, and app thread sync
+*/
+
+/* Linux and/or other OS includes */
+
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <algorithm>
+using namespace std;
+
+/* SigSRF includes */
+
+#include "pktlib.h"   /* pktlib API definitions */
+#include "diaglib.h"  /* Log_RT() definition */
+
+/* packet notify notes, JHB Oct 2026:
+
+   -each event type has a sequence number and a waiter count. Signaling increments the sequence number, and if there are waiters, wakes them with FUTEX_WAKE. Signaling with no waiters costs one atomic increment and one atomic load, so p/m threads can signal every loop iteration
+   -waiters first get the sequence number with DSGetPacketNotifySeq(), then check their condition (e.g. try to push or pull), then if needed call DSWaitPacketNotify() with the sequence number. If a signal occurs between getting the sequence number and waiting, the futex compare fails and DSWaitPacketNotify() returns immediately, so no wakeups are lost
+   -waiter count and sequence number are accessed with sequentially consistent atomics: either the signaler sees the waiter count increment, or the waiter sees the sequence number change
+   -all waits have a timeout. Callers should use the same value as their previous polling interval, so behavior is unchanged if a signal is missed (e.g. a p/m thread stalled or an event source that doesn't signal)
+   -events are cache line aligned to avoid false sharing between event types
+*/
+
+typedef struct {
+
+   volatile uint32_t  seq;       /* futex word, incremented on each signal */
+   volatile uint32_t  waiters;   /* number of threads inside DSWaitPacketNotify() */
+
+} __attribute__((aligned(64))) PKT_NOTIFY_EVENT;
+
+static PKT_NOTIFY_EVENT notify_events[DS_PKT_NOTIFY_MAX_EVENTS];
+
+static inline int event_index(unsigned int uEvent) {  /* convert single event flag to index, -1 if invalid */
+
+   if (!uEvent || (uEvent & (uEvent-1)) || uEvent >= (1U << DS_PKT_NOTIFY_MAX_EVENTS)) return -1;
+
+   return __builtin_ctz(uEvent);
+}
+
+uint32_t DSGetPacketNotifySeq(unsigned int uEvent) {
+
+int i;
+
+   if ((i = event_index(uEvent)) < 0) return 0;
+
+   return __atomic_load_n(&notify_events[i].seq, __ATOMIC_SEQ_CST);
+}
+
+int DSWaitPacketNotify(unsigned int uEvent, uint32_t seq, unsigned int uTimeout_usec) {
+
+int i, ret_val;
+struct timespec ts;
+
+   if ((i = event_index(uEvent)) < 0) {
+
+      Log_RT(2, "ERROR: DSWaitPacketNotify() says invalid event 0x%x, must be one DS_PKT_NOTIFY_xxx flag \n", uEvent);
+      return -1;
+   }
+
+   __atomic_add_fetch(&notify_events[i].waiters, 1, __ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&notify_events[i].seq, __ATOMIC_SEQ_CST) != seq) ret_val = 1;  /* already signaled */
+   else {
+
+      ts.tv_sec = uTimeout_usec / 1000000L;
+      ts.tv_nsec = (uTimeout_usec % 1000000L)*1000;
+
+      if (!syscall(SYS_futex, &notify_events[i].seq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0)) ret_val = __atomic_load_n(&notify_events[i].seq, __ATOMIC_SEQ_CST) != seq;  /* woken; zero return if spurious */
+      else if (errno == EAGAIN) ret_val = 1;  /* seq changed before the kernel compare */
+      else if (errno == ETIMEDOUT || errno == EINTR) ret_val = 0;
+      else {
+         Log_RT(2, "ERROR: DSWaitPacketNotify() says futex wait fails, errno = %d \n", errno);
+         ret_val = -1;
+      }
+   }
+
+   __atomic_sub_fetch(&notify_events[i].waiters, 1, __ATOMIC_SEQ_CST);
+
+   return ret_val;
+}
+
+int DSSignalPacketNotify(unsigned int uEvents) {
+
+int i, num_woken = 0;
+
+   for (i=0; i<DS_PKT_NOTIFY_MAX_EVENTS; i++) if (uEvents & (1U << i)) {
+
+      __atomic_add_fetch(&notify_events[i].seq, 1, __ATOMIC_SEQ_CST);
+
+      if (__atomic_load_n(&notify_events[i].waiters, __ATOMIC_SEQ_CST)) {
+
+         long ret_val = syscall(SYS_futex, &notify_events[i].seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+         if (ret_val > 0) num_woken += ret_val;
+      }
+   }
+
+   return num_woken;
+}
@@ -63,6 +63,14 @@ Revision History
                            -comprehensive error handling
   Modified Mar 2025 JHB, per changes in pktlib.h to standardize with other SigSRF libs, adjust references to DS_PKTLIB_SUPPRESS_WARNING_ERROR_MSG, DS_PKTLIB_SUPPRESS_INFO_MSG, and DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG flags
   Modified Apr 2025 JHB, per updates in pktlib.h, rename p_eth_hdr_type to p_eth_protocol 
+  Modified Oct 2026 JHB, add memory-mapped read mode: DSOpenPcap() with DS_OPEN_PCAP_MMAP flag maps the input file, DSReadPcapPtr() walks pcap, pcapng, and .rtp records in place and returns a pointer into the mapping instead of copying packet data. Link layer, VLAN, Null/Loopback, and TSO length fix handling are the same as DSReadPcap(). Move .rtp packet formatting and TSO length fix into static helpers shared by both read functions
+  Modified Oct 2026 JHB, add DSReadPcapBatch() to read multiple records per call into a caller supplied packet arena. Uses DSReadPcapPtr() for memory-mapped inputs, otherwise DSReadPcap()
+  Modified Oct 2026 JHB, add pcap index support: DSCreatePcapIndex() builds a per-packet index (offset, record number, arrival time, 5-tuple, SSRC, RTP timestamp and sequence number) in one streaming pass and saves it as a .sigidx sidecar file. DSFindPcapPacket() uses an existing sidecar, or builds one on first use if DS_FIND_PCAP_PACKET_USE_INDEX is given, and binary searches it instead of scanning the pcap on every call
+  Modified Oct 2026 JHB, add DSSeekPcap() to position pcap, pcapng, and .rtp inputs at the first record at or after a given arrival time, using a coarse per-handle time index built on first use. DSClosePcap() frees the time index
+  Modified Oct 2026 JHB, DSSeekPcap() bisects libpcap files by file offset with record header resync instead of building a time index in a pass over the whole file. The time index is still used for pcapng, .rtp, and compressed files
+  Modified Oct 2026 JHB, add DSCreatePcapWriter() and DSWritePcapBuffered() for buffered pcap output. Records are coalesced in a per-file buffer and written with writev(); concurrent writers reserve buffer space atomically so no semaphore is needed. DSClosePcap() flushes and frees the writer. Move DSWritePcap() placeholder ethernet header protocol setup into a static helper shared by both write functions
+  Modified Oct 2026 JHB, add DSScanPcap() for chunk-parallel parsing: libpcap files are split into byte ranges, each range start is resynchronized on a record boundary using record header sanity checks, and ranges are parsed concurrently with boundaries verified afterwards. Index builds for DSCreatePcapIndex() and DSFindPcapPacket() now use DSScanPcap(). Add DSGetPcapStats() for a fast parallel pcap stats pass
+  Modified Oct 2026 JHB, add streaming gzip and zstd compressed pcap support. DSOpenPcap() detects compressed inputs by magic number and compressed outputs by .gz or .zst extension, and returns an fopencookie() stream that decompresses or compresses with bounded buffers. zlib and libzstd are loaded at run-time. pcap_writev() falls back to fwrite() for streams with no file descriptor
 */
 
 /* Linux and/or other OS includes */
@@ -70,6 +78,15 @@ Revision History
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sched.h>
+#include <pthread.h>
+#include <dlfcn.h>
 
 #include <algorithm>
 using namespace std;
@@ -98,6 +115,550 @@ int link_layer_length = -1;
    return link_layer_length;
 }
 
+/* memory-mapped read mode support, JHB Oct 2026. Notes:
+
+  -DSOpenPcap() with DS_OPEN_PCAP_MMAP maps the whole input file (MAP_PRIVATE, so in-place fixes such as TSO zero length are copy-on-write and never reach the file) and adds an entry to pcap_mmap_info[], keyed by the FILE* handle it returns
+  -DSReadPcapPtr() looks up the entry and walks records in place; the FILE* file position is not used (or advanced) by DSReadPcapPtr()
+  -entries are claimed with an atomic compare-and-swap on the fp field, so no locks or semaphores are needed. Lookups are a linear scan up to a high water mark, typically a handful of entries
+  -if mmap() fails (e.g. input is a pipe or special file) the entry is still created but with base == NULL, and DSReadPcapPtr() falls back to DSReadPcap() into the entry's scratch buffer
+*/
+
+#define MAX_PCAP_MMAP  1024
+
+typedef struct {
+
+  FILE*    fp;       /* FILE* handle returned by DSOpenPcap(), used as lookup key. NULL indicates entry is available */
+  uint8_t* base;     /* start of mapping, NULL if mmap() failed and DSReadPcapPtr() falls back to DSReadPcap() */
+  uint64_t size;     /* size of mapping (file size at time of DSOpenPcap() call) */
+  uint64_t pos;      /* current read position (offset of next record) */
+  uint8_t* pkt_buf;  /* scratch buffer for records that cannot be returned in place (.rtp records, fallback reads). Allocated on first use */
+
+} PCAP_MMAP_INFO;
+
+static PCAP_MMAP_INFO pcap_mmap_info[MAX_PCAP_MMAP] = {{ 0 }};
+static int nPcapMmapMax = 0;  /* high water mark of pcap_mmap_info[] entries in use */
+
+static PCAP_MMAP_INFO* find_pcap_mmap(FILE* fp) {
+
+   if (fp) for (int i=0; i<nPcapMmapMax; i++) if (pcap_mmap_info[i].fp == fp) return &pcap_mmap_info[i];
+
+   return NULL;
+}
+
+static int pcap_mmap_attach(FILE* fp, unsigned int uFlags, const char* pcap_file) {
+
+PCAP_MMAP_INFO* p;
+struct stat file_stat;
+int i, n;
+
+   if ((p = find_pcap_mmap(fp))) {  /* already mapped, for example a DS_OPEN_PCAP_RESET call. Sync read position to first record */
+
+      p->pos = ftell(fp);
+      return 1;
+   }
+
+   if (!(uFlags & DS_OPEN_PCAP_MMAP)) return 0;
+
+   for (i=0; i<MAX_PCAP_MMAP; i++) if (__sync_bool_compare_and_swap(&pcap_mmap_info[i].fp, NULL, fp)) break;  /* claim first available entry */
+
+   if (i == MAX_PCAP_MMAP) {
+
+      Log_RT(2, "ERROR: DSOpenPcap() says max number of memory-mapped inputs %d exceeded for file %s \n", MAX_PCAP_MMAP, pcap_file ? pcap_file : "");
+      return -1;
+   }
+
+   while ((n = nPcapMmapMax) < i+1 && !__sync_bool_compare_and_swap(&nPcapMmapMax, n, i+1));  /* update high water mark */
+
+   p = &pcap_mmap_info[i];
+
+   p->base = NULL;
+   p->size = 0;
+   p->pkt_buf = NULL;
+   p->pos = ftell(fp);  /* DSOpenPcap() has read the file header(s), fp points at first record */
+
+   if (fstat(fileno(fp), &file_stat) == 0 && S_ISREG(file_stat.st_mode) && file_stat.st_size > 0) {
+
+      void* addr = mmap(NULL, file_stat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp), 0);
+
+      if (addr != MAP_FAILED) {
+
+         p->base = (uint8_t*)addr;
+         p->size = file_stat.st_size;
+
+         madvise(addr, p->size, MADV_SEQUENTIAL);  /* hint for kernel read-ahead, records are normally walked start to end */
+      }
+   }
+
+   if (!p->base && !(uFlags & DS_OPEN_PCAP_QUIET)) {
+
+      if (fileno(fp) < 0) Log_RT(4, "INFO: DSOpenPcap() says compressed file %s can't be memory-mapped, DSReadPcapPtr() will use buffered reads \n", pcap_file ? pcap_file : "");  /* fopencookie() streams have no file descriptor, JHB Oct 2026 */
+      else Log_RT(3, "WARNING: DSOpenPcap() says unable to memory-map file %s, errno = %d, DSReadPcapPtr() will use buffered reads \n", pcap_file ? pcap_file : "", errno);
+   }
+
+   return 1;
+}
+
+static void pcap_mmap_detach(PCAP_MMAP_INFO* p) {
+
+   if (p->base) munmap(p->base, p->size);
+   if (p->pkt_buf) free(p->pkt_buf);
+
+   p->base = NULL;
+   p->size = 0;
+   p->pos = 0;
+   p->pkt_buf = NULL;
+
+   __sync_synchronize();
+   p->fp = NULL;  /* release entry last */
+}
+
+static uint64_t pcap_read_pos(FILE* fp) {  /* current read position for buffered or memory-mapped handles */
+
+PCAP_MMAP_INFO* p = find_pcap_mmap(fp);
+
+   if (p && p->base) return p->pos;
+
+   return ftell(fp);
+}
+
+static void pcap_set_read_pos(FILE* fp, uint64_t pos) {  /* set read position for buffered or memory-mapped handles */
+
+PCAP_MMAP_INFO* p = find_pcap_mmap(fp);
+
+   if (p && p->base) p->pos = pos;
+   else fseek(fp, pos, SEEK_SET);
+}
+
+/* compressed pcap support, JHB Oct 2026. Notes:
+
+  -DSOpenPcap() detects gzip and zstd compressed inputs by magic number, and compressed outputs by .gz or .zst file extension. A compressed file is returned as a FILE* stream created with fopencookie(), so DSReadPcap(), DSWritePcap(), DSClosePcap() and other APIs work unchanged
+  -decompression and compression are streaming with bounded buffers; compressed files are never expanded in memory or on disk
+  -zlib and libzstd are loaded at run-time with dlopen(), so pktlib has no link-time dependency on either. If a library is not available DSOpenPcap() returns an error only for files that need it
+  -decompressed data is kept in a window of 2*PCAP_COMPRESS_BUF_SIZE bytes. Backward seeks inside the window (stdio read-ahead adjustment, DS_READ_PCAP_COPY, pcapng block handling) are free. Other seeks are emulated: forward seeks decompress and discard, backward seeks restart decompression from the start of the file. SEEK_END is not supported
+  -compressed outputs are sequential; only position queries (ftell) are supported
+  -compressed inputs can't be memory-mapped; DS_OPEN_PCAP_MMAP handles fall back to buffered reads, and DSScanPcap() parses them as one range
+*/
+
+#define PCAP_COMPRESS_NONE         0
+#define PCAP_COMPRESS_GZIP         1
+#define PCAP_COMPRESS_ZSTD         2
+
+#define PCAP_COMPRESS_BUF_SIZE     (128*1024)
+#define PCAP_COMPRESS_GZIP_MODE    "wb6"  /* gzopen() write mode and compression level */
+#define PCAP_COMPRESS_ZSTD_LEVEL   3
+
+typedef struct { const void* src; size_t size; size_t pos; } zstd_in_buf_t;  /* same layout as ZSTD_inBuffer in zstd.h */
+typedef struct { void* dst; size_t size; size_t pos; } zstd_out_buf_t;  /* same layout as ZSTD_outBuffer */
+
+static struct {  /* zlib and libzstd APIs, set by pcap_compress_lib_init() */
+
+  void*    (*gzopen)(const char*, const char*);
+  int      (*gzbuffer)(void*, unsigned int);
+  int      (*gzread)(void*, void*, unsigned int);
+  int      (*gzwrite)(void*, const void*, unsigned int);
+  int      (*gzrewind)(void*);
+  int      (*gzclose)(void*);
+
+  void*    (*ZSTD_createDStream)(void);
+  size_t   (*ZSTD_initDStream)(void*);
+  size_t   (*ZSTD_decompressStream)(void*, zstd_out_buf_t*, zstd_in_buf_t*);
+  size_t   (*ZSTD_freeDStream)(void*);
+  void*    (*ZSTD_createCStream)(void);
+  size_t   (*ZSTD_initCStream)(void*, int);
+  size_t   (*ZSTD_compressStream)(void*, zstd_out_buf_t*, zstd_in_buf_t*);
+  size_t   (*ZSTD_endStream)(void*, zstd_out_buf_t*);
+  size_t   (*ZSTD_freeCStream)(void*);
+  unsigned (*ZSTD_isError)(size_t);
+
+  bool     fGzip;  /* all zlib APIs found */
+  bool     fZstd;  /* all libzstd APIs found */
+
+} pcap_compress_lib = { 0 };
+
+static pthread_once_t pcap_compress_lib_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+
+  int       type;        /* PCAP_COMPRESS_GZIP or PCAP_COMPRESS_ZSTD */
+  bool      fWrite;
+  void*     gz;          /* gzFile handle (gzip) */
+  FILE*     fp;          /* compressed file (zstd) */
+  void*     zs;          /* ZSTD_DStream or ZSTD_CStream (zstd) */
+  uint8_t*  zbuf;        /* compressed data buffer (zstd), PCAP_COMPRESS_BUF_SIZE bytes */
+  zstd_in_buf_t zin;     /* compressed data not yet consumed by the decompressor (zstd read) */
+  bool      fEnd;        /* end of compressed file reached (zstd read) */
+
+  uint8_t*  win;         /* decompressed data window (read), 2*PCAP_COMPRESS_BUF_SIZE bytes */
+  uint64_t  win_start;   /* stream offset of win[0] */
+  uint32_t  win_len;
+  uint64_t  pos;         /* current uncompressed stream position */
+
+} PCAP_COMPRESS_INFO;
+
+static void pcap_compress_lib_init(void) {  /* one time run-time lookup of zlib and libzstd APIs */
+
+void* hLib;
+void* temp;
+bool fFound;
+
+   #define PCAP_COMPRESS_SYM(name) if (!(temp = dlsym(hLib, #name))) fFound = false; else memcpy(&pcap_compress_lib.name, &temp, sizeof(void*));  /* memcpy avoids object to function pointer cast warnings, same as DSInitLogging() in diaglib */
+
+   if ((hLib = dlopen("libz.so.1", RTLD_NOW | RTLD_LOCAL)) || (hLib = dlopen("libz.so", RTLD_NOW | RTLD_LOCAL))) {
+
+      fFound = true;
+      PCAP_COMPRESS_SYM(gzopen); PCAP_COMPRESS_SYM(gzbuffer); PCAP_COMPRESS_SYM(gzread); PCAP_COMPRESS_SYM(gzwrite); PCAP_COMPRESS_SYM(gzrewind); PCAP_COMPRESS_SYM(gzclose);
+      pcap_compress_lib.fGzip = fFound;
+   }
+
+   if ((hLib = dlopen("libzstd.so.1", RTLD_NOW | RTLD_LOCAL)) || (hLib = dlopen("libzstd.so", RTLD_NOW | RTLD_LOCAL))) {
+
+      fFound = true;
+      PCAP_COMPRESS_SYM(ZSTD_createDStream); PCAP_COMPRESS_SYM(ZSTD_initDStream); PCAP_COMPRESS_SYM(ZSTD_decompressStream); PCAP_COMPRESS_SYM(ZSTD_freeDStream);
+      PCAP_COMPRESS_SYM(ZSTD_createCStream); PCAP_COMPRESS_SYM(ZSTD_initCStream); PCAP_COMPRESS_SYM(ZSTD_compressStream); PCAP_COMPRESS_SYM(ZSTD_endStream); PCAP_COMPRESS_SYM(ZSTD_freeCStream);
+      PCAP_COMPRESS_SYM(ZSTD_isError);
+      pcap_compress_lib.fZstd = fFound;
+   }
+}
+
+static int pcap_compress_type(FILE* fp) {  /* look for gzip or zstd magic number at start of an uncompressed FILE* handle. File position is restored to start of file */
+
+uint8_t magic[4] = { 0 };
+int type = PCAP_COMPRESS_NONE;
+
+   if (fread(magic, 1, sizeof(magic), fp) >= 2) {
+
+      if (magic[0] == 0x1f && magic[1] == 0x8b) type = PCAP_COMPRESS_GZIP;
+      else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) type = PCAP_COMPRESS_ZSTD;
+   }
+
+   fseek(fp, 0, SEEK_SET);
+
+   return type;
+}
+
+static int pcap_compress_ext(const char* pcap_file) {  /* output compression type from file extension */
+
+int len = strlen(pcap_file);
+
+   if (len > 3 && !strcasecmp(&pcap_file[len-3], ".gz")) return PCAP_COMPRESS_GZIP;
+   if (len > 4 && !strcasecmp(&pcap_file[len-4], ".zst")) return PCAP_COMPRESS_ZSTD;
+
+   return PCAP_COMPRESS_NONE;
+}
+
+static ssize_t pcap_decompress(PCAP_COMPRESS_INFO* c, uint8_t* buf, size_t size) {  /* decompress up to size bytes. Returns number of bytes, 0 for end of file, or -1 for an error condition */
+
+zstd_out_buf_t out = { buf, size, 0 };
+size_t prev_pos, ret;
+
+   if (c->type == PCAP_COMPRESS_GZIP) return pcap_compress_lib.gzread(c->gz, buf, size);
+
+   while (out.pos < out.size) {
+
+      if (c->zin.pos >= c->zin.size && !c->fEnd) {  /* refill compressed data */
+
+         c->zin.src = c->zbuf;
+         c->zin.size = fread(c->zbuf, 1, PCAP_COMPRESS_BUF_SIZE, c->fp);
+         c->zin.pos = 0;
+         if (!c->zin.size) c->fEnd = true;
+      }
+
+      prev_pos = out.pos;
+
+      ret = pcap_compress_lib.ZSTD_decompressStream(c->zs, &out, &c->zin);  /* consecutive frames are handled by the decompressor */
+      if (pcap_compress_lib.ZSTD_isError(ret)) return -1;
+
+      if (c->fEnd && out.pos == prev_pos) break;  /* no more input and decompressor has nothing buffered */
+   }
+
+   return out.pos;
+}
+
+static int pcap_decompress_rewind(PCAP_COMPRESS_INFO* c) {  /* restart decompression at start of file */
+
+   c->win_start = c->win_len = 0;
+   c->pos = 0;
+
+   if (c->type == PCAP_COMPRESS_GZIP) return pcap_compress_lib.gzrewind(c->gz);
+
+   c->zin.size = c->zin.pos = 0;
+   c->fEnd = false;
+
+   if (pcap_compress_lib.ZSTD_isError(pcap_compress_lib.ZSTD_initDStream(c->zs))) return -1;
+
+   return fseek(c->fp, 0, SEEK_SET);
+}
+
+static ssize_t pcap_decompress_fill(PCAP_COMPRESS_INFO* c) {  /* add decompressed data to the window. If the window is full slide it, keeping the most recent PCAP_COMPRESS_BUF_SIZE bytes for backward seeks */
+
+ssize_t num_bytes;
+
+   if (c->win_len == 2*PCAP_COMPRESS_BUF_SIZE) {
+
+      memmove(c->win, &c->win[PCAP_COMPRESS_BUF_SIZE], PCAP_COMPRESS_BUF_SIZE);
+      c->win_start += PCAP_COMPRESS_BUF_SIZE;
+      c->win_len = PCAP_COMPRESS_BUF_SIZE;
+   }
+
+   if ((num_bytes = pcap_decompress(c, &c->win[c->win_len], 2*PCAP_COMPRESS_BUF_SIZE - c->win_len)) > 0) c->win_len += num_bytes;
+
+   return num_bytes;
+}
+
+static ssize_t pcap_compress_read(void* cookie, char* buf, size_t size) {  /* fopencookie() read function */
+
+PCAP_COMPRESS_INFO* c = (PCAP_COMPRESS_INFO*)cookie;
+size_t num_read = 0, len;
+ssize_t ret;
+
+   while (num_read < size) {
+
+      if (c->pos >= c->win_start + c->win_len) {  /* window consumed, decompress more */
+
+         if ((ret = pcap_decompress_fill(c)) < 0) return num_read ? (ssize_t)num_read : -1;
+         if (ret == 0) break;  /* end of file */
+         continue;
+      }
+
+      len = min((size_t)(c->win_start + c->win_len - c->pos), size - num_read);
+      memcpy(&buf[num_read], &c->win[c->pos - c->win_start], len);
+
+      num_read += len;
+      c->pos += len;
+   }
+
+   return num_read;
+}
+
+static ssize_t pcap_compress_write(void* cookie, const char* buf, size_t size) {  /* fopencookie() write function. Returns 0 for an error condition */
+
+PCAP_COMPRESS_INFO* c = (PCAP_COMPRESS_INFO*)cookie;
+zstd_in_buf_t in = { buf, size, 0 };
+
+   if (c->type == PCAP_COMPRESS_GZIP) {
+
+      if (pcap_compress_lib.gzwrite(c->gz, buf, size) != (int)size) return 0;
+   }
+   else while (in.pos < in.size) {
+
+      zstd_out_buf_t out = { c->zbuf, PCAP_COMPRESS_BUF_SIZE, 0 };
+
+      if (pcap_compress_lib.ZSTD_isError(pcap_compress_lib.ZSTD_compressStream(c->zs, &out, &in))) return 0;
+      if (out.pos && fwrite(c->zbuf, 1, out.pos, c->fp) != out.pos) return 0;
+   }
+
+   c->pos += size;
+
+   return size;
+}
+
+static int pcap_compress_seek(void* cookie, off64_t* offset, int whence) {  /* fopencookie() seek function, see notes above */
+
+PCAP_COMPRESS_INFO* c = (PCAP_COMPRESS_INFO*)cookie;
+int64_t target;
+
+   if (whence == SEEK_SET) target = *offset;
+   else if (whence == SEEK_CUR) target = (int64_t)c->pos + *offset;
+   else return -1;  /* SEEK_END not supported */
+
+   if (target < 0) return -1;
+
+   if ((uint64_t)target != c->pos) {
+
+      if (c->fWrite) return -1;  /* compressed outputs are sequential */
+
+      if ((uint64_t)target < c->win_start && pcap_decompress_rewind(c) < 0) return -1;
+
+      while ((uint64_t)target > c->win_start + c->win_len) if (pcap_decompress_fill(c) <= 0) return -1;  /* seek past end of file or error condition */
+
+      c->pos = target;
+   }
+
+   *offset = c->pos;
+
+   return 0;
+}
+
+static int pcap_compress_close(void* cookie) {  /* fopencookie() close function, called by fclose() after stdio buffered data is written */
+
+PCAP_COMPRESS_INFO* c = (PCAP_COMPRESS_INFO*)cookie;
+int ret_val = 0;
+size_t remaining;
+
+   if (c->type == PCAP_COMPRESS_GZIP) {
+      if (c->gz && pcap_compress_lib.gzclose(c->gz) != 0) ret_val = EOF;
+   }
+   else {
+
+      if (c->zs && c->fWrite) do {  /* write end of frame */
+
+         zstd_out_buf_t out = { c->zbuf, PCAP_COMPRESS_BUF_SIZE, 0 };
+
+         remaining = pcap_compress_lib.ZSTD_endStream(c->zs, &out);
+         if (pcap_compress_lib.ZSTD_isError(remaining) || (out.pos && fwrite(c->zbuf, 1, out.pos, c->fp) != out.pos)) { ret_val = EOF; break; }
+
+      } while (remaining);
+
+      if (c->zs) {
+         if (c->fWrite) pcap_compress_lib.ZSTD_freeCStream(c->zs);
+         else pcap_compress_lib.ZSTD_freeDStream(c->zs);
+      }
+
+      if (c->fp && fclose(c->fp) != 0) ret_val = EOF;
+   }
+
+   if (c->zbuf) free(c->zbuf);
+   if (c->win) free(c->win);
+   free(c);
+
+   return ret_val;
+}
+
+static FILE* pcap_compress_open(const char* pcap_file, int type, bool fWrite) {  /* open a compressed file as a FILE* stream. Returns NULL for an error condition, in which case a message has been logged */
+
+PCAP_COMPRESS_INFO* c;
+FILE* fp = NULL;
+cookie_io_functions_t io_funcs = { pcap_compress_read, pcap_compress_write, pcap_compress_seek, pcap_compress_close };
+const char* szType = type == PCAP_COMPRESS_GZIP ? "gzip" : "zstd";
+
+   pthread_once(&pcap_compress_lib_once, pcap_compress_lib_init);
+
+   if ((type == PCAP_COMPRESS_GZIP && !pcap_compress_lib.fGzip) || (type == PCAP_COMPRESS_ZSTD && !pcap_compress_lib.fZstd)) {
+
+      Log_RT(2, "ERROR: DSOpenPcap() says %s library (%s) not found, unable to open %s compressed file %s \n", szType, type == PCAP_COMPRESS_GZIP ? "libz.so" : "libzstd.so", szType, pcap_file);
+      return NULL;
+   }
+
+   if (!(c = (PCAP_COMPRESS_INFO*)calloc(1, sizeof(PCAP_COMPRESS_INFO)))) goto mem_err;
+
+   c->type = type;
+   c->fWrite = fWrite;
+
+   if (!fWrite && !(c->win = (uint8_t*)malloc(2*PCAP_COMPRESS_BUF_SIZE))) goto mem_err;
+
+   if (type == PCAP_COMPRESS_GZIP) {
+
+      if (!(c->gz = pcap_compress_lib.gzopen(pcap_file, fWrite ? PCAP_COMPRESS_GZIP_MODE : "rb"))) goto open_err;
+
+      pcap_compress_lib.gzbuffer(c->gz, PCAP_COMPRESS_BUF_SIZE);  /* zlib internal buffer size, must be set before first read or write */
+   }
+   else {
+
+      if (!(c->fp = fopen(pcap_file, fWrite ? "wb" : "rb"))) goto open_err;
+      if (!(c->zbuf = (uint8_t*)malloc(PCAP_COMPRESS_BUF_SIZE))) goto mem_err;
+
+      if (!(c->zs = fWrite ? pcap_compress_lib.ZSTD_createCStream() : pcap_compress_lib.ZSTD_createDStream())) goto mem_err;
+
+      if (pcap_compress_lib.ZSTD_isError(fWrite ? pcap_compress_lib.ZSTD_initCStream(c->zs, PCAP_COMPRESS_ZSTD_LEVEL) : pcap_compress_lib.ZSTD_initDStream(c->zs))) goto open_err;
+   }
+
+   if ((fp = fopencookie(c, fWrite ? "wb" : "rb", io_funcs))) return fp;
+
+open_err:
+   Log_RT(2, "ERROR: DSOpenPcap() unable to open %s compressed %s file %s, errno = %d \n", szType, fWrite ? "output" : "input", pcap_file, errno);
+   if (c) pcap_compress_close(c);
+   return NULL;
+
+mem_err:
+   Log_RT(2, "ERROR: DSOpenPcap() says unable to allocate memory for %s compressed file %s \n", szType, pcap_file);
+   if (c) pcap_compress_close(c);
+   return NULL;
+}
+
+/* helpers shared by DSReadPcap() and DSReadPcapPtr() */
+
+static uint32_t format_rtp_record(uint8_t* rtp_data, uint16_t rtp_len, pcap_hdr_t* pcap_file_hdr, uint8_t* pkt_buffer) {  /* create an IPv4/UDP packet from .rtp record data, return formatted packet length */
+
+FORMAT_PKT format_pkt;
+
+   format_pkt.IP_Version = IPv4;
+
+/* create IPv4 packet, JHB May 2024. Notes:
+
+   -use .rtp file header source and destination IP address and port fields if they have non-zero values
+   -only if pcap_file_hdr has been given by caller (which implies the caller saved it from original DSOpenPcap() call)
+   -so far I've only seen .rtp file format specs that allow (i) one RTP stream per file and (ii) IPv4 addresses (see other comments with https links). Also I'm not sure why destination IP address and port are in string format but source values are not
+*/
+
+   if (pcap_file_hdr && pcap_file_hdr->rtp.src_ip_addr != 0) memcpy(&format_pkt.SrcAddr, &pcap_file_hdr->rtp.src_ip_addr, IPV4_ADDR_LEN);  /* use src IP addr and port if non-zero, otherwise use generic local IP values */
+   else {
+      uint32_t src_ip_addr = htonl(0xC0A80003);  /* 192.168.0.3 */
+      memcpy(&format_pkt.SrcAddr, &src_ip_addr, IPV4_ADDR_LEN);  /* FORMAT_PKT SrcAddr field is 16 bytes, so we use memcpy() to fill first 4 bytes */
+   }
+   if (pcap_file_hdr && pcap_file_hdr->rtp.src_port != 0) format_pkt.udpHeader.SrcPort = pcap_file_hdr->rtp.src_port;
+   else format_pkt.udpHeader.SrcPort = 0x0228;  /* 10242, network byte order */
+
+   #if 0
+   uint32_t src_ip_addr;
+   memcpy(&src_ip_addr, &format_pkt.SrcAddr, IPV4_ADDR_LEN);
+   printf(" src ip addr = %x, port = %u \n", src_ip_addr, format_pkt.udpHeader.SrcPort);
+   #endif
+
+   uint32_t dst_ip_addr;
+   uint16_t dst_port;
+
+   if (!pcap_file_hdr || inet_pton(AF_INET, (const char*)&pcap_file_hdr->rtp.dst_ip_addr, &dst_ip_addr) != 1 || dst_ip_addr == 0) {  /* if dest IP address is non-zero then convert xx.xx.xx.xx format to integer */
+      dst_ip_addr = htonl(0xC0A80001);  /* otherwise use generic local IP addr 192.168.0.1 */
+   }
+   memcpy(&format_pkt.DstAddr, &dst_ip_addr, IPV4_ADDR_LEN);
+
+   if (!pcap_file_hdr || (dst_port = htons(atoi((const char*)&pcap_file_hdr->rtp.dst_port))) == 0) {  /* convert dest port from string (network byte order) */
+      dst_port = 0x0A18;  /* 6154, network byte order */
+   }
+   format_pkt.udpHeader.DstPort = dst_port;
+
+   #if 0
+   memcpy(&dst_ip_addr, &format_pkt.DstAddr, IPV4_ADDR_LEN);
+   printf(" dst ip addr = %x, port = %u, dst ip string = %s \n", dst_ip_addr, format_pkt.udpHeader.DstPort, pcap_file_hdr ? (const char*)&pcap_file_hdr->rtp.dst_ip_addr : "n/a");
+   #endif
+
+   return DSFormatPacket(-1, DS_FMT_PKT_STANDALONE | DS_FMT_PKT_USER_HDRALL | DS_FMT_PKT_USER_UDP_PAYLOAD, rtp_data, rtp_len, &format_pkt, pkt_buffer);
+}
+
+static void tso_length_fix(unsigned int uFlags, uint16_t block_type, uint8_t* pkt_ptr, uint32_t incl_len) {
+
+/* if specified by uFlags, apply TSO "zero length" fix and set packet length to what was captured. Note that Wireshark will label these as "length reported as 0, presumed to be because of TCP segmentation offload (TSO)", test with capture_test2.png, JHB Feb 2025 */
+
+   if (!(uFlags & DS_READ_PCAP_DISABLE_TSO_LENGTH_FIX) && (block_type == PCAP_PB_TYPE || block_type == RTP_PB_TYPE || block_type == PCAPNG_EPB_TYPE || block_type == PCAPNG_SPB_TYPE) && (pkt_ptr[0] >> 4) == IPV4 && pkt_ptr[9] == TCP) {  /* to-do: handle IPv6 */
+
+      if (!((pkt_ptr[2] << 8) | pkt_ptr[3])) {  /* if length is reported as zero then set to packet capture length */
+
+         pkt_ptr[2] = incl_len >> 8;
+         pkt_ptr[3] = incl_len & 0xff;
+         #ifdef TSO_LENGTH_FIX_DEBUG
+         printf("\n *** applying TSO length fix, inserting pkt len = %d \n", (pkt_ptr[2] << 8) | pkt_ptr[3]);
+         #endif
+      }
+   }
+}
+
+static void log_unused_block(const char* szFunc, unsigned int uFlags, uint32_t block_type, int link_len) {
+
+/* inform if NRB, statistics, journal, or decryption block; warn on unknown block */
+
+   if (block_type == 4 || block_type == 5 || block_type == 9 || block_type == 10) {
+
+      char blkstr[20];
+      switch (block_type) {
+         case 4:
+            strcpy(blkstr, "NRB");
+            break;
+         case 5:
+            strcpy(blkstr, "statistics");  /* test with 1920x1080_H.265.pcapng */
+            break;
+         case 9:
+            strcpy(blkstr, "journal");
+            break;
+         case 10:
+            strcpy(blkstr, "decryption");
+            break;
+      }
+
+      if (!(uFlags & DS_READ_PCAP_SUPPRESS_INFO_MSG)) Log_RT(4, "INFO: %s() says reading unused %s block (type = %d), ignoring data, link len = %d, uFlags = 0x%x \n", szFunc, blkstr, block_type, link_len, uFlags);
+   }
+   else if (!(uFlags & DS_READ_PCAP_SUPPRESS_WARNING_ERROR_MSG)) Log_RT(3, "WARNING: %s() says reading unknown block type %d, ignoring data, link_len = %d, uFlags = 0x%x \n", szFunc, block_type, link_len, uFlags);
+}
+
 //#define DEBUG_PCAPNG  /* enable for pcapng format debug, JHB Oct 2020 */
 
 int DSOpenPcap(const char* pcap_file, unsigned int uFlags, FILE** fp_pcap, pcap_hdr_t* pcap_file_hdr, const char* pErrstr) {
@@ -111,6 +672,7 @@ pcapng_hdr_t* p_file_hdr_ng;
 pcapng_idb_t file_idb_pcapng;
 char errstr[MAX_INPUT_LEN] = "";
 char tmpstr[2*MAX_INPUT_LEN];
+int compress_type;
 
    if (!pcap_file || !strlen(pcap_file) || !fp_pcap) {  /* look for NULL path/filename, empty string, or NULL file pointer, JHB Jul 2024 */
 
@@ -129,9 +691,12 @@ char tmpstr[2*MAX_INPUT_LEN];
 
    if (uFlags & DS_WRITE) {
 
-   /* open file for writing */
+   /* open file for writing. Output is compressed if filename ends in .gz or .zst, JHB Oct 2026 */
 
-      *fp_pcap = fopen(pcap_file, "wb");
+      if ((compress_type = pcap_compress_ext(pcap_file)) != PCAP_COMPRESS_NONE) {
+         if (!(*fp_pcap = pcap_compress_open(pcap_file, compress_type, true))) goto wr_ret;  /* error message already logged */
+      }
+      else *fp_pcap = fopen(pcap_file, "wb");
 
       if (!*fp_pcap) {
    
@@ -146,7 +711,7 @@ char tmpstr[2*MAX_INPUT_LEN];
 
          if (!(uFlags & DS_OPEN_PCAP_QUIET)) {
 
-            sprintf(tmpstr, "INFO: DSOpenPcap() opened output%s file: %s \n", extstr, pcap_file);
+            sprintf(tmpstr, "INFO: DSOpenPcap() opened output%s%s file: %s \n", compress_type == PCAP_COMPRESS_GZIP ? " gzip compressed" : compress_type == PCAP_COMPRESS_ZSTD ? " zstd compressed" : "", extstr, pcap_file);
             Log_RT(4, tmpstr);
          }
       }
@@ -193,11 +758,17 @@ wr_ret:
          }
          else {
 
+            if ((compress_type = pcap_compress_type(*fp_pcap)) != PCAP_COMPRESS_NONE) {  /* gzip or zstd compressed input, re-open as a decompressing stream, JHB Oct 2026 */
+
+               fclose(*fp_pcap);
+               if (!(*fp_pcap = pcap_compress_open(pcap_file, compress_type, false))) goto rd_ret;  /* error message already logged */
+            }
+
             ret_val = 1;
 
             if (!(uFlags & DS_OPEN_PCAP_QUIET)) {
 
-               sprintf(tmpstr, "INFO: DSOpenPcap() opened input%s file: %s \n", extstr, pcap_file);
+               sprintf(tmpstr, "INFO: DSOpenPcap() opened input%s%s file: %s \n", compress_type == PCAP_COMPRESS_GZIP ? " gzip compressed" : compress_type == PCAP_COMPRESS_ZSTD ? " zstd compressed" : "", extstr, pcap_file);
                Log_RT(4, tmpstr);
             }
          }
@@ -423,6 +994,17 @@ wr_ret:
       }
 
 rd_ret:
+
+      if (ret_val >= 0 && *fp_pcap && (uFlags & (DS_OPEN_PCAP_MMAP | DS_OPEN_PCAP_RESET))) {  /* memory-mapped read mode: map file after header(s) have been read and fp_pcap points at first record. For a reset, sync the mapped read position if the file is already mapped, JHB Oct 2026 */
+
+         if (pcap_mmap_attach(*fp_pcap, uFlags, pcap_file) < 0) {
+
+            fclose(*fp_pcap);
+            *fp_pcap = NULL;
+            ret_val = -1;
+         }
+      }
+
       return ret_val;
    }
 }
@@ -607,32 +1189,10 @@ a few useful constants from if_ether.h (one copy here https://github.com/spotify
          p_pkt_hdr->incl_len = pcapng_block_header.block_length - sizeof(pcapng_block_header_t) - 4;  /* duplicated block length field is handled together with padding below */
 
          fUnusedBlockType = true;  /* prevent reading data below, and seek instead */
-         int link_len_save = link_len;
-         link_len = 0;
 
-      /* inform if NRB, statistics, journal, or decryption block; warn on unknown block */
-
-         if (pcapng_block_header.block_type == 4 || pcapng_block_header.block_type == 5 || pcapng_block_header.block_type == 9 || pcapng_block_header.block_type == 10) {
-
-            char blkstr[20];
-            switch (pcapng_block_header.block_type) {
-               case 4:
-                  strcpy(blkstr, "NRB");
-                  break;
-               case 5:
-                  strcpy(blkstr, "statistics");  /* test with 1920x1080_H.265.pcapng */
-                  break;
-               case 9:
-                  strcpy(blkstr, "journal");
-                  break;
-               case 10:
-                  strcpy(blkstr, "decryption");
-                  break;
-            }
+         log_unused_block("DSReadPcap", uFlags, pcapng_block_header.block_type, link_len);  /* inform if NRB, statistics, journal, or decryption block; warn on unknown block */
 
-            if (!(uFlags & DS_READ_PCAP_SUPPRESS_INFO_MSG)) Log_RT(4, "INFO: DSReadPcap() says reading unused %s block (type = %d), ignoring data, link len = %d, uFlags = 0x%x \n", blkstr, pcapng_block_header.block_type, link_len_save, uFlags);
-         }
-         else if (!(uFlags & DS_READ_PCAP_SUPPRESS_WARNING_ERROR_MSG)) Log_RT(3, "WARNING: DSReadPcap() says reading unknown block type %d, ignoring data, link_len = %d, uFlags = 0x%x \n", pcapng_block_header.block_type, link_len_save, uFlags);
+         link_len = 0;
       }
    }
 
@@ -755,363 +1315,1872 @@ a few useful constants from if_ether.h (one copy here https://github.com/spotify
       p_pkt_hdr->incl_len = packet_length = rtp_len + IPV4_HEADER_LEN + UDP_HEADER_LEN;
       p_pkt_hdr->orig_len = p_pkt_hdr->incl_len;
 
-      FORMAT_PKT format_pkt;
-      format_pkt.IP_Version = IPv4;
-
-   /* create IPv4 packet, JHB May 2024. Notes:
+      uint32_t pkt_len_fmt = format_rtp_record(rtp_data, rtp_len, pcap_file_hdr, pkt_ptr);  /* create IPv4/UDP packet, using .rtp file header addresses and ports if available */
 
-      -use .rtp file header source and destination IP address and port fields if they have non-zero values
-      -only if pcap_file_hdr has been given by caller (which implies the caller saved it from original DSOpenPcap() call)
-      -so far I've only seen .rtp file format specs that allow (i) one RTP stream per file and (ii) IPv4 addresses (see other comments with https links). Also I'm not sure why destination IP address and port are in string format but source values are not
-   */
+      #if 0  /* additional .rtp format sanity checks - verify all payload sub lengths match after submitting packet to DSPacketInfo(), JHB Oct 2024 */
+      int pktlen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt_buffer, -1, NULL, NULL);
+      int udplen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PYLDLEN, pkt_buffer, -1, NULL, NULL);
+      int rtplen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_PYLDLEN, pkt_buffer, -1, NULL, NULL);
+      uint32_t rtp_timestamp = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_TIMESTAMP, pkt_buffer, -1, NULL, NULL);
+
+      printf("\n *** p_pkt_hdr->incl_len = %u, packet_length = %u, pkt_len_fmt = %u, rtp_len = %u, timestamp = %u.%u sec, pktlib info: pkt len = %d, udp len = %d, rtp pyld len = %d, rtp timestamp = %u \n", p_pkt_hdr->incl_len, packet_length, pkt_len_fmt, rtp_len, p_pkt_hdr->ts_sec, p_pkt_hdr->ts_usec/1000, pktlen, udplen, rtplen, rtp_timestamp);
+      #endif
+
+      if (pkt_len_fmt != p_pkt_hdr->incl_len) Log_RT(3, "WARNING: DSReadPcap() says packet len after format %u not matching file record len %u \n", pkt_len_fmt, p_pkt_hdr->incl_len);
+   }
+
+/* apply TSO "zero length" fix if needed */
+
+   tso_length_fix(uFlags, *p_block_type, pkt_ptr, p_pkt_hdr->incl_len);
+
+   if (file_type == PCAP_TYPE_PCAPNG) {
+
+      int ret_val, i, num_int32 = 0;
+      uint32_t dummy_uint32;
+      (void)ret_val;
+      padding = (4 - (p_pkt_hdr->incl_len & 3)) & 3;
+      ret_val = fread(&dummy_uint32, padding, 1, fp_in);  /* pcapng format pads packet data to 32 bits */
+
+      if (pcapng_block_header.block_type == PCAPNG_EPB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_epb_t) - p_pkt_hdr->incl_len - padding)/4;
+      else if (pcapng_block_header.block_type == PCAPNG_SPB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_spb_t) - p_pkt_hdr->incl_len - padding)/4;
+      else if (pcapng_block_header.block_type == PCAPNG_IDB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_idb_t) - p_pkt_hdr->incl_len - padding)/4;
+      else num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_block_header_t) - p_pkt_hdr->incl_len - padding)/4;
+
+      for (i=0; i<num_int32; i++) ret_val = fread(&dummy_uint32, sizeof(uint32_t), 1, fp_in);  /* read past options, if any, and duplicated block length field */
+   }
+
+   #ifdef DEBUG_PCAPNG
+   static int count2 = 0;
+   if (count2 < 5 || (file_type == PCAP_TYPE_PCAPNG && pcapng_epb.block_type != 6)) {
+     printf(" packet len = %d, padding = %d \n", packet_length, padding);
+     count2++;
+   }
+   #endif
+
+   if (uFlags & DS_READ_PCAP_COPY) fseek(fp_in, fp_save, SEEK_SET);  /* restore filepos if needed */
+
+   return packet_length;
+
+/* read error handler */
+
+pcap_read_error:
+
+   if (!strlen(errstr)) fprintf(stderr, "\n *** code bug: inside DSReadPcap() error handler but errstr len is zero \n");  /* errstr should have non-zero length for error condition */
+
+   if (feof(fp_in)) return 0;  /* we already checked feof() on entry, but sometimes fread() returns 0 bytes even if not feof, then checking feof again shows true. I have no idea why, but for now let it be, JHB Feb 2025 */ 
+
+   char* file_path = getFilePathFromFilePointer(fp_in);
+   Log_RT(2, "ERROR: DSReadPcap() says %s from file %s, uFlags = 0x%x \n", errstr, file_path ? file_path : "error in getFilePathFromPointer()", uFlags);
+   if (file_path) free(file_path);
+   return -1;  /* return error condition */
+}
+
+/* read a pcap record in place from a memory-mapped pcap, pcapng, or rtp file, JHB Oct 2026. Notes:
+
+  -fp_pcap must be opened by DSOpenPcap() with the DS_OPEN_PCAP_MMAP flag
+  -on return *p_pkt points to packet data inside the mapping (for .rtp records, to a per-handle buffer containing the formatted IPv4/UDP packet). The pointer is valid until the next DSReadPcapPtr() or DSClosePcap() call on fp_pcap
+  -record parsing, link layer handling, and return values are the same as DSReadPcap(). A record truncated by end of file returns zero, same as DSReadPcap()
+*/
+
+int DSReadPcapPtr(FILE* fp_pcap, unsigned int uFlags, uint8_t** p_pkt, pcaprec_hdr_t* pcap_pkt_hdr, int link_layer_info, uint16_t* p_eth_protocol, uint16_t* p_block_type, pcap_hdr_t* pcap_file_hdr) {
+
+PCAP_MMAP_INFO* p;
+pcaprec_hdr_t pcap_pkt_hdr_local;
+pcaprec_hdr_t* p_pkt_hdr;
+pcapng_block_header_t pcapng_block_header;
+uint8_t* rec;   /* start of current record */
+uint8_t* data;  /* start of record data (link layer, if any, followed by packet data) */
+uint64_t pos, next_pos;
+int packet_length;
+uint16_t eth_protocol = 0, file_type, link_len, link_type;
+uint16_t rtp_len = 0, record_len = 0;  /* rtp file format items */
+char errstr[1024] = "";
+bool fUnusedBlockType = false;
+
+uint16_t block_type_local = 0;
+
+   if (!p_pkt || !(p = find_pcap_mmap(fp_pcap))) {
+
+      Log_RT(2, "ERROR: DSReadPcapPtr() says %s \n", !p_pkt ? "p_pkt is NULL" : "fp_pcap is NULL or was not opened with DS_OPEN_PCAP_MMAP flag");
+      return -1;
+   }
+
+   if (!p->base) {  /* mmap() failed in DSOpenPcap(), fall back to DSReadPcap() using the handle's scratch buffer */
+
+      if (!p->pkt_buf && !(p->pkt_buf = (uint8_t*)malloc(MAX_TCP_PACKET_LEN))) return -1;
+
+      *p_pkt = p->pkt_buf;
+      return DSReadPcap(fp_pcap, uFlags, p->pkt_buf, pcap_pkt_hdr, link_layer_info, p_eth_protocol, p_block_type, pcap_file_hdr);
+   }
+
+   *p_pkt = NULL;
+
+   if (!pcap_pkt_hdr) p_pkt_hdr = &pcap_pkt_hdr_local;
+   else p_pkt_hdr = pcap_pkt_hdr;
+
+   if (!p_block_type) p_block_type = &block_type_local;
+
+   file_type = (link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16;
+   link_type = (link_layer_info & PCAP_LINK_LAYER_LINK_TYPE_MASK) >> 20;
+   link_len = link_layer_info & PCAP_LINK_LAYER_LEN_MASK;
+
+   pos = p->pos;
+   rec = p->base + pos;
+
+   #define MMAP_AVAIL(n) (pos + (uint64_t)(n) <= p->size)  /* check for enough mapped data remaining */
+
+   if (!MMAP_AVAIL(1)) return 0;  /* end of file */
+
+/* parse pcap or rtp record header */
+
+   if (file_type == PCAP_TYPE_RTP) {
+
+      uint32_t timestamp;  /* msec offset from start, big-endian, see comments in DSReadPcap() */
+
+      *p_block_type = RTP_PB_TYPE;
+
+      if (!MMAP_AVAIL(8)) return 0;  /* partial record at end of file */
+
+      record_len = (rec[0] << 8) | rec[1];
+      rtp_len = (rec[2] << 8) | rec[3];
+
+      if ((int)record_len - (int)rtp_len != 8) Log_RT(3, "WARNING: DSReadPcapPtr() says rtp format record header fails sanity check, record_len = %u, rtp_len = %u \n", record_len, rtp_len);
+
+      timestamp = ((uint32_t)rec[4] << 24) | (rec[5] << 16) | (rec[6] << 8) | rec[7];
+
+      p_pkt_hdr->ts_sec = timestamp / 1000L;
+      p_pkt_hdr->ts_usec = 1000*timestamp - 1000000L * p_pkt_hdr->ts_sec;
+      p_pkt_hdr->incl_len = rtp_len;
+
+      data = rec + 8;
+      next_pos = pos + 8 + rtp_len;
+   }
+   else if (file_type == PCAP_TYPE_LIBPCAP) {
+
+      *p_block_type = PCAP_PB_TYPE;
+
+      if (!MMAP_AVAIL(sizeof(pcaprec_hdr_t))) return 0;
+
+      memcpy(p_pkt_hdr, rec, sizeof(pcaprec_hdr_t));  /* records are not guaranteed to be aligned, so we copy */
+
+      data = rec + sizeof(pcaprec_hdr_t);
+      next_pos = pos + sizeof(pcaprec_hdr_t) + p_pkt_hdr->incl_len;
+   }
+   else {  /* pcapng format */
+
+      if (!MMAP_AVAIL(sizeof(pcapng_block_header_t))) return 0;
+
+      memcpy(&pcapng_block_header, rec, sizeof(pcapng_block_header_t));
+
+      *p_block_type = pcapng_block_header.block_type;
+
+      if (pcapng_block_header.block_length < sizeof(pcapng_block_header_t) + 4) { sprintf(errstr, "invalid pcapng block length %u", pcapng_block_header.block_length); goto pcap_read_error; }
+      if (!MMAP_AVAIL(pcapng_block_header.block_length)) return 0;
+
+      next_pos = pos + pcapng_block_header.block_length;  /* block length includes padding, options, and duplicated block length */
+
+      if (pcapng_block_header.block_type == PCAPNG_SPB_TYPE) {
+
+         pcapng_spb_t pcapng_spb;
+         memcpy(&pcapng_spb, rec, sizeof(pcapng_spb_t));
+
+         p_pkt_hdr->orig_len = p_pkt_hdr->incl_len = pcapng_spb.original_pkt_len;
+         p_pkt_hdr->ts_sec = 0;  /* simple blocks don't have timestamps */
+         p_pkt_hdr->ts_usec = 0;
+
+         data = rec + sizeof(pcapng_spb_t);
+      }
+      else if (pcapng_block_header.block_type == PCAPNG_EPB_TYPE) {
+
+         pcapng_epb_t pcapng_epb;
+         memcpy(&pcapng_epb, rec, sizeof(pcapng_epb_t));
+
+         p_pkt_hdr->incl_len = pcapng_epb.captured_pkt_len;
+         p_pkt_hdr->orig_len = pcapng_epb.original_pkt_len;
+
+         uint64_t usec = ((uint64_t)pcapng_epb.timestamp_hi << 32) | pcapng_epb.timestamp_lo;
+         p_pkt_hdr->ts_sec = usec / 1000000L;
+         p_pkt_hdr->ts_usec = usec - 1000000L * p_pkt_hdr->ts_sec;
 
-      if (pcap_file_hdr && pcap_file_hdr->rtp.src_ip_addr != 0) memcpy(&format_pkt.SrcAddr, &pcap_file_hdr->rtp.src_ip_addr, IPV4_ADDR_LEN);  /* use src IP addr and port if non-zero, otherwise use generic local IP values */
+         data = rec + sizeof(pcapng_epb_t);
+      }
+      else if (pcapng_block_header.block_type == PCAPNG_IDB_TYPE) {
+
+         p_pkt_hdr->incl_len = pcapng_block_header.block_length - sizeof(pcapng_idb_t) - 4;
+
+         data = rec + sizeof(pcapng_idb_t);
+      }
+      else {  /* unused or unknown block type, see notes in DSReadPcap() */
+
+         p_pkt_hdr->incl_len = pcapng_block_header.block_length - sizeof(pcapng_block_header_t) - 4;
+
+         data = rec + sizeof(pcapng_block_header_t);
+         fUnusedBlockType = true;
+
+         log_unused_block("DSReadPcapPtr", uFlags, pcapng_block_header.block_type, link_len);
+
+         link_len = 0;
+      }
+
+      if ((uint64_t)(data - p->base) + p_pkt_hdr->incl_len > next_pos) { sprintf(errstr, "pcapng block type %u captured length %u exceeds block length %u", pcapng_block_header.block_type, p_pkt_hdr->incl_len, pcapng_block_header.block_length); goto pcap_read_error; }
+   }
+
+   if ((uint64_t)(data - p->base) + p_pkt_hdr->incl_len > p->size) return 0;  /* partial record at end of file */
+
+   if (p_pkt_hdr->incl_len < link_len) { sprintf(errstr, "incl_len %d < link_len %d", p_pkt_hdr->incl_len, link_len); goto pcap_read_error; }
+
+/* link layer handling, same as DSReadPcap() but parsed in place */
+
+   if (link_len == sizeof(ethhdr)) {
+
+      uint32_t null_loopback_af_inet;
+      memcpy(&null_loopback_af_inet, data, sizeof(uint32_t));  /* first 4 bytes of link layer could be Null/Loopback protocol ID */
+
+      if (!(uFlags & DS_READ_PCAP_DISABLE_NULL_LOOPBACK_PROTOCOL) && null_loopback_af_inet == 2) {
+
+         link_len = NULL_LOOPBACK_LINK_LEN;
+         eth_protocol = ETH_P_IP;
+      }
+      else if (!(uFlags & DS_READ_PCAP_DISABLE_NULL_LOOPBACK_PROTOCOL) && (null_loopback_af_inet == 24 || null_loopback_af_inet == 28 || null_loopback_af_inet == 30)) {
+
+         link_len = NULL_LOOPBACK_LINK_LEN;
+         eth_protocol = ETH_P_IPV6;
+      }
       else {
-         uint32_t src_ip_addr = htonl(0xC0A80003);  /* 192.168.0.3 */
-         memcpy(&format_pkt.SrcAddr, &src_ip_addr, IPV4_ADDR_LEN);  /* FORMAT_PKT SrcAddr field is 16 bytes, so we use memcpy() to fill first 4 bytes */
+
+         eth_protocol = (data[12] << 8) | data[13];  /* stored in file as big-endian */
+
+         if (eth_protocol == ETH_P_8021Q) link_len += sizeof(vlan_hdr_t);  /* skip VLAN header. Note if there is "double-tagging" (stacked VLAN) we need to add a little more code here */
       }
-      if (pcap_file_hdr && pcap_file_hdr->rtp.src_port != 0) format_pkt.udpHeader.SrcPort = pcap_file_hdr->rtp.src_port;
-      else format_pkt.udpHeader.SrcPort = 0x0228;  /* 10242, network byte order */
+   }
+   else if (link_len == LINKTYPE_LINUX_SLL_LINK_LEN) {
 
-      #if 0
-      uint32_t src_ip_addr;
-      memcpy(&src_ip_addr, &format_pkt.SrcAddr, IPV4_ADDR_LEN);
-      printf(" src ip addr = %x, port = %u \n", src_ip_addr, format_pkt.udpHeader.SrcPort);
-      #endif
+      eth_protocol = (data[14] << 8) | data[15];  /* Linux SLL ethernet header type follows 14 bytes of MAC address and unused fields */
+   }
+   else if (get_link_layer_len(link_type) < 0) {
+
+      Log_RT(3, "WARNING: DSReadPcapPtr() says unexpected link type = %d, file_type = %d, link_len = %d \n", link_type, file_type, link_len);
+   }
+
+   if (p_eth_protocol) *p_eth_protocol = eth_protocol;
+
+   if ((packet_length = p_pkt_hdr->incl_len - link_len) <= 0) { sprintf(errstr, "incl_len %d - link_len %d <= 0 when reading", p_pkt_hdr->incl_len, link_len); goto pcap_read_error; }
+
+   if (file_type != PCAP_TYPE_RTP) {
+
+      if (!fUnusedBlockType) *p_pkt = data + link_len;  /* return pointer into the mapping. For unused block types no data is returned, same as DSReadPcap() */
+   }
+   else {  /* .rtp records include only RTP header and payload, so we create an IPv4 packet in the handle's scratch buffer */
+
+      if (!p->pkt_buf && !(p->pkt_buf = (uint8_t*)malloc(MAX_TCP_PACKET_LEN))) { sprintf(errstr, "unable to allocate %d bytes for rtp packet buffer", MAX_TCP_PACKET_LEN); goto pcap_read_error; }
+
+      p_pkt_hdr->incl_len = packet_length = rtp_len + IPV4_HEADER_LEN + UDP_HEADER_LEN;
+      p_pkt_hdr->orig_len = p_pkt_hdr->incl_len;
+
+      uint32_t pkt_len_fmt = format_rtp_record(data, rtp_len, pcap_file_hdr, p->pkt_buf);
+
+      if (pkt_len_fmt != p_pkt_hdr->incl_len) Log_RT(3, "WARNING: DSReadPcapPtr() says packet len after format %u not matching file record len %u \n", pkt_len_fmt, p_pkt_hdr->incl_len);
+
+      *p_pkt = p->pkt_buf;
+   }
+
+/* apply TSO "zero length" fix if needed. The mapping is MAP_PRIVATE so this modifies only our copy of the page */
+
+   if (*p_pkt) tso_length_fix(uFlags, *p_block_type, *p_pkt, p_pkt_hdr->incl_len);
+
+   if (!(uFlags & DS_READ_PCAP_COPY)) p->pos = next_pos;  /* advance to next record unless only a copy was requested */
+
+   return packet_length;
+
+pcap_read_error:
+
+   char* file_path = getFilePathFromFilePointer(fp_pcap);
+   Log_RT(2, "ERROR: DSReadPcapPtr() says %s from file %s at offset %llu, uFlags = 0x%x \n", errstr, file_path ? file_path : "error in getFilePathFromPointer()", (unsigned long long)pos, uFlags);
+   if (file_path) free(file_path);
+   return -1;
+}
+
+/* read a batch of pcap records into a packet arena, JHB Oct 2026. See notes in pktlib.h */
+
+static inline bool isPacketBlockType(uint16_t block_type) { return block_type == PCAP_PB_TYPE || block_type == RTP_PB_TYPE || block_type == PCAPNG_EPB_TYPE || block_type == PCAPNG_SPB_TYPE; }
+
+#define BATCH_ARENA_ALIGN(n)  (((n) + 7) & ~7)  /* keep packet data in arena 8-byte aligned */
+
+int DSReadPcapBatch(FILE* fp_pcap, unsigned int uFlags, uint8_t* arena, int arena_len, pcap_batch_rec_t batch_recs[], int max_recs, int link_layer_info, pcap_hdr_t* pcap_file_hdr) {
+
+PCAP_MMAP_INFO* p;
+int num_recs = 0, arena_ofs = 0, pkt_len = 0;
+uint16_t eth_protocol = 0, block_type = 0;
+pcaprec_hdr_t pcap_rec_hdr;
+uint8_t* pkt_ptr;
+
+   if (!fp_pcap || !arena || !batch_recs || arena_len <= 0 || max_recs <= 0) {
+
+      Log_RT(2, "ERROR: DSReadPcapBatch() says invalid param, fp_pcap = %p, arena = %p, arena_len = %d, batch_recs = %p, max_recs = %d \n", fp_pcap, arena, arena_len, batch_recs, max_recs);
+      return -1;
+   }
+
+   uFlags &= ~DS_READ_PCAP_COPY;  /* not supported, batch reads always advance */
+
+   if ((p = find_pcap_mmap(fp_pcap)) && !p->base) p = NULL;  /* if mmap() was not available for this handle use DSReadPcap() */
+
+   if (!p && arena_len < MAX_TCP_PACKET_LEN) {
+
+      Log_RT(2, "ERROR: DSReadPcapBatch() says arena_len %d less than minimum %d for non memory-mapped input \n", arena_len, MAX_TCP_PACKET_LEN);
+      return -1;
+   }
+
+   while (num_recs < max_recs) {
+
+      if (p) {  /* memory-mapped input: parse record in place, copy to arena only if it fits */
+
+         uint64_t pos_save = p->pos;
+
+         if ((pkt_len = DSReadPcapPtr(fp_pcap, uFlags, &pkt_ptr, &pcap_rec_hdr, link_layer_info, &eth_protocol, &block_type, pcap_file_hdr)) <= 0) break;
+
+         if (!isPacketBlockType(block_type)) continue;
+
+         if (pkt_len > arena_len - arena_ofs) {  /* doesn't fit, leave it for next batch */
+
+            p->pos = pos_save;
+
+            if (!num_recs) {
+               Log_RT(2, "ERROR: DSReadPcapBatch() says arena_len %d too small for packet length %d \n", arena_len, pkt_len);
+               return -1;
+            }
+
+            break;
+         }
+
+         memcpy(&arena[arena_ofs], pkt_ptr, pkt_len);
+      }
+      else {  /* buffered input: DSReadPcap() reads directly into arena, so we need room for a max size packet */
+
+         if (arena_len - arena_ofs < MAX_TCP_PACKET_LEN) break;
+
+         if ((pkt_len = DSReadPcap(fp_pcap, uFlags, &arena[arena_ofs], &pcap_rec_hdr, link_layer_info, &eth_protocol, &block_type, pcap_file_hdr)) <= 0) break;
+
+         if (!isPacketBlockType(block_type)) continue;
+      }
+
+      batch_recs[num_recs].offset = arena_ofs;
+      batch_recs[num_recs].pkt_len = pkt_len;
+      batch_recs[num_recs].eth_protocol = eth_protocol;
+      batch_recs[num_recs].block_type = block_type;
+      batch_recs[num_recs].pcap_rec_hdr = pcap_rec_hdr;
+
+      num_recs++;
+      arena_ofs = min(BATCH_ARENA_ALIGN(arena_ofs + pkt_len), arena_len);
+   }
+
+   if (!num_recs && pkt_len < 0) return pkt_len;  /* error condition with no records read */
+
+   return num_recs;
+}
+
+/* time based seek support, JHB Oct 2026. Notes:
+
+  -libpcap files are bisected by file offset, with no pass over the file. At each step the midpoint is resynchronized on a record boundary with pcap_scan_resync() (see DSScanPcap() notes below) and the record timestamp decides which half to keep. When the remaining span is PCAP_SEEK_BISECT_MIN_BYTES or less the seek reads forward to the first packet record at or after the target time. Buffered handles are mapped temporarily for the bisection
+  -bisection assumes arrival timestamps go backwards by no more than PCAP_SEEK_TS_JITTER sec, the same assumption made by DSScanPcap() resync chains
+  -pcapng, .rtp (.rtpdump), and compressed files have no fixed record header to resync on (or can't be mapped), so on first call for a handle DSSeekPcap() builds a coarse time index with one entry per PCAP_TIME_INDEX_INTERVAL records. Each entry holds a record file offset and the max arrival timestamp of all packet records before it. Using max instead of the previous record's timestamp keeps the index monotonic if timestamps are slightly out of order
+  -an indexed seek binary searches for the last entry with max timestamp less than the target time, positions there, and reads forward to the first packet record at or after the target time
+  -works for pcap, pcapng (EPB timestamps), and .rtp (.rtpdump) files, for both buffered and memory-mapped (DS_OPEN_PCAP_MMAP) handles
+  -entries are claimed and released the same way as pcap_mmap_info[]. DSClosePcap() frees the handle's time index
+*/
+
+#define MAX_PCAP_TIME_INDEX       1024
+#define PCAP_TIME_INDEX_INTERVAL  1024  /* records per index entry */
+
+#define PCAP_SEEK_BISECT_MIN_BYTES  (64*1024)  /* libpcap bisection stops when the remaining span is this size or less */
+#define PCAP_SEEK_TS_JITTER         1          /* seconds a timestamp may go backwards, for captures with slightly out of order arrival times */
+
+typedef struct {
+
+  uint64_t offset;    /* file offset of record */
+  uint64_t max_time;  /* max arrival timestamp (usec) of all packet records before offset */
+
+} PCAP_TIME_INDEX_ENTRY;
+
+typedef struct {
+
+  FILE*                  fp;           /* FILE* handle, used as lookup key. NULL indicates entry is available */
+  uint64_t               first_time;   /* arrival timestamp of first packet record */
+  uint32_t               num_entries;
+  PCAP_TIME_INDEX_ENTRY* entry;
+
+} PCAP_TIME_INDEX;
+
+static PCAP_TIME_INDEX pcap_time_index[MAX_PCAP_TIME_INDEX] = {{ 0 }};
+static int nPcapTimeIndexMax = 0;  /* high water mark of pcap_time_index[] entries in use */
+
+static PCAP_TIME_INDEX* find_pcap_time_index(FILE* fp) {
+
+   if (fp) for (int i=0; i<nPcapTimeIndexMax; i++) if (pcap_time_index[i].fp == fp) return &pcap_time_index[i];
+
+   return NULL;
+}
+
+static void pcap_time_index_free(PCAP_TIME_INDEX* t) {
+
+   if (t->entry) free(t->entry);
+
+   t->entry = NULL;
+   t->num_entries = 0;
+   t->first_time = 0;
+
+   __sync_synchronize();
+   t->fp = NULL;  /* release entry last */
+}
+
+static int pcap_seek_read(FILE* fp, int link_layer_info, pcaprec_hdr_t* pcap_pkt_hdr, uint16_t* p_block_type, pcap_hdr_t* pcap_file_hdr) {  /* read next record without returning packet data, for buffered or memory-mapped handles */
+
+uint8_t* pkt;
+
+   if (find_pcap_mmap(fp)) return DSReadPcapPtr(fp, DS_READ_PCAP_SUPPRESS_INFO_MSG, &pkt, pcap_pkt_hdr, link_layer_info, NULL, p_block_type, pcap_file_hdr);  /* DSReadPcapPtr() handles fallback if the file could not be mapped */
+
+   return DSReadPcap(fp, DS_READ_PCAP_SUPPRESS_INFO_MSG, NULL, pcap_pkt_hdr, link_layer_info, NULL, p_block_type, pcap_file_hdr);
+}
+
+static PCAP_TIME_INDEX* pcap_time_index_create(FILE* fp, int link_layer_info, pcap_hdr_t* pcap_file_hdr) {  /* build time index in one pass over the records, starting at current read position. Read position is restored when done */
+
+PCAP_TIME_INDEX* t;
+pcaprec_hdr_t pcap_pkt_hdr;
+uint16_t block_type;
+uint64_t start_pos, pos, rec_time, max_time = 0, record = 0;
+uint32_t num_alloc = 0;
+bool fFirst = true;
+int i, n, ret_val;
+
+   for (i=0; i<MAX_PCAP_TIME_INDEX; i++) if (__sync_bool_compare_and_swap(&pcap_time_index[i].fp, NULL, fp)) break;  /* claim first available entry */
+
+   if (i == MAX_PCAP_TIME_INDEX) {
+
+      Log_RT(2, "ERROR: DSSeekPcap() says max number of time indexed inputs %d exceeded \n", MAX_PCAP_TIME_INDEX);
+      return NULL;
+   }
+
+   while ((n = nPcapTimeIndexMax) < i+1 && !__sync_bool_compare_and_swap(&nPcapTimeIndexMax, n, i+1));  /* update high water mark */
+
+   t = &pcap_time_index[i];
+
+   start_pos = pcap_read_pos(fp);
+
+   do {
+
+      pos = pcap_read_pos(fp);
+
+      if (record % PCAP_TIME_INDEX_INTERVAL == 0) {  /* add index entry */
+
+         if (t->num_entries == num_alloc) {
+
+            PCAP_TIME_INDEX_ENTRY* entry = (PCAP_TIME_INDEX_ENTRY*)realloc(t->entry, (num_alloc = max(2*num_alloc, (uint32_t)256))*sizeof(PCAP_TIME_INDEX_ENTRY));
+
+            if (!entry) {
+
+               Log_RT(2, "ERROR: DSSeekPcap() says unable to allocate time index mem, %u entries \n", num_alloc);
+               pcap_set_read_pos(fp, start_pos);
+               pcap_time_index_free(t);
+               return NULL;
+            }
+
+            t->entry = entry;
+         }
+
+         t->entry[t->num_entries].offset = pos;
+         t->entry[t->num_entries++].max_time = max_time;
+      }
+
+      if ((ret_val = pcap_seek_read(fp, link_layer_info, &pcap_pkt_hdr, &block_type, pcap_file_hdr)) > 0) {
+
+         record++;
+
+         if (isPacketBlockType(block_type)) {
+
+            rec_time = (uint64_t)pcap_pkt_hdr.ts_sec*1000000L + pcap_pkt_hdr.ts_usec;
+
+            if (fFirst) { t->first_time = rec_time; fFirst = false; }
+            max_time = max(max_time, rec_time);
+         }
+      }
+
+   } while (ret_val > 0);
+
+   if (ret_val < 0) Log_RT(3, "WARNING: DSSeekPcap() says read error after %llu records, time index covers records up to the error \n", (unsigned long long)record);
+
+   pcap_set_read_pos(fp, start_pos);
+
+   return t;
+}
+
+static uint64_t pcap_scan_resync(uint8_t* base, uint64_t size, uint64_t start, uint32_t max_len, uint32_t ts_min);
+
+static uint64_t pcap_seek_bisect(FILE* fp, int link_layer_info, unsigned int uFlags, uint64_t* p_seek_time) {  /* bisect a libpcap file by offset. Returns offset of a record before the first packet record at or after seek_time, or 0 if the file can't be bisected. Relative seek_time is converted to absolute */
+
+PCAP_MMAP_INFO* p;
+pcap_hdr_t file_hdr;
+pcaprec_hdr_t rec_hdr;
+struct stat file_stat;
+uint8_t* base = NULL;
+uint64_t size = 0, lo = sizeof(pcap_hdr_t), hi, mid, ofs, rec_time;
+uint32_t max_len, ts_min;
+bool fMapped = false;
+
+   if (((link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) != PCAP_TYPE_LIBPCAP) return 0;
+
+   if ((p = find_pcap_mmap(fp)) && p->base) { base = p->base; size = p->size; }
+   else if (fileno(fp) >= 0 && !fstat(fileno(fp), &file_stat) && S_ISREG(file_stat.st_mode) && (uint64_t)file_stat.st_size >= lo + sizeof(pcaprec_hdr_t)) {  /* buffered handle, map for duration of the bisection. Compressed (fopencookie) streams have no file descriptor */
+
+      void* addr = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+
+      if (addr != MAP_FAILED) { base = (uint8_t*)addr; size = file_stat.st_size; fMapped = true; }
+   }
+
+   if (!base || size < lo + sizeof(pcaprec_hdr_t) || (memcpy(&file_hdr, base, sizeof(pcap_hdr_t)), file_hdr.magic_number != 0xa1b2c3d4)) {
+
+      if (fMapped) munmap(base, size);
+      return 0;
+   }
+
+   memcpy(&rec_hdr, base + lo, sizeof(pcaprec_hdr_t));  /* first record */
+
+   if (uFlags & DS_SEEK_PCAP_RELATIVE_TIME) *p_seek_time += (uint64_t)rec_hdr.ts_sec*1000000L + rec_hdr.ts_usec;
+
+   max_len = file_hdr.snaplen ? file_hdr.snaplen : 262144;  /* 262144 is the libpcap max snaplen */
+   ts_min = rec_hdr.ts_sec > PCAP_SEEK_TS_JITTER ? rec_hdr.ts_sec - PCAP_SEEK_TS_JITTER : 0;
+
+/* lo is always a record start earlier than seek_time (allowing for jitter), or the first record */
+
+   hi = size;
+
+   while (hi - lo > PCAP_SEEK_BISECT_MIN_BYTES) {
+
+      mid = lo + (hi - lo)/2;
+
+      if ((ofs = pcap_scan_resync(base, size, mid, max_len, ts_min)) >= hi) { hi = mid; continue; }  /* no record start found in [mid, hi) */
+
+      memcpy(&rec_hdr, base + ofs, sizeof(pcaprec_hdr_t));
+      rec_time = (uint64_t)rec_hdr.ts_sec*1000000L + rec_hdr.ts_usec;
+
+      if (rec_time + PCAP_SEEK_TS_JITTER*1000000L < *p_seek_time) lo = ofs;
+      else hi = mid;
+   }
+
+   if (fMapped) munmap(base, size);
+
+   return lo;
+}
+
+/* seek to a record by arrival time, see notes in pktlib.h */
+
+int DSSeekPcap(FILE* fp_pcap, unsigned int uFlags, uint64_t seek_time, int link_layer_info, pcap_hdr_t* pcap_file_hdr, uint64_t* p_rec_time) {
+
+PCAP_TIME_INDEX* t;
+pcaprec_hdr_t pcap_pkt_hdr;
+uint16_t block_type = 0;
+uint64_t pos, rec_time = 0;
+uint32_t lo, hi, mid;
+int ret_val;
+
+   if (!fp_pcap) {
+
+      Log_RT(2, "ERROR: DSSeekPcap() says fp_pcap is NULL \n");
+      return -1;
+   }
+
+   if (!(pos = pcap_seek_bisect(fp_pcap, link_layer_info, uFlags, &seek_time))) {  /* libpcap files are bisected by offset, other files use a time index */
+
+      if (!(t = find_pcap_time_index(fp_pcap)) && !(t = pcap_time_index_create(fp_pcap, link_layer_info, pcap_file_hdr))) return -1;
+
+      if (uFlags & DS_SEEK_PCAP_RELATIVE_TIME) seek_time += t->first_time;
+
+   /* binary search for first entry with max time >= seek_time, then step back one. Entry 0 max time is zero so this finds the last entry with max time < seek_time */
+
+      lo = 0; hi = t->num_entries;
+
+      while (lo < hi) {
+
+         mid = (lo + hi) >> 1;
+
+         if (t->entry[mid].max_time < seek_time) lo = mid + 1;
+         else hi = mid;
+      }
+
+      if (lo > 0) lo--;
+
+      pos = t->entry[lo].offset;
+   }
+
+   pcap_set_read_pos(fp_pcap, pos);
+
+/* read forward to first packet record at or after seek_time */
+
+   do {
+
+      pos = pcap_read_pos(fp_pcap);
+
+      if ((ret_val = pcap_seek_read(fp_pcap, link_layer_info, &pcap_pkt_hdr, &block_type, pcap_file_hdr)) <= 0) break;  /* no record at or after seek_time (file is left at end), or error condition */
+
+      rec_time = (uint64_t)pcap_pkt_hdr.ts_sec*1000000L + pcap_pkt_hdr.ts_usec;
+
+   } while (!isPacketBlockType(block_type) || rec_time < seek_time);
+
+   if (ret_val > 0) {
+
+      pcap_set_read_pos(fp_pcap, pos);  /* leave handle positioned at the found record */
+      if (p_rec_time) *p_rec_time = rec_time;
+      ret_val = 1;
+   }
+
+   return ret_val;
+}
+
+/* set placeholder ethernet header protocol from IP version in packet data, used by DSWritePcap() and DSWritePcapBuffered() */
+
+static int pcap_set_eth_protocol(uint8_t* pkt_buffer, struct ethhdr* p_eth_hdr, const char* szFunc) {
+
+uint8_t version = pkt_buffer[0] >> 4;
+
+   if (version == IPv4) p_eth_hdr->h_proto = htons(0x0800);
+   else if (version == IPv6) p_eth_hdr->h_proto = htons(0x86DD);
+   else {
+      Log_RT(2, "ERROR: %s() says invalid IP header version number: %d found in pkt_buf \n", szFunc, version);
+      return -1;
+   }
+
+   return 0;
+}
+
+/* write a pcap record */
+
+int DSWritePcap(FILE* fp_out, unsigned int uFlags, uint8_t* pkt_buffer, int packet_length, pcaprec_hdr_t* pcap_pkt_hdr, struct ethhdr* eth_hdr, pcap_hdr_t* pcap_file_hdr
+#ifdef USE_LEGACY_PARAMS  /* remove pTermInfo and timespec params, JHB Jul 2024 */
+, TERMINATION_INFO* pTermInfo
+,  struct timespec* ts
+#endif
+) {  /* add pcap_hdr_t* param, JHB Jul 2024 */
+
+pcaprec_hdr_t         pcap_pkt_hdr_local = { 0 };
+pcaprec_hdr_t*        p_pkt_hdr;
+struct ethhdr         eth_hdr_local;
+struct ethhdr*        p_eth_hdr;
+#ifdef USE_LEGACY_PARAMS
+struct timespec       ts_local = { 0 };
+struct timespec*      p_ts;
+#else
+struct timespec       ts = { 0 };
+#endif
+
+   if (!pcap_pkt_hdr) p_pkt_hdr = &pcap_pkt_hdr_local;
+   else p_pkt_hdr = pcap_pkt_hdr;
+
+   if (!eth_hdr) {
+      p_eth_hdr = &eth_hdr_local;
+      memset(p_eth_hdr, 0, sizeof(struct ethhdr));
+   }
+   else p_eth_hdr = eth_hdr;
+
+   int link_type = pcap_file_hdr ? pcap_file_hdr->link_type : LINKTYPE_ETHERNET;  /* default link type is standard 14-byte ethernet header unless file header struct is given, JHB Jul 2024 */
+
+   #ifdef USE_LEGACY_PARAMS
+   if (!ts) p_ts = &ts_local;
+   else p_ts = ts;
+
+   if (!p_ts->tv_sec) clock_gettime(CLOCK_REALTIME, p_ts);  /* if sec is uninitialized, then get current time */
+   p_pkt_hdr->ts_sec = p_ts->tv_sec;
+   p_pkt_hdr->ts_usec = p_ts->tv_nsec/1000;
+   #else
+   if (uFlags & DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK) {  /* get wall clock time if instructed, otherwise leave pcap_pkt_hdr as-is, JHB Jul 2024 */
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      p_pkt_hdr->ts_sec = ts.tv_sec;
+      p_pkt_hdr->ts_usec = ts.tv_nsec/1000;
+   }
+   #endif
+
+   #if 0
+   static int count = 0;
+   if (count++ < 100) printf("\n *** pkt incl len = %u, pkt orig len = %u, pcap_file_hdr = %p, link type = %u \n", p_pkt_hdr->incl_len, p_pkt_hdr->orig_len, pcap_file_hdr, link_type);
+   #endif
+
+   bool fWriteEthHdr = link_type == LINKTYPE_ETHERNET;  /* write out ethernet header depending on link type, JHB Jul 2024 */ 
+
+   if (!p_pkt_hdr->incl_len) p_pkt_hdr->incl_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);  /* add 14 for ethernet header (ETH_HLEN is in Linux if_ether.h). If lengths are not zero then leave as-is (i.e. use what's already in pacp_pkt_hdr), JHB Jul 2024 */
+   if (!p_pkt_hdr->orig_len) p_pkt_hdr->orig_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);
+
+   if (!eth_hdr && fWriteEthHdr) {  /* if no ethernet header struct given and we need to write out a header then Localhost placeholder data */ 
+
+   /* create placeholder ethernet header for output pcap, assume standard 14-byte header */
+
+      memset(p_eth_hdr->h_dest, 0, sizeof(eth_hdr_local.h_dest));  /* for MAC addresses we use Localhost (all zeros) */
+      memset(p_eth_hdr->h_source, 0, sizeof(eth_hdr_local.h_source));
+
+      #ifdef USE_LEGACY_PARAMS  /* remove legacy pTermInfo param. See comments in packet_flow_media_proc.c near DSWritePcap() that give additional explanation, JHB Jul 2024 */
+      if (pTermInfo != NULL) {
+
+         if (pTermInfo->remote_ip.type == DS_IPV4 || pTermInfo->remote_ip.type == IPv4) p_eth_hdr->h_proto = htons(0x0800);
+         else if (pTermInfo->remote_ip.type == DS_IPV6 || pTermInfo->remote_ip.type == IPv6) p_eth_hdr->h_proto = htons(0x86DD);
+         else
+         {
+            Log_RT(2, "ERROR: DSWritePcap, invalid IP type in term info, unable to write packet\n");
+            return -1;
+         }
+      }
+      else
+      #endif
+      if (pcap_set_eth_protocol(pkt_buffer, p_eth_hdr, "DSWritePcap") < 0) return -1;
+   }
+
+   int num_bytes_written = fwrite(p_pkt_hdr, sizeof(pcaprec_hdr_t), 1, fp_out) * sizeof(pcaprec_hdr_t);
+   if (fWriteEthHdr) num_bytes_written += fwrite(p_eth_hdr, sizeof(eth_hdr_local), 1, fp_out) * sizeof(eth_hdr_local);
+   num_bytes_written += fwrite(pkt_buffer, packet_length, 1, fp_out) * packet_length;
+
+   return num_bytes_written;
+}
+
+/* buffered pcap writer. Notes, JHB Oct 2026:
+
+  -DSCreatePcapWriter() attaches a user-space write buffer to a pcap file opened by DSOpenPcap() with DS_WRITE, and adds an entry to pcap_writer_info[], keyed by the FILE* handle. Entries are claimed and released the same way as pcap_mmap_info[]
+  -DSWritePcapBuffered() formats records the same as DSWritePcap() and appends them to the buffer. When a record doesn't fit, buffered data, record header, and packet data are written with one writev() call, instead of three fwrite() calls per record
+  -multiple threads may call DSWritePcapBuffered() for the same file. Each caller reserves buffer space with an atomic compare-and-swap and copies its record in parallel with other callers. The caller whose reservation crosses the end of the buffer waits for earlier copies to complete, writes the buffer, and resets it; callers that reserve while a flush is pending retry after the reset. Record order in the file is reservation order
+  -DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK timestamps are taken inside the reservation: a caller reads the reserve position, takes the timestamp, and then reserves with a compare-and-swap from the position it read, retrying on failure. A successful reservation means no other caller reserved after the timestamp was taken, so timestamps are in file order the same as with DSWritePcap() calls serialized by a semaphore
+*/
+
+#define MAX_PCAP_WRITERS                1024
+#define PCAP_WRITER_DEFAULT_BUF_SIZE    (256*1024)
+
+typedef struct {
+
+  FILE*              fp;           /* FILE* handle returned by DSOpenPcap(), NULL if entry is available */
+  int                fd;
+  uint8_t*           buf;
+  uint32_t           buf_size;
+  volatile uint32_t  reserved;     /* bytes reserved by writers. Values larger than buf_size indicate a flush is pending */
+  volatile uint32_t  committed;    /* bytes copied into buf by writers */
+  volatile int       err;          /* set if a writev() fails */
+
+} PCAP_WRITER_INFO;
+
+static PCAP_WRITER_INFO pcap_writer_info[MAX_PCAP_WRITERS] = {{ 0 }};
+static int nPcapWriterMax = 0;  /* high water mark of pcap_writer_info[] entries in use */
+
+static PCAP_WRITER_INFO* find_pcap_writer(FILE* fp) {
+
+   if (fp) for (int i=0; i<nPcapWriterMax; i++) if (pcap_writer_info[i].fp == fp) return &pcap_writer_info[i];
+
+   return NULL;
+}
+
+static int pcap_writev(FILE* fp, int fd, struct iovec* iov, int iovcnt) {  /* writev() with handling for partial writes and interrupts */
+
+int i, num_bytes_written = 0;
+ssize_t ret;
+
+   if (fd < 0) {  /* no file descriptor, for example a compressed output stream, JHB Oct 2026 */
+
+      for (i=0; i<iovcnt; i++) {
+         if (fwrite(iov[i].iov_base, 1, iov[i].iov_len, fp) != iov[i].iov_len) return -1;
+         num_bytes_written += iov[i].iov_len;
+      }
+
+      return num_bytes_written;
+   }
+
+   while (iovcnt > 0) {
+
+      if ((ret = writev(fd, iov, iovcnt)) < 0) {
+         if (errno == EINTR) continue;
+         return -1;
+      }
+
+      num_bytes_written += ret;
+
+      for (i=0; i<iovcnt && (size_t)ret >= iov[i].iov_len; i++) ret -= iov[i].iov_len;  /* skip fully written iovecs */
+
+      iov += i;
+      iovcnt -= i;
+
+      if (iovcnt > 0) { iov->iov_base = (uint8_t*)iov->iov_base + ret; iov->iov_len -= ret; }
+   }
+
+   return num_bytes_written;
+}
+
+int DSCreatePcapWriter(FILE* fp_out, unsigned int uFlags, int buf_size) {
+
+PCAP_WRITER_INFO* w;
+int i;
+
+   (void)uFlags;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+   if (!fp_out) {
+      Log_RT(2, "ERROR: DSCreatePcapWriter() says fp_out is NULL \n");
+      return -1;
+   }
+
+   if (find_pcap_writer(fp_out)) return 0;  /* writer already exists */
+
+   if (buf_size <= 0) buf_size = PCAP_WRITER_DEFAULT_BUF_SIZE;
+
+   for (i=0; i<MAX_PCAP_WRITERS; i++) if (__sync_bool_compare_and_swap(&pcap_writer_info[i].fp, NULL, fp_out)) break;  /* claim first available entry */
+
+   if (i == MAX_PCAP_WRITERS) {
+
+      Log_RT(2, "ERROR: DSCreatePcapWriter() says max number of pcap writers %d exceeded \n", MAX_PCAP_WRITERS);
+      return -1;
+   }
+
+   w = &pcap_writer_info[i];
+
+   if (!(w->buf = (uint8_t*)malloc(buf_size))) {
+
+      Log_RT(2, "ERROR: DSCreatePcapWriter() says unable to allocate %d bytes for write buffer \n", buf_size);
+      __sync_lock_release(&w->fp);
+      return -1;
+   }
+
+   fflush(fp_out);  /* file header (and anything else) written by fwrite() must reach the file before buffered records */
+
+   w->fd = fileno(fp_out);
+   w->buf_size = buf_size;
+   w->reserved = w->committed = 0;
+   w->err = 0;
+
+   int max = nPcapWriterMax;
+   while (i+1 > max && !__sync_bool_compare_and_swap(&nPcapWriterMax, max, i+1)) max = nPcapWriterMax;  /* update high water mark */
+
+   return 1;
+}
+
+int DSWritePcapBuffered(FILE* fp_out, unsigned int uFlags, uint8_t* pkt_buffer, int packet_length, pcaprec_hdr_t* pcap_pkt_hdr, struct ethhdr* eth_hdr, pcap_hdr_t* pcap_file_hdr) {
+
+PCAP_WRITER_INFO* w;
+pcaprec_hdr_t pcap_pkt_hdr_local = { 0 };
+pcaprec_hdr_t* p_pkt_hdr;
+struct ethhdr eth_hdr_local;
+struct ethhdr* p_eth_hdr;
+struct timespec ts;
+struct iovec iov[3];
+uint8_t hdr[sizeof(pcaprec_hdr_t) + ETH_HLEN];
+int hdr_len = 0, rec_len = 0, iovcnt = 0;
+uint32_t reserve_len, pos;
+bool fWriteEthHdr = false;
+
+   if (!pkt_buffer && !(uFlags & DS_WRITE_PCAP_FLUSH)) return 0;  /* nothing to do */
+
+   if (!(w = find_pcap_writer(fp_out))) {  /* no writer for this file, use DSWritePcap() */
+
+      if (!pkt_buffer) return 0;
+      return DSWritePcap(fp_out, uFlags, pkt_buffer, packet_length, pcap_pkt_hdr, eth_hdr, pcap_file_hdr);
+   }
+
+   if (pkt_buffer) {  /* format record header and ethernet header, same as DSWritePcap() */
+
+      p_pkt_hdr = pcap_pkt_hdr ? pcap_pkt_hdr : &pcap_pkt_hdr_local;
+
+      if (!eth_hdr) {
+         p_eth_hdr = &eth_hdr_local;
+         memset(p_eth_hdr, 0, sizeof(struct ethhdr));
+      }
+      else p_eth_hdr = eth_hdr;
+
+      fWriteEthHdr = (pcap_file_hdr ? pcap_file_hdr->link_type : LINKTYPE_ETHERNET) == LINKTYPE_ETHERNET;
+
+      if (!p_pkt_hdr->incl_len) p_pkt_hdr->incl_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);
+      if (!p_pkt_hdr->orig_len) p_pkt_hdr->orig_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);
+
+      if (!eth_hdr && fWriteEthHdr && pcap_set_eth_protocol(pkt_buffer, p_eth_hdr, "DSWritePcapBuffered") < 0) return -1;
+
+      hdr_len = sizeof(pcaprec_hdr_t) + (fWriteEthHdr ? ETH_HLEN : 0);
+      rec_len = hdr_len + packet_length;
+   }
+
+retry:
+
+   reserve_len = (uFlags & DS_WRITE_PCAP_FLUSH) ? w->buf_size + 1 : rec_len;  /* a flush reserves past the end of the buffer */
+
+   pos = __sync_fetch_and_add(&w->reserved, 0);
+
+   if (pos > w->buf_size) {  /* another caller is flushing, wait for buffer reset and try again */
+
+      while (__sync_fetch_and_add(&w->reserved, 0) > w->buf_size) sched_yield();
+      goto retry;
+   }
+
+   if (pkt_buffer && (uFlags & DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK)) {  /* take wall clock timestamp before reserving from pos. If another caller reserves first the compare-and-swap fails and the timestamp is taken again, so timestamps are in file order */
+
+      clock_gettime(CLOCK_REALTIME, &ts);
+      p_pkt_hdr->ts_sec = ts.tv_sec;
+      p_pkt_hdr->ts_usec = ts.tv_nsec/1000;
+   }
+
+   if (!__sync_bool_compare_and_swap(&w->reserved, pos, pos + reserve_len)) goto retry;
+
+   if (pos + reserve_len <= w->buf_size) {  /* record fits, copy to buffer */
+
+      memcpy(&w->buf[pos], p_pkt_hdr, sizeof(pcaprec_hdr_t));
+      if (fWriteEthHdr) memcpy(&w->buf[pos + sizeof(pcaprec_hdr_t)], p_eth_hdr, ETH_HLEN);
+      memcpy(&w->buf[pos + hdr_len], pkt_buffer, packet_length);
+
+      __sync_fetch_and_add(&w->committed, reserve_len);
+
+      return w->err ? -1 : rec_len;
+   }
+
+/* this caller's reservation crosses the end of the buffer: wait for earlier callers to finish copying, then write buffered data plus this record (if any) with one writev() call and reset the buffer */
+
+   while (__sync_fetch_and_add(&w->committed, 0) != pos) sched_yield();
+
+   if (pos) { iov[iovcnt].iov_base = w->buf; iov[iovcnt++].iov_len = pos; }
+
+   if (pkt_buffer) {
+
+      memcpy(hdr, p_pkt_hdr, sizeof(pcaprec_hdr_t));
+      if (fWriteEthHdr) memcpy(&hdr[sizeof(pcaprec_hdr_t)], p_eth_hdr, ETH_HLEN);
+
+      iov[iovcnt].iov_base = hdr; iov[iovcnt++].iov_len = hdr_len;
+      iov[iovcnt].iov_base = pkt_buffer; iov[iovcnt++].iov_len = packet_length;
+   }
+
+   if (iovcnt && pcap_writev(w->fp, w->fd, iov, iovcnt) < 0) {
+
+      Log_RT(2, "ERROR: DSWritePcapBuffered() says writev() failed, errno = %d \n", errno);
+      w->err = 1;
+   }
+
+   __sync_lock_test_and_set(&w->committed, 0);
+   __sync_synchronize();
+   __sync_lock_test_and_set(&w->reserved, 0);  /* release buffer to other callers */
+
+   return w->err ? -1 : rec_len;
+}
+
+/* DSFilterPcapRecord() reads a pcap file to find the next occurrence of a desired packet type. Notes JHB Sep 2023:
+
+  -currently searches for next RTP packet, filtering out packets specified by DS_FILTER_PKT_xxx flags. To-do: add flags to search for other types
+  -link_layer_info must be given from a prior DSOpenPcap(). Maybe at some point we can get this using only fp (DSOpenPcap() would need to keep track)
+  -fills a packet buffer if both fp and pktbuf are given. If pktbuf is given but not pktlen then we get pktlen using DSGetPacketInfo() 
+  -fills in a PKTINFO struct with packet info, if specified
+  -returns packet length if packet search succeeds, 0 if not, or < 0 for error condition
+*/
+
+int DSFilterPacket(FILE* fp, unsigned int uFlags, int link_layer_info, pcaprec_hdr_t* p_pcap_rec_hdr, uint8_t* pktbuf, int pktlen, PKTINFO* PktInfo, uint64_t* pNumRead) {
+
+int ret_val = -1;
+uint64_t num_read = 0;
+
+PKTINFO PktInfo_local;
+PKTINFO* pPktInfo;
+
+pcaprec_hdr_t pcap_pkt_hdr_local;  /* defined in pktlib.h */
+pcaprec_hdr_t* p_pkt_hdr;
+
+uint8_t pktbuf_local[MAX_TCP_PACKET_LEN];
+uint8_t* pkt_in_buf;
+uint64_t cur_pos = 0;
+
+   if (!fp && !pktbuf) {
+      Log_RT(3, "WARNING: DSFilterPacket() says both fp_pcap and pktbuf cannot be NULL. If a file handle is not specified a valid pktbuf must be supplied \n");
+      return -1;
+   }
+
+   if (PktInfo) pPktInfo = PktInfo;
+   else pPktInfo = &PktInfo_local;
+
+   if (p_pcap_rec_hdr) p_pkt_hdr = p_pcap_rec_hdr;
+   else p_pkt_hdr = &pcap_pkt_hdr_local;
+
+   if (pktbuf) pkt_in_buf = pktbuf;
+   else pkt_in_buf = pktbuf_local;
+   
+   uint16_t pkt_type, block_type, input_type = (link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16;
+
+   if (input_type == PCAP_TYPE_LIBPCAP || input_type == PCAP_TYPE_PCAPNG) {
+
+   if (fp && (uFlags & DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET)) cur_pos = ftell(fp);
+
+read_packet:
+
+      if (fp) {  /* if a file handle given, we read packet and length from the file. Otherwise we assume pktbuf and pktlen params are valid */
+
+         pktlen = DSReadPcap(fp, uFlags, pkt_in_buf, p_pkt_hdr, link_layer_info, &pkt_type, &block_type, NULL);
+
+         if (uFlags & DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET) {
+
+            uint64_t new_pos = ftell(fp);
+            num_read += new_pos - cur_pos;
+            cur_pos = new_pos;
+         }
+         else num_read++;
+      }
+      else if (!pktlen) pktlen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt_in_buf, -1, NULL, NULL);
+
+      if (pktlen > 0) {  /* add non IP packet handing, JHB Dec 2021 */
+
+         if (block_type != PCAP_PB_TYPE && block_type != PCAPNG_EPB_TYPE && block_type != PCAPNG_SPB_TYPE) {  /* ignore IDB, NRB, and other non-packet data block types. See definitions in pktlib.h */
+
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+
+         if ((uFlags & DS_FILTER_PKT_ARP) && (pkt_type == ETH_P_ARP)) {  /* ignore ARP packets (ETH_P_ARP defined in if_ether.h Linux header file, typically value of 0x0806) */
+            #ifdef PKT_DISCARD_DEBUG
+            printf(" ************* ignoring ARP pkt \n");
+            #endif
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+
+         if ((uFlags & DS_FILTER_PKT_802) && (pkt_type >= 82 && pkt_type <= 1536)) { /* ignore 802.2 LLC frames (https://networkengineering.stackexchange.com/questions/50586/eth-ii-vs-802-2-llc-snap). Note - added the lower range check of 82 after some .pcapng test files with Ethernet prototype value of zero were misinterpreted as 802.2, JHB Sep 2022 */
+            #ifdef PKT_DISCARD_DEBUG
+            printf(" ************* ignoring LLC frame, pkt_type = %d \n", pkt_type);
+            #endif
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+
+      /* fill in PktInfo struct with IP, UDP, and RTP header items */
+ 
+         ret_val = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTINFO | DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG | DS_PKTLIB_SUPPRESS_INFO_MSG, pkt_in_buf, -1, pPktInfo, NULL);  /* note - if packet is malformed (invalid IP version, incorrect header, mismatching length, etc) return value is < 0 and a warning message will be printed by DSGetPacketInfo(). We use the DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG and DS_PKTLIB_SUPPRESS_INFO_MSG flags to suppress RTP related warning messages as the packet type is unknown at this point */
+
+         if (ret_val < 0) {
+            #ifdef PKT_DISCARD_DEBUG
+            printf("************* invalid IP version or malformed packet, pkt type = %d, pkt len = %d \n", pkt_type, pktlen);
+            #endif
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+
+         uint8_t protocol = PktInfo->protocol;
+
+         if ((uFlags & DS_FILTER_PKT_TCP) && protocol == TCP_PROTOCOL) {
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         } 
+
+         if ((uFlags & DS_FILTER_PKT_UDP) && protocol == UDP_PROTOCOL) {
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         } 
+
+         if ((uFlags & DS_FILTER_PKT_UDP_SIP) && protocol == UDP_PROTOCOL) {
+
+            uint16_t dst_port = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_DST_PORT, pkt_in_buf, -1, pPktInfo, NULL);
+            uint16_t src_port = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_SRC_PORT, pkt_in_buf, -1, pPktInfo, NULL);
+
+            if (dst_port == SIP_PORT || src_port == SIP_PORT) {
+               if (fp) goto read_packet;
+               else ret_val = -1;
+            }
+         } 
+
+         if (protocol != UDP_PROTOCOL && protocol != TCP_PROTOCOL) { /* ignore ICMP and various other protocols */
+            #ifdef PKT_DISCARD_DEBUG
+            printf(" ************* ignoring non UDP or TCP pkt with protocol = %d \n", ret_val);
+            #endif
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+
+         if ((uFlags & DS_FILTER_PKT_RTCP) && protocol == UDP_PROTOCOL && (PktInfo->rtp_pyld_type >= RTCP_PYLD_TYPE_MIN && PktInfo->rtp_pyld_type <= RTCP_PYLD_TYPE_MAX)) {
+
+            if (fp) goto read_packet;
+            else ret_val = -1;
+         }
+ 
+      /* packet has met filter specs, leave num_read pointing at matching packet, return */ 
+
+ //printf("\n *** file pos end of filter packet = %llu \n", (unsigned long long)ftell(fp));
+
+         ret_val = pktlen;
+      }
+      else if (pktlen == 0) ret_val = 0;
+   }
+
+   if (pNumRead) *pNumRead = num_read;
+
+   return ret_val;
+}
+
+
+/* chunk-parallel pcap scan support, JHB Oct 2026. Notes:
+
+  -DSScanPcap() splits a libpcap file into byte ranges and parses them concurrently, one thread and one DS_OPEN_PCAP_MMAP handle per range. Used by DSCreatePcapIndex() (and DSFindPcapPacket() index builds) and DSGetPcapStats()
+  -libpcap records have no sync marker, so the start of each range after the first is found by scanning forward from the nominal split point for an offset where a chain of PCAP_SCAN_RESYNC_RECS record headers passes sanity checks (captured length <= snaplen and <= original length, usec < 1000000, timestamps non-decreasing within PCAP_SCAN_RESYNC_TS_JITTER), or a shorter chain ends exactly at file end
+  -a false resync is unlikely but possible, for example packet payload that contains a copy of pcap data. After all ranges are parsed each range end position is compared with the next range start; on a mismatch the callback is told to discard the next range's results and the range is parsed again from the correct position in the calling thread, so results are always the same as a sequential pass
+  -pcapng and .rtp files are parsed as one range. pcapng blocks can be resynchronized on (block type, length, trailing length) but section and interface blocks change parsing state, so splitting them would need a pre-pass
+  -DS_READ_PCAP_COPY is removed from uFlags, same as DSReadPcapBatch(). This includes uFlags given to DSGetPcapStats()
+*/
+
+#define PCAP_SCAN_MAX_RANGES          64
+#define PCAP_SCAN_MIN_RANGE_SIZE      (16*1024*1024)  /* minimum bytes per range, smaller files are parsed as one range */
+#define PCAP_SCAN_RESYNC_RECS         8               /* number of consecutive plausible record headers required to start a range */
+#define PCAP_SCAN_RESYNC_MAX_BYTES    (4*1024*1024)   /* max bytes searched for a range start. If none is found the range is merged with the previous one */
+#define PCAP_SCAN_RESYNC_TS_JITTER    1               /* seconds a timestamp may go backwards within a resync chain, for captures with slightly out of order arrival times */
+
+typedef struct {
+
+  const char*         szPcap;
+  unsigned int        uFlags;
+  int                 link_layer_info;
+  int                 range;
+  uint64_t            start;      /* offset of first record in the range */
+  uint64_t            end;        /* records starting at or after end belong to the next range */
+  uint64_t            end_pos;    /* offset after last record parsed */
+  int                 ret_val;    /* 1 if range parsed ok, < 0 for a read error or callback abort */
+  bool                fParsed;    /* set once callback may have been called for the range */
+  bool                fAbort;     /* set if callback returned < 0 */
+  PCAP_SCAN_CALLBACK  callback;
+  void*               user_data;
+  pthread_t           thread;
+
+} PCAP_SCAN_RANGE;
+
+static uint64_t pcap_scan_resync(uint8_t* base, uint64_t size, uint64_t start, uint32_t max_len, uint32_t ts_min) {  /* find first offset at or after start where a chain of plausible record headers begins. Returns size if none found */
+
+pcaprec_hdr_t hdr;
+uint64_t ofs, pos, limit = min(size, start + PCAP_SCAN_RESYNC_MAX_BYTES);
+uint32_t ts_prev;
+int n;
+
+   for (ofs=start; ofs<limit; ofs++) {
+
+      for (n=0, pos=ofs, ts_prev=ts_min; n<PCAP_SCAN_RESYNC_RECS && pos + sizeof(pcaprec_hdr_t) <= size; n++) {
+
+         memcpy(&hdr, base + pos, sizeof(pcaprec_hdr_t));  /* unaligned */
+
+         if (hdr.incl_len > max_len || hdr.incl_len > hdr.orig_len || hdr.ts_usec >= 1000000L || hdr.ts_sec < ts_prev) break;
+
+         ts_prev = hdr.ts_sec > PCAP_SCAN_RESYNC_TS_JITTER ? hdr.ts_sec - PCAP_SCAN_RESYNC_TS_JITTER : 0;
+         pos += sizeof(pcaprec_hdr_t) + hdr.incl_len;
+      }
+
+      if (n == PCAP_SCAN_RESYNC_RECS || pos == size) return ofs;  /* full chain, or chain ends exactly at file end */
+   }
+
+   return size;
+}
+
+static int pcap_scan_range(PCAP_SCAN_RANGE* r) {  /* parse records starting in [start, end) and call the user callback for each */
+
+FILE* fp_pcap = NULL;
+pcap_scan_rec_t scan_rec;
+uint64_t pos;
+
+   r->end_pos = r->start;
+   r->ret_val = -1;
+   r->fParsed = true;
+   r->fAbort = false;
+
+   if (DSOpenPcap(r->szPcap, DS_READ | DS_OPEN_PCAP_QUIET | DS_OPEN_PCAP_MMAP, &fp_pcap, NULL, "") <= 0 || !fp_pcap) return r->ret_val;  /* each range has its own handle and read position */
+
+   pcap_set_read_pos(fp_pcap, r->start);
+   r->ret_val = 1;
+
+   while ((pos = pcap_read_pos(fp_pcap)) < r->end) {
+
+      if ((scan_rec.pkt_len = DSReadPcapPtr(fp_pcap, r->uFlags, &scan_rec.pkt, &scan_rec.pcap_rec_hdr, r->link_layer_info, &scan_rec.eth_protocol, &scan_rec.block_type, NULL)) <= 0) {
+
+         if (scan_rec.pkt_len < 0) r->ret_val = -1;
+         break;
+      }
+
+      r->end_pos = pcap_read_pos(fp_pcap);
+
+      scan_rec.offset = pos;
+      scan_rec.length = r->end_pos - pos;
+
+      if (r->callback(r->range, &scan_rec, r->user_data) < 0) { r->fAbort = true; r->ret_val = -1; break; }
+   }
+
+   DSClosePcap(fp_pcap, DS_CLOSE_PCAP_QUIET);
+
+   return r->ret_val;
+}
+
+static void* pcap_scan_thread(void* arg) {
+
+   pcap_scan_range((PCAP_SCAN_RANGE*)arg);
+
+   return NULL;
+}
+
+int DSScanPcap(const char* szInputPcap, unsigned int uFlags, int num_threads, PCAP_SCAN_CALLBACK callback, void* user_data) {
+
+FILE* fp_pcap = NULL;
+pcap_hdr_t pcap_file_hdr;
+pcaprec_hdr_t pcap_rec_hdr;
+PCAP_MMAP_INFO* p;
+PCAP_SCAN_RANGE range[PCAP_SCAN_MAX_RANGES];
+uint64_t first_rec_offset, size = 0, start;
+uint32_t max_len = 0, ts_min = 0;
+int i, j, num_ranges = 1, link_layer_info, ret_val = 1;
+
+   if (!szInputPcap || !callback) { Log_RT(2, "ERROR: DSScanPcap() says %s is NULL \n", !szInputPcap ? "szInputPcap" : "callback"); return -1; }
+
+   uFlags &= ~DS_READ_PCAP_COPY;  /* not supported, scans always advance (otherwise pcap_scan_range() would read the same record forever) */
+
+   if ((link_layer_info = DSOpenPcap(szInputPcap, DS_READ | DS_OPEN_PCAP_QUIET | DS_OPEN_PCAP_MMAP, &fp_pcap, &pcap_file_hdr, "")) <= 0 || !fp_pcap) return -1;
+
+   first_rec_offset = pcap_read_pos(fp_pcap);
+
+/* decide number of ranges and find range start offsets. Only libpcap files with a successful mapping are split */
+
+   if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+   num_threads = max(1, min(num_threads, PCAP_SCAN_MAX_RANGES));
+
+   if ((p = find_pcap_mmap(fp_pcap)) && p->base && ((link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16) == PCAP_TYPE_LIBPCAP && p->size >= first_rec_offset + sizeof(pcaprec_hdr_t)) {
+
+      size = p->size;
+      num_ranges = max((uint64_t)1, min((uint64_t)num_threads, (size - first_rec_offset) / PCAP_SCAN_MIN_RANGE_SIZE));
+
+      max_len = pcap_file_hdr.snaplen ? pcap_file_hdr.snaplen : 262144;  /* 262144 is the libpcap max snaplen */
+
+      memcpy(&pcap_rec_hdr, p->base + first_rec_offset, sizeof(pcaprec_hdr_t));  /* first record timestamp is a lower bound for resync chains */
+      ts_min = pcap_rec_hdr.ts_sec > PCAP_SCAN_RESYNC_TS_JITTER ? pcap_rec_hdr.ts_sec - PCAP_SCAN_RESYNC_TS_JITTER : 0;
+   }
+
+   memset(range, 0, sizeof(range));
+   range[0].start = first_rec_offset;
+
+   for (i=1, j=1; i<num_ranges; i++) {
+
+      start = pcap_scan_resync(p->base, size, first_rec_offset + i*((size - first_rec_offset) / num_ranges), max_len, ts_min);
+
+      if (start < size && start > range[j-1].start) range[j++].start = start;  /* if no start found merge with previous range */
+   }
+
+   num_ranges = j;
+
+   DSClosePcap(fp_pcap, DS_CLOSE_PCAP_QUIET);
+
+   for (i=0; i<num_ranges; i++) {
+
+      range[i].szPcap = szInputPcap;
+      range[i].uFlags = uFlags;
+      range[i].link_layer_info = link_layer_info;
+      range[i].range = i;
+      range[i].end = i+1 < num_ranges ? range[i+1].start : UINT64_MAX;
+      range[i].callback = callback;
+      range[i].user_data = user_data;
+   }
+
+/* parse ranges concurrently. Range 0 is parsed by the calling thread. If a thread can't be created its range is left for the sequential pass below */
+
+   for (i=1; i<num_ranges; i++) if (pthread_create(&range[i].thread, NULL, pcap_scan_thread, &range[i])) range[i].thread = 0;
+
+   pcap_scan_range(&range[0]);
+
+   for (i=1; i<num_ranges; i++) if (range[i].thread) pthread_join(range[i].thread, NULL);
+
+/* verify range boundaries in file order. A range whose start doesn't match the previous range's end is discarded and parsed again */
+
+   for (i=0; i<num_ranges; i++) {
+
+      if (i > 0 && (!range[i].fParsed || range[i].start != range[i-1].end_pos)) {
+
+         if (range[i].fParsed) callback(i, NULL, user_data);  /* tell callback to discard results for this range */
+
+         range[i].start = range[i-1].end_pos;
+
+         pcap_scan_range(&range[i]);
+      }
+
+      if (range[i].ret_val < 0) {  /* read error or callback abort, discard results after this range */
+
+         for (j=i+1; j<num_ranges; j++) if (range[j].fParsed) callback(j, NULL, user_data);
+
+         if (!range[i].fAbort) Log_RT(2, "ERROR: DSScanPcap() says pcap read error in range %d, file offset %llu \n", i, (unsigned long long)range[i].end_pos);
+
+         ret_val = -1;
+         break;
+      }
+   }
+
+   return ret_val < 0 ? ret_val : num_ranges;
+}
+
+
+/* DSGetPcapStats() support, JHB Oct 2026 */
+
+typedef struct {
+
+  pcap_stats_t  range_stats[PCAP_SCAN_MAX_RANGES];  /* one per range, merged after DSScanPcap() returns. No locks needed as each range is parsed by one thread */
+
+} PCAP_STATS_SCAN;
+
+static int pcap_stats_callback(int range, pcap_scan_rec_t* scan_rec, void* user_data) {
+
+pcap_stats_t* stats = &((PCAP_STATS_SCAN*)user_data)->range_stats[range];
+uint64_t timestamp;
+uint8_t protocol = 0;
+
+   if (!scan_rec) { memset(stats, 0, sizeof(pcap_stats_t)); return 1; }  /* discard range results */
+
+   stats->num_recs++;
+
+   if (!scan_rec->pkt || !isPacketBlockType(scan_rec->block_type)) return 1;
+
+   stats->num_pkts++;
+   stats->num_bytes += scan_rec->pcap_rec_hdr.incl_len;
+
+   if (scan_rec->block_type != PCAPNG_SPB_TYPE) {  /* SPBs have no timestamp */
+
+      timestamp = (uint64_t)scan_rec->pcap_rec_hdr.ts_sec*1000000L + scan_rec->pcap_rec_hdr.ts_usec;
+
+      if (!stats->first_timestamp || timestamp < stats->first_timestamp) stats->first_timestamp = timestamp;
+      if (timestamp > stats->last_timestamp) stats->last_timestamp = timestamp;
+   }
+
+   if (scan_rec->eth_protocol == ETH_P_IP && scan_rec->pkt_len >= 20) { stats->num_ipv4++; protocol = scan_rec->pkt[9]; }
+   else if (scan_rec->eth_protocol == ETH_P_IPV6 && scan_rec->pkt_len >= 40) { stats->num_ipv6++; protocol = scan_rec->pkt[6]; }  /* next header only, extension headers are not followed */
+   else stats->num_other++;
+
+   if (protocol == TCP_PROTOCOL) stats->num_tcp++;
+   else if (protocol == UDP_PROTOCOL) stats->num_udp++;
+
+   return 1;
+}
+
+int DSGetPcapStats(const char* szInputPcap, unsigned int uFlags, int num_threads, pcap_stats_t* pcap_stats) {
+
+PCAP_STATS_SCAN* scan;
+int i, ret_val;
+
+   if (!pcap_stats) { Log_RT(2, "ERROR: DSGetPcapStats() says pcap_stats is NULL \n"); return -1; }
+
+   memset(pcap_stats, 0, sizeof(pcap_stats_t));
+
+   if (!(scan = (PCAP_STATS_SCAN*)calloc(1, sizeof(PCAP_STATS_SCAN)))) return -1;
+
+   if ((ret_val = DSScanPcap(szInputPcap, uFlags, num_threads, pcap_stats_callback, scan)) > 0) {
+
+      for (i=0; i<ret_val; i++) {
+
+         pcap_stats_t* s = &scan->range_stats[i];
+
+         pcap_stats->num_recs += s->num_recs;
+         pcap_stats->num_pkts += s->num_pkts;
+         pcap_stats->num_bytes += s->num_bytes;
+         pcap_stats->num_ipv4 += s->num_ipv4;
+         pcap_stats->num_ipv6 += s->num_ipv6;
+         pcap_stats->num_tcp += s->num_tcp;
+         pcap_stats->num_udp += s->num_udp;
+         pcap_stats->num_other += s->num_other;
+
+         if (s->first_timestamp && (!pcap_stats->first_timestamp || s->first_timestamp < pcap_stats->first_timestamp)) pcap_stats->first_timestamp = s->first_timestamp;
+         pcap_stats->last_timestamp = max(pcap_stats->last_timestamp, s->last_timestamp);
+      }
+
+      pcap_stats->num_ranges = ret_val;
+   }
+
+   free(scan);
+
+   return ret_val;
+}
+
+
+/* pcap index support for DSFindPcapPacket(), JHB Oct 2026. Notes:
+
+  -a pcap index is one compact entry per packet record (file offset, record number, arrival time, 5-tuple, RTP SSRC, timestamp, and sequence number) built in one DSScanPcap() pass over a pcap or pcapng file
+  -DSCreatePcapIndex() builds an index and saves it as a sidecar file with the pcap file name plus ".sigidx" (e.g. input.pcap.sigidx). DSFindPcapPacket() uses a sidecar index if one exists and matches pcap file size and modification time, or builds one on first use if DS_FIND_PCAP_PACKET_USE_INDEX is given
+  -sidecar files are memory-mapped, not read, and are written to a temporary name and renamed so concurrent processes never see a partial file. If the sidecar can't be written (e.g. read-only directory) the index is kept in memory only
+  -loaded indexes are cached in pcap_index[], keyed by pcap file path. Entries are claimed with an atomic compare-and-swap and are read-only after that, so no locks are needed. An index made stale by a pcap file change is left in place (the next lookup fails the size / time check and a new index is built)
+  -for each entry, filter_flags records which DSFilterPacket() filter categories the packet falls into. Entries that pass the filters always applied by DSFindPcapPacket() are also sorted by (SSRC, RTP timestamp, entry number) so SSRC and SSRC + timestamp searches are binary searches instead of a full pcap scan
+*/
+
+#define MAX_PCAP_INDEX             64
+#define PCAP_INDEX_MAGIC           "SIGIDX"
+#define PCAP_INDEX_VERSION         1
+#define PCAP_INDEX_FILE_EXT        ".sigidx"
+
+#define PCAP_INDEX_READ_ERROR      1  /* PCAP_INDEX_FILE_HDR flags: pcap read error before end of file, index covers records up to the error */
+
+#define PCAP_INDEX_FILTER_ARP      1  /* filter_flags categories, one per DS_FILTER_PKT_xxx flag */
+#define PCAP_INDEX_FILTER_802      2
+#define PCAP_INDEX_FILTER_TCP      4
+#define PCAP_INDEX_FILTER_UDP      8
+#define PCAP_INDEX_FILTER_RTCP     0x10
+#define PCAP_INDEX_FILTER_UDP_SIP  0x20
+#define PCAP_INDEX_FILTER_INVALID  0x40  /* malformed packet, or not UDP or TCP. Always filtered by DSFilterPacket() */
+
+typedef struct {  /* sidecar file header, followed by num_recs PCAP_INDEX_REC structs */
+
+  char     magic[8];
+  uint32_t version;
+  uint32_t rec_size;         /* sizeof(PCAP_INDEX_REC), guards against struct layout changes */
+  uint64_t pcap_file_size;   /* pcap file size and modification time when the index was built */
+  int64_t  pcap_file_mtime;  /* in nsec */
+  uint64_t first_rec_offset; /* file offset of first record, after header(s) read by DSOpenPcap() */
+  int32_t  link_layer_info;  /* DSOpenPcap() return value */
+  uint32_t flags;
+  uint64_t num_recs;
+
+} PCAP_INDEX_FILE_HDR;
+
+typedef struct {  /* 80 bytes, no padding */
+
+  uint64_t offset;           /* file offset of record */
+  uint64_t record;           /* record number, counting all records (including pcapng non-packet blocks) after the file header. First record is 1 */
+  uint64_t timestamp;        /* arrival timestamp in usec */
+  uint32_t length;           /* record length in file, offset + length is the offset of the next record */
+  uint32_t rtp_ssrc;
+  uint32_t rtp_timestamp;
+  uint32_t seqnum;           /* same as PKTINFO seqnum, TCP sequence number or UDP/RTP sequence number */
+  uint16_t src_port;
+  uint16_t dst_port;
+  uint8_t  protocol;
+  uint8_t  ip_version;
+  uint8_t  rtp_pyld_type;
+  uint8_t  filter_flags;     /* PCAP_INDEX_FILTER_xxx flags */
+  uint8_t  src_addr[16];     /* IPv4 addresses use the first 4 bytes */
+  uint8_t  dst_addr[16];
+
+} PCAP_INDEX_REC;
+
+typedef struct {
+
+  char*               szPcap;      /* pcap file path, used as lookup key */
+  PCAP_INDEX_FILE_HDR hdr;
+  PCAP_INDEX_REC*     rec;         /* entries in file order */
+  uint32_t*           sorted;      /* entry numbers sorted by (SSRC, RTP timestamp, entry number) */
+  uint32_t            num_sorted;
+  void*               map_base;    /* non-NULL if rec points into a memory-mapped sidecar file */
+  uint64_t            map_size;
+
+} PCAP_INDEX;
+
+static PCAP_INDEX* pcap_index[MAX_PCAP_INDEX] = { NULL };
+
+#define PCAP_INDEX_FIND_FILTERS  (PCAP_INDEX_FILTER_ARP | PCAP_INDEX_FILTER_802 | PCAP_INDEX_FILTER_TCP | PCAP_INDEX_FILTER_UDP_SIP | PCAP_INDEX_FILTER_RTCP | PCAP_INDEX_FILTER_INVALID)  /* filters always applied by DSFindPcapPacket() */
+
+static uint8_t pcap_index_filter_mask(unsigned int uFlags) {  /* convert DS_FILTER_PKT_xxx flags to PCAP_INDEX_FILTER_xxx flags */
+
+uint8_t mask = PCAP_INDEX_FIND_FILTERS;
+
+   if (uFlags & DS_FILTER_PKT_UDP) mask |= PCAP_INDEX_FILTER_UDP;  /* only flag not always applied by DSFindPcapPacket() */
+
+   return mask;
+}
+
+static void pcap_index_packet(PCAP_INDEX_REC* rec, uint8_t* pkt, uint16_t eth_protocol) {  /* fill in index entry packet items, same filter logic as DSFilterPacket() */
+
+PKTINFO PktInfo;
+
+   if (eth_protocol == ETH_P_ARP) { rec->filter_flags = PCAP_INDEX_FILTER_ARP; return; }
+   if (eth_protocol >= 82 && eth_protocol <= 1536) { rec->filter_flags = PCAP_INDEX_FILTER_802; return; }
+
+   if (DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTINFO | DS_PKTLIB_SUPPRESS_WARNING_ERROR_MSG | DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG | DS_PKTLIB_SUPPRESS_INFO_MSG, pkt, -1, &PktInfo, NULL) < 0) { rec->filter_flags = PCAP_INDEX_FILTER_INVALID; return; }
+
+   rec->protocol = PktInfo.protocol;
+   rec->ip_version = PktInfo.version;
+   rec->src_port = PktInfo.src_port;
+   rec->dst_port = PktInfo.dst_port;
+   rec->seqnum = PktInfo.seqnum;
+
+   if (PktInfo.version == 4) { memcpy(rec->src_addr, &pkt[12], IPV4_ADDR_LEN); memcpy(rec->dst_addr, &pkt[16], IPV4_ADDR_LEN); }
+   else if (PktInfo.version == 6) { memcpy(rec->src_addr, &pkt[8], IPV6_ADDR_LEN); memcpy(rec->dst_addr, &pkt[24], IPV6_ADDR_LEN); }
+
+   if (PktInfo.protocol == TCP_PROTOCOL) rec->filter_flags = PCAP_INDEX_FILTER_TCP;
+   else if (PktInfo.protocol == UDP_PROTOCOL) {
+
+      rec->filter_flags = PCAP_INDEX_FILTER_UDP;
+
+      rec->rtp_ssrc = PktInfo.rtp_ssrc;
+      rec->rtp_timestamp = PktInfo.rtp_timestamp;
+      rec->rtp_pyld_type = PktInfo.rtp_pyld_type;
+
+      if (PktInfo.dst_port == SIP_PORT || PktInfo.src_port == SIP_PORT) rec->filter_flags |= PCAP_INDEX_FILTER_UDP_SIP;
+      if (PktInfo.rtp_pyld_type >= RTCP_PYLD_TYPE_MIN && PktInfo.rtp_pyld_type <= RTCP_PYLD_TYPE_MAX) rec->filter_flags |= PCAP_INDEX_FILTER_RTCP;
+   }
+   else rec->filter_flags = PCAP_INDEX_FILTER_INVALID;
+}
+
+static int pcap_index_sort(PCAP_INDEX* idx) {  /* create sorted list of entries usable by DSFindPcapPacket() */
+
+uint32_t i;
+PCAP_INDEX_REC* rec = idx->rec;
+
+   if (!idx->hdr.num_recs) return 1;
+
+   if (!(idx->sorted = (uint32_t*)malloc(idx->hdr.num_recs*sizeof(uint32_t)))) return -1;
+
+   for (i=0, idx->num_sorted=0; i<idx->hdr.num_recs; i++) if (!(rec[i].filter_flags & PCAP_INDEX_FIND_FILTERS)) idx->sorted[idx->num_sorted++] = i;
+
+   sort(idx->sorted, idx->sorted + idx->num_sorted, [rec](uint32_t a, uint32_t b) {
+
+      if (rec[a].rtp_ssrc != rec[b].rtp_ssrc) return rec[a].rtp_ssrc < rec[b].rtp_ssrc;
+      if (rec[a].rtp_timestamp != rec[b].rtp_timestamp) return rec[a].rtp_timestamp < rec[b].rtp_timestamp;
+      return a < b;
+   });
+
+   return 1;
+}
+
+static void pcap_index_free(PCAP_INDEX* idx) {
+
+   if (idx->map_base) munmap(idx->map_base, idx->map_size);
+   else if (idx->rec) free(idx->rec);
+
+   if (idx->sorted) free(idx->sorted);
+   if (idx->szPcap) free(idx->szPcap);
+
+   free(idx);
+}
+
+typedef struct {  /* per-range index entries, filled in by pcap_index_callback() and merged in range order by pcap_index_create() */
+
+  PCAP_INDEX_REC* rec;
+  uint64_t        num_recs;
+  uint64_t        num_alloc;
+  uint64_t        num_blocks;  /* all records parsed in the range, including pcapng non-packet blocks. Used for record numbering */
+
+} PCAP_INDEX_RANGE;
+
+static int pcap_index_callback(int range, pcap_scan_rec_t* scan_rec, void* user_data) {  /* DSScanPcap() callback, called concurrently for different ranges */
+
+PCAP_INDEX_RANGE* r = &((PCAP_INDEX_RANGE*)user_data)[range];
+PCAP_INDEX_REC* rec;
+
+   if (!scan_rec) { r->num_recs = 0; r->num_blocks = 0; return 1; }  /* discard range results */
+
+   r->num_blocks++;
+
+   if (!scan_rec->pkt || (scan_rec->block_type != PCAP_PB_TYPE && scan_rec->block_type != PCAPNG_EPB_TYPE && scan_rec->block_type != PCAPNG_SPB_TYPE)) return 1;
+
+   if (r->num_recs == r->num_alloc) {
+
+      uint64_t num_alloc = max(r->num_alloc*2, (uint64_t)65536);
+      if (!(rec = (PCAP_INDEX_REC*)realloc(r->rec, num_alloc*sizeof(PCAP_INDEX_REC)))) return -1;
+
+      r->rec = rec;
+      r->num_alloc = num_alloc;
+   }
+
+   rec = &r->rec[r->num_recs++];
+
+   memset(rec, 0, sizeof(PCAP_INDEX_REC));
+
+   rec->offset = scan_rec->offset;
+   rec->length = scan_rec->length;
+   rec->record = r->num_blocks;  /* relative to range start, adjusted when ranges are merged */
+   rec->timestamp = (uint64_t)scan_rec->pcap_rec_hdr.ts_sec*1000000L + scan_rec->pcap_rec_hdr.ts_usec;
+
+   pcap_index_packet(rec, scan_rec->pkt, scan_rec->eth_protocol);
+
+   return 1;
+}
+
+static PCAP_INDEX* pcap_index_create(const char* szInputPcap, struct stat* pcap_stat) {  /* build index with a DSScanPcap() pass over the pcap. libpcap files are parsed in parallel ranges */
+
+FILE* fp_pcap = NULL;
+int link_layer_info, i;
+uint64_t j, n, num_recs = 0, record = 0;
+PCAP_INDEX_RANGE* range;
+PCAP_INDEX* idx;
+
+   if ((link_layer_info = DSOpenPcap(szInputPcap, DS_READ | DS_OPEN_PCAP_QUIET | DS_OPEN_PCAP_MMAP, &fp_pcap, NULL, "")) <= 0 || !fp_pcap) return NULL;
+
+   uint16_t input_type = (link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16;
+
+   if ((input_type != PCAP_TYPE_LIBPCAP && input_type != PCAP_TYPE_PCAPNG) || !(idx = (PCAP_INDEX*)calloc(1, sizeof(PCAP_INDEX)))) {  /* DSFilterPacket() and DSFindPcapPacket() handle only pcap and pcapng */
+
+      DSClosePcap(fp_pcap, DS_CLOSE_PCAP_QUIET);
+      return NULL;
+   }
+
+   memcpy(idx->hdr.magic, PCAP_INDEX_MAGIC, sizeof(PCAP_INDEX_MAGIC));
+   idx->hdr.version = PCAP_INDEX_VERSION;
+   idx->hdr.rec_size = sizeof(PCAP_INDEX_REC);
+   idx->hdr.pcap_file_size = pcap_stat->st_size;
+   idx->hdr.pcap_file_mtime = (int64_t)pcap_stat->st_mtim.tv_sec*1000000000L + pcap_stat->st_mtim.tv_nsec;
+   idx->hdr.link_layer_info = link_layer_info;
+   idx->hdr.first_rec_offset = pcap_read_pos(fp_pcap);
+
+   DSClosePcap(fp_pcap, DS_CLOSE_PCAP_QUIET);  /* records are read by DSScanPcap() */
+
+   if (!(range = (PCAP_INDEX_RANGE*)calloc(PCAP_SCAN_MAX_RANGES, sizeof(PCAP_INDEX_RANGE)))) { pcap_index_free(idx); return NULL; }
+
+   if (DSScanPcap(szInputPcap, DS_READ_PCAP_SUPPRESS_INFO_MSG, 0, pcap_index_callback, range) < 0) idx->hdr.flags |= PCAP_INDEX_READ_ERROR;  /* on error, entries up to the error are kept */
+
+/* merge ranges in file order */
+
+   for (i=0; i<PCAP_SCAN_MAX_RANGES; i++) num_recs += range[i].num_recs;
+
+   if (num_recs > UINT32_MAX) {
+
+      Log_RT(3, "WARNING: DSFindPcapPacket() says pcap file %s exceeds max index size, index truncated \n", szInputPcap);
+      num_recs = UINT32_MAX;
+      idx->hdr.flags |= PCAP_INDEX_READ_ERROR;
+   }
+
+   if (range[0].num_recs == num_recs) { idx->rec = range[0].rec; range[0].rec = NULL; idx->hdr.num_recs = num_recs; }  /* one range, use as-is */
+   else if ((idx->rec = (PCAP_INDEX_REC*)malloc(num_recs*sizeof(PCAP_INDEX_REC)))) {
+
+      for (i=0; i<PCAP_SCAN_MAX_RANGES; i++) {
+
+         n = min(range[i].num_recs, num_recs - idx->hdr.num_recs);
+
+         for (j=0; j<n; j++) {
+
+            idx->rec[idx->hdr.num_recs + j] = range[i].rec[j];
+            idx->rec[idx->hdr.num_recs + j].record += record;
+         }
+
+         idx->hdr.num_recs += n;
+         record += range[i].num_blocks;
+      }
+   }
+
+   for (i=0; i<PCAP_SCAN_MAX_RANGES; i++) if (range[i].rec) free(range[i].rec);
+   free(range);
+
+   if ((num_recs && !idx->rec) || !(idx->szPcap = strdup(szInputPcap)) || pcap_index_sort(idx) < 0) { pcap_index_free(idx); return NULL; }
 
-      uint32_t dst_ip_addr;
-      uint16_t dst_port;
+   return idx;
+}
 
-      if (!pcap_file_hdr || inet_pton(AF_INET, (const char*)&pcap_file_hdr->rtp.dst_ip_addr, &dst_ip_addr) != 1 || dst_ip_addr == 0) {  /* if dest IP address is non-zero then convert xx.xx.xx.xx format to integer */
-         dst_ip_addr = htonl(0xC0A80001);  /* otherwise use generic local IP addr 192.168.0.1 */
-      }
-      memcpy(&format_pkt.DstAddr, &dst_ip_addr, IPV4_ADDR_LEN);
+static int pcap_index_write(PCAP_INDEX* idx) {  /* save index as sidecar file. Write to a temporary name and rename so other processes never see a partial file */
 
-      if (!pcap_file_hdr || (dst_port = htons(atoi((const char*)&pcap_file_hdr->rtp.dst_port))) == 0) {  /* convert dest port from string (network byte order) */
-         dst_port = 0x0A18;  /* 6154, network byte order */
-      }
-      format_pkt.udpHeader.DstPort = dst_port;
+FILE* fp;
+bool fOK;
+char* szIndex = (char*)malloc(strlen(idx->szPcap) + 32);
+char* szTemp = (char*)malloc(strlen(idx->szPcap) + 32);
 
-      #if 0
-      memcpy(&dst_ip_addr, &format_pkt.DstAddr, IPV4_ADDR_LEN);
-      printf(" dst ip addr = %x, port = %u, dst ip string = %s \n", dst_ip_addr, format_pkt.udpHeader.DstPort, pcap_file_hdr ? (const char*)&pcap_file_hdr->rtp.dst_ip_addr : "n/a");
-      #endif
+   if (!szIndex || !szTemp) { if (szIndex) free(szIndex); if (szTemp) free(szTemp); return -1; }
 
-      uint32_t pkt_len_fmt = DSFormatPacket(-1, DS_FMT_PKT_STANDALONE | DS_FMT_PKT_USER_HDRALL | DS_FMT_PKT_USER_UDP_PAYLOAD, rtp_data, rtp_len, &format_pkt, pkt_buffer);
+   sprintf(szIndex, "%s%s", idx->szPcap, PCAP_INDEX_FILE_EXT);
+   sprintf(szTemp, "%s.%d", szIndex, getpid());
 
-      #if 0  /* additional .rtp format sanity checks - verify all payload sub lengths match after submitting packet to DSPacketInfo(), JHB Oct 2024 */
-      int pktlen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt_buffer, -1, NULL, NULL);
-      int udplen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PYLDLEN, pkt_buffer, -1, NULL, NULL);
-      int rtplen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_PYLDLEN, pkt_buffer, -1, NULL, NULL);
-      uint32_t rtp_timestamp = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_RTP_TIMESTAMP, pkt_buffer, -1, NULL, NULL);
+   if ((fp = fopen(szTemp, "wb"))) {
 
-      printf("\n *** p_pkt_hdr->incl_len = %u, packet_length = %u, pkt_len_fmt = %u, rtp_len = %u, timestamp = %u.%u sec, pktlib info: pkt len = %d, udp len = %d, rtp pyld len = %d, rtp timestamp = %u \n", p_pkt_hdr->incl_len, packet_length, pkt_len_fmt, rtp_len, p_pkt_hdr->ts_sec, p_pkt_hdr->ts_usec/1000, pktlen, udplen, rtplen, rtp_timestamp);
-      #endif
+      fOK = fwrite(&idx->hdr, sizeof(PCAP_INDEX_FILE_HDR), 1, fp) == 1 && (!idx->hdr.num_recs || fwrite(idx->rec, sizeof(PCAP_INDEX_REC), idx->hdr.num_recs, fp) == idx->hdr.num_recs);
 
-      if (pkt_len_fmt != p_pkt_hdr->incl_len) Log_RT(3, "WARNING: DSReadPcap() says packet len after format %u not matching file record len %u \n", pkt_len_fmt, p_pkt_hdr->incl_len);
+      if (fclose(fp) || !fOK || rename(szTemp, szIndex)) { unlink(szTemp); fp = NULL; }
    }
 
-/* if specified by uFlags, apply TSO "zero length" fix and set packet length to what was captured. Note that Wireshark will label these as "length reported as 0, presumed to be because of TCP segmentation offload (TSO)", test with capture_test2.png, JHB Feb 2025 */
+   free(szIndex);
+   free(szTemp);
 
-   if (!(uFlags & DS_READ_PCAP_DISABLE_TSO_LENGTH_FIX) && (*p_block_type == PCAP_PB_TYPE || *p_block_type == RTP_PB_TYPE || *p_block_type == PCAPNG_EPB_TYPE || *p_block_type == PCAPNG_SPB_TYPE) && (pkt_ptr[0] >> 4) == IPV4 && pkt_ptr[9] == TCP) {  /* to-do: handle IPv6 */
+   return fp ? 1 : -1;
+}
 
-      if (!((pkt_ptr[2] << 8) | pkt_ptr[3])) {  /* if length is reported as zero then set to packet capture length */
+static PCAP_INDEX* pcap_index_load(const char* szInputPcap, struct stat* pcap_stat) {  /* map an existing sidecar file, return NULL if none, or if stale or invalid */
 
-         pkt_ptr[2] = p_pkt_hdr->incl_len >> 8;
-         pkt_ptr[3] = p_pkt_hdr->incl_len & 0xff;
-         #ifdef TSO_LENGTH_FIX_DEBUG
-         printf("\n *** applying TSO length fix, inserting pkt len = %d \n", (pkt_ptr[2] << 8) | pkt_ptr[3]);
-         #endif
-      }
-   }
+int fd;
+struct stat index_stat;
+PCAP_INDEX_FILE_HDR* hdr;
+PCAP_INDEX* idx = NULL;
+void* addr;
+char* szIndex = (char*)malloc(strlen(szInputPcap) + 32);
 
-   if (file_type == PCAP_TYPE_PCAPNG) {
+   if (!szIndex) return NULL;
 
-      int ret_val, i, num_int32 = 0;
-      uint32_t dummy_uint32;
-      (void)ret_val;
-      padding = (4 - (p_pkt_hdr->incl_len & 3)) & 3;
-      ret_val = fread(&dummy_uint32, padding, 1, fp_in);  /* pcapng format pads packet data to 32 bits */
+   sprintf(szIndex, "%s%s", szInputPcap, PCAP_INDEX_FILE_EXT);
+   fd = open(szIndex, O_RDONLY);
+   free(szIndex);
 
-      if (pcapng_block_header.block_type == PCAPNG_EPB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_epb_t) - p_pkt_hdr->incl_len - padding)/4;
-      else if (pcapng_block_header.block_type == PCAPNG_SPB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_spb_t) - p_pkt_hdr->incl_len - padding)/4;
-      else if (pcapng_block_header.block_type == PCAPNG_IDB_TYPE) num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_idb_t) - p_pkt_hdr->incl_len - padding)/4;
-      else num_int32 = (pcapng_block_header.block_length - sizeof(pcapng_block_header_t) - p_pkt_hdr->incl_len - padding)/4;
+   if (fd < 0) return NULL;
 
-      for (i=0; i<num_int32; i++) ret_val = fread(&dummy_uint32, sizeof(uint32_t), 1, fp_in);  /* read past options, if any, and duplicated block length field */
-   }
+   if (fstat(fd, &index_stat) || (uint64_t)index_stat.st_size < sizeof(PCAP_INDEX_FILE_HDR) || (addr = mmap(NULL, index_stat.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) { close(fd); return NULL; }
 
-   #ifdef DEBUG_PCAPNG
-   static int count2 = 0;
-   if (count2 < 5 || (file_type == PCAP_TYPE_PCAPNG && pcapng_epb.block_type != 6)) {
-     printf(" packet len = %d, padding = %d \n", packet_length, padding);
-     count2++;
+   close(fd);  /* mapping stays valid after close */
+
+   hdr = (PCAP_INDEX_FILE_HDR*)addr;
+
+   if (memcmp(hdr->magic, PCAP_INDEX_MAGIC, sizeof(PCAP_INDEX_MAGIC)) || hdr->version != PCAP_INDEX_VERSION || hdr->rec_size != sizeof(PCAP_INDEX_REC) ||
+       hdr->pcap_file_size != (uint64_t)pcap_stat->st_size || hdr->pcap_file_mtime != (int64_t)pcap_stat->st_mtim.tv_sec*1000000000L + pcap_stat->st_mtim.tv_nsec ||
+       (uint64_t)index_stat.st_size != sizeof(PCAP_INDEX_FILE_HDR) + hdr->num_recs*sizeof(PCAP_INDEX_REC) ||
+       !(idx = (PCAP_INDEX*)calloc(1, sizeof(PCAP_INDEX)))) {
+
+      munmap(addr, index_stat.st_size);
+      return NULL;
    }
-   #endif
 
-   if (uFlags & DS_READ_PCAP_COPY) fseek(fp_in, fp_save, SEEK_SET);  /* restore filepos if needed */
+   idx->hdr = *hdr;
+   idx->rec = (PCAP_INDEX_REC*)((uint8_t*)addr + sizeof(PCAP_INDEX_FILE_HDR));
+   idx->map_base = addr;
+   idx->map_size = index_stat.st_size;
 
-   return packet_length;
+   if (!(idx->szPcap = strdup(szInputPcap)) || pcap_index_sort(idx) < 0) { pcap_index_free(idx); return NULL; }
 
-/* read error handler */
+   return idx;
+}
 
-pcap_read_error:
+static PCAP_INDEX* pcap_index_get(const char* szInputPcap, bool fCreate, bool* fCached) {  /* look up index in cache, then sidecar file, then build if fCreate is set */
 
-   if (!strlen(errstr)) fprintf(stderr, "\n *** code bug: inside DSReadPcap() error handler but errstr len is zero \n");  /* errstr should have non-zero length for error condition */
+struct stat pcap_stat;
+PCAP_INDEX* idx;
+int i;
 
-   if (feof(fp_in)) return 0;  /* we already checked feof() on entry, but sometimes fread() returns 0 bytes even if not feof, then checking feof again shows true. I have no idea why, but for now let it be, JHB Feb 2025 */ 
+   *fCached = false;
 
-   char* file_path = getFilePathFromFilePointer(fp_in);
-   Log_RT(2, "ERROR: DSReadPcap() says %s from file %s, uFlags = 0x%x \n", errstr, file_path ? file_path : "error in getFilePathFromPointer()", uFlags);
-   if (file_path) free(file_path);
-   return -1;  /* return error condition */
-}
+   if (!szInputPcap || stat(szInputPcap, &pcap_stat) || !S_ISREG(pcap_stat.st_mode)) return NULL;
 
-/* write a pcap record */
+   int64_t mtime = (int64_t)pcap_stat.st_mtim.tv_sec*1000000000L + pcap_stat.st_mtim.tv_nsec;
 
-int DSWritePcap(FILE* fp_out, unsigned int uFlags, uint8_t* pkt_buffer, int packet_length, pcaprec_hdr_t* pcap_pkt_hdr, struct ethhdr* eth_hdr, pcap_hdr_t* pcap_file_hdr
-#ifdef USE_LEGACY_PARAMS  /* remove pTermInfo and timespec params, JHB Jul 2024 */
-, TERMINATION_INFO* pTermInfo
-,  struct timespec* ts
-#endif
-) {  /* add pcap_hdr_t* param, JHB Jul 2024 */
+   for (i=0; i<MAX_PCAP_INDEX; i++) if ((idx = pcap_index[i]) && !strcmp(idx->szPcap, szInputPcap) && idx->hdr.pcap_file_size == (uint64_t)pcap_stat.st_size && idx->hdr.pcap_file_mtime == mtime) { *fCached = true; return idx; }
 
-pcaprec_hdr_t         pcap_pkt_hdr_local = { 0 };
-pcaprec_hdr_t*        p_pkt_hdr;
-struct ethhdr         eth_hdr_local;
-struct ethhdr*        p_eth_hdr;
-#ifdef USE_LEGACY_PARAMS
-struct timespec       ts_local = { 0 };
-struct timespec*      p_ts;
-#else
-struct timespec       ts = { 0 };
-#endif
+   if (!(idx = pcap_index_load(szInputPcap, &pcap_stat))) {
 
-   if (!pcap_pkt_hdr) p_pkt_hdr = &pcap_pkt_hdr_local;
-   else p_pkt_hdr = pcap_pkt_hdr;
+      if (!fCreate || !(idx = pcap_index_create(szInputPcap, &pcap_stat))) return NULL;
 
-   if (!eth_hdr) {
-      p_eth_hdr = &eth_hdr_local;
-      memset(p_eth_hdr, 0, sizeof(struct ethhdr));
+      if (pcap_index_write(idx) < 0) Log_RT(4, "INFO: DSFindPcapPacket() says unable to write index file %s%s, using in-memory index \n", szInputPcap, PCAP_INDEX_FILE_EXT);
    }
-   else p_eth_hdr = eth_hdr;
 
-   int link_type = pcap_file_hdr ? pcap_file_hdr->link_type : LINKTYPE_ETHERNET;  /* default link type is standard 14-byte ethernet header unless file header struct is given, JHB Jul 2024 */
+   for (i=0; i<MAX_PCAP_INDEX; i++) if (__sync_bool_compare_and_swap(&pcap_index[i], NULL, idx)) { *fCached = true; break; }  /* if cache is full caller uses index once and frees it */
 
-   #ifdef USE_LEGACY_PARAMS
-   if (!ts) p_ts = &ts_local;
-   else p_ts = ts;
+   return idx;
+}
 
-   if (!p_ts->tv_sec) clock_gettime(CLOCK_REALTIME, p_ts);  /* if sec is uninitialized, then get current time */
-   p_pkt_hdr->ts_sec = p_ts->tv_sec;
-   p_pkt_hdr->ts_usec = p_ts->tv_nsec/1000;
-   #else
-   if (uFlags & DS_WRITE_PCAP_SET_TIMESTAMP_WALLCLOCK) {  /* get wall clock time if instructed, otherwise leave pcap_pkt_hdr as-is, JHB Jul 2024 */
+static uint64_t pcap_index_lower_bound(PCAP_INDEX* idx, uint64_t key, uint64_t n) {  /* first position in sorted[] with (SSRC:RTP timestamp, entry number) >= (key, n) */
 
-      clock_gettime(CLOCK_REALTIME, &ts);
-      p_pkt_hdr->ts_sec = ts.tv_sec;
-      p_pkt_hdr->ts_usec = ts.tv_nsec/1000;
-   }
-   #endif
+uint64_t lo = 0, hi = idx->num_sorted;
 
-   #if 0
-   static int count = 0;
-   if (count++ < 100) printf("\n *** pkt incl len = %u, pkt orig len = %u, pcap_file_hdr = %p, link type = %u \n", p_pkt_hdr->incl_len, p_pkt_hdr->orig_len, pcap_file_hdr, link_type);
-   #endif
+   while (lo < hi) {
 
-   bool fWriteEthHdr = link_type == LINKTYPE_ETHERNET;  /* write out ethernet header depending on link type, JHB Jul 2024 */ 
+      uint64_t mid = (lo + hi) >> 1;
+      uint32_t e = idx->sorted[mid];
+      uint64_t k = ((uint64_t)idx->rec[e].rtp_ssrc << 32) | idx->rec[e].rtp_timestamp;
 
-   if (!p_pkt_hdr->incl_len) p_pkt_hdr->incl_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);  /* add 14 for ethernet header (ETH_HLEN is in Linux if_ether.h). If lengths are not zero then leave as-is (i.e. use what's already in pacp_pkt_hdr), JHB Jul 2024 */
-   if (!p_pkt_hdr->orig_len) p_pkt_hdr->orig_len = packet_length + (fWriteEthHdr ? ETH_HLEN : 0);
+      if (k < key || (k == key && e < n)) lo = mid + 1;
+      else hi = mid;
+   }
 
-   if (!eth_hdr && fWriteEthHdr) {  /* if no ethernet header struct given and we need to write out a header then Localhost placeholder data */ 
+   return lo;
+}
 
-   /* create placeholder ethernet header for output pcap, assume standard 14-byte header */
+static uint64_t pcap_index_find_offset(PCAP_INDEX* idx, uint64_t offset, bool fSeek, bool fEnd) {  /* first entry with start (fEnd false) or end (fEnd true) offset > offset. Offsets are bytes if fSeek is set, otherwise records */
 
-      memset(p_eth_hdr->h_dest, 0, sizeof(eth_hdr_local.h_dest));  /* for MAC addresses we use Localhost (all zeros) */
-      memset(p_eth_hdr->h_source, 0, sizeof(eth_hdr_local.h_source));
+uint64_t lo = 0, hi = idx->hdr.num_recs;
 
-      #ifdef USE_LEGACY_PARAMS  /* remove legacy pTermInfo param. See comments in packet_flow_media_proc.c near DSWritePcap() that give additional explanation, JHB Jul 2024 */
-      if (pTermInfo != NULL) {
+   while (lo < hi) {
 
-         if (pTermInfo->remote_ip.type == DS_IPV4 || pTermInfo->remote_ip.type == IPv4) p_eth_hdr->h_proto = htons(0x0800);
-         else if (pTermInfo->remote_ip.type == DS_IPV6 || pTermInfo->remote_ip.type == IPv6) p_eth_hdr->h_proto = htons(0x86DD);
-         else
-         {
-            Log_RT(2, "ERROR: DSWritePcap, invalid IP type in term info, unable to write packet\n");
-            return -1;
-         }
-      }
-      else
-      #endif
-      {
+      uint64_t mid = (lo + hi) >> 1;
+      PCAP_INDEX_REC* rec = &idx->rec[mid];
+      uint64_t k = fSeek ? rec->offset + (fEnd ? rec->length : 0) : rec->record;
 
-         uint8_t version = pkt_buffer[0] >> 4;
-         if (version == IPv4) p_eth_hdr->h_proto = htons(0x0800);
-         else if (version == IPv6) p_eth_hdr->h_proto = htons(0x86DD);
-         else
-         {
-            Log_RT(2, "ERROR: DSWritePcap() says invalid IP header version number: %d found in pkt_buf \n", version);
-            return -1;
-         }
-      }
+      if (k <= offset) lo = mid + 1;
+      else hi = mid;
    }
 
-   int num_bytes_written = fwrite(p_pkt_hdr, sizeof(pcaprec_hdr_t), 1, fp_out) * sizeof(pcaprec_hdr_t);
-   if (fWriteEthHdr) num_bytes_written += fwrite(p_eth_hdr, sizeof(eth_hdr_local), 1, fp_out) * sizeof(eth_hdr_local);
-   num_bytes_written += fwrite(pkt_buffer, packet_length, 1, fp_out) * packet_length;
-
-   return num_bytes_written;
+   return lo;
 }
 
-/* DSFilterPcapRecord() reads a pcap file to find the next occurrence of a desired packet type. Notes JHB Sep 2023:
+/* DSFindPcapPacket() using a pcap index. Return values and offset semantics are the same as the pcap scan in DSFindPcapPacket() */
 
-  -currently searches for next RTP packet, filtering out packets specified by DS_FILTER_PKT_xxx flags. To-do: add flags to search for other types
-  -link_layer_info must be given from a prior DSOpenPcap(). Maybe at some point we can get this using only fp (DSOpenPcap() would need to keep track)
-  -fills a packet buffer if both fp and pktbuf are given. If pktbuf is given but not pktlen then we get pktlen using DSGetPacketInfo() 
-  -fills in a PKTINFO struct with packet info, if specified
-  -returns packet length if packet search succeeds, 0 if not, or < 0 for error condition
-*/
+static uint64_t pcap_index_find_packet(PCAP_INDEX* idx, unsigned int uFlags, PKTINFO* PktInfo, uint64_t offset_start, uint64_t offset_end, uint64_t* pFoundOffset, int* error_cond) {
 
-int DSFilterPacket(FILE* fp, unsigned int uFlags, int link_layer_info, pcaprec_hdr_t* p_pcap_rec_hdr, uint8_t* pktbuf, int pktlen, PKTINFO* PktInfo, uint64_t* pNumRead) {
+bool fSeek = (uFlags & DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET) != 0, fFirst = (uFlags & DS_FIND_PCAP_PACKET_FIRST_MATCHING) != 0;
+uint8_t mask = pcap_index_filter_mask(uFlags);
+uint64_t i, i_start, i_end, n = idx->hdr.num_recs, offset_count, found = n, base_time;
+PCAP_INDEX_REC* rec = idx->rec;
 
-int ret_val = -1;
-uint64_t num_read = 0;
+   #define PASS(e)  (!(rec[e].filter_flags & mask))
 
-PKTINFO PktInfo_local;
-PKTINFO* pPktInfo;
+   #define MATCH(e) (PASS(e) && (!(uFlags & DS_FIND_PCAP_PACKET_RTP_SSRC) || rec[e].rtp_ssrc == PktInfo->rtp_ssrc) && (!(uFlags & DS_FIND_PCAP_PACKET_RTP_PYLDTYPE) || rec[e].rtp_pyld_type == PktInfo->rtp_pyld_type) && \
+                     (!(uFlags & DS_FIND_PCAP_PACKET_RTP_TIMESTAMP) || rec[e].rtp_timestamp == PktInfo->rtp_timestamp) && (!(uFlags & DS_FIND_PCAP_PACKET_SEQNUM) || rec[e].seqnum == PktInfo->seqnum))
 
-pcaprec_hdr_t pcap_pkt_hdr_local;  /* defined in pktlib.h */
-pcaprec_hdr_t* p_pkt_hdr;
+/* binary search for first entry at or after offset_start. Scan starting count is the same as the pcap scan: first record offset or offset_start for seek offsets, offset_start for record offsets */
 
-uint8_t pktbuf_local[MAX_TCP_PACKET_LEN];
-uint8_t* pkt_in_buf;
-uint64_t cur_pos = 0;
+   if (fSeek) offset_count = offset_start ? offset_start : idx->hdr.first_rec_offset;
+   else offset_count = offset_start;
 
-   if (!fp && !pktbuf) {
-      Log_RT(3, "WARNING: DSFilterPacket() says both fp_pcap and pktbuf cannot be NULL. If a file handle is not specified a valid pktbuf must be supplied \n");
-      return -1;
+   i_start = pcap_index_find_offset(idx, fSeek ? offset_count - 1 : offset_count, fSeek, false);  /* first entry with offset >= offset_count, or record > offset_count. Note offset_count is always > 0 for seek offsets, as the file header precedes the first record */
+
+/* find end of search range. The pcap scan stops once the end of the last filtered packet exceeds offset_end, so all filtered packets ending at or before offset_end are searched, plus the next one */
+
+   if (!offset_end) i_end = n;
+   else if (offset_count > offset_end) i_end = i_start;
+   else {
+
+      for (i = max(i_start, pcap_index_find_offset(idx, offset_end, fSeek, true)); i<n; i++) if (PASS(i)) break;
+      i_end = min(i+1, n);
    }
 
-   if (PktInfo) pPktInfo = PktInfo;
-   else pPktInfo = &PktInfo_local;
+   for (i=i_start; i<i_end; i++) if (PASS(i)) break;  /* base time is the first filtered packet, same as the pcap scan */
+   if (i >= i_end) goto index_find_end;
 
-   if (p_pcap_rec_hdr) p_pkt_hdr = p_pcap_rec_hdr;
-   else p_pkt_hdr = &pcap_pkt_hdr_local;
+   base_time = rec[i].timestamp;
 
-   if (pktbuf) pkt_in_buf = pktbuf;
-   else pkt_in_buf = pktbuf_local;
-   
-   uint16_t pkt_type, block_type, input_type = (link_layer_info & PCAP_LINK_LAYER_FILE_TYPE_MASK) >> 16;
+   if (uFlags & DS_FIND_PCAP_PACKET_RTP_SSRC) {  /* binary search entries sorted by SSRC and RTP timestamp */
 
-   if (input_type == PCAP_TYPE_LIBPCAP || input_type == PCAP_TYPE_PCAPNG) {
+      uint64_t key_lo = (uint64_t)PktInfo->rtp_ssrc << 32, key_hi = key_lo | 0xffffffff;
+      bool fTimestamp = (uFlags & DS_FIND_PCAP_PACKET_RTP_TIMESTAMP) != 0;
 
-   if (fp && (uFlags & DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET)) cur_pos = ftell(fp);
+      if (fTimestamp) key_lo = key_hi = key_lo | PktInfo->rtp_timestamp;
 
-read_packet:
+      uint64_t lo = pcap_index_lower_bound(idx, key_lo, fTimestamp ? i_start : 0), hi = pcap_index_lower_bound(idx, key_hi, fTimestamp ? i_end : n);
 
-      if (fp) {  /* if a file handle given, we read packet and length from the file. Otherwise we assume pktbuf and pktlen params are valid */
+      if (fTimestamp) {  /* entries in [lo, hi) are in file order and inside the search range */
 
-         pktlen = DSReadPcap(fp, uFlags, pkt_in_buf, p_pkt_hdr, link_layer_info, &pkt_type, &block_type, NULL);
+         if (fFirst) { for (i=lo; i<hi; i++) if (MATCH(idx->sorted[i])) { found = idx->sorted[i]; break; } }
+         else for (i=hi; i>lo; i--) if (MATCH(idx->sorted[i-1])) { found = idx->sorted[i-1]; break; }
+      }
+      else for (i=lo; i<hi; i++) {  /* entries in [lo, hi) are sorted by RTP timestamp, keep first or last in file order */
 
-         if (uFlags & DS_FIND_PCAP_PACKET_USE_SEEK_OFFSET) {
+         uint32_t e = idx->sorted[i];
 
-            uint64_t new_pos = ftell(fp);
-            num_read += new_pos - cur_pos;
-            cur_pos = new_pos;
-         }
-         else num_read++;
+         if (e >= i_start && e < i_end && MATCH(e) && (found == n || (fFirst ? e < found : e > found))) found = e;
       }
-      else if (!pktlen) pktlen = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTLEN, pkt_in_buf, -1, NULL, NULL);
+   }
+   else if (fFirst) { for (i=i_start; i<i_end; i++) if (MATCH(i)) { found = i; break; } }
+   else for (i=i_end; i>i_start; i--) if (MATCH(i-1)) { found = i-1; break; }
 
-      if (pktlen > 0) {  /* add non IP packet handing, JHB Dec 2021 */
+   if (found < n) {
 
-         if (block_type != PCAP_PB_TYPE && block_type != PCAPNG_EPB_TYPE && block_type != PCAPNG_SPB_TYPE) {  /* ignore IDB, NRB, and other non-packet data block types. See definitions in pktlib.h */
+      if (pFoundOffset) *pFoundOffset = fSeek ? rec[found].offset + rec[found].length : rec[found].record;
 
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
+      return rec[found].timestamp - base_time;
+   }
 
-         if ((uFlags & DS_FILTER_PKT_ARP) && (pkt_type == ETH_P_ARP)) {  /* ignore ARP packets (ETH_P_ARP defined in if_ether.h Linux header file, typically value of 0x0806) */
-            #ifdef PKT_DISCARD_DEBUG
-            printf(" ************* ignoring ARP pkt \n");
-            #endif
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
+index_find_end:
 
-         if ((uFlags & DS_FILTER_PKT_802) && (pkt_type >= 82 && pkt_type <= 1536)) { /* ignore 802.2 LLC frames (https://networkengineering.stackexchange.com/questions/50586/eth-ii-vs-802-2-llc-snap). Note - added the lower range check of 82 after some .pcapng test files with Ethernet prototype value of zero were misinterpreted as 802.2, JHB Sep 2022 */
-            #ifdef PKT_DISCARD_DEBUG
-            printf(" ************* ignoring LLC frame, pkt_type = %d \n", pkt_type);
-            #endif
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
+   if (error_cond && (idx->hdr.flags & PCAP_INDEX_READ_ERROR) && i_end == n) *error_cond = -1;  /* pcap scan would have reached the read error */
 
-      /* fill in PktInfo struct with IP, UDP, and RTP header items */
- 
-         ret_val = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_PKTINFO | DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG | DS_PKTLIB_SUPPRESS_INFO_MSG, pkt_in_buf, -1, pPktInfo, NULL);  /* note - if packet is malformed (invalid IP version, incorrect header, mismatching length, etc) return value is < 0 and a warning message will be printed by DSGetPacketInfo(). We use the DS_PKTLIB_SUPPRESS_RTP_WARNING_ERROR_MSG and DS_PKTLIB_SUPPRESS_INFO_MSG flags to suppress RTP related warning messages as the packet type is unknown at this point */
+   return 0;
 
-         if (ret_val < 0) {
-            #ifdef PKT_DISCARD_DEBUG
-            printf("************* invalid IP version or malformed packet, pkt type = %d, pkt len = %d \n", pkt_type, pktlen);
-            #endif
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
+   #undef PASS
+   #undef MATCH
+}
 
-         uint8_t protocol = PktInfo->protocol;
+/* create a pcap index sidecar file for use by DSFindPcapPacket(), see notes in pktlib.h */
 
-         if ((uFlags & DS_FILTER_PKT_TCP) && protocol == TCP_PROTOCOL) {
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         } 
+int DSCreatePcapIndex(const char* szInputPcap, unsigned int uFlags) {
 
-         if ((uFlags & DS_FILTER_PKT_UDP) && protocol == UDP_PROTOCOL) {
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         } 
+struct stat pcap_stat;
+PCAP_INDEX* idx;
+int ret_val;
 
-         if ((uFlags & DS_FILTER_PKT_UDP_SIP) && protocol == UDP_PROTOCOL) {
+   if (!szInputPcap || stat(szInputPcap, &pcap_stat)) {
 
-            uint16_t dst_port = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_DST_PORT, pkt_in_buf, -1, pPktInfo, NULL);
-            uint16_t src_port = DSGetPacketInfo(-1, DS_BUFFER_PKT_IP_PACKET | DS_PKT_INFO_SRC_PORT, pkt_in_buf, -1, pPktInfo, NULL);
+      Log_RT(2, "ERROR: DSCreatePcapIndex() says unable to stat pcap file %s, errno = %d \n", szInputPcap ? szInputPcap : "NULL", errno);
+      return -1;
+   }
 
-            if (dst_port == SIP_PORT || src_port == SIP_PORT) {
-               if (fp) goto read_packet;
-               else ret_val = -1;
-            }
-         } 
+   if (!(idx = pcap_index_create(szInputPcap, &pcap_stat))) {
 
-         if (protocol != UDP_PROTOCOL && protocol != TCP_PROTOCOL) { /* ignore ICMP and various other protocols */
-            #ifdef PKT_DISCARD_DEBUG
-            printf(" ************* ignoring non UDP or TCP pkt with protocol = %d \n", ret_val);
-            #endif
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
+      Log_RT(2, "ERROR: DSCreatePcapIndex() says unable to create index for %s, file may not exist or may not be pcap or pcapng format \n", szInputPcap);
+      return -1;
+   }
 
-         if ((uFlags & DS_FILTER_PKT_RTCP) && protocol == UDP_PROTOCOL && (PktInfo->rtp_pyld_type >= RTCP_PYLD_TYPE_MIN && PktInfo->rtp_pyld_type <= RTCP_PYLD_TYPE_MAX)) {
+   if (pcap_index_write(idx) < 0) {
 
-            if (fp) goto read_packet;
-            else ret_val = -1;
-         }
- 
-      /* packet has met filter specs, leave num_read pointing at matching packet, return */ 
+      Log_RT(2, "ERROR: DSCreatePcapIndex() says unable to write index file %s%s, errno = %d \n", szInputPcap, PCAP_INDEX_FILE_EXT, errno);
+      ret_val = -1;
+   }
+   else {
 
- //printf("\n *** file pos end of filter packet = %llu \n", (unsigned long long)ftell(fp));
+      ret_val = (int)min(idx->hdr.num_recs, (uint64_t)INT_MAX);
 
-         ret_val = pktlen;
-      }
-      else if (pktlen == 0) ret_val = 0;
+      if (!(uFlags & DS_OPEN_PCAP_QUIET)) Log_RT(4, "INFO: DSCreatePcapIndex() created index file %s%s, %llu packet records%s \n", szInputPcap, PCAP_INDEX_FILE_EXT, (unsigned long long)idx->hdr.num_recs, (idx->hdr.flags & PCAP_INDEX_READ_ERROR) ? ", pcap read error before end of file" : "");
    }
 
-   if (pNumRead) *pNumRead = num_read;
+   pcap_index_free(idx);  /* DSFindPcapPacket() maps the sidecar file on first use */
 
    return ret_val;
 }
 
-
 /* DSFindPcapPacket() finds specific packets in a pcap given packet matching specs */
 
 uint64_t DSFindPcapPacket(const char* szInputPcap, unsigned int uFlags, PKTINFO* PktInfo, uint64_t offset_start, uint64_t offset_end, uint64_t* pFoundOffset, int* error_cond) {
@@ -1122,9 +3191,20 @@ PKTINFO PktInfo_pcap;
 int link_layer_info;
 uint64_t packet_time = 0, offset_count = 0, num_read = 0;
 int ret_val = 0;
+PCAP_INDEX* idx;
+bool fCached;
 
    if (error_cond) *error_cond = 1;  /* initialize error condition to no error */
 
+   if ((idx = pcap_index_get(szInputPcap, (uFlags & DS_FIND_PCAP_PACKET_USE_INDEX) != 0, &fCached))) {  /* use pcap index if available, JHB Oct 2026 */
+
+      packet_time = pcap_index_find_packet(idx, uFlags, PktInfo, offset_start, offset_end, pFoundOffset, error_cond);
+
+      if (!fCached) pcap_index_free(idx);
+
+      return packet_time;
+   }
+
    if ((link_layer_info = DSOpenPcap(szInputPcap, DS_READ | DS_OPEN_PCAP_QUIET, &fp_pcap, NULL, "")) > 0 && fp_pcap) {
 
       uint64_t base_time = 0;
@@ -1219,6 +3299,21 @@ int ret_val = 0;
 int DSClosePcap(FILE* fp_pcap, unsigned int uFlags) {
 
 int ret_val = -1;
+PCAP_MMAP_INFO* p;
+PCAP_TIME_INDEX* t;
+PCAP_WRITER_INFO* w;
+
+   if ((p = find_pcap_mmap(fp_pcap))) pcap_mmap_detach(p);  /* unmap if opened with DS_OPEN_PCAP_MMAP flag, JHB Oct 2026 */
+
+   if ((t = find_pcap_time_index(fp_pcap))) pcap_time_index_free(t);  /* free time index if DSSeekPcap() was used, JHB Oct 2026 */
+
+   if ((w = find_pcap_writer(fp_pcap))) {  /* flush and free buffered writer if DSCreatePcapWriter() was used, JHB Oct 2026 */
+
+      DSWritePcapBuffered(fp_pcap, DS_WRITE_PCAP_FLUSH, NULL, 0, NULL, NULL, NULL);
+      free(w->buf);
+      w->buf = NULL;
+      __sync_lock_release(&w->fp);
+   }
 
    if (fp_pcap) ret_val = fclose(fp_pcap);
 
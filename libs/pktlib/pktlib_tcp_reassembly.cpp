@@ -0,0 +1,524 @@
+/*
+$Header: /root/Signalogic/DirectCore/lib/pktlib/pktlib_tcp_reassembly.cpp
+
+Description
+
+  APIs for TCP flow reassembly: per flow sequence tracking, out-of-order segment buffering, retransmission trimming, and in-order byte stream delivery
+
+Notes
+
+  -a TCP reassembly instance is not shared between threads; each app thread (or each consumer, e.g. a DER stream decoder) should create its own
+  -no dependencies on other pktlib APIs, other than PKTINFO filled by DSGetPacketInfo()
+
+Projects
+
+  SigSRF, DirectCore
+
+Copyright Signalogic Inc. 2026
+
+License
+
+  Github SigSRF License, Version 1.1, https://github.com/signalogic/SigSRF_SDK/blob/master/LICENSE.md
+
+Documentation and Usage
+
+  1) All TCP reassembly related API definitions and flags are documented in pktlib.h
+
+  2) If you modify DSXxx() functions, then place the resulting .o before libpktlib.so in your app link order, then your mods will take precedence over pktlib function names
+
+Revision History
+
+  Created Oct 2026 JHB, TCP flow table with per flow sequence tracking, out-of-order segment buffering from a preallocated segment pool, retransmission trimming, and in-order byte stream callback. Intended to replace per-port packet aggregation in derlib and SIP-over-TCP aggregation in mediaMin
+  Modified Oct 2026 JHB, deliver all saved segments when a flow is closed (skipping stopped partway through the drain and later segments were freed without delivery), return DS_TCP_REASSEMBLY_ERROR_NO_MEMORY if an oversize segment can't be allocated, carry DS_TCP_STREAM_GAP over to the next delivered data if the first segment after a gap is fully trimmed
+*/
+
+/* Linux and/or other OS includes */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+using namespace std;
+
+/* SigSRF includes */
+
+#include "pktlib.h"   /* pktlib API definitions, includes arpa/inet.h, netinet/if_ether.h */
+#include "diaglib.h"  /* Log_RT() definition */
+
+/* TCP reassembly notes, JHB Oct 2026:
+
+   -flows are unidirectional and identified by IP src addr, IP dst addr, src port, and dst port. Flows are found with a hash table of TCP_REASM_HASH_SIZE buckets
+   -each flow tracks the next expected sequence number. Segments arriving in order are delivered to the user callback directly from the caller's packet buffer (no copy). Retransmitted data already delivered is trimmed; segments entirely already delivered are reported as duplicates
+   -out-of-order segments are saved in a per instance pool of TCP_REASM_SEG_BUF_SIZE buffers, allocated once at create time. Segments too large for a pool buffer (e.g. TSO captures) use malloc(). When a gap is filled, saved segments are delivered in sequence order
+   -if a flow's saved data exceeds max_flow_bytes, or the segment pool is exhausted (in which case least recently used flows with saved data are also skipped ahead), the flow skips ahead to its first saved segment and the callback is given DS_TCP_STREAM_GAP to indicate missing data (e.g. capture loss). Skipping continues until saved data is max_flow_bytes/2 or less and a segment is available
+   -DS_TCP_STREAM_GAP is given with the next data delivered after a gap, even if the first segment after the gap is entirely data already delivered
+   -flows are closed after FIN (once all data up to the FIN is delivered) or RST, and the callback is given DS_TCP_STREAM_END. Closed flows stay in the flow table so late retransmissions are recognized as duplicates instead of starting a new flow; a SYN re-opens the flow. The least recently used flow is removed if the flow table is full
+   -sequence number comparisons handle 32-bit wrap
+*/
+
+#define TCP_REASM_HASH_SIZE      1024    /* number of flow hash buckets, must be a power of 2 */
+#define TCP_REASM_SEG_BUF_SIZE   1536    /* segment buffer size, enough for standard MTU segments */
+#define TCP_REASM_SEG_POOL_SIZE  2048    /* default number of preallocated segment entries and buffers */
+#define TCP_REASM_MAX_FLOW_BYTES 262144  /* default max out-of-order data saved per flow */
+
+#define TCP_FIN  0x01  /* TCP header flags */
+#define TCP_SYN  0x02
+#define TCP_RST  0x04
+
+#define DRAIN_NO_SKIP       0  /* DrainSegments() modes: deliver saved segments that are in order */
+#define DRAIN_SKIP_RECOVER  1  /* skip gaps until the flow's saved data and the segment pool have recovered */
+#define DRAIN_SKIP_ALL      2  /* skip all gaps, deliver all saved segments. Used when a flow is closed */
+
+#define SEGMENT_SAVED       1  /* SaveSegment() return values */
+#define SEGMENT_DUPLICATE   0
+#define SEGMENT_POOL_EMPTY  -1
+#define SEGMENT_NO_MEMORY   -2
+
+typedef struct TCP_SEGMENT {
+
+   uint32_t             seq;
+   int                  len;
+   uint8_t*             data;
+   bool                 fMalloc;   /* data was malloc'd instead of a pool buffer */
+   struct TCP_SEGMENT*  next;      /* next segment in flow's sequence ordered list, or next free segment */
+
+} TCP_SEGMENT;
+
+typedef struct TCP_FLOW {
+
+   TCP_FLOW_INFO     info;            /* flow info given to user callback */
+
+   uint32_t          next_seq;        /* next expected sequence number */
+   bool              fFin;            /* FIN received, fin_seq is valid */
+   bool              fClosed;         /* flow closed after FIN or RST, DS_TCP_STREAM_END has been given */
+   bool              fGapPending;     /* data was skipped, DS_TCP_STREAM_GAP not yet given */
+   uint32_t          fin_seq;
+
+   TCP_SEGMENT*      pSegments;       /* saved out-of-order segments, in sequence order */
+   int               saved_bytes;
+
+   struct TCP_FLOW*  hash_next;       /* next flow in hash bucket, or next free flow */
+   struct TCP_FLOW*  lru_prev;        /* flow LRU list, least recently used first */
+   struct TCP_FLOW*  lru_next;
+
+} TCP_FLOW;
+
+typedef struct {
+
+   TCP_STREAM_CALLBACK  pCallback;
+   void*                pUserData;
+   unsigned int         uFlags;
+   int                  max_flow_bytes;
+
+   TCP_FLOW*            hash[TCP_REASM_HASH_SIZE];
+   TCP_FLOW*            flows;
+   int                  max_flows;
+   TCP_FLOW*            pFreeFlows;
+   TCP_FLOW*            pLRU;         /* LRU list head and tail */
+   TCP_FLOW*            pMRU;
+
+   TCP_SEGMENT*         segments;
+   TCP_SEGMENT*         pFreeSegments;
+   int                  num_segments;
+   uint8_t*             bufs;         /* num_segments buffers of TCP_REASM_SEG_BUF_SIZE bytes; segments[i] uses buffer i */
+
+   TCP_REASSEMBLY_STATS stats;
+
+} TCP_REASSEMBLY;
+
+/* inline helpers */
+
+static inline bool seq_lt(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }  /* sequence number comparisons with wrap */
+static inline bool seq_leq(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+static inline unsigned int flow_hash(const uint8_t* src_addr, const uint8_t* dst_addr, int addr_len, uint16_t src_port, uint16_t dst_port) {
+
+uint64_t h = 0xcbf29ce484222325ULL;  /* FNV-1a */
+int i;
+
+   for (i=0; i<addr_len; i++) h = (h ^ src_addr[i]) * 0x100000001b3ULL;
+   for (i=0; i<addr_len; i++) h = (h ^ dst_addr[i]) * 0x100000001b3ULL;
+   h = (h ^ src_port) * 0x100000001b3ULL;
+   h = (h ^ dst_port) * 0x100000001b3ULL;
+
+   return (unsigned int)(h >> 32) & (TCP_REASM_HASH_SIZE-1);
+}
+
+static inline unsigned int flow_hash(TCP_FLOW_INFO* pInfo) {
+
+   return flow_hash(pInfo->src_addr, pInfo->dst_addr, pInfo->ip_version == IPv6 ? 16 : 4, pInfo->src_port, pInfo->dst_port);
+}
+
+static void FreeSegment(TCP_REASSEMBLY* pReasm, TCP_SEGMENT* pSeg) {  /* return segment to pool, free malloc'd data if any */
+
+   if (pSeg->fMalloc) free(pSeg->data);
+
+   pSeg->fMalloc = false;
+   pSeg->next = pReasm->pFreeSegments;
+   pReasm->pFreeSegments = pSeg;
+}
+
+static int Deliver(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow, uint8_t* data, int len, unsigned int uStreamFlags) {  /* deliver in-order data to user callback */
+
+   if (pFlow->fGapPending) { uStreamFlags |= DS_TCP_STREAM_GAP; pFlow->fGapPending = false; }
+
+   pReasm->stats.bytes_delivered += len;
+   pFlow->info.bytes_delivered += len;
+
+   if (pReasm->pCallback) return pReasm->pCallback(&pFlow->info, data, len, uStreamFlags, pReasm->pUserData);
+
+   return 0;
+}
+
+static void DrainSegments(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow, int nMode) {  /* deliver saved segments that are now in order. Depending on nMode (DRAIN_xxx), also skip over missing data */
+
+TCP_SEGMENT* pSeg;
+
+   while ((pSeg = pFlow->pSegments)) {
+
+      if (seq_lt(pFlow->next_seq, pSeg->seq)) {  /* gap before this segment */
+
+         if (nMode == DRAIN_NO_SKIP) break;
+
+         pReasm->stats.gaps++;
+         pFlow->next_seq = pSeg->seq;
+         pFlow->fGapPending = true;  /* given with next data delivered */
+      }
+
+      pFlow->pSegments = pSeg->next;
+      pFlow->saved_bytes -= pSeg->len;
+
+      int skip = (int)(pFlow->next_seq - pSeg->seq);  /* trim data already delivered, if segments overlap */
+
+      if (skip < pSeg->len) {
+
+         Deliver(pReasm, pFlow, &pSeg->data[skip], pSeg->len - skip, 0);
+         pFlow->next_seq = pSeg->seq + pSeg->len;
+      }
+
+      FreeSegment(pReasm, pSeg);
+
+      if (nMode == DRAIN_SKIP_RECOVER && pFlow->saved_bytes <= pReasm->max_flow_bytes/2 && pReasm->pFreeSegments) nMode = DRAIN_NO_SKIP;  /* enough room recovered, stop skipping */
+   }
+}
+
+static void CloseFlow(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow, unsigned int uStreamFlags) {  /* deliver remaining data and notify user callback. Flow remains in the flow table */
+
+TCP_SEGMENT* pSeg;
+
+   if (pFlow->fClosed) return;
+
+   DrainSegments(pReasm, pFlow, DRAIN_SKIP_ALL);
+
+   while ((pSeg = pFlow->pSegments)) { pFlow->pSegments = pSeg->next; FreeSegment(pReasm, pSeg); }  /* should already be empty */
+   pFlow->saved_bytes = 0;
+
+   if (pFlow->fGapPending) { uStreamFlags |= DS_TCP_STREAM_GAP; pFlow->fGapPending = false; }  /* data was skipped but nothing delivered after it */
+
+   if (pReasm->pCallback) pReasm->pCallback(&pFlow->info, NULL, 0, DS_TCP_STREAM_END | uStreamFlags, pReasm->pUserData);
+
+   pFlow->fClosed = true;
+   pReasm->stats.active_flows--;
+}
+
+static void RemoveFlow(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow, unsigned int uStreamFlags) {  /* close flow if needed, remove from hash table and LRU list */
+
+TCP_FLOW** ppFlow = &pReasm->hash[flow_hash(&pFlow->info)];
+
+   CloseFlow(pReasm, pFlow, uStreamFlags);
+
+   while (*ppFlow && *ppFlow != pFlow) ppFlow = &(*ppFlow)->hash_next;
+   if (*ppFlow) *ppFlow = pFlow->hash_next;
+
+   if (pFlow->lru_prev) pFlow->lru_prev->lru_next = pFlow->lru_next;
+   else pReasm->pLRU = pFlow->lru_next;
+   if (pFlow->lru_next) pFlow->lru_next->lru_prev = pFlow->lru_prev;
+   else pReasm->pMRU = pFlow->lru_prev;
+
+   pFlow->hash_next = pReasm->pFreeFlows;
+   pReasm->pFreeFlows = pFlow;
+}
+
+static void RecoverSegments(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow) {  /* segment pool exhausted: skip ahead in current flow, then in least recently used flows, until a segment is available */
+
+TCP_FLOW* pLRUFlow;
+
+   DrainSegments(pReasm, pFlow, DRAIN_SKIP_RECOVER);
+
+   for (pLRUFlow = pReasm->pLRU; pLRUFlow && !pReasm->pFreeSegments; pLRUFlow = pLRUFlow->lru_next) if (pLRUFlow->pSegments) DrainSegments(pReasm, pLRUFlow, DRAIN_SKIP_RECOVER);
+}
+
+static void TouchFlow(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow) {  /* move flow to most recently used end of LRU list */
+
+   if (pReasm->pMRU == pFlow) return;
+
+   if (pFlow->lru_prev) pFlow->lru_prev->lru_next = pFlow->lru_next;
+   else pReasm->pLRU = pFlow->lru_next;
+   if (pFlow->lru_next) pFlow->lru_next->lru_prev = pFlow->lru_prev;
+
+   pFlow->lru_prev = pReasm->pMRU;
+   pFlow->lru_next = NULL;
+   pReasm->pMRU->lru_next = pFlow;
+   pReasm->pMRU = pFlow;
+}
+
+static int SaveSegment(TCP_REASSEMBLY* pReasm, TCP_FLOW* pFlow, uint32_t seq, uint8_t* data, int len) {  /* save out-of-order segment in sequence order. Returns a SEGMENT_xxx value */
+
+TCP_SEGMENT** ppInsert = &pFlow->pSegments;
+TCP_SEGMENT* pSeg;
+
+   while (*ppInsert && seq_lt((*ppInsert)->seq, seq)) ppInsert = &(*ppInsert)->next;
+
+   if (*ppInsert && (*ppInsert)->seq == seq && (*ppInsert)->len >= len) { pReasm->stats.duplicate_segments++; return SEGMENT_DUPLICATE; }  /* already saved */
+
+   if (!(pSeg = pReasm->pFreeSegments)) { pReasm->stats.pool_exhausted++; return SEGMENT_POOL_EMPTY; }
+
+   if (len <= TCP_REASM_SEG_BUF_SIZE) pSeg->data = &pReasm->bufs[(pSeg - pReasm->segments)*TCP_REASM_SEG_BUF_SIZE];
+   else if ((pSeg->data = (uint8_t*)malloc(len))) { pSeg->fMalloc = true; pReasm->stats.oversize_segments++; }
+   else {
+
+      Log_RT(2, "ERROR: DSTcpReassemblyAddPacket() says unable to allocate %d bytes for oversize segment \n", len);
+      return SEGMENT_NO_MEMORY;
+   }
+
+   pReasm->pFreeSegments = pSeg->next;
+
+   memcpy(pSeg->data, data, len);
+   pSeg->seq = seq;
+   pSeg->len = len;
+
+   pSeg->next = *ppInsert;
+   *ppInsert = pSeg;
+
+   pFlow->saved_bytes += len;
+   pReasm->stats.out_of_order_segments++;
+
+   return SEGMENT_SAVED;
+}
+
+/* public APIs */
+
+HTCPREASSEMBLY DSCreateTcpReassembly(unsigned int uFlags, int max_flows, int num_segments, TCP_STREAM_CALLBACK pCallback, void* pUserData) {
+
+TCP_REASSEMBLY* pReasm;
+int i;
+
+   if (max_flows <= 0) max_flows = TCP_REASM_HASH_SIZE;
+   if (num_segments <= 0) num_segments = TCP_REASM_SEG_POOL_SIZE;
+
+   if (!(pReasm = (TCP_REASSEMBLY*)calloc(1, sizeof(TCP_REASSEMBLY)))) goto mem_err;
+
+   pReasm->flows = (TCP_FLOW*)calloc(max_flows, sizeof(TCP_FLOW));
+   pReasm->segments = (TCP_SEGMENT*)calloc(num_segments, sizeof(TCP_SEGMENT));
+   pReasm->bufs = (uint8_t*)malloc((size_t)num_segments*TCP_REASM_SEG_BUF_SIZE);
+
+   if (!pReasm->flows || !pReasm->segments || !pReasm->bufs) goto mem_err;
+
+   pReasm->pCallback = pCallback;
+   pReasm->pUserData = pUserData;
+   pReasm->uFlags = uFlags;
+   pReasm->max_flow_bytes = TCP_REASM_MAX_FLOW_BYTES;
+   pReasm->max_flows = max_flows;
+   pReasm->num_segments = num_segments;
+
+   for (i=max_flows-1; i>=0; i--) { pReasm->flows[i].hash_next = pReasm->pFreeFlows; pReasm->pFreeFlows = &pReasm->flows[i]; }  /* build free lists */
+   for (i=num_segments-1; i>=0; i--) { pReasm->segments[i].next = pReasm->pFreeSegments; pReasm->pFreeSegments = &pReasm->segments[i]; }
+
+   return (HTCPREASSEMBLY)pReasm;
+
+mem_err:
+
+   Log_RT(2, "ERROR: DSCreateTcpReassembly() says unable to allocate memory, max_flows = %d, num_segments = %d \n", max_flows, num_segments);
+
+   if (pReasm) { free(pReasm->flows); free(pReasm->segments); free(pReasm->bufs); free(pReasm); }
+
+   return NULL;
+}
+
+int DSDeleteTcpReassembly(HTCPREASSEMBLY hReasm) {  /* remove all flows, delivering remaining saved data, and free the instance */
+
+TCP_REASSEMBLY* pReasm = (TCP_REASSEMBLY*)hReasm;
+int nFlows = 0;
+
+   if (!pReasm) return -1;
+
+   while (pReasm->pLRU) { RemoveFlow(pReasm, pReasm->pLRU, 0); nFlows++; }
+
+   free(pReasm->flows);
+   free(pReasm->segments);
+   free(pReasm->bufs);
+   free(pReasm);
+
+   return nFlows;
+}
+
+int DSTcpReassemblyAddPacket(HTCPREASSEMBLY hReasm, uint8_t* pkt_buf, PKTINFO* PktInfo, unsigned int uFlags) {
+
+TCP_REASSEMBLY* pReasm = (TCP_REASSEMBLY*)hReasm;
+TCP_FLOW_INFO key;
+TCP_FLOW* pFlow;
+uint8_t tcp_flags, *data;
+uint32_t seq;
+int len, addr_len, save_status = SEGMENT_SAVED, ret_val = 0;
+unsigned int hash_index;
+
+   (void)uFlags;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+   if (!pReasm || !pkt_buf || !PktInfo) return -1;
+
+   if (PktInfo->protocol != TCP) return 0;
+
+   pReasm->stats.packets++;
+
+/* get flow key and TCP header items */
+
+   memset(&key, 0, sizeof(key));
+
+   key.ip_version = pkt_buf[0] >> 4;
+
+   if (key.ip_version == IPv4) { addr_len = 4; memcpy(key.src_addr, &pkt_buf[12], 4); memcpy(key.dst_addr, &pkt_buf[16], 4); }
+   else if (key.ip_version == IPv6) { addr_len = 16; memcpy(key.src_addr, &pkt_buf[8], 16); memcpy(key.dst_addr, &pkt_buf[24], 16); }
+   else return -1;
+
+   key.src_port = PktInfo->src_port;
+   key.dst_port = PktInfo->dst_port;
+
+   tcp_flags = pkt_buf[PktInfo->ip_hdr_len + 13];
+   seq = PktInfo->seqnum;
+   data = &pkt_buf[PktInfo->pyld_ofs];
+   len = max(PktInfo->pyld_len, 0);
+
+/* find flow, create if needed */
+
+   hash_index = flow_hash(key.src_addr, key.dst_addr, addr_len, key.src_port, key.dst_port);
+
+   for (pFlow = pReasm->hash[hash_index]; pFlow; pFlow = pFlow->hash_next) {
+
+      if (pFlow->info.src_port == key.src_port && pFlow->info.dst_port == key.dst_port && pFlow->info.ip_version == key.ip_version && !memcmp(pFlow->info.src_addr, key.src_addr, addr_len) && !memcmp(pFlow->info.dst_addr, key.dst_addr, addr_len)) break;
+   }
+
+   if (pFlow) TouchFlow(pReasm, pFlow);
+
+   if (pFlow && pFlow->fClosed && (tcp_flags & TCP_SYN) && !(tcp_flags & TCP_RST)) {  /* SYN on closed flow, re-open */
+
+      pFlow->next_seq = seq + 1;
+      pFlow->fFin = pFlow->fClosed = pFlow->fGapPending = false;
+      pFlow->info.bytes_delivered = 0;
+      pFlow->info.pFlowUserData = NULL;
+
+      goto flow_start;
+   }
+   else if (!pFlow) {
+
+      if (tcp_flags & TCP_RST) return 0;  /* RST for unknown flow */
+
+      if (!pReasm->pFreeFlows) { RemoveFlow(pReasm, pReasm->pLRU, DS_TCP_STREAM_EVICTED); pReasm->stats.flow_evictions++; }  /* table full, remove least recently used flow */
+
+      pFlow = pReasm->pFreeFlows;
+      pReasm->pFreeFlows = pFlow->hash_next;
+
+      memset(pFlow, 0, sizeof(TCP_FLOW));
+      pFlow->info = key;
+      pFlow->next_seq = (tcp_flags & TCP_SYN) ? seq + 1 : seq;  /* SYN consumes one sequence number. Flows can also be picked up mid-stream */
+
+      pFlow->hash_next = pReasm->hash[hash_index];
+      pReasm->hash[hash_index] = pFlow;
+
+      pFlow->lru_prev = pReasm->pMRU;  /* add to end of LRU list */
+      if (pReasm->pMRU) pReasm->pMRU->lru_next = pFlow;
+      else pReasm->pLRU = pFlow;
+      pReasm->pMRU = pFlow;
+
+flow_start:
+
+      pReasm->stats.total_flows++;
+      pReasm->stats.active_flows++;
+      if (pReasm->stats.active_flows > pReasm->stats.max_flows) pReasm->stats.max_flows = pReasm->stats.active_flows;
+
+      ret_val |= DS_TCP_REASSEMBLY_RETURN_NEW_FLOW;
+
+      if (pReasm->pCallback) pReasm->pCallback(&pFlow->info, NULL, 0, DS_TCP_STREAM_START, pReasm->pUserData);
+   }
+   else if (pFlow->fClosed) {  /* late retransmission or other packet on closed flow */
+
+      if (len > 0) { pReasm->stats.duplicate_segments++; ret_val |= DS_TCP_REASSEMBLY_RETURN_DUPLICATE; }
+
+      return ret_val;
+   }
+
+   if (tcp_flags & TCP_SYN) seq++;  /* data in a SYN packet (e.g. TCP Fast Open) follows the SYN sequence number */
+
+   if (tcp_flags & TCP_FIN) { pFlow->fFin = true; pFlow->fin_seq = seq + len; }
+
+/* handle segment data */
+
+   if (len > 0) {
+
+      if (seq_leq(seq + len, pFlow->next_seq)) {  /* all data already delivered, retransmission */
+
+         pReasm->stats.duplicate_segments++;
+         ret_val |= DS_TCP_REASSEMBLY_RETURN_DUPLICATE;
+      }
+      else if (seq_leq(seq, pFlow->next_seq)) {  /* in order, possibly overlapping data already delivered. Deliver directly from caller's packet buffer */
+
+         int skip = (int)(pFlow->next_seq - seq);
+
+         if (skip) pReasm->stats.trimmed_bytes += skip;
+
+         Deliver(pReasm, pFlow, &data[skip], len - skip, 0);
+         pFlow->next_seq = seq + len;
+
+         DrainSegments(pReasm, pFlow, DRAIN_NO_SKIP);  /* deliver saved segments that are now in order */
+
+         ret_val |= DS_TCP_REASSEMBLY_RETURN_DELIVERED;
+      }
+      else {  /* out of order, save segment */
+
+         if ((save_status = SaveSegment(pReasm, pFlow, seq, data, len)) == SEGMENT_SAVED) ret_val |= DS_TCP_REASSEMBLY_RETURN_SAVED;
+         else if (save_status == SEGMENT_DUPLICATE) ret_val |= DS_TCP_REASSEMBLY_RETURN_DUPLICATE;  /* already saved */
+         else if (save_status == SEGMENT_NO_MEMORY) pReasm->stats.dropped_segments++;  /* oversize segment could not be allocated, error is returned below */
+         else {  /* no segment pool entry available, skip ahead to saved data */
+
+            RecoverSegments(pReasm, pFlow);
+
+            if (seq_leq(seq, pFlow->next_seq) && seq_lt(pFlow->next_seq, seq + len)) {  /* current flow skipped ahead to or past this segment */
+
+               Deliver(pReasm, pFlow, &data[pFlow->next_seq - seq], (int)(seq + len - pFlow->next_seq), 0);
+               pFlow->next_seq = seq + len;
+               DrainSegments(pReasm, pFlow, DRAIN_NO_SKIP);
+               ret_val |= DS_TCP_REASSEMBLY_RETURN_DELIVERED;
+            }
+            else if (seq_lt(pFlow->next_seq, seq) && (save_status = SaveSegment(pReasm, pFlow, seq, data, len)) == SEGMENT_SAVED) ret_val |= DS_TCP_REASSEMBLY_RETURN_SAVED;
+            else pReasm->stats.dropped_segments++;
+         }
+
+         if (pFlow->saved_bytes > pReasm->max_flow_bytes) DrainSegments(pReasm, pFlow, DRAIN_SKIP_RECOVER);  /* flow's saved data limit exceeded, assume missing data is lost */
+      }
+   }
+
+/* close flow after RST, or after FIN once all data is delivered */
+
+   if ((tcp_flags & TCP_RST) || (pFlow->fFin && seq_leq(pFlow->fin_seq, pFlow->next_seq))) {
+
+      CloseFlow(pReasm, pFlow, (tcp_flags & TCP_RST) ? DS_TCP_STREAM_RESET : 0);
+      ret_val |= DS_TCP_REASSEMBLY_RETURN_FLOW_END;
+   }
+
+   if (save_status == SEGMENT_NO_MEMORY) return DS_TCP_REASSEMBLY_ERROR_NO_MEMORY;
+
+   return ret_val;
+}
+
+int DSGetTcpReassemblyStats(HTCPREASSEMBLY hReasm, unsigned int uFlags, TCP_REASSEMBLY_STATS* pStats) {
+
+TCP_REASSEMBLY* pReasm = (TCP_REASSEMBLY*)hReasm;
+
+   (void)uFlags;  /* currently not used, avoid compiler warning (Makefile has -Wextra flag) */
+
+   if (!pReasm || !pStats) return -1;
+
+   *pStats = pReasm->stats;
+
+   return 1;
+}